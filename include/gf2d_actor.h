@@ -32,7 +32,7 @@ typedef struct
 
 /**
  * @brief initialize the actor subsystem
- * @param max the maximum number of concurrent actors to support
+ * @param max how many actors to allocate space for at a time, more space is added as needed
  */
 void gf2d_actor_init(Uint32 max);
 
@@ -0,0 +1,54 @@
+#ifndef __GF2D_ATLAS_H__
+#define __GF2D_ATLAS_H__
+
+#include <SDL.h>
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+
+#include "gf3d_texture.h"
+
+/**
+ * @purpose pack small sprite images into shared atlas pages as they are loaded,
+ * so the 2D overlay draws from a handful of textures instead of one per image.
+ * Pages are packed with a skyline (bottom left) packer.  Space in a page is only reclaimed once every
+ * image in it has been released
+ */
+
+/**
+ * @brief initialize the sprite atlas, auto-cleaned up on program exit
+ * @param pageSize width and height of each atlas page in pixels
+ * @param maxImageSize images wider or taller than this get their own texture
+ * @param maxPages how many pages may be made.  0 disables the atlas
+ */
+void gf2d_atlas_init(Uint32 pageSize,Uint32 maxImageSize,Uint32 maxPages);
+
+/**
+ * @brief check if an image is small enough to go in the atlas
+ * @param width the image width in pixels
+ * @param height the image height in pixels
+ * @return 1 if it may be added, 0 if it should get its own texture
+ */
+int gf2d_atlas_accepts(Uint32 width,Uint32 height);
+
+/**
+ * @brief pack an image into an atlas page
+ * @param surface 32 bit image data, as returned by gf3d_vgraphics_screen_convert.  It is not freed
+ * @param offset [output] where the image was placed in the page, in pixels
+ * @return NULL if there was no room, or the page texture.  Free it with gf2d_atlas_release, then gf3d_texture_free
+ */
+Texture *gf2d_atlas_add(SDL_Surface *surface,GFC_Vector2D *offset);
+
+/**
+ * @brief note that an image added to a page is no longer used
+ * @param page the texture returned by gf2d_atlas_add
+ */
+void gf2d_atlas_release(Texture *page);
+
+/**
+ * @brief get how many atlas pages are in use
+ * @return the page count
+ */
+Uint32 gf2d_atlas_get_page_count();
+
+#endif
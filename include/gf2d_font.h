@@ -75,6 +75,13 @@ void gf2d_font_update();
 FontTypes gf2d_font_type_from_text(const char *buf);
 
 
+/**
+ * @brief get the font loaded for a tag
+ * @param tag the font tag
+ * @return NULL if the tag is bad or has no font, the font otherwise
+ */
+Font *gf2d_font_get_by_tag(FontTypes tag);
+
 /**
  * @brief draw text to the screen overlay layer
  */
@@ -38,6 +38,12 @@ void gf2d_mouse_show();
  */
 void gf2d_mouse_update();
 
+/**
+ * @brief read the mouse again without starting a new frame, so the position is as fresh as possible
+ * @note pumps SDL events, movement is still measured from the last gf2d_mouse_update
+ */
+void gf2d_mouse_resample();
+
 /**
  * @brief Draw the mouse to the screen.  Should probably be the last thing you do each frame
  */
@@ -0,0 +1,41 @@
+#ifndef __GF2D_PERF_OVERLAY_H__
+#define __GF2D_PERF_OVERLAY_H__
+
+#include "gfc_types.h"
+
+#include "gf2d_font.h"
+
+/**
+ * @purpose a performance overlay in the corner of the screen: a CPU vs GPU frame time graph, the frame's draw and
+ * upload counters from gf3d_stats and a bar for each memory heap.
+ * It is painted on the CPU into one image from glyphs rendered once at startup, and that image is drawn as a single
+ * sprite through the gf2d pipeline.  The image is only re-uploaded at the refresh rate, and that upload shows up in
+ * the staging and single time submit counters on the frames it happens
+ */
+
+/**
+ * @brief setup the overlay, auto-cleaned up on program exit.  It starts hidden
+ * @param fontTag the font to draw text with, the smallest configured font works best
+ * @param refreshMs how often the image is repainted and uploaded while it is shown
+ * @note call after gf2d_font_init
+ */
+void gf2d_perf_overlay_init(FontTypes fontTag,Uint32 refreshMs);
+
+/**
+ * @brief show the overlay if it is hidden, hide it if it is shown
+ */
+void gf2d_perf_overlay_toggle();
+
+/**
+ * @brief check if the overlay is being drawn
+ * @return true if it is
+ */
+Bool gf2d_perf_overlay_shown();
+
+/**
+ * @brief record the last frame's timings and draw the overlay if it is shown
+ * @note call once per frame between gf3d_vgraphics_render_start and gf3d_vgraphics_render_end, after other 2D draws
+ */
+void gf2d_perf_overlay_draw();
+
+#endif
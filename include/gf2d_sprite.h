@@ -44,12 +44,15 @@ typedef struct
     VkBuffer                    buffer;
     VkDeviceMemory              bufferMemory;
     VkDescriptorSet            *descriptorSet;          /**<descriptor sets used for this sprite to render*/
-    SDL_Surface                *surface;                /**<pointer to the cpu surface data*/
+    SDL_Surface                *surface;                /**<pointer to the cpu surface data, NULL unless kept with TF_KeepSurface*/
+    Uint8                       inAtlas;                /**<if true, texture is a shared atlas page*/
+    GFC_Vector2D                atlasOffset;            /**<where the image starts in its atlas page, in pixels*/
 }Sprite;
 
 /**
  * @brief initialize the internal management system for sprites, auto-cleaned up on program exit
- * @param max_sprites how many concurrent sprites to support
+ * @param max_sprites how many sprites to allocate space for at a time, more space is added as needed.
+ * This is also the number of sprite draws supported per frame
  */
 void gf2d_sprite_manager_init(Uint32 max_sprites);
 
@@ -70,6 +73,18 @@ Sprite *gf2d_sprite_new();
  */
 Sprite * gf2d_sprite_load(const char * filename,int frame_width,int frame_height, Uint32 frames_per_line);
 
+/**
+ * @brief loads a sprite sheet into memory with texture options.
+ * Small images are packed into a shared atlas page unless TF_KeepSurface is set
+ * @param filename the name of the file to load
+ * @param frame_width how wide an individual frame is on the sprite sheet.  if <= 0 this is assumed to be the image size
+ * @param frame_height how high an individual frame is on the sprite sheet.  if <= 0 this is assumed to be the image size
+ * @param frames_per_line how many frames across are on the sprite sheet
+ * @param textureFlags TextureFlags for the texture.  Use TF_KeepSurface to draw the sprite to surfaces
+ * @return NULL on error (check logs) or a pointer to a sprite that can be draw to the 2d overlay
+ */
+Sprite * gf2d_sprite_load_flags(const char * filename,int frame_width,int frame_height, Uint32 frames_per_line,Uint32 textureFlags);
+
 /**
  * @brief loads a flat image into memory
  * @param filename the name of the file containing the image data
@@ -100,6 +115,7 @@ void gf2d_sprite_create_vertex_buffer(Sprite *sprite);
 
 /**
  * @brief create a sprite from an SDL_Surface
+ * @note the sprite takes ownership of the surface, even on failure.  Its image is kept for drawing to surfaces
  * @param surface pointer to SDL_Surface image data
  * @param frame_width how wide an individual frame is on the sprite sheet.  if <= 0 this is assumed to be the image size
  * @param frame_height how high an individual frame is on the sprite sheet.  if <= 0 this is assumed to be the image size
@@ -114,6 +130,12 @@ Sprite * gf2d_sprite_from_surface(SDL_Surface *surface,int frame_width,int frame
  */
 void gf2d_sprite_free(Sprite *sprite);
 
+/**
+ * @brief get how many sprites are alive
+ * @return the count
+ */
+Uint32 gf2d_sprite_get_count();
+
 /**
  * @brief draw a sprite to the screen with NULLable options
  * @param sprite the sprite to draw
@@ -162,7 +184,7 @@ void gf2d_sprite_draw_full(
 
 /**
  * @brief draw a sprite to a surface instead of to the screen.
- * @note sprite must have been loaded with surface data preserved
+ * @note sprite must have been loaded with TF_KeepSurface or made with gf2d_sprite_from_surface
  * @param sprite the sprite to draw
  * @param position where on the target surface to draw it to
  * @param scale (optional) if provided the sprite will be scaled by this factor
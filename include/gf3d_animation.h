@@ -0,0 +1,216 @@
+#ifndef __GF3D_ANIMATION_H__
+#define __GF3D_ANIMATION_H__
+
+#include "gfc_types.h"
+#include "gfc_text.h"
+#include "gfc_list.h"
+#include "gfc_matrix.h"
+
+/**
+ * @purpose skeletal animation loaded from the nodes, skins and animations of a gltf file.
+ * Keyframes are stored as compact structure of arrays tracks and poses are sampled for many characters at once,
+ * four at a time with SSE when available.  Joint matrices are built parent before child in a flattened order
+ * and written out as palettes ready for gf3d_skin_upload_palette
+ */
+
+typedef enum
+{
+    AC_TX = 0,
+    AC_TY,
+    AC_TZ,
+    AC_RX,
+    AC_RY,
+    AC_RZ,
+    AC_RW,
+    AC_SX,
+    AC_SY,
+    AC_SZ,
+    AC_MAX
+}AnimationChannel;
+
+typedef enum
+{
+    AP_Translation = AC_TX,     /**<paths are the first channel they write to*/
+    AP_Rotation = AC_RX,
+    AP_Scale = AC_SX
+}AnimationPath;
+
+typedef enum
+{
+    AI_Linear = 0,
+    AI_Step,
+    AI_CubicSpline      /**<hermite curve through the keys, using the in and out tangents from the file*/
+}AnimationInterpolation;
+
+typedef struct
+{
+    Uint16      joint;          /**<flattened joint index this track drives*/
+    Uint8       path;           /**<AnimationPath*/
+    Uint8       interpolation;  /**<AnimationInterpolation*/
+    Uint32      keyCount;
+    float      *times;          /**<keyCount key times, may be shared with other tracks in the clip*/
+    float      *values;         /**<component planar: component c of key k is values[c * keyCount + k]*/
+    float      *tangents;       /**<cubic splines only: the in tangents then the out tangents, each component planar like values*/
+}AnimationTrack;
+
+typedef struct
+{
+    GFC_TextLine    name;
+    float           duration;       /**<time of the last key in seconds*/
+    Uint32          trackCount;
+    AnimationTrack *tracks;         /**<sorted by joint so sampling walks the pose in order*/
+    float          *data;           /**<one block for all of the times and values of the clip*/
+    Uint32          dataCount;      /**<how many floats are in data*/
+}AnimationClip;
+
+typedef struct
+{
+    Uint32          jointCount;
+    Sint32         *parent;         /**<flattened index of each joint's parent, always less than its own index.  -1 for roots*/
+    Uint32         *skinJoint;      /**<flattened index to the joint index used by the mesh (palette slot)*/
+    Uint32         *node;           /**<flattened index to the gltf node index*/
+    GFC_Matrix4    *inverseBind;    /**<per flattened joint*/
+    float          *rest;           /**<rest pose, AC_MAX floats per flattened joint*/
+    float          *rootParent;     /**<12 float affine per flattened joint: for roots, the world transform of the non joint
+                                        nodes above them (an armature node for one), identity otherwise.  NULL if no root has any*/
+}Skeleton;
+
+typedef struct
+{
+    Uint32          jointCount;
+    Uint32          instanceCount;
+    Uint32          stride;         /**<instanceCount rounded up to a multiple of 4*/
+    float          *channels;       /**<channel c of joint j for instance i is channels[(j * AC_MAX + c) * stride + i]*/
+    float          *world;          /**<scratch world matrices, 12 floats per joint per instance in the same layout*/
+    float          *time;           /**<scratch space for sampling*/
+    Uint32         *key;
+    Uint32         *next;
+    float          *factor;
+}AnimationPoseBatch;
+
+typedef struct
+{
+    GFC_TextLine    filename;
+    Skeleton       *skeleton;
+    GFC_List       *clips;          /**<list of AnimationClip*/
+}AnimationSet;
+
+/**
+ * @brief load the first skin and all of the animations from a gltf or glb file
+ * @param filename the file to load
+ * @return NULL on error or if the file has no skin, the animation set otherwise
+ */
+AnimationSet *gf3d_animation_set_load(const char *filename);
+
+/**
+ * @brief free an animation set, its skeleton and its clips
+ * @param set the set to free
+ */
+void gf3d_animation_set_free(AnimationSet *set);
+
+/**
+ * @brief find a clip by name
+ * @param set the set to search
+ * @param name the name of the clip
+ * @return NULL if not found, the clip otherwise
+ */
+AnimationClip *gf3d_animation_set_get_clip(AnimationSet *set,const char *name);
+
+/**
+ * @brief get a clip by index
+ * @param set the set to search
+ * @param index which clip
+ * @return NULL if out of range, the clip otherwise
+ */
+AnimationClip *gf3d_animation_set_get_clip_by_index(AnimationSet *set,Uint32 index);
+
+/**
+ * @brief allocate a skeleton with identity inverse binds and an identity rest pose.  Every joint is a root
+ * @param jointCount how many joints
+ * @return NULL on error, or the skeleton
+ */
+Skeleton *gf3d_animation_skeleton_new(Uint32 jointCount);
+
+/**
+ * @brief free a skeleton
+ * @param skeleton the skeleton to free
+ */
+void gf3d_animation_skeleton_free(Skeleton *skeleton);
+
+/**
+ * @brief allocate an empty clip
+ * @param trackCount how many tracks it will have
+ * @param dataCount how many floats of times and values it needs in total
+ * @return NULL on error, or the clip
+ */
+AnimationClip *gf3d_animation_clip_new(Uint32 trackCount,Uint32 dataCount);
+
+/**
+ * @brief free a clip
+ * @param clip the clip to free
+ */
+void gf3d_animation_clip_free(AnimationClip *clip);
+
+/**
+ * @brief allocate poses for many instances of a skeleton
+ * @param skeleton the skeleton the instances use
+ * @param instanceCount how many instances
+ * @return NULL on error, or the pose batch
+ */
+AnimationPoseBatch *gf3d_animation_pose_batch_new(Skeleton *skeleton,Uint32 instanceCount);
+
+/**
+ * @brief free a pose batch
+ * @param batch the batch to free
+ */
+void gf3d_animation_pose_batch_free(AnimationPoseBatch *batch);
+
+/**
+ * @brief sample a clip for a range of instances.  Joints not animated by the clip are set to the rest pose
+ * @param clip the clip to sample
+ * @param skeleton the skeleton the clip was loaded for
+ * @param batch the poses to write to
+ * @param first the first instance to sample
+ * @param count how many instances
+ * @param times the time in seconds for each instance, count long
+ * @param loop if true times wrap around the clip duration, otherwise they are clamped
+ * @note translation and scale are lerped, rotations are normalized lerps along the shortest path.  Cubic spline
+ * tracks are sampled on their hermite curve, rotations normalized after, with the scalar kernel only
+ */
+void gf3d_animation_sample_batch(
+    AnimationClip *clip,
+    Skeleton *skeleton,
+    AnimationPoseBatch *batch,
+    Uint32 first,
+    Uint32 count,
+    const float *times,
+    Bool loop);
+
+/**
+ * @brief build the skinning palettes for a range of sampled instances
+ * @param skeleton the skeleton the poses were sampled for
+ * @param batch the sampled poses
+ * @param first the first instance
+ * @param count how many instances
+ * @param palettes one palette per instance, each jointCount long.  Matrices are written in mesh joint order
+ */
+void gf3d_animation_build_palettes(
+    Skeleton *skeleton,
+    AnimationPoseBatch *batch,
+    Uint32 first,
+    Uint32 count,
+    GFC_Matrix4 **palettes);
+
+/**
+ * @brief enable or disable the simd kernels at runtime, useful to compare against the scalar path
+ * @param enable if false the plain C kernels are used
+ */
+void gf3d_animation_set_simd(Bool enable);
+
+/**
+ * @brief get the name of the kernel that will be used
+ * @return "sse" or "scalar"
+ */
+const char *gf3d_animation_get_kernel_name();
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef __GF3D_BINDLESS_H__
+#define __GF3D_BINDLESS_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+
+#include "gf3d_texture.h"
+
+/**
+ * @purpose keep every texture in one large sampler array so pipelines can pick textures by index.
+ * Needs descriptor indexing, turned on with "bindless_textures" in the graphics config.
+ * There is one descriptor set per swap chain image.  Texture changes are written to each set
+ * the next time its frame starts, so draws never need a texture descriptor write of their own.
+ * Bindless pipelines get the array at binding 0 of the set after their own (set 1, or set 2 with the frame ubo),
+ * and the texture index as a push constant
+ */
+
+/**
+ * @brief setup the bindless texture array if the device supports it, auto-cleaned up on program exit
+ * @param maxTextures how many textures the array holds.  Clamped to the device limits
+ * @note call after the swap chain is setup and before any textures are made
+ */
+void gf3d_bindless_init(Uint32 maxTextures);
+
+/**
+ * @brief check if bindless textures are available
+ * @return true if the array was setup
+ */
+Bool gf3d_bindless_enabled();
+
+/**
+ * @brief get the layout for the bindless texture array, to be used as set 1 in pipeline layouts
+ * @return VK_NULL_HANDLE if bindless is not enabled
+ */
+VkDescriptorSetLayout gf3d_bindless_get_layout();
+
+/**
+ * @brief get the descriptor set holding the texture array for a swap chain frame
+ * @param frame the swap chain frame
+ * @return NULL if bindless is not enabled, the set otherwise
+ */
+VkDescriptorSet *gf3d_bindless_get_descriptor_set(Uint32 frame);
+
+/**
+ * @brief give a texture a slot in the array.  Its index stays the same until it is removed
+ * @param tex the texture, its image view and sampler must be setup
+ */
+void gf3d_bindless_add_texture(Texture *tex);
+
+/**
+ * @brief rewrite a texture's slot after its sampler or image view changed
+ * @param tex the texture
+ */
+void gf3d_bindless_update_texture(Texture *tex);
+
+/**
+ * @brief release a texture's slot.  The index is not reused until frames that may still use it are done
+ * @param tex the texture
+ */
+void gf3d_bindless_remove_texture(Texture *tex);
+
+/**
+ * @brief write any texture changes to the set for this frame and recycle old slots
+ * @param frame the swap chain frame that is starting
+ */
+void gf3d_bindless_begin_frame(Uint32 frame);
+
+#endif
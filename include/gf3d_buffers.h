@@ -16,15 +16,30 @@ void gf3d_buffer_copy(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
  * @param size how much memory to create
  * @param usage usage flags
  * @param properties memory properties
- * @param buffer (output) will be set with the handle to the buffer
- * @param bufferMemory (output) will be set with the handle to the bufferMemory
- * @return 1 on success, 0 on failure
+ * @param buffer (output) will be set with the handle to the buffer, VK_NULL_HANDLE on failure
+ * @param bufferMemory (output) will be set with the handle to the bufferMemory, VK_NULL_HANDLE on failure
+ * @return 1 on success, 0 on failure.  Nothing needs to be freed on failure
+ * @note the caller's file and line are recorded with the object tracker
  */
-int gf3d_buffer_create(
+#define gf3d_buffer_create(size,usage,properties,buffer,bufferMemory) gf3d_buffer_create_at(size,usage,properties,buffer,bufferMemory,__FILE__,__LINE__)
+
+/**
+ * @brief use gf3d_buffer_create instead, it fills in the call site
+ */
+int gf3d_buffer_create_at(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer * buffer,
-    VkDeviceMemory * bufferMemory);
+    VkDeviceMemory * bufferMemory,
+    const char *file,
+    int line);
+
+/**
+ * @brief destroy a buffer and free its memory
+ * @param buffer the buffer to destroy, may be VK_NULL_HANDLE
+ * @param bufferMemory the memory to free, may be VK_NULL_HANDLE
+ */
+void gf3d_buffer_free(VkBuffer buffer,VkDeviceMemory bufferMemory);
 
 #endif
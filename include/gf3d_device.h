@@ -3,12 +3,15 @@
 
 #include <vulkan/vulkan.h>
 
+#include "gfc_types.h"
+
 
 typedef struct
 {
     VkPhysicalDevice device;                        /**vulkan device handle*/
     VkPhysicalDeviceProperties  deviceProperties;   /**<properties of the device*/
     VkPhysicalDeviceFeatures    deviceFeatures;     /**<features of the device*/
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures;   /**<descriptor indexing support, all false if the device cannot report it*/
     int score;                                      /**<how many device features match ideal*/
 }GF3D_Device;
 
@@ -45,6 +48,12 @@ VkPhysicalDevice gf3d_devices_get_device_by_name(const char *name);
  */
 GF3D_Device *gf3d_device_get_chosen_gpu_info();
 
+/**
+ * @brief check if bindless textures were asked for in the config and the device supports them
+ * @return true if the logical device was created with descriptor indexing enabled
+ */
+Bool gf3d_device_bindless_enabled();
+
 /**
  * @brief get the creation info needed to create a logical device based on what has been loaded and configured so far
  * @param enableValidationLayers if true, this will turn on validation layers. 
@@ -0,0 +1,56 @@
+#ifndef __GF3D_FRAME_PACER_H__
+#define __GF3D_FRAME_PACER_H__
+
+#include "gfc_types.h"
+
+/**
+ * @purpose frame pacing against the display instead of a fixed sleep.
+ * With a fifo present mode the swap chain already waits for vsync, so a target frame rate is rounded to a whole
+ * number of refresh intervals.  Frame starts are paced that far apart and the vsync wait inside each frame lines it
+ * up with the vblank, and nothing waits at all if the target is the refresh rate or higher.
+ * With mailbox or immediate the pacer waits for the target frame time on the high resolution clock, sleeping for
+ * most of it and spinning for the last couple of milliseconds.  A target of 0 runs uncapped.
+ * Frames are measured in refresh intervals so frames that miss their slot are counted
+ */
+
+typedef struct
+{
+    float   targetMs;       /**<the frame time being paced to, 0 for none*/
+    float   refreshMs;      /**<one refresh interval of the display*/
+    Bool    vsync;          /**<the present mode waits for vsync*/
+    Uint32  frames;         /**<frames paced*/
+    float   frameMs;        /**<the last frame, from one wait to the next*/
+    float   averageMs;      /**<exponential average of the frame time*/
+    float   waitMs;         /**<time the last frame spent waiting in the pacer*/
+    float   intervals;      /**<how many refresh intervals the last frame took*/
+    Uint32  missed;         /**<frames that took longer than their slot by more than half a refresh interval*/
+    float   windowMs;       /**<mean frame time over the last check window, compared against the target*/
+}FramePacing;
+
+/**
+ * @brief setup frame pacing
+ * @param targetFps the frame rate to hold, 0 for no limit beyond what the present mode does
+ * @param refreshRate the display refresh rate in hz, 0 if unknown (60 is assumed)
+ * @note call after the swap chain is created, it checks the present mode
+ */
+void gf3d_frame_pacer_init(float targetFps,float refreshRate);
+
+/**
+ * @brief wait until it is time to start the next frame, and measure the one that just finished
+ * @note call once per frame after gf3d_vgraphics_render_end
+ */
+void gf3d_frame_pacer_wait();
+
+/**
+ * @brief get the pacing measurements
+ * @return the measurements, never NULL
+ */
+const FramePacing *gf3d_frame_pacer_get();
+
+/**
+ * @brief get the frame rate from the average frame time
+ * @return frames per second
+ */
+float gf3d_frame_pacer_get_fps();
+
+#endif
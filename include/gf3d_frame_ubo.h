@@ -0,0 +1,82 @@
+#ifndef __GF3D_FRAME_UBO_H__
+#define __GF3D_FRAME_UBO_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_matrix.h"
+
+/**
+ * @purpose one uniform block of frame wide data (camera, time, resolution), written once per frame
+ * instead of being copied into every draw's UBO.  There is one buffer and descriptor set per swap chain image.
+ * Pipelines that set "frameUBO" in their config get it at set 0, and their own descriptor set moves to set 1
+ */
+
+typedef struct
+{
+    GFC_Matrix4     view;
+    GFC_Matrix4     proj;
+    GFC_Matrix4     viewProj;   /**<proj * view*/
+    GFC_Vector4D    camera;     /**<camera position in world space, w is 1*/
+    GFC_Vector4D    time;       /**<x seconds since start, y seconds since last frame, z frame count*/
+    GFC_Vector4D    resolution; /**<x,y view extent in pixels, z,w their inverse*/
+}FrameUBO;
+
+/**
+ * @brief called just before the frame's draws are recorded and submitted to rewrite the view with the freshest input
+ * @param view the view as of render start, update it in place
+ * @param data the data given to gf3d_frame_ubo_set_late_latch
+ */
+typedef void (*FrameUBOLatch)(GFC_Matrix4 view,void *data);
+
+/**
+ * @brief setup the frame UBO buffers and descriptor sets, auto-cleaned up on program exit
+ * @note call after the swap chain is setup and before any pipelines that use it are made
+ */
+void gf3d_frame_ubo_init();
+
+/**
+ * @brief fill in and write the frame UBO for the swap chain frame that is starting
+ * @param frame the swap chain frame
+ */
+void gf3d_frame_ubo_update(Uint32 frame);
+
+/**
+ * @brief late latch the camera: have the view updated again right before the frame's draws are submitted and rewrite the frame UBO with it
+ * @note only draws that read the view from the frame UBO see the latched camera, the view baked into per draw
+ * UBOs while recording is left as it was.  The latched view is also kept as the graphics view for the next frame
+ * @param latch the function to update the view, NULL to turn late latching off
+ * @param data passed to latch
+ */
+void gf3d_frame_ubo_set_late_latch(FrameUBOLatch latch,void *data);
+
+/**
+ * @brief run the late latch, if one is set, and rewrite the frame UBO for the swap chain frame
+ * @note called by gf3d_vgraphics_render_end before gf3d_pipeline_submit_all_pipe_commands records and submits the
+ * pipelines' draws, the buffers are host coherent so the write is seen by those submits
+ * @param frame the swap chain frame
+ * @return true if the view was latched
+ */
+Bool gf3d_frame_ubo_late_latch(Uint32 frame);
+
+/**
+ * @brief get the layout of the frame UBO set, for pipeline layouts
+ * @return VK_NULL_HANDLE if not initialized
+ */
+VkDescriptorSetLayout gf3d_frame_ubo_get_layout();
+
+/**
+ * @brief get the frame UBO descriptor set for a swap chain frame
+ * @param frame the swap chain frame
+ * @return NULL if not initialized or out of range
+ */
+VkDescriptorSet *gf3d_frame_ubo_get_descriptor_set(Uint32 frame);
+
+/**
+ * @brief get the cpu copy of the frame UBO as last written
+ * @return a pointer to the data, do not free it
+ */
+const FrameUBO *gf3d_frame_ubo_get();
+
+#endif
@@ -3,6 +3,11 @@
 
 #include "simple_json.h"
 #include "gfc_types.h"
+#include "gfc_list.h"
+#include "gfc_text.h"
+
+//forward declaration:
+typedef struct ObjData_S ObjData;
 
 typedef enum
 {
@@ -14,17 +19,42 @@ typedef enum
     G_CT_float = 5126
 }GLTF_componentType;
 
+typedef struct
+{
+    char   *data;       /**<start of the buffer bytes*/
+    size_t  size;       /**<length of the buffer in bytes*/
+    void   *block;      /**<memory that owns the bytes, NULL if they live inside another block (ie: the glb container)*/
+    size_t  blockSize;  /**<size of the owning block, needed to unmap it*/
+    Uint8   mapped;     /**<if true the block was mapped from disk and must be unmapped instead of freed*/
+}GLTF_Buffer;
+
 typedef struct
 {
     SJson *json;
-    GFC_List  *buffers;
+    GFC_List  *buffers;     /**<list of GLTF_Buffer, one per buffer in the file*/
     GFC_TextLine filename;
+    GLTF_Buffer glb;        /**<the whole .glb container if loaded from a binary file.  The BIN chunk is referenced in place*/
 }GLTF;
 
 /**
- * @brief load and decode the binary data from an embedded gltf file
- * @param filename the gltf file to load
+ * @brief a view of an accessor that references the buffer bytes directly.  No data is copied
+ * @note element i starts at data + (i * stride)
+ */
+typedef struct
+{
+    const char         *data;           /**<the first element of the accessor*/
+    Uint32              count;          /**<how many elements there are*/
+    Uint32              stride;         /**<bytes between the start of each element*/
+    GLTF_componentType  componentType;  /**<the type of each component*/
+    Uint32              componentCount; /**<how many components per element (SCALAR 1, VEC3 3, MAT4 16, etc)*/
+    Uint8               normalized;     /**<if true, integer components map to the 0-1 (or -1 to 1) range*/
+}GLTF_AccessorView;
+
+/**
+ * @brief load a gltf file.  Supports embedded data: uri buffers, external .bin buffers and binary .glb containers
+ * @param filename the gltf or glb file to load
  * @return NULL on error, or the gltlf file otherwise.
+ * @note external .bin files and .glb containers are memory mapped when they exist on disk and fall back to the pak otherwise
  * @note must be freed with gf3d_gltf_free when you are done
  */
 GLTF *gf3d_gltf_load(const char *filename);
@@ -40,14 +70,76 @@ GLTF *gf3d_gltf_load(const char *filename);
  */
 const char *gf3d_gltf_accessor_get_details(GLTF* gltf,Uint32 accessorIndex, int *bufferIndex, int *count);
 
+/**
+ * @brief get a view of the accessor data that points directly into the loaded/mapped buffer
+ * @param gltf the gltf to extract from
+ * @param accessorIndex which accessor to view
+ * @param view [output] populated with the pointer, count, stride and component information
+ * @return 0 on error (missing accessor, sparse accessor or out of bounds range), 1 otherwise
+ * @note the view is only valid until gf3d_gltf_free is called
+ */
+int gf3d_gltf_accessor_get_view(GLTF *gltf,Uint32 accessorIndex,GLTF_AccessorView *view);
+
+/**
+ * @brief read one component of one element from an accessor view as a float, converting and normalizing as needed
+ * @param view the view to read from
+ * @param element which element
+ * @param component which component of the element
+ * @return the value, or 0 if out of range
+ */
+float gf3d_gltf_accessor_get_float(GLTF_AccessorView *view,Uint32 element,Uint32 component);
+
+/**
+ * @brief read one component of one element from an accessor view as an unsigned integer
+ * @param view the view to read from
+ * @param element which element
+ * @param component which component of the element
+ * @return the value, or 0 if out of range
+ */
+Uint32 gf3d_gltf_accessor_get_uint(GLTF_AccessorView *view,Uint32 element,Uint32 component);
+
+/**
+ * @brief copy an accessor into a tightly packed float array, converting from any component type
+ * @param view the view to read from
+ * @param output [output] must have space for view->count * components floats
+ * @param components how many floats to write per element.  Extra components are filled with zero
+ * @return the number of elements written
+ */
+Uint32 gf3d_gltf_accessor_read_floats(GLTF_AccessorView *view,float *output,Uint32 components);
+
+/**
+ * @brief copy an accessor into a tightly packed Uint16 array, converting from any integer component type
+ * @param view the view to read from
+ * @param output [output] must have space for view->count * view->componentCount Uint16s
+ * @return the number of elements written
+ */
+Uint32 gf3d_gltf_accessor_read_uint16(GLTF_AccessorView *view,Uint16 *output);
+
+/**
+ * @brief copy an accessor into a tightly packed Uint8 array, converting from any integer component type
+ * @param view the view to read from
+ * @param output [output] must have space for view->count * view->componentCount Uint8s
+ * @return the number of elements written
+ */
+Uint32 gf3d_gltf_accessor_read_uint8(GLTF_AccessorView *view,Uint8 *output);
+
 /**
  * @brief get the data from a buffer view in the gltf
  * @param gltf the one to extract from
  * @param viewIndex which buffer view to extract with
  * @param buffer [output] make sure you have enough space.  Get the details from gf3d_gltf_accessor_get_details
+ * @note prefer gf3d_gltf_accessor_get_view, which does not copy and honors byteStride and componentType
  */
 void gf3d_gltf_get_buffer_view_data(GLTF *gltf,Uint32 viewIndex,char *buffer);
 
+/**
+ * @brief parse a mesh primitive of a gltf file into obj data, including the skinning attributes (JOINTS_0/WEIGHTS_0)
+ * @param gltf the loaded gltf
+ * @param primitive the primitive json from the meshes list
+ * @return NULL on error, or obj data in buffer order.  Free with gf3d_obj_free
+ */
+ObjData *gf3d_gltf_parse_primitive(GLTF *gltf,SJson *primitive);
+
 /**
  * @brief free the decoded gltf file data and the json.
  * @param gltf the data to free
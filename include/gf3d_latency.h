@@ -0,0 +1,89 @@
+#ifndef __GF3D_LATENCY_H__
+#define __GF3D_LATENCY_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+
+/**
+ * @purpose a test mode that timestamps input to photon latency.  The last time input was sampled for a frame is
+ * stamped on the high resolution clock, then the frame's submit and present, and the time its command buffers are
+ * seen complete by a fence that is polled each frame.  Photons are not measured directly: they are estimated as
+ * GPU completion plus half a refresh interval for the wait until scanout.  Time spent queued in the presentation
+ * engine with fifo is only seen as it backs up into the next acquire, so it shows in the input to submit stage.
+ * Off unless gf3d_latency_init is called, when it is off the hooks return immediately
+ */
+
+typedef struct
+{
+    float   average;
+    float   p50;
+    float   p99;
+}LatencyStage;
+
+typedef struct
+{
+    Uint32          frames;     /**<frames measured in the window*/
+    LatencyStage    submit;     /**<input sampled to queue submit*/
+    LatencyStage    present;    /**<input sampled to the present call returning*/
+    LatencyStage    gpu;        /**<input sampled to the fence seeing the frame complete*/
+    LatencyStage    photon;     /**<input sampled to the estimated scanout*/
+}LatencyStats;
+
+/**
+ * @brief turn on the latency test mode, auto-cleaned up on program exit with a final report
+ * @param samples how many frames to keep for the averages and percentiles
+ * @note call after gf3d_vgraphics_init
+ */
+void gf3d_latency_init(Uint32 samples);
+
+/**
+ * @brief check if latency is being measured
+ * @return true if it is
+ */
+Bool gf3d_latency_enabled();
+
+/**
+ * @brief stamp the time input was sampled for the frame being built, the last stamp before submit is the one used
+ */
+void gf3d_latency_mark_input();
+
+/**
+ * @brief check the fences of submitted frames and record the ones that have completed
+ * @note called by gf3d_vgraphics_render_start and gf3d_vgraphics_render_end
+ */
+void gf3d_latency_poll();
+
+/**
+ * @brief stamp the submit of a swap chain frame and get the fence to submit it with
+ * @note called by gf3d_vgraphics_render_end just before the pipelines submit the frame's draws, the fence goes on
+ * the frame's last submit and so signals once all of them are done
+ * @param frame the swap chain frame
+ * @return the fence to signal when the frame's commands complete, VK_NULL_HANDLE when not measuring this frame
+ */
+VkFence gf3d_latency_submit(Uint32 frame);
+
+/**
+ * @brief report that the submit given a fence by gf3d_latency_submit failed, so the frame is not waited on
+ * @param frame the swap chain frame
+ */
+void gf3d_latency_submit_failed(Uint32 frame);
+
+/**
+ * @brief stamp the present of a swap chain frame
+ * @param frame the swap chain frame
+ */
+void gf3d_latency_present(Uint32 frame);
+
+/**
+ * @brief get the averages and percentiles over the measured frames
+ * @param stats [output] filled in, zeroed when nothing was measured
+ */
+void gf3d_latency_get(LatencyStats *stats);
+
+/**
+ * @brief log the input to submit, gpu and photon latencies
+ */
+void gf3d_latency_report();
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef __GF3D_OBJ_BVH_H__
+#define __GF3D_OBJ_BVH_H__
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_matrix.h"
+#include "gfc_primitives.h"
+
+#include "gf3d_obj_load.h"
+
+/**
+ * @purpose bounding volume hierarchy over the triangles of an ObjData, built with binned SAH.
+ * Queries are done in object space so the hierarchy only needs to be built once per ObjData
+ */
+
+typedef struct
+{
+    float   min[3];
+    float   max[3];
+    Uint32  first;          /**<leaf: first triangle in the ordered triangle list, inner node: index of the left child (right is first + 1)*/
+    Uint32  count;          /**<how many triangles in a leaf, 0 for inner nodes*/
+}ObjBVHNode;
+
+struct ObjBVH_S
+{
+    ObjBVHNode     *nodes;          /**<node 0 is the root*/
+    Uint32          nodeCount;
+    Uint32         *faces;          /**<face index into the obj outFace, in leaf order*/
+    GFC_Vector3D   *verts;          /**<3 vertices per triangle in leaf order, copied for cache friendly tests*/
+    Uint32          triangleCount;
+    Uint32          depth;          /**<levels in the tree, the root alone is 1.  Sizes the traversal stack*/
+};
+
+/**
+ * @brief build a bvh for an obj from its faceVertices and outFace
+ * @param obj the obj to build for.  gf3d_obj_load_reorg must have been called
+ * @return NULL on error or if the obj has no faces, the bvh otherwise
+ * @note the bvh is a snapshot, if the vertices are changed it must be rebuilt
+ */
+ObjBVH *gf3d_obj_bvh_build(ObjData *obj);
+
+/**
+ * @brief free a bvh
+ * @param bvh the bvh to free
+ */
+void gf3d_obj_bvh_free(ObjBVH *bvh);
+
+/**
+ * @brief find the closest triangle hit by an edge, in the space the bvh was built in
+ * @param bvh the bvh to search
+ * @param e the edge to test with
+ * @param contact [optional output] the point of impact closest to e.a
+ * @param faceIndex [optional output] the index of the face that was hit
+ * @return 1 if the edge hits any triangle, 0 otherwise
+ */
+int gf3d_obj_bvh_edge_test(ObjBVH *bvh,GFC_Edge3D e,GFC_Vector3D *contact,Uint32 *faceIndex);
+
+/**
+ * @brief test if an edge hits anything at all.  Faster than gf3d_obj_bvh_edge_test since it stops at the first hit
+ * @param bvh the bvh to search
+ * @param e the edge to test with
+ * @return 1 if the edge is blocked, 0 otherwise
+ */
+int gf3d_obj_bvh_edge_occluded(ObjBVH *bvh,GFC_Edge3D e);
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "gf3d_mesh.h"
 
+typedef struct ObjBVH_S ObjBVH;
+
 struct ObjData_S
 {    
     GFC_Vector3D *vertices;
@@ -28,6 +30,7 @@ struct ObjData_S
     Vertex *faceVertices;
     Uint32  face_vert_count;
     GFC_Box     bounds;
+    ObjBVH     *bvh;        /**<built on the first edge test, freed when the vertices change*/
 };
 
 /**
@@ -51,13 +54,19 @@ ObjData *gf3d_obj_load_from_file(const char *filename);
 ObjData *gf3d_obj_duplicate(ObjData *in);
 
 /**
- * @brief update the vertex positions of all faceVerticies of an obj
+ * @brief update the vertex positions of all faceVerticies of an obj.  The bounds are recalculated to match
  * @param obj the obj to modify
  * @param offset how much to move the faceVertices
  * @param rotation apply this rotation to the vertices and normals
  */
 void gf3d_obj_move(ObjData *obj,GFC_Vector3D offset,GFC_Vector3D rotation);
 
+/**
+ * @brief recalculate the bounds of the obj from its vertices (or faceVertices if the vertices have been freed)
+ * @param obj the obj to update
+ */
+void gf3d_obj_get_bounds(ObjData *obj);
+
 /**
  * @brief re-organize the vertices into faceVertices for use with the rendering pipeline
  * @param obj the object to reorg
@@ -84,13 +93,54 @@ ObjData *gf3d_obj_merge(ObjData *ObjA,GFC_Vector3D offsetA,ObjData *ObjB,GFC_Vec
 void gf3d_obj_free(ObjData *obj);
 
 /**
- * @brief perform a collision test between the edge and an obj.  Searches through each triangle for collision, returning the FIRST triangle with collision (so convex hulls might return the wrong side)
+ * @brief perform a collision test between the edge and an obj.  Uses the obj bvh (building it on first use) and returns the triangle hit closest to e.a
  * @param obj the object to test
  * @param offset if the model has moved, rotated, scaled etc.  this is applied before the test 
  * @param e the edge to test with
  * @param contact [optional output] provides the point of impact
+ * @return 1 if there was a collision, 0 otherwise
  */
 int gf3d_obj_edge_test(ObjData *obj,GFC_Matrix4 offset, GFC_Edge3D e,GFC_Vector3D *contact);
 
+/**
+ * @brief perform a collision test between the edge and an obj without the bvh.  Searches through each triangle for collision, returning the FIRST triangle with collision (so convex hulls might return the wrong side)
+ * @param obj the object to test
+ * @param offset if the model has moved, rotated, scaled etc.  this is applied before the test 
+ * @param e the edge to test with
+ * @param contact [optional output] provides the point of impact
+ * @return 1 if there was a collision, 0 otherwise
+ */
+int gf3d_obj_edge_test_linear(ObjData *obj,GFC_Matrix4 offset, GFC_Edge3D e,GFC_Vector3D *contact);
+
+/**
+ * @brief test many edges against the same obj and offset.  The offset is only inverted once for the whole batch
+ * @param obj the object to test
+ * @param offset if the model has moved, rotated, scaled etc.  this is applied before the test 
+ * @param edges the edges to test
+ * @param count how many edges there are
+ * @param hits [optional output] set to 1 or 0 for each edge.  Must hold count entries
+ * @param contacts [optional output] the closest point of impact for each edge that hit.  Must hold count entries
+ * @return the number of edges that hit
+ */
+Uint32 gf3d_obj_edge_test_batch(ObjData *obj,GFC_Matrix4 offset,GFC_Edge3D *edges,Uint32 count,Uint8 *hits,GFC_Vector3D *contacts);
+
+/**
+ * @brief cast a ray at an obj
+ * @param obj the object to test
+ * @param offset if the model has moved, rotated, scaled etc.  this is applied before the test
+ * @param origin where the ray starts
+ * @param direction which way it goes, does not need to be normalized
+ * @param distance how far the ray reaches
+ * @param contact [optional output] the closest point of impact
+ * @return 1 if there was a collision, 0 otherwise
+ */
+int gf3d_obj_ray_test(ObjData *obj,GFC_Matrix4 offset,GFC_Vector3D origin,GFC_Vector3D direction,float distance,GFC_Vector3D *contact);
+
+/**
+ * @brief (re)build the bvh used for edge and ray tests
+ * @param obj the obj to build for.  gf3d_obj_load_reorg must have been called
+ * @note called automatically on the first test, but useful to avoid the hitch at load time
+ */
+void gf3d_obj_build_bvh(ObjData *obj);
 
 #endif
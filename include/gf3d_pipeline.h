@@ -18,6 +18,9 @@ typedef struct
     VkBuffer                indexBuffer;
     void                   *uboData;        //pointer to corresponding memory in the pipeline uboData
     Texture                *texture;        //optional!!
+    VkBuffer                storageBuffer;  //optional, bound to binding 2 as a storage buffer
+    VkDeviceSize            storageRange;   //how much of the storage buffer to bind
+    void                   *pushData;       //pointer to this draw's push constants in the pipeline pushConstantData
 }PipelineDrawCall;
 
 typedef struct
@@ -49,8 +52,15 @@ typedef struct
     size_t                  uboDataSize;            /**<size of a single UBO for this pipeline*/
     UniformBufferList      *uboBigBuffer;           /**<for batched draws.  This is the memory for ALL draws one per frame*/
     
+    Uint32                  pushConstantSize;       /**<bytes of per-draw push constant data from the config, 0 for none*/
+    Uint32                  pushConstantRange;      /**<bytes pushed per draw, including the bindless texture index*/
+    VkShaderStageFlags      pushConstantStages;     /**<stages that read the push constants*/
+    char                   *pushConstantData;       /**<pre-allocated push constants, pushConstantRange for each draw call*/
+    
     VkCommandBuffer         commandBuffer;          /**<for current command*/
     VkIndexType             indexType;              /**<size of the indices in the index buffer*/
+    Bool                    bindless;               /**<textures come from the bindless array in the set after the pipeline's own, the index is pushed after the pipeline's own push constants*/
+    Bool                    frameUBO;               /**<the frame ubo is bound at set 0 and the pipeline's own set at set 1*/
 }Pipeline;
 
 /**
@@ -84,9 +94,12 @@ Pipeline *gf3d_pipeline_graphics_load(VkDevice device,const char *vertFile,const
  * @param vertexInputDescription the vertex input description to use
  * @param vertextInputAttributeDescriptions list of how the attributes are described
  * @param vertexAttributeCount how many of the above are provided in the list
- * @param bufferSize the sizeof() the ubo to be used with this pipeline
+ * @param bufferSize the sizeof() the ubo to be used with this pipeline, 0 if the pipeline has no per-draw ubo
  * @param indexType VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32, or VK_INDEX_TYPE_UINT8_EXT
  * @returns NULL on error (see logs) or a pointer to a pipeline
+ * @note "pushConstants":{"size":bytes,"stageFlags":[...]} in the config adds a per-draw push constant range,
+ * filled with gf3d_pipeline_queue_render_push.  "bindless":true uses the bindless texture array.
+ * "frameUBO":true binds the frame ubo at set 0
 */
 Pipeline *gf3d_pipeline_create_from_config(
     VkDevice device,
@@ -132,13 +145,34 @@ void gf3d_pipeline_reset_frame(Pipeline *pipe,Uint32 frame);
  * @param indexBuffer which face buffer to use for the draw
  * @param uboData the UBO data to draw with.  Note this is copied by the function, feel free to change it after use
  * @param texture [optional] if you have a texture to render with, provide it here.  Note if the pipeline needs one, you MUST provide one
+ * @return NULL on error, or the queued draw call so optional bindings (like storageBuffer) can be set
+ */
+PipelineDrawCall *gf3d_pipeline_queue_render(
+    Pipeline *pipe,
+    VkBuffer vertexBuffer,
+    Uint32 vertexCount,
+    VkBuffer indexBuffer,
+    void *uboData,
+    Texture *texture);
+
+/**
+ * @brief queue up a render with push constants, for pipelines that set "pushConstants" in their config
+ * @param pipe the pipeline to queue up for
+ * @param vertexBuffer which buffer to bind
+ * @param vertexCount how many vertices to draw (usually 3 per face)
+ * @param indexBuffer which face buffer to use for the draw
+ * @param uboData [optional] the UBO data to draw with.  Copied, left zeroed if NULL
+ * @param pushData [optional] the per-draw data to push, pushConstantSize bytes.  Copied, left zeroed if NULL
+ * @param texture [optional] the texture to render with
+ * @return NULL on error, or the queued draw call
  */
-void gf3d_pipeline_queue_render(
+PipelineDrawCall *gf3d_pipeline_queue_render_push(
     Pipeline *pipe,
     VkBuffer vertexBuffer,
     Uint32 vertexCount,
     VkBuffer indexBuffer,
     void *uboData,
+    void *pushData,
     Texture *texture);
 
 /**
@@ -0,0 +1,107 @@
+#ifndef __GF3D_POOL_H__
+#define __GF3D_POOL_H__
+
+#include "gfc_types.h"
+
+/**
+ * @purpose a growable pool of fixed size elements for the resource managers.
+ * Elements are allocated in chunks that never move, so pointers to them stay valid as the pool grows.
+ * Free slots are kept on a free list so allocating and releasing do not search.
+ * Every slot has a generation that changes when it is released, so handles to freed elements can be detected
+ */
+
+typedef struct
+{
+    Uint32  index;          /**<slot in the pool*/
+    Uint32  generation;     /**<0 is never a valid generation*/
+}PoolHandle;
+
+typedef struct
+{
+    size_t      elementSize;
+    size_t      slotSize;       /**<element plus the slot header, padded for alignment*/
+    Uint32      chunkSize;      /**<slots per chunk*/
+    Uint32      chunkCount;
+    Uint8     **chunks;
+    Uint32      capacity;       /**<slots in all chunks*/
+    Uint32      maxCapacity;    /**<0 for no limit*/
+    Uint32      count;          /**<live elements*/
+    Uint32      freeHead;       /**<first free slot, capacity when there are none*/
+    Uint32      freeCount;
+}Pool;
+
+/**
+ * @brief make a new pool
+ * @param elementSize sizeof the type stored
+ * @param chunkSize how many elements to allocate at a time.  The first chunk is allocated immediately
+ * @param maxCapacity the pool will not grow past this many elements.  0 for no limit
+ * @return NULL on error or the pool
+ */
+Pool *gf3d_pool_new(size_t elementSize,Uint32 chunkSize,Uint32 maxCapacity);
+
+/**
+ * @brief free a pool and all of its chunks.  Clean up the elements first
+ * @param pool the pool to free
+ */
+void gf3d_pool_free(Pool *pool);
+
+/**
+ * @brief get a zeroed element from the pool, growing it if needed
+ * @param pool the pool to allocate from
+ * @return NULL if the pool is at its maximum capacity or out of memory, the element otherwise
+ */
+void *gf3d_pool_alloc(Pool *pool);
+
+/**
+ * @brief return an element to the pool.  Handles to it become invalid
+ * @param pool the pool it came from
+ * @param element the element to release
+ */
+void gf3d_pool_release(Pool *pool,void *element);
+
+/**
+ * @brief get a handle to a live element
+ * @param pool the pool it came from
+ * @param element the element
+ * @return a handle with generation 0 on error
+ */
+PoolHandle gf3d_pool_get_handle(Pool *pool,void *element);
+
+/**
+ * @brief get the element a handle refers to
+ * @param pool the pool to search
+ * @param handle the handle
+ * @return NULL if the element has been released since the handle was made, the element otherwise
+ */
+void *gf3d_pool_get(Pool *pool,PoolHandle handle);
+
+/**
+ * @brief get a live element by slot index, for walking every element in the pool
+ * @param pool the pool
+ * @param index from 0 to gf3d_pool_get_capacity
+ * @return NULL if the slot is free, the element otherwise
+ */
+void *gf3d_pool_get_nth(Pool *pool,Uint32 index);
+
+/**
+ * @brief get how many slots the pool has in total
+ * @param pool the pool
+ * @return the number of slots
+ */
+Uint32 gf3d_pool_get_capacity(Pool *pool);
+
+/**
+ * @brief get how many elements are live
+ * @param pool the pool
+ * @return the live count
+ */
+Uint32 gf3d_pool_get_count(Pool *pool);
+
+/**
+ * @brief get how many elements can be allocated before the pool has to grow
+ * @param pool the pool
+ * @return the number of free slots
+ */
+Uint32 gf3d_pool_get_free_count(Pool *pool);
+
+#endif
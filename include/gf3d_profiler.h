@@ -0,0 +1,105 @@
+#ifndef __GF3D_PROFILER_H__
+#define __GF3D_PROFILER_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+#include "gfc_text.h"
+
+/**
+ * @purpose GPU timing with timestamp queries.  Every pipeline's commands are timed as a zone named after
+ * the pipeline, and user zones can be added around any recorded commands.
+ * There is one query pool per swap chain image, so results are read back the next time that frame starts,
+ * when the GPU is done with them, and nothing waits on the GPU for timing.
+ * Turned on with "gpu_profiler" in the graphics config
+ */
+
+#define PROFILER_HISTORY 64     /**<how many frames the rolling average covers*/
+
+typedef struct
+{
+    GFC_TextLine    name;
+    float           lastMs;                     /**<GPU time in the most recent frame read back*/
+    float           averageMs;                  /**<rolling average over the last PROFILER_HISTORY frames it ran in*/
+    float           maxMs;                      /**<highest time in the history*/
+    float           history[PROFILER_HISTORY];
+    Uint32          historyCount;
+    Uint32          historyIndex;
+    Uint32          lastFrame;                  /**<profiler frame the zone last had a result in*/
+}ProfilerZone;
+
+/**
+ * @brief setup the GPU profiler if it is turned on in the config, auto-cleaned up on program exit
+ * @param config the graphics config file, "gpu_profiler":true turns it on
+ * @param maxZones how many zones may be timed each frame
+ * @note call after the graphics command pool is setup
+ */
+void gf3d_profiler_init(const char *config,Uint32 maxZones);
+
+/**
+ * @brief check if the profiler is running
+ * @return true if it is
+ */
+Bool gf3d_profiler_enabled();
+
+/**
+ * @brief read back the results for a swap chain frame from the last time it was used
+ * @param frame the swap chain frame that is starting
+ * @note called by gf3d_vgraphics_render_start before any commands are recorded
+ */
+void gf3d_profiler_begin_frame(Uint32 frame);
+
+/**
+ * @brief record the reset of the frame's queries, only the first call each frame records anything
+ * @param commandBuffer a command buffer of the frame that is outside of a render pass
+ * @note called by gf3d_command_rendering_begin before the render pass begins, zones are ignored until it runs
+ */
+void gf3d_profiler_reset_queries(VkCommandBuffer commandBuffer);
+
+/**
+ * @brief write the start timestamp of a zone
+ * @param commandBuffer the command buffer being recorded
+ * @param name the zone name.  Zones with the same name in a frame are added together
+ * @return a handle for gf3d_profiler_zone_end, -1 if the zone is not being timed
+ */
+Sint32 gf3d_profiler_zone_begin(VkCommandBuffer commandBuffer,const char *name);
+
+/**
+ * @brief write the end timestamp of a zone
+ * @param commandBuffer the same command buffer the zone was begun in
+ * @param zone the handle returned by gf3d_profiler_zone_begin
+ */
+void gf3d_profiler_zone_end(VkCommandBuffer commandBuffer,Sint32 zone);
+
+/**
+ * @brief get how many distinct zones have been timed
+ * @return the count
+ */
+Uint32 gf3d_profiler_get_zone_count();
+
+/**
+ * @brief get the timing of a zone
+ * @param index from 0 to gf3d_profiler_get_zone_count() - 1
+ * @return NULL if out of range, the zone otherwise
+ */
+const ProfilerZone *gf3d_profiler_get_zone(Uint32 index);
+
+/**
+ * @brief get the timing of a zone by name
+ * @param name the zone name
+ * @return NULL if no zone by that name has been timed
+ */
+const ProfilerZone *gf3d_profiler_get_zone_by_name(const char *name);
+
+/**
+ * @brief get the GPU time of the most recent frame read back, zones that were not nested in another added up
+ * @return the time in milliseconds
+ */
+float gf3d_profiler_get_frame_ms();
+
+/**
+ * @brief log the averages for every zone
+ */
+void gf3d_profiler_log();
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef __GF3D_REGISTRY_H__
+#define __GF3D_REGISTRY_H__
+
+#include "gfc_types.h"
+#include "gfc_text.h"
+
+/**
+ * @purpose a string keyed hash map for looking up loaded resources by filename.
+ * Keys are interned so each distinct path is stored once and compared like a GFC_TextLine (up to GFCLINELEN characters)
+ */
+
+typedef struct
+{
+    Uint32      hash;       /**<cached hash of the key*/
+    const char *key;        /**<interned key, NULL if the slot was never used*/
+    void       *data;       /**<the resource, NULL if the slot was removed*/
+}RegistryEntry;
+
+typedef struct
+{
+    Uint32          capacity;   /**<always a power of two*/
+    Uint32          count;      /**<live entries*/
+    Uint32          used;       /**<live and removed entries, probe chains end at unused slots*/
+    RegistryEntry  *entries;
+}Registry;
+
+/**
+ * @brief get the stable, shared copy of a string.  The same text always returns the same pointer
+ * @param str the string to intern.  Only the first GFCLINELEN characters are kept
+ * @return NULL on error or if str is NULL, the interned string otherwise.  It lives until program exit and every
+ * registry has been freed
+ */
+const char *gf3d_registry_intern(const char *str);
+
+/**
+ * @brief hash a key the way the registry does
+ * @param key the string to hash
+ * @return the hash, never 0
+ */
+Uint32 gf3d_registry_hash(const char *key);
+
+/**
+ * @brief make a new registry
+ * @param capacity how many entries are expected.  It grows if more are added
+ * @return NULL on error, or the registry
+ */
+Registry *gf3d_registry_new(Uint32 capacity);
+
+/**
+ * @brief free a registry.  The resources in it are not touched
+ * @param reg the registry to free
+ */
+void gf3d_registry_free(Registry *reg);
+
+/**
+ * @brief add a resource, replacing any resource already under the key
+ * @param reg the registry to add to
+ * @param key the name to find it by.  Empty keys are ignored
+ * @param data the resource, must not be NULL
+ * @return 0 on error, 1 otherwise
+ */
+int gf3d_registry_insert(Registry *reg,const char *key,void *data);
+
+/**
+ * @brief find a resource by key
+ * @param reg the registry to search
+ * @param key the name to search for
+ * @return NULL if not found, the resource otherwise
+ */
+void *gf3d_registry_get(Registry *reg,const char *key);
+
+/**
+ * @brief remove a key from the registry
+ * @param reg the registry to remove from
+ * @param key the name to remove
+ * @param data if not NULL the key is only removed if it still refers to this resource
+ * @return 1 if an entry was removed, 0 otherwise
+ */
+int gf3d_registry_remove(Registry *reg,const char *key,void *data);
+
+/**
+ * @brief remove every entry
+ * @param reg the registry to clear
+ */
+void gf3d_registry_clear(Registry *reg);
+
+#endif
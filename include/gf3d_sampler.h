@@ -0,0 +1,74 @@
+#ifndef __GF3D_SAMPLER_H__
+#define __GF3D_SAMPLER_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+
+/**
+ * @purpose a cache of VkSamplers shared by every texture.
+ * Samplers are keyed by their settings, so textures that sample the same way use the same handle.
+ * Drivers limit how many samplers can exist at once (maxSamplerAllocationCount), so textures must not make their own
+ */
+
+typedef enum
+{
+    SP_Texture = 0,     /**<model textures: trilinear, repeating, anisotropic*/
+    SP_Sprite,          /**<2D overlay images: linear, clamped, base level only*/
+    SP_Pixel,           /**<nearest filtering for pixel art and lookup tables*/
+    SP_MAX
+}SamplerPreset;
+
+typedef struct
+{
+    VkFilter                filter;         /**<used for both magnification and minification*/
+    VkSamplerMipmapMode     mipmapMode;
+    VkSamplerAddressMode    addressMode;    /**<used for U, V and W*/
+    float                   maxAnisotropy;  /**<1 or less disables anisotropic filtering*/
+    Uint32                  useMips;        /**<0 samples only the base level*/
+}SamplerSettings;
+
+/**
+ * @brief initialize the sampler cache and its presets
+ * @param config (optional) a config file with a "samplers" object that overrides the presets by name:
+ * "texture", "sprite" and "pixel"
+ * @note must be called after the logical device is created
+ */
+void gf3d_sampler_init(const char *config);
+
+/**
+ * @brief get a sampler with the given settings, creating it the first time it is asked for
+ * @param settings how to sample
+ * @return VK_NULL_HANDLE on error, or a shared sampler.  Do not destroy it, the cache owns it
+ */
+VkSampler gf3d_sampler_get(const SamplerSettings *settings);
+
+/**
+ * @brief get the sampler for a preset
+ * @param preset which SamplerPreset
+ * @return VK_NULL_HANDLE on error, or a shared sampler
+ */
+VkSampler gf3d_sampler_get_preset(SamplerPreset preset);
+
+/**
+ * @brief change the settings for a preset
+ * @note only textures that get their sampler after this is called will use the new settings
+ * @param preset which SamplerPreset
+ * @param settings the new settings
+ */
+void gf3d_sampler_set_preset(SamplerPreset preset,const SamplerSettings *settings);
+
+/**
+ * @brief get the settings for a preset
+ * @param preset which SamplerPreset
+ * @return NULL if the preset is out of range, the settings otherwise
+ */
+const SamplerSettings *gf3d_sampler_get_preset_settings(SamplerPreset preset);
+
+/**
+ * @brief get how many samplers the cache has created
+ * @return the count
+ */
+Uint32 gf3d_sampler_get_count();
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef __GF3D_SKIN_H__
+#define __GF3D_SKIN_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_matrix.h"
+#include "gfc_color.h"
+#include "gfc_primitives.h"
+
+#include "gf3d_pipeline.h"
+#include "gf3d_texture.h"
+#include "gf3d_obj_load.h"
+
+/**
+ * @purpose skinned mesh rendering.  Bind pose vertices stay resident on the gpu, each frame only the joint palettes are uploaded.
+ * Palettes live in one storage buffer per swap frame and every draw references its palette by jointBase in its push constants.
+ * Camera data comes from the frame ubo, so skinned draws have no ubo of their own
+ */
+
+typedef struct
+{
+    GFC_Vector3D vertex;
+    GFC_Vector3D normal;
+    GFC_Vector2D texel;
+    GFC_Vector4D weights;   /**<weights for each of the joints, sum to 1*/
+    Uint8        joints[4]; /**<joint indices into the palette for this mesh*/
+}SkinnedVertex;
+
+typedef struct
+{
+    GFC_Matrix4     model;
+    GFC_Vector4D    color;
+    Uint32          jointBase;  /**<where in the palette storage buffer this draw's joints start*/
+    Uint32          jointCount;
+    Uint32          padding[2];
+}SkinPushConstants;     /**<the per-draw data, pushed instead of written to the UBO*/
+
+typedef struct
+{
+    Uint32          vertexCount;
+    VkBuffer        vertexBuffer;
+    VkDeviceMemory  vertexBufferMemory;
+    Uint32          faceCount;
+    VkBuffer        faceBuffer;
+    VkDeviceMemory  faceBufferMemory;
+    Uint32          jointCount;     /**<highest joint index referenced + 1*/
+    GFC_Box         bounds;         /**<bind pose bounds*/
+}SkinnedMesh;
+
+/**
+ * @brief initialize the skinned mesh renderer.  Creates the skinned pipeline and the palette buffers
+ * @param maxDraws how many skinned draw calls are supported per frame
+ * @param maxJoints how many joint matrices can be uploaded per frame, across all instances
+ * @param pipeConfig the pipeline config file to use, if NULL "config/skinned_pipeline.cfg" is used
+ */
+void gf3d_skin_init(Uint32 maxDraws,Uint32 maxJoints,const char *pipeConfig);
+
+/**
+ * @brief called once at the beginning of each render frame to reset the palette cursor
+ * @note safe to call if the skin system was never initialized
+ */
+void gf3d_skin_reset_frame();
+
+/**
+ * @brief create a gpu resident skinned mesh from obj data that contains bone indices and weights
+ * @param obj the obj to build from.  It must be in buffer order (as loaded from gltf)
+ * @return NULL on error, or the skinned mesh.  The obj can be freed after this
+ * @note vertices without bone data are bound entirely to joint 0
+ */
+SkinnedMesh *gf3d_skin_mesh_from_obj(ObjData *obj);
+
+/**
+ * @brief free a skinned mesh
+ * @param mesh the mesh to free
+ */
+void gf3d_skin_mesh_free(SkinnedMesh *mesh);
+
+/**
+ * @brief get how many skinned meshes are alive
+ * @return the count
+ */
+Uint32 gf3d_skin_get_mesh_count();
+
+/**
+ * @brief upload a joint palette for this frame.  Meshes that share a skeleton (or instances drawn several times) can share one upload
+ * @param palette the joint matrices (world from bind pose, inverse bind already applied)
+ * @param jointCount how many matrices in the palette
+ * @param jointBase [output] where the palette was placed, pass to gf3d_skin_draw_palette
+ * @return 0 if there is no room left this frame, 1 on success
+ */
+int gf3d_skin_upload_palette(GFC_Matrix4 *palette,Uint32 jointCount,Uint32 *jointBase);
+
+/**
+ * @brief queue a skinned mesh to draw with a palette uploaded this frame
+ * @param mesh the mesh to draw
+ * @param modelMat the model matrix
+ * @param color the color mod
+ * @param jointBase as returned from gf3d_skin_upload_palette
+ * @param texture the texture to draw with
+ */
+void gf3d_skin_draw_palette(SkinnedMesh *mesh,GFC_Matrix4 modelMat,GFC_Color color,Uint32 jointBase,Texture *texture);
+
+/**
+ * @brief upload the palette and queue a skinned mesh to draw in one step
+ * @param mesh the mesh to draw
+ * @param modelMat the model matrix
+ * @param color the color mod
+ * @param palette the joint matrices
+ * @param jointCount how many joints in the palette
+ * @param texture the texture to draw with
+ */
+void gf3d_skin_draw(SkinnedMesh *mesh,GFC_Matrix4 modelMat,GFC_Color color,GFC_Matrix4 *palette,Uint32 jointCount,Texture *texture);
+
+/**
+ * @brief get the pipeline used for skinned meshes
+ * @return NULL if not initialized, or the pipeline
+ */
+Pipeline *gf3d_skin_get_pipeline();
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef __GF3D_STATIC_BATCH_H__
+#define __GF3D_STATIC_BATCH_H__
+
+#include "gfc_types.h"
+#include "gfc_list.h"
+#include "gfc_matrix.h"
+#include "gfc_primitives.h"
+
+#include "gf3d_texture.h"
+#include "gf3d_obj_load.h"
+
+/**
+ * @purpose bake many static pieces of geometry into a few merged objs, one per material.
+ * Add every piece, build once, then upload each group obj like any other buffer ordered obj
+ */
+
+typedef struct
+{
+    Uint32  firstFace;      /**<first face of this piece in the group obj*/
+    Uint32  faceCount;      /**<how many faces belong to this piece*/
+    Uint32  firstVertex;    /**<first vertex of this piece in the group obj*/
+    Uint32  vertexCount;    /**<how many vertices belong to this piece*/
+    GFC_Box bounds;         /**<transformed bounds of this piece for culling*/
+    Uint32  entry;          /**<the order this piece was added to the batch*/
+}StaticBatchRange;
+
+typedef struct
+{
+    Uint32  firstIndex;     /**<first index to draw (faces * 3)*/
+    Uint32  indexCount;     /**<how many indices to draw*/
+}StaticBatchDrawRange;
+
+typedef struct
+{
+    Texture            *texture;    /**<the material shared by everything in this group*/
+    ObjData            *obj;        /**<merged faceVertices and outFace, in buffer order*/
+    StaticBatchRange   *ranges;     /**<one per piece, in the order they appear in the obj*/
+    Uint32              rangeCount;
+    GFC_Box             bounds;     /**<bounds of the whole group*/
+}StaticBatchGroup;
+
+typedef struct
+{
+    GFC_List   *entries;    /**<pieces waiting to be built*/
+    GFC_List   *groups;     /**<StaticBatchGroup's, populated by gf3d_static_batch_build*/
+}StaticBatch;
+
+/**
+ * @brief make a new empty static batch
+ * @return NULL on error or the batch
+ */
+StaticBatch *gf3d_static_batch_new();
+
+/**
+ * @brief queue a piece of geometry for the batch
+ * @param batch the batch to add to
+ * @param obj the geometry.  It must have been reorganized into buffer order.  It is not copied until build, so keep it alive until then
+ * @param transform where to place this piece
+ * @param texture the material, pieces with the same texture are merged together.  NULL is a valid material
+ */
+void gf3d_static_batch_add(StaticBatch *batch,ObjData *obj,GFC_Matrix4 transform,Texture *texture);
+
+/**
+ * @brief merge all of the queued pieces into groups.  Each piece is transformed and copied exactly once
+ * @param batch the batch to build
+ * @return the number of groups built by this call, 0 if nothing was queued or on error.  A failed build adds no
+ * groups and the queued pieces are dropped.  Use gf3d_static_batch_get_group_count for the total
+ * @note a material is split into more than one group if it would go over the 16 bit index limit of Face
+ * @note the queued pieces are cleared, the input objs can be freed after this
+ */
+Uint32 gf3d_static_batch_build(StaticBatch *batch);
+
+/**
+ * @brief get how many groups have been built
+ * @param batch the batch to check
+ * @return the group count
+ */
+Uint32 gf3d_static_batch_get_group_count(StaticBatch *batch);
+
+/**
+ * @brief get a built group
+ * @param batch the batch to get from
+ * @param index which group
+ * @return NULL if out of range, the group otherwise
+ */
+StaticBatchGroup *gf3d_static_batch_get_group(StaticBatch *batch,Uint32 index);
+
+/**
+ * @brief cull the pieces of a group and get the index ranges that still need to be drawn.  Neighboring visible pieces are joined into one range
+ * @param group the group to cull
+ * @param visible callback that returns true if the bounds should be drawn
+ * @param data passed to the visible callback
+ * @param out [output] must have room for group->rangeCount ranges
+ * @return how many draw ranges were written
+ */
+Uint32 gf3d_static_batch_group_cull(
+    StaticBatchGroup *group,
+    Bool (*visible)(GFC_Box *bounds,void *data),
+    void *data,
+    StaticBatchDrawRange *out);
+
+/**
+ * @brief free a static batch and all of its groups
+ * @param batch the batch to free
+ * @note textures are not reference counted by the batch
+ */
+void gf3d_static_batch_free(StaticBatch *batch);
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef __GF3D_STATS_H__
+#define __GF3D_STATS_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+#include "gfc_text.h"
+
+/**
+ * @purpose per frame counters for the renderer: draw calls for each pipeline, command buffer binds, descriptor writes,
+ * staging uploads and the single time command submits that stall on vkQueueWaitIdle.  Along with those it keeps
+ * how many textures, sprites and skinned meshes are alive and how much device memory is allocated from each heap.
+ * Counters run from one gf3d_stats_end_frame to the next, the finished frame can be queried, logged or written to CSV
+ */
+
+#define STATS_MAX_PIPELINES 16
+
+typedef enum
+{
+    SC_DrawCalls,           /**<vkCmdDraw and vkCmdDrawIndexed*/
+    SC_Binds,               /**<vkCmdBindPipeline, vkCmdBindDescriptorSets, vkCmdBindVertexBuffers and vkCmdBindIndexBuffer*/
+    SC_DescriptorWrites,    /**<descriptors written with vkUpdateDescriptorSets*/
+    SC_StagingBytes,        /**<bytes sent through host visible staging buffers*/
+    SC_SingleTimeSubmits,   /**<single time command buffers, each waits for the queue to go idle*/
+    SC_MAX
+}StatCounter;
+
+typedef struct
+{
+    GFC_TextLine    name;
+    Uint32          drawCalls;
+}StatsPipeline;
+
+typedef struct
+{
+    Uint32          frame;                              /**<how many frames had been finished when this one was*/
+    float           frameMs;                            /**<cpu time from the last frame end to this one*/
+    Uint64          counters[SC_MAX];
+    float           stallMs;                            /**<time spent waiting for the queue after single time submits*/
+    StatsPipeline   pipelines[STATS_MAX_PIPELINES];
+    Uint32          pipelineCount;
+    Uint32          textures;                           /**<textures alive at the end of the frame*/
+    Uint32          sprites;                            /**<sprites alive at the end of the frame*/
+    Uint32          meshes;                             /**<skinned meshes alive at the end of the frame*/
+    Uint32          heapCount;
+    VkDeviceSize    heapUsed[VK_MAX_MEMORY_HEAPS];      /**<bytes allocated through gf3d from each heap*/
+    VkDeviceSize    heapSize[VK_MAX_MEMORY_HEAPS];      /**<total size of each heap*/
+}FrameStats;
+
+/**
+ * @brief setup frame statistics, auto-cleaned up on program exit
+ * @param physicalDevice the device memory allocations are made from
+ * @note call before any device memory is allocated
+ */
+void gf3d_stats_init(VkPhysicalDevice physicalDevice);
+
+/**
+ * @brief add to one of the counters for the current frame
+ * @param counter which counter
+ * @param amount how much to add
+ */
+void gf3d_stats_add(StatCounter counter,Uint64 amount);
+
+/**
+ * @brief add draw calls recorded for a pipeline this frame, they are added to SC_DrawCalls as well
+ * @param pipeline the name of the pipeline
+ * @param drawCalls how many were recorded
+ */
+void gf3d_stats_add_pipeline_draws(const char *pipeline,Uint32 drawCalls);
+
+/**
+ * @brief add the time spent stalled waiting for the GPU this frame
+ * @param ms the time in milliseconds
+ */
+void gf3d_stats_add_stall(float ms);
+
+/**
+ * @brief note device memory that has been allocated
+ * @param memory the new allocation
+ * @param size its size in bytes
+ * @param memoryTypeIndex the memory type it was allocated with
+ */
+void gf3d_stats_memory_alloc(VkDeviceMemory memory,VkDeviceSize size,Uint32 memoryTypeIndex);
+
+/**
+ * @brief note device memory that is being freed
+ * @param memory the allocation, ignored if it was not noted with gf3d_stats_memory_alloc
+ */
+void gf3d_stats_memory_free(VkDeviceMemory memory);
+
+/**
+ * @brief finish counting the current frame and start the next
+ * @note called by gf3d_vgraphics_render_end after the frame is presented
+ */
+void gf3d_stats_end_frame();
+
+/**
+ * @brief get the counts for the most recently finished frame
+ * @return the frame stats, never NULL
+ */
+const FrameStats *gf3d_stats_get();
+
+/**
+ * @brief log the most recently finished frame
+ */
+void gf3d_stats_log();
+
+/**
+ * @brief write a row to a CSV file for every finished frame from now on
+ * @param filename the file to write, it is overwritten
+ * @return 1 on success, 0 on failure
+ * @note there is a name and draw count column pair for each of the STATS_MAX_PIPELINES pipeline slots, filled in
+ * the order pipelines first draw, so pipelines created after the file is opened are included
+ */
+int gf3d_stats_csv_open(const char *filename);
+
+/**
+ * @brief stop writing the CSV file
+ */
+void gf3d_stats_csv_close();
+
+#endif
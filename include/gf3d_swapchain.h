@@ -13,8 +13,30 @@
  * @param surface the surface that the swap chain should support
  * @param width the desired width of the swap chain buffers
  * @param height the desired height of the swap chain buffers
+ * @param presentMode the preferred present mode, if the surface does not support it mailbox is used, then fifo
  */
-void gf3d_swapchain_init(VkPhysicalDevice device,VkDevice logicalDevice, VkSurfaceKHR surface,Uint32 width,Uint32 height);
+void gf3d_swapchain_init(VkPhysicalDevice device,VkDevice logicalDevice, VkSurfaceKHR surface,Uint32 width,Uint32 height,VkPresentModeKHR presentMode);
+
+/**
+ * @brief get the present mode the swap chain was created with
+ * @return the present mode, VK_PRESENT_MODE_FIFO_KHR if there is no swap chain
+ */
+VkPresentModeKHR gf3d_swapchain_get_present_mode();
+
+/**
+ * @brief get a present mode by its config name
+ * @param name one of "immediate", "mailbox", "fifo" or "fifo_relaxed"
+ * @param defaultMode returned if name is NULL or not recognized
+ * @return the present mode
+ */
+VkPresentModeKHR gf3d_swapchain_present_mode_from_name(const char *name,VkPresentModeKHR defaultMode);
+
+/**
+ * @brief get the config name of a present mode
+ * @param mode the present mode
+ * @return the name, "unknown" for modes without one
+ */
+const char *gf3d_swapchain_present_mode_name(VkPresentModeKHR mode);
 
 /**
  * @brief check if the initialized swap chain is sufficient for rendering
@@ -5,44 +5,191 @@
 #include "gfc_types.h"
 #include "gfc_text.h"
 
+#include "gf3d_sampler.h"
+
+typedef enum
+{
+    TF_None = 0,
+    TF_NoMips = 1,      /**<only keep the full resolution image, for sprites and UI that are drawn 1:1*/
+    TF_KeepSurface = 2  /**<keep the decoded image in cpu memory after upload, for drawing to surfaces or picking*/
+}TextureFlags;
+
+typedef struct
+{
+    Uint32              textureCount;       /**<live textures*/
+    Uint32              unreferencedCount;  /**<textures with no references kept in case they are loaded again*/
+    VkDeviceSize        gpuBytes;           /**<device memory allocated for texture images*/
+    Uint32              surfaceCount;       /**<textures still holding their decoded image*/
+    size_t              surfaceBytes;       /**<cpu memory held by those images*/
+}TextureMemoryStats;
+
 typedef struct
 {
     Uint8               _inuse;
     Uint32              _refcount;
     Uint32              width,height;
+    Uint32              mipLevels;  /**<how many levels in the mip chain, 1 if there are no mips*/
+    VkFormat            format;     /**<R8G8B8A8 for images loaded through SDL, or a BC format for DDS / KTX2 files*/
+    VkDeviceSize        gpuBytes;   /**<size of the device memory allocation for the image*/
     GFC_TextLine            filename;
     VkImage             textureImage;
     VkDeviceMemory      textureImageMemory;
     VkImageView         textureImageView;
-    VkSampler           textureSampler;
-    SDL_Surface        *surface;    /**<the image data in CPU space*/
+    VkSampler           textureSampler; /**<shared from the sampler cache, not owned by the texture*/
+    SamplerPreset       samplerPreset;  /**<the sampler it was loaded for, textures are shared by filename and this*/
+    SDL_Surface        *surface;    /**<the image data in CPU space, only kept if loaded with TF_KeepSurface*/
+    Uint32              bindlessIndex;  /**<slot in the bindless texture array, 0 if it has none*/
+    VkBuffer            streamBuffer;   /**<persistent staging for gf3d_texture_stream, one slice per swap chain image*/
+    VkDeviceMemory      streamMemory;
+    Uint8              *streamMapped;
+    Bool                streamPending;  /**<waiting to be recorded at the start of the next frame's commands*/
 }Texture;
 
 /**
  * @brief initialize the texture subsystem
- * @param max_textures the maximum number of concurrent textures to be supported.
+ * @param max_textures how many textures to allocate space for at a time, more space is added as needed.
  * This is inclusive of all model textures and sprites
  */
 void gf3d_texture_init(Uint32 max_textures);
 
 /**
- * @brief load a texture from file.
+ * @brief load a texture from file.  A full mip chain is generated for it.
+ * DDS and KTX2 files with BC1, BC3, BC5 or BC7 data are uploaded as they are, with the mips stored in the file
  * @param filename the path to the file to load
  * @return NULL on error or the texture loaded
  */
 Texture *gf3d_texture_load(const char *filename);
 
+/**
+ * @brief find a texture that is already loaded, without loading it or adding a reference
+ * @param filename the path the texture was loaded from
+ * @return NULL if it is not loaded, the texture otherwise
+ */
+Texture *gf3d_texture_get_by_filename(const char * filename);
+
+/**
+ * @brief find a texture that is already loaded for a sampler, without loading it or adding a reference
+ * @param filename the path the texture was loaded from
+ * @param preset the SamplerPreset it was loaded with
+ * @return NULL if it is not loaded for that sampler, the texture otherwise
+ */
+Texture *gf3d_texture_get_sampled(const char * filename,SamplerPreset preset);
+
+/**
+ * @brief load a texture from file with options
+ * @param filename the path to the file to load
+ * @param flags TextureFlags
+ * @return NULL on error or the texture loaded
+ * @note textures are shared by filename, if the file is already loaded it is returned as it was first loaded.
+ * The exception is TF_KeepSurface, which reloads the image data for a shared texture that did not keep it
+ */
+Texture *gf3d_texture_load_flags(const char *filename,Uint32 flags);
+
+/**
+ * @brief load a texture from file to be sampled with a preset
+ * @param filename the path to the file to load
+ * @param flags TextureFlags
+ * @param preset the SamplerPreset to use, SP_Texture is the same as gf3d_texture_load_flags
+ * @return NULL on error or the texture loaded
+ * @note textures are shared by filename and sampler, so a sprite and a model using the same image get separate
+ * textures and neither changes how the other is sampled
+ */
+Texture *gf3d_texture_load_sampled(const char *filename,Uint32 flags,SamplerPreset preset);
+
+/**
+ * @brief decode an image file into a surface in the screen format, without making a texture
+ * @param filename the image file to load
+ * @return NULL on error, or the surface.  The caller owns it
+ */
+SDL_Surface *gf3d_texture_load_surface(const char *filename);
+
 /**
  * @brief create a texture based on the provided surface.
- * @note the filename is not populated by this
+ * @note the filename is not populated by this.  The texture takes ownership of the surface, even on failure
  * @param surface the SDL_Surface image data to convert
  * @return NULL on error or a new Texture otherwise
  */
 Texture *gf3d_texture_convert_surface(SDL_Surface * surface);
 
+/**
+ * @brief create a texture based on the provided surface with options
+ * @note the filename is not populated by this.  The texture takes ownership of the surface, even on failure
+ * @param surface the SDL_Surface image data to convert
+ * @param flags TextureFlags
+ * @return NULL on error or a new Texture otherwise
+ */
+Texture *gf3d_texture_convert_surface_flags(SDL_Surface * surface,Uint32 flags);
+
+/**
+ * @brief create a texture from a decoded image and register it under a filename and sampler, so loading that file
+ * later for the same sampler shares it
+ * @note the texture takes ownership of the surface, even on failure
+ * @param surface the SDL_Surface image data to convert
+ * @param filename the name the image was loaded from
+ * @param flags TextureFlags
+ * @param preset the SamplerPreset to use
+ * @return NULL on error or a new Texture otherwise
+ */
+Texture *gf3d_texture_convert_surface_named(SDL_Surface *surface,const char *filename,Uint32 flags,SamplerPreset preset);
+
+/**
+ * @brief copy image data into part of an existing texture
+ * @note only for R8G8B8A8 textures with one mip level.  Waits for the copy to finish
+ * @param tex the texture to update
+ * @param surface 32 bit image data in the texture's layout, as returned by gf3d_vgraphics_screen_convert.  It is not freed
+ * @param x the left edge of the region in texels
+ * @param y the top edge of the region in texels
+ * @return 0 on error, 1 otherwise
+ */
+int gf3d_texture_update_region(Texture *tex,SDL_Surface *surface,Uint32 x,Uint32 y);
+
+/**
+ * @brief upload the texture's kept surface again, for images that are repainted on the cpu every so often
+ * @note the copy is recorded into the frame's own commands before its first render pass, through a staging buffer
+ * that is made once and kept mapped, so nothing is submitted or waited on.  The surface is read when the copy is
+ * recorded, at the start of the next pipeline command buffer, so the upload shows up a frame later at most.
+ * Only for R8G8B8A8 textures without mips that kept their surface
+ * @param tex the texture to upload
+ * @return 0 on error, 1 otherwise
+ */
+int gf3d_texture_stream(Texture *tex);
+
+/**
+ * @brief record the uploads queued by gf3d_texture_stream
+ * @param commandBuffer a command buffer of the frame that is outside of a render pass
+ * @note called by gf3d_command_rendering_begin before the render pass begins
+ */
+void gf3d_texture_record_streams(VkCommandBuffer commandBuffer);
+
 /**
 * @brief free a previously loaded texture
  */
 void gf3d_texture_free(Texture *tex);
 
+/**
+ * @brief change how a texture is sampled
+ * @note this affects every user of the texture and does not change which loads share it.  To sample a file
+ * differently from its other users, load it with gf3d_texture_load_sampled instead
+ * @param tex the texture to change
+ * @param preset the SamplerPreset to use.  Textures use SP_Texture by default
+ */
+void gf3d_texture_set_sampler(Texture *tex,SamplerPreset preset);
+
+/**
+ * @brief get how many textures are alive, including unreferenced textures that have not been reclaimed
+ * @return the count
+ */
+Uint32 gf3d_texture_get_count();
+
+/**
+ * @brief get how much memory textures are using
+ * @param stats [output] the totals
+ */
+void gf3d_texture_get_memory_stats(TextureMemoryStats *stats);
+
+/**
+ * @brief log the memory totals and every texture that still holds cpu image data
+ */
+void gf3d_texture_log_memory();
+
 #endif
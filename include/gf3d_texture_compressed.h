@@ -0,0 +1,52 @@
+#ifndef __GF3D_TEXTURE_COMPRESSED_H__
+#define __GF3D_TEXTURE_COMPRESSED_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+
+/**
+ * @purpose parse block compressed textures (BC1, BC3, BC5 and BC7) out of DDS and KTX2 files so their
+ * mip chains can be uploaded to the gpu as they are, without decoding
+ */
+
+#define GF3D_COMPRESSED_MAX_LEVELS 16
+
+typedef struct
+{
+    VkFormat        format;
+    Uint32          width,height;
+    Uint32          blockBytes;     /**<bytes per 4x4 block, 8 for BC1, 16 for the rest*/
+    Uint32          mipLevels;      /**<levels in the file, never more than the full mip chain for the size*/
+    const Uint8    *levelData[GF3D_COMPRESSED_MAX_LEVELS];  /**<points into the file memory, largest level first*/
+    size_t          levelSize[GF3D_COMPRESSED_MAX_LEVELS];
+}CompressedImage;
+
+/**
+ * @brief check if file data looks like a DDS or KTX2 file
+ * @param data the file contents
+ * @param size how many bytes of data
+ * @return 1 if it has a DDS or KTX2 signature, 0 otherwise
+ */
+int gf3d_texture_compressed_check(const void *data,size_t size);
+
+/**
+ * @brief parse a DDS or KTX2 file held in memory
+ * @param data the file contents.  It must outlive the CompressedImage, which points into it
+ * @param size how many bytes of data
+ * @param image [output] the format, size and mip levels
+ * @return 0 if the data is not a supported 2D block compressed image, 1 otherwise
+ * @note cube maps, arrays, volume textures and supercompressed KTX2 files are not supported
+ */
+int gf3d_texture_compressed_parse(const void *data,size_t size,CompressedImage *image);
+
+/**
+ * @brief get how many bytes a level of a block compressed image takes
+ * @param width the width of the level in texels
+ * @param height the height of the level in texels
+ * @param blockBytes bytes per 4x4 block
+ * @return the size in bytes
+ */
+size_t gf3d_texture_compressed_level_size(Uint32 width,Uint32 height,Uint32 blockBytes);
+
+#endif
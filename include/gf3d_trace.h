@@ -0,0 +1,58 @@
+#ifndef __GF3D_TRACE_H__
+#define __GF3D_TRACE_H__
+
+#include <SDL.h>
+
+#include "gfc_types.h"
+
+/**
+ * @purpose CPU timing zones on the high resolution clock, recorded into a ring buffer and written out
+ * as Chrome trace JSON (chrome://tracing or ui.perfetto.dev) on demand.
+ * Zones nest and may be used from any thread, each thread shows as its own track.
+ * Zone names are kept by pointer, so they must outlive the trace: use string literals or other static names
+ */
+
+typedef struct
+{
+    const char *name;
+    Uint64      start;      /**<performance counter when the zone began*/
+}TraceZone;
+
+/**
+ * @brief start recording trace events, auto-cleaned up on program exit
+ * @param maxEvents how many events the ring buffer holds, the oldest are overwritten first
+ */
+void gf3d_trace_init(Uint32 maxEvents);
+
+/**
+ * @brief check if trace events are being recorded
+ * @return true if they are
+ */
+Bool gf3d_trace_enabled();
+
+/**
+ * @brief begin a timing zone
+ * @param name the zone name, see the note about name lifetime above
+ * @return the zone, pass it to gf3d_trace_end on the same thread
+ */
+TraceZone gf3d_trace_begin(const char *name);
+
+/**
+ * @brief end a timing zone and record it
+ * @param zone the zone returned by gf3d_trace_begin
+ */
+void gf3d_trace_end(TraceZone zone);
+
+/**
+ * @brief record a frame boundary marker
+ */
+void gf3d_trace_frame();
+
+/**
+ * @brief write the recorded events as Chrome trace JSON
+ * @param filename the file to write
+ * @return 1 on success, 0 on failure
+ */
+int gf3d_trace_dump(const char *filename);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __GF3D_TRACKER_H__
+#define __GF3D_TRACKER_H__
+
+#include <vulkan/vulkan.h>
+
+#include "gfc_types.h"
+
+/**
+ * @purpose a debug tracker for vulkan objects and device memory.  Every create and vkAllocateMemory is recorded with
+ * a tag and the file and line it came from, and every destroy and vkFreeMemory removes it again.
+ * Live and peak counts and bytes can be reported per category and per tag at any time, and anything still alive at
+ * shutdown is reported by call site as a leak.
+ * Turned on with "object_tracker" in the graphics config, when it is off the hooks return immediately
+ */
+
+typedef enum
+{
+    TC_Memory,              /**<vkAllocateMemory, the only category that always has a size*/
+    TC_Buffer,
+    TC_Image,
+    TC_ImageView,
+    TC_Sampler,
+    TC_DescriptorPool,
+    TC_DescriptorSetLayout,
+    TC_Pipeline,
+    TC_PipelineLayout,
+    TC_RenderPass,
+    TC_ShaderModule,
+    TC_Framebuffer,
+    TC_CommandPool,
+    TC_QueryPool,
+    TC_Semaphore,
+    TC_Fence,
+    TC_MAX
+}TrackerCategory;
+
+/**
+ * @brief record a vulkan object that was created
+ * @param category what kind of object it is
+ * @param handle the new object
+ * @param size how many bytes it uses, 0 if unknown or counted by the memory bound to it
+ * @param tag what it is for, must be a string literal or otherwise outlive the object
+ */
+#define gf3d_tracker_create(category,handle,size,tag) gf3d_tracker_create_at(category,(Uint64)(handle),size,tag,__FILE__,__LINE__)
+
+/**
+ * @brief record that a vulkan object is being destroyed
+ * @param category what kind of object it is
+ * @param handle the object, VK_NULL_HANDLE is ignored
+ */
+#define gf3d_tracker_destroy(category,handle) gf3d_tracker_destroy_at(category,(Uint64)(handle),__FILE__,__LINE__)
+
+/**
+ * @brief setup the tracker if it is turned on in the config, auto-cleaned up on program exit
+ * @param config the graphics config file, "object_tracker":true turns it on
+ * @note call before any vulkan objects are created, so the leak report runs after every other manager has closed
+ */
+void gf3d_tracker_init(const char *config);
+
+/**
+ * @brief check if the tracker is recording
+ * @return true if it is
+ */
+Bool gf3d_tracker_enabled();
+
+/**
+ * @brief use gf3d_tracker_create instead, it fills in the call site
+ */
+void gf3d_tracker_create_at(TrackerCategory category,Uint64 handle,VkDeviceSize size,const char *tag,const char *file,int line);
+
+/**
+ * @brief use gf3d_tracker_destroy instead, it fills in the call site
+ */
+void gf3d_tracker_destroy_at(TrackerCategory category,Uint64 handle,const char *file,int line);
+
+/**
+ * @brief get the live count and bytes for a category
+ * @param category which category
+ * @param bytes [output] optional, set to the live bytes
+ * @return how many objects of the category are alive
+ */
+Uint32 gf3d_tracker_get_live(TrackerCategory category,VkDeviceSize *bytes);
+
+/**
+ * @brief log live and peak counts and bytes for each category and the live count and bytes for each tag
+ * @param sites if true also log the live objects grouped by the call site that created them
+ */
+void gf3d_tracker_report(Bool sites);
+
+#endif
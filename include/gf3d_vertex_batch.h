@@ -0,0 +1,61 @@
+#ifndef __GF3D_VERTEX_BATCH_H__
+#define __GF3D_VERTEX_BATCH_H__
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_matrix.h"
+
+#include "gf3d_mesh.h"
+
+/**
+ * @purpose batch kernels for moving and measuring large vertex arrays.
+ * Uses AVX when compiled with -mavx, SSE on any x86_64 build and plain C everywhere else.
+ * Matrices are applied the same way as gfc_matrix4_v_multiply (row vector times matrix)
+ */
+
+/**
+ * @brief get the name of the kernel set that was compiled in
+ * @return "avx", "sse" or "scalar"
+ */
+const char *gf3d_vertex_batch_get_kernel_name();
+
+/**
+ * @brief transform vertices by a matrix.  Positions are transformed with w = 1, normals with w = 0 and texels are copied
+ * @param out where to write the transformed vertices, may be the same as in
+ * @param in the vertices to transform
+ * @param count how many vertices
+ * @param matrix the transform to apply
+ * @note normals are not re-normalized, so the matrix should not contain non-uniform scale
+ */
+void gf3d_vertex_batch_transform(Vertex *out,const Vertex *in,Uint32 count,GFC_Matrix4 matrix);
+
+/**
+ * @brief transform an array of points in place
+ * @param points the points to transform
+ * @param count how many points
+ * @param matrix the transform to apply
+ * @param w 1 for positions, 0 for directions
+ */
+void gf3d_vertex_batch_transform_points(GFC_Vector3D *points,Uint32 count,GFC_Matrix4 matrix,float w);
+
+/**
+ * @brief get the minimum and maximum of the vertex positions
+ * @param vertices the vertices to check
+ * @param count how many vertices
+ * @param min [output] the smallest x, y and z
+ * @param max [output] the largest x, y and z
+ * @note if count is zero, min and max are set to zero
+ */
+void gf3d_vertex_batch_bounds(const Vertex *vertices,Uint32 count,GFC_Vector3D *min,GFC_Vector3D *max);
+
+/**
+ * @brief get the minimum and maximum of an array of points
+ * @param points the points to check
+ * @param count how many points
+ * @param min [output] the smallest x, y and z
+ * @param max [output] the largest x, y and z
+ * @note if count is zero, min and max are set to zero
+ */
+void gf3d_vertex_batch_points_bounds(const GFC_Vector3D *points,Uint32 count,GFC_Vector3D *min,GFC_Vector3D *max);
+
+#endif
@@ -145,6 +145,15 @@ Command *gf3d_vgraphics_get_graphics_command_pool();
  */
 VkImageView gf3d_vgraphics_create_image_view(VkImage image, VkFormat format);
 
+/**
+ * @brief create an image view covering a mip chain
+ * @param image the image to create the view for
+ * @param format the format to create the view for
+ * @param mipLevels how many mip levels the image has
+ * @return VkNullHandle on error or an imageview handle otherwise
+ */
+VkImageView gf3d_vgraphics_create_image_view_mips(VkImage image, VkFormat format, Uint32 mipLevels);
+
 /**
  * @brief create an empty SDL_Surface in the format supported by the screen
  * @param w the width to create, should be non-zero
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 1, binding = 1) uniform sampler2D texSampler;
+
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec4 colorMod;
+layout(location = 3) in vec3 fragPosition;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    vec3 lightDir = normalize(vec3(0.5, 0.5, 1.0));
+    float light = max(dot(normalize(fragNormal), lightDir), 0.0) * 0.75 + 0.25;
+    vec4 texColor = texture(texSampler, fragTexCoord);
+    outColor = vec4(texColor.rgb * light, texColor.a) * colorMod;
+}
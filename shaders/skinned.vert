@@ -0,0 +1,61 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//shared by every draw this frame
+layout(set = 0, binding = 0) uniform FrameUBO
+{
+    mat4    view;
+    mat4    proj;
+    mat4    viewProj;
+    vec4    camera;
+    vec4    time;
+    vec4    resolution;
+} frame;
+
+//the data that changes with every draw
+layout(push_constant) uniform DrawConstants
+{
+    mat4    model;
+    vec4    color;
+    uint    jointBase;
+    uint    jointCount;
+    uvec2   padding;
+} draw;
+
+//joint palettes for every skinned draw this frame, draw.jointBase says where ours begins
+layout(std430, set = 1, binding = 2) readonly buffer JointPalette
+{
+    mat4    joints[];
+} palette;
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec4 inWeights;
+layout(location = 4) in uvec4 inJoints;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec4 colorMod;
+layout(location = 3) out vec3 fragPosition;
+
+void main()
+{
+    mat4 skin = inWeights.x * palette.joints[draw.jointBase + inJoints.x] +
+                inWeights.y * palette.joints[draw.jointBase + inJoints.y] +
+                inWeights.z * palette.joints[draw.jointBase + inJoints.z] +
+                inWeights.w * palette.joints[draw.jointBase + inJoints.w];
+    mat4 world = draw.model * skin;
+    vec4 position = world * vec4(inPosition, 1.0);
+
+    fragNormal = normalize(mat3(world) * inNormal);
+    fragTexCoord = inTexCoord;
+    fragPosition = position.xyz;
+    colorMod = draw.color;
+    gl_Position = frame.viewProj * position;
+}
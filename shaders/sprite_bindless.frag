@@ -0,0 +1,25 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform DrawConstants
+{
+    uint textureIndex;
+}draw;
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 colorMod;
+layout(location = 2) in float drawOrder;
+
+layout(location = 0) out vec4 outColor;
+
+
+void main()
+{
+    //the index is the same for the whole draw, so it needs no nonuniformEXT
+    vec4 texColor = texture(textures[draw.textureIndex], fragTexCoord);
+    outColor = texColor * colorMod;
+    gl_FragDepth = drawOrder;
+}
@@ -0,0 +1,471 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "simple_json.h"
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_vector.h"
+#include "gfc_matrix.h"
+#include "gfc_color.h"
+#include "gfc_pak.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_texture.h"
+#include "gf3d_obj_load.h"
+#include "gf3d_skin.h"
+#include "gf3d_stats.h"
+#include "gf3d_profiler.h"
+#include "gf2d_sprite.h"
+#include "gf2d_font.h"
+
+extern int __DEBUG;
+
+/**
+ * @purpose scripted benchmark scenes run through the full renderer for a fixed number of frames, with the results
+ * written as JSON: mean, p50 and p99 frame times, GPU times when the profiler is on, the gf3d_stats counters averaged
+ * per frame, and every frame time so runs can be compared.
+ * usage: bench [--config file] [--out file] [--scene name] [--frames count]
+ * config/bench.cfg is a graphics config with a hidden window and a "bench" block that sizes the scenes
+ */
+
+typedef struct
+{
+    const char *name;
+    int       (*setup)(SJson *bench);   /**<returns how many frames to run, 0 to use the configured count, -1 on failure*/
+    void      (*frame)(Uint32 frame);   /**<queue the draws for a frame*/
+    void      (*cleanup)();
+    Bool        warmup;                 /**<run warmup frames before recording*/
+}BenchScene;
+
+typedef struct
+{
+    SJson          *bench;          /**<the bench block of the config*/
+    Uint32          frames;
+    Uint32          warmup;
+    Uint32          random;         /**<scenes place things with this so every run is the same*/
+    Sprite        **sprites;
+    Uint32          spriteCount;
+    Uint32          spriteDraws;
+    Uint32          labels;
+    SkinnedMesh   **meshes;
+    Texture       **meshTextures;
+    Uint32          meshCount;
+    Uint32          meshDraws;
+    SJson          *images;         /**<image files for the asset load scene*/
+    SJson          *models;         /**<model files for the asset load scene*/
+}BenchData;
+
+static BenchData bench = {0};
+
+Uint32 bench_random()
+{
+    bench.random = bench.random * 1664525 + 1013904223;
+    return bench.random >> 8;
+}
+
+int bench_get_int(SJson *json,const char *key,int defaultValue)
+{
+    int value = defaultValue;
+    sj_get_integer_value(sj_object_get_value(json,key),&value);
+    return value;
+}
+
+/**
+ * sprites: a few thousand sprites a frame drawn from every configured image
+ */
+
+int bench_sprites_setup(SJson *config)
+{
+    int i,c;
+    SJson *images;
+    const char *filename;
+    images = sj_object_get_value(config,"images");
+    c = sj_array_get_count(images);
+    if (!c)return -1;
+    bench.sprites = gfc_allocate_array(sizeof(Sprite *),c);
+    if (!bench.sprites)return -1;
+    for (i = 0; i < c; i++)
+    {
+        filename = sj_get_string_value(sj_array_get_nth(images,i));
+        if (!filename)continue;
+        bench.sprites[bench.spriteCount] = gf2d_sprite_load_image(filename);
+        if (bench.sprites[bench.spriteCount])bench.spriteCount++;
+    }
+    bench.spriteDraws = bench_get_int(config,"sprites",4000);
+    return bench.spriteCount?0:-1;
+}
+
+void bench_sprites_frame(Uint32 frame)
+{
+    Uint32 i;
+    float scale;
+    Sprite *sprite;
+    GFC_Vector2D position,scaleTo;
+    GFC_Vector2D resolution = gf3d_vgraphics_get_resolution();
+    bench.random = 1;
+    for (i = 0; i < bench.spriteDraws; i++)
+    {
+        sprite = bench.sprites[i % bench.spriteCount];
+        //everything is drawn about 64 pixels across so large images do not make it a fill rate test
+        scale = 64.0 / MAX(MAX(sprite->frameWidth,sprite->frameHeight),1);
+        scaleTo = gfc_vector2d(scale,scale);
+        position.x = (bench_random() + frame * 3) % (Uint32)MAX(resolution.x,1);
+        position.y = bench_random() % (Uint32)MAX(resolution.y,1);
+        gf2d_sprite_draw(sprite,position,&scaleTo,NULL,NULL,NULL,NULL,NULL,0);
+    }
+}
+
+void bench_sprites_cleanup()
+{
+    Uint32 i;
+    for (i = 0; i < bench.spriteCount; i++)
+    {
+        gf2d_sprite_free(bench.sprites[i]);
+    }
+    free(bench.sprites);
+    bench.sprites = NULL;
+    bench.spriteCount = 0;
+}
+
+/**
+ * labels: text that changes every frame, so every line is a new text image
+ */
+
+int bench_labels_setup(SJson *config)
+{
+    bench.labels = bench_get_int(config,"labels",200);
+    return 0;
+}
+
+void bench_labels_frame(Uint32 frame)
+{
+    Uint32 i;
+    char text[64];
+    GFC_Vector2D resolution = gf3d_vgraphics_get_resolution();
+    gf2d_font_update();
+    for (i = 0; i < bench.labels; i++)
+    {
+        snprintf(text,sizeof(text),"label %i: frame %i",i,frame);
+        gf2d_font_draw_line_tag(text,FT_H6,GFC_COLOR_WHITE,gfc_vector2d((i / 30) * 180 % (int)MAX(resolution.x,1),(i % 30) * 22));
+    }
+}
+
+void bench_labels_cleanup()
+{
+    bench.labels = 0;
+}
+
+/**
+ * meshes: the same mesh drawn many times through the skinned pipeline, sharing one palette
+ */
+
+SkinnedMesh *bench_mesh_load(const char *objFile)
+{
+    ObjData *obj;
+    SkinnedMesh *mesh;
+    obj = gf3d_obj_load_from_file(objFile);
+    if (!obj)return NULL;
+    mesh = gf3d_skin_mesh_from_obj(obj);
+    gf3d_obj_free(obj);
+    return mesh;
+}
+
+int bench_meshes_setup(SJson *config)
+{
+    const char *filename;
+    bench.meshes = gfc_allocate_array(sizeof(SkinnedMesh *),1);
+    bench.meshTextures = gfc_allocate_array(sizeof(Texture *),1);
+    if ((!bench.meshes)||(!bench.meshTextures))return -1;
+    filename = sj_get_string_value(sj_object_get_value(config,"mesh"));
+    if (!filename)return -1;
+    bench.meshes[0] = bench_mesh_load(filename);
+    if (!bench.meshes[0])return -1;
+    filename = sj_get_string_value(sj_object_get_value(config,"mesh_texture"));
+    if (filename)bench.meshTextures[0] = gf3d_texture_load(filename);
+    bench.meshCount = 1;
+    bench.meshDraws = bench_get_int(config,"meshes",500);
+    return 0;
+}
+
+void bench_meshes_frame(Uint32 frame)
+{
+    Uint32 i,jointBase = 0;
+    GFC_Matrix4 palette,modelMat;
+    gfc_matrix4_identity(palette);
+    if (!gf3d_skin_upload_palette(&palette,1,&jointBase))return;
+    for (i = 0; i < bench.meshDraws; i++)
+    {
+        gfc_matrix4_identity(modelMat);
+        modelMat[3][0] = (float)(i % 25) * 3 - 36;
+        modelMat[3][1] = (float)((i / 25) % 20) * 3 - 28;
+        modelMat[3][2] = -60 - (float)(i / 500) * 3;
+        gf3d_skin_draw_palette(bench.meshes[0],modelMat,GFC_COLOR_WHITE,jointBase,bench.meshTextures[0]);
+    }
+}
+
+void bench_meshes_cleanup()
+{
+    Uint32 i;
+    for (i = 0; i < bench.meshCount; i++)
+    {
+        gf3d_skin_mesh_free(bench.meshes[i]);
+        gf3d_texture_free(bench.meshTextures[i]);
+    }
+    free(bench.meshes);
+    free(bench.meshTextures);
+    bench.meshes = NULL;
+    bench.meshTextures = NULL;
+    bench.meshCount = 0;
+}
+
+/**
+ * assets: one frame per asset, loading every configured image and model cold
+ */
+
+int bench_assets_setup(SJson *config)
+{
+    int c;
+    bench.images = sj_object_get_value(config,"images");
+    bench.models = sj_object_get_value(config,"models");
+    c = sj_array_get_count(bench.images) + sj_array_get_count(bench.models);
+    if (!c)return -1;
+    bench.sprites = gfc_allocate_array(sizeof(Sprite *),c);
+    bench.meshes = gfc_allocate_array(sizeof(SkinnedMesh *),c);
+    bench.meshTextures = gfc_allocate_array(sizeof(Texture *),c);
+    if ((!bench.sprites)||(!bench.meshes)||(!bench.meshTextures))return -1;
+    return c;
+}
+
+void bench_assets_load_model(const char *filename)
+{
+    SJson *json,*model;
+    const char *file;
+    json = gfc_pak_load_json(filename);
+    if (!json)return;
+    model = sj_object_get_value(json,"model");
+    file = sj_get_string_value(sj_object_get_value(model,"obj"));
+    if (file)bench.meshes[bench.meshCount] = bench_mesh_load(file);
+    file = sj_get_string_value(sj_object_get_value(model,"texture"));
+    if (file)bench.meshTextures[bench.meshCount] = gf3d_texture_load(file);
+    bench.meshCount++;
+    sj_free(json);
+}
+
+void bench_assets_frame(Uint32 frame)
+{
+    const char *filename;
+    GFC_Matrix4 modelMat;
+    Uint32 imageCount = sj_array_get_count(bench.images);
+    if (frame >= imageCount)
+    {
+        filename = sj_get_string_value(sj_array_get_nth(bench.models,frame - imageCount));
+        if (!filename)return;
+        bench_assets_load_model(filename);
+        gfc_matrix4_identity(modelMat);
+        modelMat[3][2] = -20;
+        if (bench.meshes[bench.meshCount - 1])
+        {
+            gf3d_skin_draw(bench.meshes[bench.meshCount - 1],modelMat,GFC_COLOR_WHITE,&modelMat,1,bench.meshTextures[bench.meshCount - 1]);
+        }
+        return;
+    }
+    filename = sj_get_string_value(sj_array_get_nth(bench.images,frame));
+    if (!filename)return;
+    bench.sprites[bench.spriteCount] = gf2d_sprite_load_image(filename);
+    if (!bench.sprites[bench.spriteCount])return;
+    gf2d_sprite_draw_image(bench.sprites[bench.spriteCount],gfc_vector2d(0,0));
+    bench.spriteCount++;
+}
+
+void bench_assets_cleanup()
+{
+    bench_sprites_cleanup();
+    bench_meshes_cleanup();
+    bench.images = NULL;
+    bench.models = NULL;
+}
+
+static BenchScene bench_scenes[] =
+{
+    {"sprites",bench_sprites_setup,bench_sprites_frame,bench_sprites_cleanup,1},
+    {"labels",bench_labels_setup,bench_labels_frame,bench_labels_cleanup,1},
+    {"meshes",bench_meshes_setup,bench_meshes_frame,bench_meshes_cleanup,1},
+    {"assets",bench_assets_setup,bench_assets_frame,bench_assets_cleanup,0},
+    {NULL}
+};
+
+/**
+ * running and reporting
+ */
+
+int bench_compare_float(const void *a,const void *b)
+{
+    float fa = *(const float *)a,fb = *(const float *)b;
+    if (fa < fb)return -1;
+    if (fa > fb)return 1;
+    return 0;
+}
+
+/**
+ * @brief mean, p50 and p99 (nearest rank) of a set of samples
+ */
+SJson *bench_summary_json(float *samples,Uint32 count)
+{
+    Uint32 i;
+    double sum = 0;
+    float *sorted;
+    SJson *json;
+    json = sj_object_new();
+    if ((!json)||(!count))return json;
+    sorted = gfc_allocate_array(sizeof(float),count);
+    if (!sorted)return json;
+    memcpy(sorted,samples,sizeof(float) * count);
+    qsort(sorted,count,sizeof(float),bench_compare_float);
+    for (i = 0; i < count; i++)sum += sorted[i];
+    sj_object_insert(json,"mean",sj_new_float(sum / count));
+    sj_object_insert(json,"p50",sj_new_float(sorted[(count - 1) / 2]));
+    sj_object_insert(json,"p99",sj_new_float(sorted[MIN((Uint32)(count * 0.99),count - 1)]));
+    sj_object_insert(json,"min",sj_new_float(sorted[0]));
+    sj_object_insert(json,"max",sj_new_float(sorted[count - 1]));
+    free(sorted);
+    return json;
+}
+
+void bench_render_frame(BenchScene *scene,Uint32 frame)
+{
+    SDL_PumpEvents();
+    gf3d_vgraphics_render_start();
+    scene->frame(frame);
+    gf3d_vgraphics_render_end();
+}
+
+SJson *bench_run_scene(BenchScene *scene)
+{
+    int frames;
+    Uint32 i,c;
+    float *frameMs,*gpuMs;
+    double counters[SC_MAX] = {0},stallMs = 0;
+    const FrameStats *stats;
+    SJson *json,*counterJson,*samples;
+
+    frames = scene->setup(bench.bench);
+    if (frames < 0)
+    {
+        slog("bench scene %s failed to setup, skipping",scene->name);
+        printf("%s: setup failed, skipped\n",scene->name);
+        scene->cleanup();
+        return NULL;
+    }
+    if (!frames)frames = bench.frames;
+    frameMs = gfc_allocate_array(sizeof(float),frames);
+    gpuMs = gfc_allocate_array(sizeof(float),frames);
+    if ((!frameMs)||(!gpuMs))
+    {
+        scene->cleanup();
+        return NULL;
+    }
+    for (i = 0; (scene->warmup)&&(i < bench.warmup); i++)
+    {
+        bench_render_frame(scene,i);
+    }
+    for (i = 0; i < frames; i++)
+    {
+        bench_render_frame(scene,i);
+        stats = gf3d_stats_get();
+        frameMs[i] = stats->frameMs;
+        gpuMs[i] = gf3d_profiler_get_frame_ms();
+        for (c = 0; c < SC_MAX; c++)counters[c] += stats->counters[c];
+        stallMs += stats->stallMs;
+    }
+    vkDeviceWaitIdle(gf3d_vgraphics_get_default_logical_device());
+    stats = gf3d_stats_get();
+
+    json = sj_object_new();
+    sj_object_insert(json,"name",sj_new_str(scene->name));
+    sj_object_insert(json,"frames",sj_new_int(frames));
+    sj_object_insert(json,"frame_ms",bench_summary_json(frameMs,frames));
+    if (gf3d_profiler_enabled())sj_object_insert(json,"gpu_ms",bench_summary_json(gpuMs,frames));
+    counterJson = sj_object_new();
+    sj_object_insert(counterJson,"draw_calls",sj_new_float(counters[SC_DrawCalls] / frames));
+    sj_object_insert(counterJson,"binds",sj_new_float(counters[SC_Binds] / frames));
+    sj_object_insert(counterJson,"descriptor_writes",sj_new_float(counters[SC_DescriptorWrites] / frames));
+    sj_object_insert(counterJson,"staging_bytes",sj_new_float(counters[SC_StagingBytes] / frames));
+    sj_object_insert(counterJson,"single_time_submits",sj_new_float(counters[SC_SingleTimeSubmits] / frames));
+    sj_object_insert(counterJson,"stall_ms",sj_new_float(stallMs / frames));
+    sj_object_insert(counterJson,"textures",sj_new_int(stats->textures));
+    sj_object_insert(counterJson,"sprites",sj_new_int(stats->sprites));
+    sj_object_insert(counterJson,"meshes",sj_new_int(stats->meshes));
+    sj_object_insert(json,"counters_per_frame",counterJson);
+    samples = sj_array_new();
+    for (i = 0; i < frames; i++)
+    {
+        sj_array_append(samples,sj_new_float(frameMs[i]));
+    }
+    sj_object_insert(json,"samples",samples);
+
+    printf("%-10s %6i frames  draws %8.1f  staged %10.0fB\n",
+        scene->name,frames,counters[SC_DrawCalls] / frames,counters[SC_StagingBytes] / frames);
+    free(frameMs);
+    free(gpuMs);
+    scene->cleanup();
+    return json;
+}
+
+int main(int argc,char *argv[])
+{
+    int a;
+    BenchScene *scene;
+    const char *config = "config/bench.cfg";
+    const char *out = "bench_results.json";
+    const char *only = NULL;
+    int frames = 0;
+    SJson *json,*results,*result;
+
+    for (a = 1; a < argc; a++)
+    {
+        if ((strcmp(argv[a],"--config") == 0)&&(a + 1 < argc))config = argv[++a];
+        else if ((strcmp(argv[a],"--out") == 0)&&(a + 1 < argc))out = argv[++a];
+        else if ((strcmp(argv[a],"--scene") == 0)&&(a + 1 < argc))only = argv[++a];
+        else if ((strcmp(argv[a],"--frames") == 0)&&(a + 1 < argc))frames = atoi(argv[++a]);
+        else if (strcmp(argv[a],"--debug") == 0)__DEBUG = 1;
+    }
+    init_logger("bench.log",0);
+    json = gfc_pak_load_json(config);
+    if (!json)
+    {
+        printf("failed to load bench config %s\n",config);
+        return 1;
+    }
+    bench.bench = sj_object_get_value(json,"bench");
+    bench.frames = frames?frames:bench_get_int(bench.bench,"frames",300);
+    bench.warmup = bench_get_int(bench.bench,"warmup",30);
+    if (!bench.frames)bench.frames = 1;
+
+    gf3d_vgraphics_init(config);
+    gf2d_font_init("config/font.cfg");
+    gf3d_skin_init(MAX(bench_get_int(bench.bench,"meshes",500),1),64,NULL);
+
+    results = sj_array_new();
+    for (scene = bench_scenes; scene->name; scene++)
+    {
+        if ((only)&&(strcmp(only,scene->name) != 0))continue;
+        result = bench_run_scene(scene);
+        if (result)sj_array_append(results,result);
+    }
+    sj_free(json);
+    json = sj_object_new();
+    sj_object_insert(json,"config",sj_new_str(config));
+    sj_object_insert(json,"scenes",results);
+    sj_save(json,out);
+    sj_free(json);
+    printf("results written to %s\n",out);
+    slog("bench complete, results in %s",out);
+    exit(0);
+    return 0;
+}
+
+/*eol@eof*/
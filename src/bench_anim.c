@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <math.h>
+
+#include <SDL.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_matrix.h"
+
+#include "gf3d_animation.h"
+
+/**
+ * @purpose measure how many characters per millisecond can be sampled and skinned, simd against scalar
+ * usage: bench_anim [gltf file] [characters] [frames]
+ * without a file (or if it fails to load) a synthetic 64 joint skeleton is animated instead
+ */
+
+#define SYNTHETIC_JOINTS 64
+#define SYNTHETIC_KEYS 30
+
+double bench_seconds(Uint64 start,Uint64 end)
+{
+    return (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief a binary tree of joints with a translation, rotation and scale track on each one
+ */
+AnimationSet *bench_synthetic_set()
+{
+    Uint32 j,k,c,t;
+    float angle,*cursor;
+    AnimationSet *set;
+    AnimationClip *clip;
+    AnimationTrack *track;
+    set = gfc_allocate_array(sizeof(AnimationSet),1);
+    if (!set)return NULL;
+    gfc_line_cpy(set->filename,"synthetic");
+    set->skeleton = gf3d_animation_skeleton_new(SYNTHETIC_JOINTS);
+    set->clips = gfc_list_new();
+    clip = gf3d_animation_clip_new(SYNTHETIC_JOINTS * 3,SYNTHETIC_KEYS + SYNTHETIC_JOINTS * SYNTHETIC_KEYS * 10);
+    if ((!set->skeleton)||(!clip))
+    {
+        gf3d_animation_clip_free(clip);
+        gf3d_animation_set_free(set);
+        return NULL;
+    }
+    for (j = 1; j < SYNTHETIC_JOINTS; j++)
+    {
+        set->skeleton->parent[j] = (j - 1) / 2;
+        set->skeleton->rest[j * AC_MAX + AC_TY] = 1;
+    }
+    gfc_line_cpy(clip->name,"wave");
+    clip->duration = (SYNTHETIC_KEYS - 1) / 30.0;
+    cursor = clip->data;
+    for (k = 0; k < SYNTHETIC_KEYS; k++)cursor[k] = k / 30.0;
+    cursor += SYNTHETIC_KEYS;
+    for (j = 0,t = 0; j < SYNTHETIC_JOINTS; j++)
+    {
+        for (c = 0; c < 3; c++,t++)
+        {
+            track = &clip->tracks[t];
+            track->joint = j;
+            track->path = (c == 0)?AP_Translation:(c == 1)?AP_Rotation:AP_Scale;
+            track->keyCount = SYNTHETIC_KEYS;
+            track->times = clip->data;
+            track->values = cursor;
+            for (k = 0; k < SYNTHETIC_KEYS; k++)
+            {
+                angle = (k + j) * 0.2;
+                if (track->path == AP_Rotation)
+                {
+                    cursor[k] = sinf(angle * 0.5) * 0.577;
+                    cursor[SYNTHETIC_KEYS + k] = sinf(angle * 0.5) * 0.577;
+                    cursor[SYNTHETIC_KEYS * 2 + k] = sinf(angle * 0.5) * 0.577;
+                    cursor[SYNTHETIC_KEYS * 3 + k] = cosf(angle * 0.5);
+                }
+                else if (track->path == AP_Scale)
+                {
+                    cursor[k] = cursor[SYNTHETIC_KEYS + k] = cursor[SYNTHETIC_KEYS * 2 + k] = 1 + sinf(angle) * 0.1;
+                }
+                else
+                {
+                    cursor[k] = sinf(angle) * 0.1;
+                    cursor[SYNTHETIC_KEYS + k] = 1;
+                    cursor[SYNTHETIC_KEYS * 2 + k] = cosf(angle) * 0.1;
+                }
+            }
+            cursor += SYNTHETIC_KEYS * ((track->path == AP_Rotation)?4:3);
+        }
+    }
+    gfc_list_append(set->clips,clip);
+    return set;
+}
+
+/**
+ * @brief sample and build palettes for every character for a number of frames
+ * @return seconds taken
+ */
+double bench_run(AnimationSet *set,AnimationClip *clip,AnimationPoseBatch *batch,float *times,GFC_Matrix4 **palettes,Uint32 characters,Uint32 frames)
+{
+    Uint32 f,i;
+    Uint64 start,end;
+    start = SDL_GetPerformanceCounter();
+    for (f = 0; f < frames; f++)
+    {
+        for (i = 0; i < characters; i++)
+        {
+            //every character is at a different point in the clip
+            times[i] = (f / 60.0) + (i * 0.037);
+        }
+        gf3d_animation_sample_batch(clip,set->skeleton,batch,0,characters,times,1);
+        gf3d_animation_build_palettes(set->skeleton,batch,0,characters,palettes);
+    }
+    end = SDL_GetPerformanceCounter();
+    return bench_seconds(start,end);
+}
+
+int main(int argc,char *argv[])
+{
+    const char *filename = NULL;
+    Uint32 characters = 1000,frames = 100;
+    Uint32 i,j,r,c,jointCount;
+    AnimationSet *set = NULL;
+    AnimationClip *clip;
+    AnimationPoseBatch *batch;
+    float *times;
+    GFC_Matrix4 **palettes,**reference;
+    double simdTime,scalarTime,diff,maxDiff = 0;
+
+    if (argc > 1)filename = argv[1];
+    if (argc > 2)characters = atoi(argv[2]);
+    if (argc > 3)frames = atoi(argv[3]);
+    if (!characters)characters = 1;
+    if (!frames)frames = 1;
+    init_logger("bench_anim.log",0);
+
+    if (filename)set = gf3d_animation_set_load(filename);
+    clip = gf3d_animation_set_get_clip_by_index(set,0);
+    if (!clip)
+    {
+        if (filename)printf("no animation in %s, using a synthetic skeleton\n",filename);
+        gf3d_animation_set_free(set);
+        set = bench_synthetic_set();
+        clip = gf3d_animation_set_get_clip_by_index(set,0);
+        if (!clip)
+        {
+            printf("failed to build the synthetic skeleton\n");
+            return 1;
+        }
+    }
+    jointCount = set->skeleton->jointCount;
+    batch = gf3d_animation_pose_batch_new(set->skeleton,characters);
+    times = gfc_allocate_array(sizeof(float),characters);
+    palettes = gfc_allocate_array(sizeof(GFC_Matrix4 *),characters);
+    reference = gfc_allocate_array(sizeof(GFC_Matrix4 *),characters);
+    if ((!batch)||(!times)||(!palettes)||(!reference))return 1;
+    for (i = 0; i < characters; i++)
+    {
+        palettes[i] = gfc_allocate_array(sizeof(GFC_Matrix4),jointCount);
+        reference[i] = gfc_allocate_array(sizeof(GFC_Matrix4),jointCount);
+        if ((!palettes[i])||(!reference[i]))return 1;
+    }
+
+    gf3d_animation_set_simd(0);
+    scalarTime = bench_run(set,clip,batch,times,reference,characters,frames);
+    gf3d_animation_set_simd(1);
+    simdTime = bench_run(set,clip,batch,times,palettes,characters,frames);
+
+    //both runs finish on the same frame so the palettes should agree
+    for (i = 0; i < characters; i++)
+    {
+        for (j = 0; j < jointCount; j++)
+        {
+            for (r = 0; r < 4; r++)
+            {
+                for (c = 0; c < 4; c++)
+                {
+                    diff = fabs(palettes[i][j][r][c] - reference[i][j][r][c]);
+                    if (diff > maxDiff)maxDiff = diff;
+                }
+            }
+        }
+    }
+
+    printf("%s: clip '%s', %i joints, %i tracks, %i characters, %i frames\n",set->filename,clip->name,jointCount,clip->trackCount,characters,frames);
+    printf("%-8s %12s %14s %16s\n","kernel","total ms","ms/frame","characters/ms");
+    printf("%-8s %12.3f %14.4f %16.1f\n","scalar",scalarTime * 1000,scalarTime * 1000 / frames,(characters * frames) / MAX(scalarTime * 1000,0.000001));
+    printf("%-8s %12.3f %14.4f %16.1f\n",gf3d_animation_get_kernel_name(),simdTime * 1000,simdTime * 1000 / frames,(characters * frames) / MAX(simdTime * 1000,0.000001));
+    printf("speedup: %.2fx, max palette difference: %g\n",scalarTime / MAX(simdTime,0.000001),maxDiff);
+    slog("anim bench %s: scalar %fms, %s %fms, max difference %g",set->filename,scalarTime * 1000,gf3d_animation_get_kernel_name(),simdTime * 1000,maxDiff);
+
+    for (i = 0; i < characters; i++)
+    {
+        free(palettes[i]);
+        free(reference[i]);
+    }
+    free(palettes);
+    free(reference);
+    free(times);
+    gf3d_animation_pose_batch_free(batch);
+    gf3d_animation_set_free(set);
+    return 0;
+}
+/*eol@eof*/
@@ -0,0 +1,113 @@
+#include <stdio.h>
+
+#include <SDL.h>
+
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+#include "gfc_matrix.h"
+#include "gfc_primitives.h"
+
+#include "gf3d_obj_load.h"
+#include "gf3d_obj_bvh.h"
+
+/**
+ * @purpose compare gf3d_obj_edge_test against the old linear scan on a real mesh
+ * usage: bench_bvh [obj file] [query count]
+ */
+
+double bench_seconds(Uint64 start,Uint64 end)
+{
+    return (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+float bench_random_range(float min,float max)
+{
+    return min + gfc_random() * (max - min);
+}
+
+int main(int argc,char *argv[])
+{
+    const char *filename = "models/dino/dino.obj";
+    Uint32 queryCount = 10000;
+    Uint32 i,linearHits = 0,bvhHits = 0,batchHits,mismatches = 0;
+    ObjData *obj;
+    GFC_Edge3D *edges;
+    Uint8 *hits;
+    GFC_Vector3D min,max,contact;
+    GFC_Matrix4 offset;
+    Uint64 start,end;
+    double buildTime,linearTime,bvhTime,batchTime;
+
+    if (argc > 1)filename = argv[1];
+    if (argc > 2)queryCount = atoi(argv[2]);
+    init_logger("bench_bvh.log",0);
+
+    obj = gf3d_obj_load_from_file(filename);
+    if ((!obj)||(!obj->face_count))
+    {
+        printf("failed to load %s\n",filename);
+        return 1;
+    }
+    edges = gfc_allocate_array(sizeof(GFC_Edge3D),queryCount);
+    hits = gfc_allocate_array(sizeof(Uint8),queryCount);
+    if ((!edges)||(!hits))return 1;
+
+    //random probes through the volume of the model, the same every run
+    min = gfc_vector3d(obj->bounds.x,obj->bounds.y,obj->bounds.z);
+    max = gfc_vector3d(obj->bounds.x + obj->bounds.w,obj->bounds.y + obj->bounds.h,obj->bounds.z + obj->bounds.d);
+    srand(1);
+    for (i = 0; i < queryCount; i++)
+    {
+        edges[i].a = gfc_vector3d(bench_random_range(min.x,max.x),bench_random_range(min.y,max.y),bench_random_range(min.z,max.z));
+        edges[i].b = gfc_vector3d(bench_random_range(min.x,max.x),bench_random_range(min.y,max.y),bench_random_range(min.z,max.z));
+    }
+    gfc_matrix4_identity(offset);
+
+    start = SDL_GetPerformanceCounter();
+    gf3d_obj_build_bvh(obj);
+    end = SDL_GetPerformanceCounter();
+    buildTime = bench_seconds(start,end);
+    if (!obj->bvh)
+    {
+        printf("failed to build bvh for %s\n",filename);
+        return 1;
+    }
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < queryCount; i++)
+    {
+        hits[i] = gf3d_obj_edge_test_linear(obj,offset,edges[i],&contact);
+        linearHits += hits[i];
+    }
+    end = SDL_GetPerformanceCounter();
+    linearTime = bench_seconds(start,end);
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < queryCount; i++)
+    {
+        if (gf3d_obj_edge_test(obj,offset,edges[i],&contact) != hits[i])mismatches++;
+        bvhHits += gf3d_obj_edge_test(obj,offset,edges[i],NULL);
+    }
+    end = SDL_GetPerformanceCounter();
+    bvhTime = bench_seconds(start,end) * 0.5;//every query ran twice
+
+    start = SDL_GetPerformanceCounter();
+    batchHits = gf3d_obj_edge_test_batch(obj,offset,edges,queryCount,hits,NULL);
+    end = SDL_GetPerformanceCounter();
+    batchTime = bench_seconds(start,end);
+
+    printf("%s: %i triangles, %i bvh nodes, built in %.3fms\n",filename,obj->face_count,obj->bvh->nodeCount,buildTime * 1000);
+    printf("%-8s %10s %12s %10s\n","method","hits","total ms","us/query");
+    printf("%-8s %10i %12.3f %10.3f\n","linear",linearHits,linearTime * 1000,linearTime * 1000000 / queryCount);
+    printf("%-8s %10i %12.3f %10.3f\n","bvh",bvhHits,bvhTime * 1000,bvhTime * 1000000 / queryCount);
+    printf("%-8s %10i %12.3f %10.3f\n","batch",batchHits,batchTime * 1000,batchTime * 1000000 / queryCount);
+    printf("speedup: %.1fx, hit/miss mismatches: %i\n",linearTime / MAX(bvhTime,0.000001),mismatches);
+    slog("bvh bench %s: linear %fms, bvh %fms, batch %fms, mismatches %i",filename,linearTime * 1000,bvhTime * 1000,batchTime * 1000,mismatches);
+
+    free(edges);
+    free(hits);
+    gf3d_obj_free(obj);
+    return 0;
+}
+/*eol@eof*/
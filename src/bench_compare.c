@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simple_json.h"
+#include "simple_logger.h"
+
+#include "gfc_types.h"
+
+/**
+ * @purpose compare two bench result files scene by scene and fail when frame times regress.
+ * usage: bench_compare <baseline.json> <candidate.json> [--p50 percent] [--p99 percent] [--alpha value]
+ * A p50 regression needs the median to be slower by more than the p50 threshold and a one sided Mann-Whitney U
+ * test over the per frame samples to say the candidate is slower at the alpha level.
+ * A p99 regression needs the 99th percentile to be slower by more than the p99 threshold and the candidate to have
+ * more frames over the baseline p99 than a 1% tail could produce by chance (binomial test at the same alpha).
+ * Exits 0 if nothing regressed, 1 if a scene regressed or is missing from the candidate, 2 on bad input
+ */
+
+typedef struct
+{
+    const char *name;
+    float      *samples;    /**<sorted frame times*/
+    Uint32      count;
+}BenchSamples;
+
+int bench_compare_float(const void *a,const void *b)
+{
+    float fa = *(const float *)a,fb = *(const float *)b;
+    if (fa < fb)return -1;
+    if (fa > fb)return 1;
+    return 0;
+}
+
+/**
+ * @brief read the frame time samples for a scene, sorted
+ * @return 0 if the scene has no samples
+ */
+int bench_samples_load(SJson *scene,BenchSamples *out)
+{
+    Uint32 i,c;
+    SJson *samples;
+    memset(out,0,sizeof(BenchSamples));
+    out->name = sj_get_string_value(sj_object_get_value(scene,"name"));
+    samples = sj_object_get_value(scene,"samples");
+    c = sj_array_get_count(samples);
+    if ((!out->name)||(!c))return 0;
+    out->samples = gfc_allocate_array(sizeof(float),c);
+    if (!out->samples)return 0;
+    for (i = 0; i < c; i++)
+    {
+        if (!sj_get_float_value(sj_array_get_nth(samples,i),&out->samples[out->count]))continue;
+        out->count++;
+    }
+    if (!out->count)
+    {
+        free(out->samples);
+        out->samples = NULL;
+        return 0;
+    }
+    qsort(out->samples,out->count,sizeof(float),bench_compare_float);
+    return 1;
+}
+
+float bench_percentile(BenchSamples *samples,float percent)
+{
+    Uint32 rank;
+    rank = (Uint32)ceil(percent * samples->count / 100.0);
+    if (rank)rank--;
+    return samples->samples[MIN(rank,samples->count - 1)];
+}
+
+double bench_normal_upper(double z)
+{
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+/**
+ * @brief one sided Mann-Whitney U test that candidate frame times are larger than the baseline's
+ * @note uses the normal approximation with a tie correction, fine for the hundreds of frames a scene runs
+ * @return the p value
+ */
+double bench_mann_whitney(BenchSamples *base,BenchSamples *cand)
+{
+    Uint32 i = 0,j = 0,k,ties;
+    double rank = 1,rankSum = 0,tieSum = 0;
+    double n1 = cand->count,n2 = base->count,n = n1 + n2;
+    double u,mean,variance;
+    float value;
+    //both are sorted, so merge them and hand out average ranks to each run of equal values
+    while ((i < base->count)||(j < cand->count))
+    {
+        if ((j >= cand->count)||((i < base->count)&&(base->samples[i] < cand->samples[j])))value = base->samples[i];
+        else value = cand->samples[j];
+        ties = 0;
+        k = 0;
+        while ((i < base->count)&&(base->samples[i] == value)){i++;ties++;}
+        while ((j < cand->count)&&(cand->samples[j] == value)){j++;ties++;k++;}
+        rankSum += k * (rank + (ties - 1) / 2.0);
+        rank += ties;
+        tieSum += (double)ties * ties * ties - ties;
+    }
+    u = rankSum - n1 * (n1 + 1) / 2.0;
+    mean = n1 * n2 / 2.0;
+    variance = (n1 * n2 / 12.0) * ((n + 1) - tieSum / (n * (n - 1)));
+    if (variance <= 0)return 1;
+    return bench_normal_upper((u - mean - 0.5) / sqrt(variance));
+}
+
+/**
+ * @brief chance of at least count of n frames landing over a percentile that only fraction of frames should exceed
+ * @return the p value
+ */
+double bench_binomial_upper(Uint32 count,Uint32 n,double fraction)
+{
+    Uint32 k;
+    double p = 0;
+    if (!count)return 1;
+    for (k = count; k <= n; k++)
+    {
+        p += exp(lgamma(n + 1) - lgamma(k + 1) - lgamma(n - k + 1) + k * log(fraction) + (n - k) * log(1 - fraction));
+    }
+    return MIN(p,1);
+}
+
+Uint32 bench_count_over(BenchSamples *samples,float limit)
+{
+    Uint32 i;
+    for (i = 0; i < samples->count; i++)
+    {
+        if (samples->samples[i] > limit)return samples->count - i;
+    }
+    return 0;
+}
+
+SJson *bench_find_scene(SJson *scenes,const char *name)
+{
+    int i,c;
+    SJson *scene;
+    const char *sceneName;
+    c = sj_array_get_count(scenes);
+    for (i = 0; i < c; i++)
+    {
+        scene = sj_array_get_nth(scenes,i);
+        sceneName = sj_get_string_value(sj_object_get_value(scene,"name"));
+        if ((sceneName)&&(strcmp(sceneName,name) == 0))return scene;
+    }
+    return NULL;
+}
+
+double bench_delta(float base,float cand)
+{
+    if (base <= 0)return 0;
+    return (cand - base) * 100.0 / base;
+}
+
+int main(int argc,char *argv[])
+{
+    int a,i,c;
+    int failures = 0;
+    const char *files[2] = {NULL,NULL};
+    int fileCount = 0;
+    float p50Threshold = 5,p99Threshold = 10,alpha = 0.01;
+    float baseP50,candP50,baseP99,candP99;
+    double pShift,pTail;
+    Bool p50Regressed,p99Regressed;
+    SJson *base,*cand,*baseScenes,*candScenes,*candScene;
+    BenchSamples baseSamples,candSamples;
+
+    for (a = 1; a < argc; a++)
+    {
+        if ((strcmp(argv[a],"--p50") == 0)&&(a + 1 < argc))p50Threshold = atof(argv[++a]);
+        else if ((strcmp(argv[a],"--p99") == 0)&&(a + 1 < argc))p99Threshold = atof(argv[++a]);
+        else if ((strcmp(argv[a],"--alpha") == 0)&&(a + 1 < argc))alpha = atof(argv[++a]);
+        else if (fileCount < 2)files[fileCount++] = argv[a];
+    }
+    if (fileCount < 2)
+    {
+        printf("usage: bench_compare <baseline.json> <candidate.json> [--p50 percent] [--p99 percent] [--alpha value]\n");
+        return 2;
+    }
+    init_logger("bench_compare.log",0);
+    base = sj_load(files[0]);
+    cand = sj_load(files[1]);
+    baseScenes = sj_object_get_value(base,"scenes");
+    candScenes = sj_object_get_value(cand,"scenes");
+    if ((!baseScenes)||(!candScenes))
+    {
+        printf("failed to load bench results from %s and %s\n",files[0],files[1]);
+        sj_free(base);
+        sj_free(cand);
+        return 2;
+    }
+
+    printf("baseline:  %s\ncandidate: %s\n",files[0],files[1]);
+    printf("thresholds: p50 +%.1f%%, p99 +%.1f%%, alpha %g\n\n",p50Threshold,p99Threshold,alpha);
+    printf("%-10s %9s %9s %8s %9s %9s %8s %9s %9s  %s\n",
+        "scene","base p50","cand p50","delta","base p99","cand p99","delta","p shift","p tail","result");
+    c = sj_array_get_count(baseScenes);
+    for (i = 0; i < c; i++)
+    {
+        if (!bench_samples_load(sj_array_get_nth(baseScenes,i),&baseSamples))continue;
+        candScene = bench_find_scene(candScenes,baseSamples.name);
+        if ((!candScene)||(!bench_samples_load(candScene,&candSamples)))
+        {
+            printf("%-10s missing from candidate  FAIL\n",baseSamples.name);
+            failures++;
+            free(baseSamples.samples);
+            continue;
+        }
+        baseP50 = bench_percentile(&baseSamples,50);
+        candP50 = bench_percentile(&candSamples,50);
+        baseP99 = bench_percentile(&baseSamples,99);
+        candP99 = bench_percentile(&candSamples,99);
+        pShift = bench_mann_whitney(&baseSamples,&candSamples);
+        pTail = bench_binomial_upper(bench_count_over(&candSamples,baseP99),candSamples.count,0.01);
+        p50Regressed = (bench_delta(baseP50,candP50) > p50Threshold)&&(pShift < alpha);
+        p99Regressed = (bench_delta(baseP99,candP99) > p99Threshold)&&(pTail < alpha);
+        if ((p50Regressed)||(p99Regressed))failures++;
+        printf("%-10s %9.3f %9.3f %+7.1f%% %9.3f %9.3f %+7.1f%% %9.2g %9.2g  %s\n",
+            baseSamples.name,
+            baseP50,candP50,bench_delta(baseP50,candP50),
+            baseP99,candP99,bench_delta(baseP99,candP99),
+            pShift,pTail,
+            (p50Regressed && p99Regressed)?"FAIL p50 p99":p50Regressed?"FAIL p50":p99Regressed?"FAIL p99":"ok");
+        free(baseSamples.samples);
+        free(candSamples.samples);
+    }
+    sj_free(base);
+    sj_free(cand);
+    if (failures)
+    {
+        printf("\n%i scene(s) regressed\n",failures);
+        slog("bench_compare: %i scene(s) regressed between %s and %s",failures,files[0],files[1]);
+        return 1;
+    }
+    printf("\nno regressions\n");
+    return 0;
+}
+
+/*eol@eof*/
@@ -15,20 +15,44 @@
 #include "gf2d_font.h"
 #include "gf2d_actor.h"
 #include "gf2d_mouse.h"
+#include "gf2d_perf_overlay.h"
 
 #include "gf3d_vgraphics.h"
 #include "gf3d_pipeline.h"
 #include "gf3d_swapchain.h"
+#include "gf3d_trace.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
+#include "gf3d_frame_pacer.h"
+#include "gf3d_frame_ubo.h"
+#include "gf3d_latency.h"
 
 extern int __DEBUG;
 
 static int _done = 0;
-static Uint32 frame_delay = 33;
 static float fps = 0;
+static int _trace = 0;
+static int _stats = 0;
+static int _lateLatch = 0;
+static int _latency = 0;
 
 void parse_arguments(int argc,char *argv[]);
 void game_frame_delay();
 
+/**
+ * @brief mouse look with the right button held, applied to the view just before the frame's draws are submitted
+ * @note only draws that read the frame UBO see it, and this demo only draws 2D, so it is there to hook up a 3D scene
+ */
+void game_late_latch(GFC_Matrix4 view,void *data)
+{
+    GFC_Vector2D movement;
+    gf2d_mouse_resample();
+    if (!gf2d_mouse_button_state(2))return;
+    movement = gf2d_mouse_get_movement();
+    if (!movement.x)return;
+    gfc_matrix4_rotate(view,view,movement.x * 0.005,gfc_vector3d(0,0,1));
+}
+
 void exitGame()
 {
     _done = 1;
@@ -39,10 +63,14 @@ int main(int argc,char *argv[])
 {
     //local variables
     Sprite *bg;
+    TraceZone zone;
+    Uint32 statsTicks = 0;
+    Uint32 latencyTicks = 0;
     //initializtion    
     parse_arguments(argc,argv);
     init_logger("gf3d.log",0);
     slog("gf3d begin");
+    if (_trace)gf3d_trace_init(1 << 16);
     //gfc init
     gfc_input_init("config/input.cfg");
     gfc_config_def_init();
@@ -51,6 +79,10 @@ int main(int argc,char *argv[])
     gf3d_vgraphics_init("config/setup.cfg");
     gf2d_font_init("config/font.cfg");
     gf2d_actor_init(1000);
+    gf2d_perf_overlay_init(FT_H6,250);
+    if (_stats)gf3d_stats_csv_open("gf3d_stats.csv");
+    if (_lateLatch)gf3d_frame_ubo_set_late_latch(game_late_latch,NULL);
+    if (_latency)gf3d_latency_init(1024);
     
     //game init
     srand(SDL_GetTicks());
@@ -60,20 +92,40 @@ int main(int argc,char *argv[])
     // main game loop    
     while(!_done)
     {
+        zone = gf3d_trace_begin("input_update");
         gfc_input_update();
+        gf3d_trace_end(zone);
         gf2d_mouse_update();
+        gf3d_latency_mark_input();
+        zone = gf3d_trace_begin("font_update");
         gf2d_font_update();
+        gf3d_trace_end(zone);
         //camera updaes
         gf3d_vgraphics_render_start();
                 //2D draws
                 gf2d_sprite_draw_image(bg,gfc_vector2d(0,0));
                 gf2d_font_draw_line_tag("ALT+F4 to exit",FT_H1,GFC_COLOR_WHITE, gfc_vector2d(10,10));
+                gf2d_perf_overlay_draw();
                 gf2d_mouse_draw();
         gf3d_vgraphics_render_end();
         if (gfc_input_command_down("exit"))_done = 1; // exit condition
+        if (gfc_input_command_pressed("perf_overlay"))gf2d_perf_overlay_toggle();
+        if (gfc_input_command_pressed("trace_dump"))gf3d_trace_dump("gf3d_trace.json");
+        if (gfc_input_command_pressed("tracker_report"))gf3d_tracker_report(0);
+        if ((_stats)&&(SDL_GetTicks() - statsTicks >= 1000))
+        {
+            gf3d_stats_log();
+            statsTicks = SDL_GetTicks();
+        }
+        if ((_latency)&&(SDL_GetTicks() - latencyTicks >= 5000))
+        {
+            gf3d_latency_report();
+            latencyTicks = SDL_GetTicks();
+        }
         game_frame_delay();
     }    
     vkDeviceWaitIdle(gf3d_vgraphics_get_default_logical_device());    
+    if (_trace)gf3d_trace_dump("gf3d_trace.json");
     //cleanup
     slog("gf3d program end");
     exit(0);
@@ -91,23 +143,30 @@ void parse_arguments(int argc,char *argv[])
         {
             __DEBUG = 1;
         }
+        else if (strcmp(argv[a],"--trace") == 0)
+        {
+            _trace = 1;
+        }
+        else if (strcmp(argv[a],"--stats") == 0)
+        {
+            _stats = 1;
+        }
+        else if (strcmp(argv[a],"--latelatch") == 0)
+        {
+            _lateLatch = 1;
+        }
+        else if (strcmp(argv[a],"--latency") == 0)
+        {
+            _latency = 1;
+        }
     }    
 }
 
 void game_frame_delay()
 {
-    Uint32 diff;
-    static Uint32 now;
-    static Uint32 then;
-    then = now;
     slog_sync();// make sure logs get written when we have time to write it
-    now = SDL_GetTicks();
-    diff = (now - then);
-    if (diff < frame_delay)
-    {
-        SDL_Delay(frame_delay - diff);
-    }
-    fps = 1000.0/MAX(SDL_GetTicks() - then,0.001);
+    gf3d_frame_pacer_wait();
+    fps = gf3d_frame_pacer_get_fps();
 //     slog("fps: %f",fps);
 }
 /*eol@eof*/
@@ -6,13 +6,16 @@
 #include "gfc_config.h"
 #include "gfc_pak.h"
 
+#include "gf3d_registry.h"
+#include "gf3d_pool.h"
+
 #include "gf2d_actor.h"
 
 
 typedef struct
 {
-    Uint32 maxActors;
-    Actor * actorList;
+    Pool  * actorPool;
+    Registry *actorNames;   /**<loaded actors by filename*/
 }ActorManager;
 
 static ActorManager actor_manager = {0};
@@ -22,12 +25,10 @@ void gf2d_actor_clear_all();
 void gf2d_actor_close()
 {
     gf2d_actor_clear_all();
-    if (actor_manager.actorList != NULL)
-    {
-        free(actor_manager.actorList);
-    }
-    actor_manager.actorList = NULL;
-    actor_manager.maxActors = 0;
+    gf3d_pool_free(actor_manager.actorPool);
+    actor_manager.actorPool = NULL;
+    gf3d_registry_free(actor_manager.actorNames);
+    actor_manager.actorNames = NULL;
 }
 
 void gf2d_actor_init(Uint32 max)
@@ -37,17 +38,19 @@ void gf2d_actor_init(Uint32 max)
         slog("cannot intialize actor manager for Zero actors!");
         return;
     }
-    actor_manager.maxActors = max;
-    actor_manager.actorList = (Actor *)gfc_allocate_array(sizeof(Actor),max);
+    actor_manager.actorPool = gf3d_pool_new(sizeof(Actor),max,0);
+    actor_manager.actorNames = gf3d_registry_new(max);
     atexit(gf2d_actor_close);
 }
 
 void gf2d_actor_delete(Actor *actor)
 {
     if (!actor)return;
+    if (actor->filename[0])gf3d_registry_remove(actor_manager.actorNames,actor->filename,actor);
     gfc_action_list_free(actor->al);
     if (actor->sprite)gf2d_sprite_free(actor->sprite);
     memset(actor,0,sizeof(Actor));
+    gf3d_pool_release(actor_manager.actorPool,actor);
 }
 
 void gf2d_actor_free(Actor *actor)
@@ -58,56 +61,46 @@ void gf2d_actor_free(Actor *actor)
 
 void gf2d_actor_clear_all()
 {
-    int i;
-    for (i = 0;i < actor_manager.maxActors;i++)
+    Uint32 i,c;
+    c = gf3d_pool_get_capacity(actor_manager.actorPool);
+    for (i = 0;i < c;i++)
     {
-        gf2d_actor_delete(&actor_manager.actorList[i]);// clean up the data
+        gf2d_actor_delete(gf3d_pool_get_nth(actor_manager.actorPool,i));// clean up the data
     }
 }
 
 Actor *gf2d_actor_new()
 {
-    int i;
-    /*search for an unused actor address*/
-    for (i = 0;i < actor_manager.maxActors;i++)
+    Uint32 i,c;
+    Actor *actor;
+    /*before the pool grows, clean up the actors that are no longer referenced*/
+    if (!gf3d_pool_get_free_count(actor_manager.actorPool))
     {
-        if ((actor_manager.actorList[i]._refCount == 0)&&(actor_manager.actorList[i].al == NULL))
+        c = gf3d_pool_get_capacity(actor_manager.actorPool);
+        for (i = 0;i < c;i++)
         {
-            actor_manager.actorList[i]._refCount = 1;//set ref count
-            actor_manager.actorList[i].al = gfc_action_list_new();
-            return &actor_manager.actorList[i];//return address of this array element        }
+            actor = gf3d_pool_get_nth(actor_manager.actorPool,i);
+            if ((actor)&&(actor->_refCount == 0))gf2d_actor_delete(actor);
         }
     }
-    /*find an unused actor address and clean up the old data*/
-    for (i = 0;i < actor_manager.maxActors;i++)
+    actor = gf3d_pool_alloc(actor_manager.actorPool);
+    if (!actor)
     {
-        if (actor_manager.actorList[i]._refCount == 0)
-        {
-            gf2d_actor_delete(&actor_manager.actorList[i]);// clean up the old data
-            actor_manager.actorList[i]._refCount = 1;//set ref count
-            actor_manager.actorList[i].al = gfc_action_list_new();
-            return &actor_manager.actorList[i];//return address of this array element
-        }
+        slog("error: out of actor addresses");
+        return NULL;
     }
-    slog("error: out of actor addresses");
-    return NULL;
+    actor->_refCount = 1;//set ref count
+    actor->al = gfc_action_list_new();
+    return actor;
 }
 
 Actor *gf2d_actor_get_by_filename(const char * filename)
 {
-    int i;
     if (!filename)
     {
         return NULL;
     }
-    for (i = 0;i < actor_manager.maxActors;i++)
-    {
-        if (gfc_line_cmp(actor_manager.actorList[i].filename,filename)==0)
-        {
-            return &actor_manager.actorList[i];
-        }
-    }
-    return NULL;// not found
+    return gf3d_registry_get(actor_manager.actorNames,filename);
 }
 
 SJson *gf2d_actor_to_json(Actor *actor)
@@ -201,6 +194,7 @@ Actor *gf2d_actor_load_image(const char *file)
         return NULL;
     }
     gfc_line_cpy(actor->filename,file);
+    gf3d_registry_insert(actor_manager.actorNames,actor->filename,actor);
     actor->sprite = sprite;
     gfc_line_cpy(actor->spriteFile,file);
     actor->frameWidth = sprite->frameWidth;
@@ -240,6 +234,7 @@ Actor *gf2d_actor_load(const char *file)
         sj_free(json);
         if (!actor)return NULL;
         gfc_line_cpy(actor->filename,file);
+        gf3d_registry_insert(actor_manager.actorNames,actor->filename,actor);
         return actor;
     }
     // if it failed to load as json, then lets try it as a flat image
@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf2d_atlas.h"
+
+#define ATLAS_PADDING 1     /**<border copied from the image edge so linear filtering does not pick up neighbors*/
+
+typedef struct
+{
+    Uint32  x,y;            /**<left edge and height of this part of the skyline*/
+    Uint32  width;
+}SkylineNode;
+
+typedef struct
+{
+    Texture        *texture;
+    SkylineNode    *nodes;
+    Uint32          nodeCount;
+    Uint32          imageCount;     /**<images still using the page*/
+}AtlasPage;
+
+typedef struct
+{
+    AtlasPage  *pages;
+    Uint32      pageCount;
+    Uint32      maxPages;
+    Uint32      pageSize;
+    Uint32      maxImageSize;
+}SpriteAtlas;
+
+extern int __DEBUG;
+static SpriteAtlas gf2d_atlas = {0};
+
+void gf2d_atlas_close()
+{
+    Uint32 i;
+    for (i = 0; i < gf2d_atlas.pageCount; i++)
+    {
+        gf3d_texture_free(gf2d_atlas.pages[i].texture);
+        if (gf2d_atlas.pages[i].nodes)free(gf2d_atlas.pages[i].nodes);
+    }
+    if (gf2d_atlas.pages)free(gf2d_atlas.pages);
+    if (__DEBUG)slog("sprite atlas closed");
+    memset(&gf2d_atlas,0,sizeof(SpriteAtlas));
+}
+
+void gf2d_atlas_init(Uint32 pageSize,Uint32 maxImageSize,Uint32 maxPages)
+{
+    if ((!pageSize)||(!maxPages))
+    {
+        slog("sprite atlas disabled");
+        return;
+    }
+    gf2d_atlas.pages = gfc_allocate_array(sizeof(AtlasPage),maxPages);
+    if (!gf2d_atlas.pages)
+    {
+        slog("failed to allocate sprite atlas pages");
+        return;
+    }
+    gf2d_atlas.maxPages = maxPages;
+    gf2d_atlas.pageSize = pageSize;
+    gf2d_atlas.maxImageSize = MIN(maxImageSize,pageSize - ATLAS_PADDING * 2);
+    atexit(gf2d_atlas_close);
+    if (__DEBUG)slog("sprite atlas initialized for %i pages of %ix%i",maxPages,pageSize,pageSize);
+}
+
+int gf2d_atlas_accepts(Uint32 width,Uint32 height)
+{
+    if (!gf2d_atlas.maxPages)return 0;
+    return (width <= gf2d_atlas.maxImageSize)&&(height <= gf2d_atlas.maxImageSize);
+}
+
+Uint32 gf2d_atlas_get_page_count()
+{
+    return gf2d_atlas.pageCount;
+}
+
+void gf2d_atlas_skyline_reset(AtlasPage *page)
+{
+    page->nodes[0].x = 0;
+    page->nodes[0].y = 0;
+    page->nodes[0].width = gf2d_atlas.pageSize;
+    page->nodeCount = 1;
+}
+
+/**
+ * @brief find how high a rect would sit if its left edge was placed at a node
+ * @return 0 if it does not fit there, 1 otherwise with y set
+ */
+int gf2d_atlas_skyline_fit(AtlasPage *page,Uint32 index,Uint32 width,Uint32 height,Uint32 *y)
+{
+    Uint32 x = page->nodes[index].x;
+    Uint32 top = 0;
+    Sint32 remaining = width;
+    if (x + width > gf2d_atlas.pageSize)return 0;
+    //rest on the highest part of the skyline the rect spans
+    while (remaining > 0)
+    {
+        if (index >= page->nodeCount)return 0;
+        top = MAX(top,page->nodes[index].y);
+        if (top + height > gf2d_atlas.pageSize)return 0;
+        remaining -= (Sint32)page->nodes[index].width;
+        index++;
+    }
+    *y = top;
+    return 1;
+}
+
+/**
+ * @brief raise the skyline under a newly placed rect
+ */
+void gf2d_atlas_skyline_place(AtlasPage *page,Uint32 index,Uint32 x,Uint32 y,Uint32 width,Uint32 height)
+{
+    Uint32 i,shrink;
+    memmove(&page->nodes[index + 1],&page->nodes[index],sizeof(SkylineNode) * (page->nodeCount - index));
+    page->nodes[index].x = x;
+    page->nodes[index].y = y + height;
+    page->nodes[index].width = width;
+    page->nodeCount++;
+    //trim the nodes now covered by the new one
+    for (i = index + 1; i < page->nodeCount;)
+    {
+        if (page->nodes[i].x >= x + width)break;
+        shrink = x + width - page->nodes[i].x;
+        if (shrink < page->nodes[i].width)
+        {
+            page->nodes[i].x += shrink;
+            page->nodes[i].width -= shrink;
+            break;
+        }
+        memmove(&page->nodes[i],&page->nodes[i + 1],sizeof(SkylineNode) * (page->nodeCount - i - 1));
+        page->nodeCount--;
+    }
+    //join neighbors at the same height
+    for (i = 0; i + 1 < page->nodeCount;)
+    {
+        if (page->nodes[i].y == page->nodes[i + 1].y)
+        {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            memmove(&page->nodes[i + 1],&page->nodes[i + 2],sizeof(SkylineNode) * (page->nodeCount - i - 2));
+            page->nodeCount--;
+        }
+        else i++;
+    }
+}
+
+/**
+ * @brief find room for a rect in a page, lowest top edge first then narrowest node
+ * @return 0 if there is no room, 1 otherwise with x and y set
+ */
+int gf2d_atlas_skyline_insert(AtlasPage *page,Uint32 width,Uint32 height,Uint32 *x,Uint32 *y)
+{
+    Uint32 i,top;
+    Uint32 best = page->nodeCount;
+    Uint32 bestTop = 0,bestWidth = 0,bestY = 0;
+    for (i = 0; i < page->nodeCount; i++)
+    {
+        if (!gf2d_atlas_skyline_fit(page,i,width,height,&top))continue;
+        if ((best == page->nodeCount)||(top + height < bestTop)||
+            ((top + height == bestTop)&&(page->nodes[i].width < bestWidth)))
+        {
+            best = i;
+            bestTop = top + height;
+            bestWidth = page->nodes[i].width;
+            bestY = top;
+        }
+    }
+    if (best == page->nodeCount)return 0;
+    *x = page->nodes[best].x;
+    *y = bestY;
+    gf2d_atlas_skyline_place(page,best,*x,bestY,width,height);
+    return 1;
+}
+
+AtlasPage *gf2d_atlas_new_page()
+{
+    AtlasPage *page;
+    SDL_Surface *surface;
+    if (gf2d_atlas.pageCount >= gf2d_atlas.maxPages)return NULL;
+    page = &gf2d_atlas.pages[gf2d_atlas.pageCount];
+    //a skyline never has more nodes than the page is wide
+    page->nodes = gfc_allocate_array(sizeof(SkylineNode),gf2d_atlas.pageSize + 1);
+    if (!page->nodes)return NULL;
+    surface = SDL_CreateRGBSurfaceWithFormat(0,gf2d_atlas.pageSize,gf2d_atlas.pageSize,32,SDL_PIXELFORMAT_RGBA32);
+    if (!surface)
+    {
+        slog("failed to make atlas page surface: %s",SDL_GetError());
+        free(page->nodes);
+        page->nodes = NULL;
+        return NULL;
+    }
+    SDL_FillRect(surface,NULL,0);
+    page->texture = gf3d_texture_convert_surface_flags(surface,TF_NoMips);
+    if (!page->texture)
+    {
+        free(page->nodes);
+        page->nodes = NULL;
+        return NULL;
+    }
+    gf3d_texture_set_sampler(page->texture,SP_Sprite);
+    gf2d_atlas_skyline_reset(page);
+    gf2d_atlas.pageCount++;
+    if (__DEBUG)slog("made sprite atlas page %i",gf2d_atlas.pageCount);
+    return page;
+}
+
+/**
+ * @brief copy an image into a new surface with its edge pixels repeated around it
+ */
+SDL_Surface *gf2d_atlas_pad_surface(SDL_Surface *surface)
+{
+    int i,j,row;
+    Uint32 *src,*dst;
+    SDL_Surface *padded;
+    padded = SDL_CreateRGBSurfaceWithFormat(0,surface->w + ATLAS_PADDING * 2,surface->h + ATLAS_PADDING * 2,32,surface->format->format);
+    if (!padded)return NULL;
+    SDL_LockSurface(surface);
+    SDL_LockSurface(padded);
+    for (j = 0; j < padded->h; j++)
+    {
+        row = MIN(MAX(j - ATLAS_PADDING,0),surface->h - 1);
+        src = (Uint32 *)((Uint8 *)surface->pixels + row * surface->pitch);
+        dst = (Uint32 *)((Uint8 *)padded->pixels + j * padded->pitch);
+        memcpy(&dst[ATLAS_PADDING],src,surface->w * 4);
+        for (i = 0; i < ATLAS_PADDING; i++)
+        {
+            dst[i] = src[0];
+            dst[padded->w - 1 - i] = src[surface->w - 1];
+        }
+    }
+    SDL_UnlockSurface(padded);
+    SDL_UnlockSurface(surface);
+    return padded;
+}
+
+Texture *gf2d_atlas_add(SDL_Surface *surface,GFC_Vector2D *offset)
+{
+    Uint32 i,x = 0,y = 0;
+    AtlasPage *page = NULL;
+    SDL_Surface *padded;
+    if ((!surface)||(!offset))return NULL;
+    if ((surface->format->BytesPerPixel != 4)||(!gf2d_atlas_accepts(surface->w,surface->h)))return NULL;
+    for (i = 0; i < gf2d_atlas.pageCount; i++)
+    {
+        if (gf2d_atlas_skyline_insert(&gf2d_atlas.pages[i],surface->w + ATLAS_PADDING * 2,surface->h + ATLAS_PADDING * 2,&x,&y))
+        {
+            page = &gf2d_atlas.pages[i];
+            break;
+        }
+    }
+    if (!page)
+    {
+        page = gf2d_atlas_new_page();
+        if (!page)return NULL;
+        if (!gf2d_atlas_skyline_insert(page,surface->w + ATLAS_PADDING * 2,surface->h + ATLAS_PADDING * 2,&x,&y))return NULL;
+    }
+    padded = gf2d_atlas_pad_surface(surface);
+    if (!padded)return NULL;
+    if (!gf3d_texture_update_region(page->texture,padded,x,y))
+    {
+        SDL_FreeSurface(padded);
+        return NULL;
+    }
+    SDL_FreeSurface(padded);
+    offset->x = x + ATLAS_PADDING;
+    offset->y = y + ATLAS_PADDING;
+    page->imageCount++;
+    page->texture->_refcount++;
+    return page->texture;
+}
+
+void gf2d_atlas_release(Texture *page)
+{
+    Uint32 i;
+    if (!page)return;
+    for (i = 0; i < gf2d_atlas.pageCount; i++)
+    {
+        if (gf2d_atlas.pages[i].texture != page)continue;
+        if (!gf2d_atlas.pages[i].imageCount)return;
+        gf2d_atlas.pages[i].imageCount--;
+        //packed space is only reused once the whole page is empty
+        if (!gf2d_atlas.pages[i].imageCount)gf2d_atlas_skyline_reset(&gf2d_atlas.pages[i]);
+        return;
+    }
+}
+
+/*eol@eof*/
@@ -382,7 +382,6 @@ void gf2d_font_draw_line(char *text,Font *font,GFC_Color color, GFC_Vector2D pos
     if (!sprite)
     {
         slog("cannot draw text '%s', failed to make overlay sprite",text);
-        SDL_FreeSurface(surface);
         return;
     }
     gf2d_sprite_draw_full(
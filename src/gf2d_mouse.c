@@ -60,6 +60,14 @@ void gf2d_mouse_update()
     gfc_vector2d_set(_mouse.mouse[0].position,x,y);
 }
 
+void gf2d_mouse_resample()
+{
+    int x,y;
+    SDL_PumpEvents();
+    _mouse.mouse[0].buttons = SDL_GetMouseState(&x,&y);
+    gfc_vector2d_set(_mouse.mouse[0].position,x,y);
+}
+
 void gf2d_mouse_draw()
 {
     if (_mouse.hidden)return;
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gfc_color.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_texture.h"
+#include "gf3d_stats.h"
+#include "gf3d_profiler.h"
+#include "gf2d_sprite.h"
+#include "gf2d_perf_overlay.h"
+
+#define OVERLAY_GLYPH_FIRST     32
+#define OVERLAY_GLYPH_COUNT     95      /**<printable ascii*/
+#define OVERLAY_HISTORY         150     /**<frames shown in the graph, two pixels each*/
+#define OVERLAY_MARGIN          8
+#define OVERLAY_GRAPH_HEIGHT    80
+#define OVERLAY_BAR_HEIGHT      6
+#define OVERLAY_TEXT_LINES      4
+
+typedef struct
+{
+    SDL_Surface    *image;      /**<white, tinted when it is blitted*/
+    int             advance;
+}OverlayGlyph;
+
+typedef struct
+{
+    Bool            shown;
+    Uint32          refreshMs;
+    Uint32          lastRefresh;
+    OverlayGlyph    glyphs[OVERLAY_GLYPH_COUNT];
+    int             lineHeight;
+    SDL_Surface    *canvas;     /**<the sprite's kept surface, the overlay is painted here then streamed to the gpu*/
+    Sprite         *sprite;
+    float           cpuMs[OVERLAY_HISTORY];
+    float           gpuMs[OVERLAY_HISTORY];
+    Uint32          historyIndex;
+    Uint32          lastFrame;  /**<stats frame last sampled*/
+}PerfOverlay;
+
+extern int __DEBUG;
+static PerfOverlay gf2d_perf_overlay = {0};
+
+void gf2d_perf_overlay_close()
+{
+    int i;
+    for (i = 0; i < OVERLAY_GLYPH_COUNT; i++)
+    {
+        if (gf2d_perf_overlay.glyphs[i].image)SDL_FreeSurface(gf2d_perf_overlay.glyphs[i].image);
+    }
+    //the canvas belongs to the sprite's texture
+    gf2d_sprite_free(gf2d_perf_overlay.sprite);
+    memset(&gf2d_perf_overlay,0,sizeof(PerfOverlay));
+    if (__DEBUG)slog("performance overlay closed");
+}
+
+void gf2d_perf_overlay_init(FontTypes fontTag,Uint32 refreshMs)
+{
+    int i,minx,maxx,miny,maxy;
+    int width,height;
+    Font *font;
+    SDL_Surface *glyph;
+    SDL_Color white = {255,255,255,255};
+    font = gf2d_font_get_by_tag(fontTag);
+    if ((!font)||(!font->font))
+    {
+        slog("no font loaded for the performance overlay");
+        return;
+    }
+    atexit(gf2d_perf_overlay_close);
+    gf2d_perf_overlay.refreshMs = refreshMs;
+    gf2d_perf_overlay.lineHeight = TTF_FontHeight(font->font);
+    width = OVERLAY_HISTORY * 2 + OVERLAY_MARGIN * 2;
+    height = OVERLAY_MARGIN * 2 + OVERLAY_GRAPH_HEIGHT + OVERLAY_MARGIN
+        + (OVERLAY_TEXT_LINES * gf2d_perf_overlay.lineHeight)
+        + (gf3d_stats_get()->heapCount * (gf2d_perf_overlay.lineHeight + OVERLAY_BAR_HEIGHT));
+    gf2d_perf_overlay.sprite = gf2d_sprite_from_surface(gf3d_vgraphics_create_surface(width,height),0,0,0);
+    if ((!gf2d_perf_overlay.sprite)||(!gf2d_perf_overlay.sprite->texture->surface))
+    {
+        slog("failed to create performance overlay image");
+        return;
+    }
+    gf2d_perf_overlay.canvas = gf2d_perf_overlay.sprite->texture->surface;
+    //glyphs are rendered once, so changing numbers never make new text images
+    for (i = 0; i < OVERLAY_GLYPH_COUNT; i++)
+    {
+        if (TTF_GlyphMetrics(font->font,OVERLAY_GLYPH_FIRST + i,&minx,&maxx,&miny,&maxy,&gf2d_perf_overlay.glyphs[i].advance) != 0)continue;
+        glyph = TTF_RenderGlyph_Blended(font->font,OVERLAY_GLYPH_FIRST + i,white);
+        if (!glyph)continue;
+        gf2d_perf_overlay.glyphs[i].image = SDL_ConvertSurface(glyph,gf2d_perf_overlay.canvas->format,0);
+        SDL_FreeSurface(glyph);
+        if (gf2d_perf_overlay.glyphs[i].image)SDL_SetSurfaceBlendMode(gf2d_perf_overlay.glyphs[i].image,SDL_BLENDMODE_BLEND);
+    }
+    if (__DEBUG)slog("performance overlay initialized at %ix%i",width,height);
+}
+
+void gf2d_perf_overlay_toggle()
+{
+    gf2d_perf_overlay.shown = !gf2d_perf_overlay.shown;
+    //repaint as soon as it is shown rather than showing stale numbers
+    if (gf2d_perf_overlay.shown)gf2d_perf_overlay.lastRefresh = 0;
+}
+
+Bool gf2d_perf_overlay_shown()
+{
+    return gf2d_perf_overlay.shown;
+}
+
+void gf2d_perf_overlay_fill(int x,int y,int w,int h,Uint8 r,Uint8 g,Uint8 b,Uint8 a)
+{
+    SDL_Rect rect;
+    rect.x = x;
+    rect.y = y;
+    rect.w = w;
+    rect.h = h;
+    SDL_FillRect(gf2d_perf_overlay.canvas,&rect,SDL_MapRGBA(gf2d_perf_overlay.canvas->format,r,g,b,a));
+}
+
+int gf2d_perf_overlay_text(const char *text,int x,int y,Uint8 r,Uint8 g,Uint8 b)
+{
+    int index;
+    SDL_Rect target;
+    OverlayGlyph *glyph;
+    for (;*text;text++)
+    {
+        index = (unsigned char)*text - OVERLAY_GLYPH_FIRST;
+        if ((index < 0)||(index >= OVERLAY_GLYPH_COUNT))continue;
+        glyph = &gf2d_perf_overlay.glyphs[index];
+        if (glyph->image)
+        {
+            target.x = x;
+            target.y = y;
+            target.w = glyph->image->w;
+            target.h = glyph->image->h;
+            SDL_SetSurfaceColorMod(glyph->image,r,g,b);
+            SDL_BlitSurface(glyph->image,NULL,gf2d_perf_overlay.canvas,&target);
+        }
+        x += glyph->advance;
+    }
+    return x;
+}
+
+void gf2d_perf_overlay_sample()
+{
+    const FrameStats *stats;
+    stats = gf3d_stats_get();
+    if (stats->frame == gf2d_perf_overlay.lastFrame)return;
+    gf2d_perf_overlay.lastFrame = stats->frame;
+    gf2d_perf_overlay.cpuMs[gf2d_perf_overlay.historyIndex] = stats->frameMs;
+    gf2d_perf_overlay.gpuMs[gf2d_perf_overlay.historyIndex] = gf3d_profiler_enabled()?gf3d_profiler_get_frame_ms():0;
+    gf2d_perf_overlay.historyIndex = (gf2d_perf_overlay.historyIndex + 1) % OVERLAY_HISTORY;
+}
+
+void gf2d_perf_overlay_paint_graph(int x,int y)
+{
+    int i,index,h;
+    float scale,top = 33.3;
+    for (i = 0; i < OVERLAY_HISTORY; i++)
+    {
+        top = MAX(top,gf2d_perf_overlay.cpuMs[i]);
+        top = MAX(top,gf2d_perf_overlay.gpuMs[i]);
+    }
+    scale = OVERLAY_GRAPH_HEIGHT / top;
+    gf2d_perf_overlay_fill(x,y,OVERLAY_HISTORY * 2,OVERLAY_GRAPH_HEIGHT,24,24,24,220);
+    //60 and 30 fps lines
+    gf2d_perf_overlay_fill(x,y + OVERLAY_GRAPH_HEIGHT - (int)(16.7 * scale),OVERLAY_HISTORY * 2,1,80,80,80,255);
+    gf2d_perf_overlay_fill(x,y + OVERLAY_GRAPH_HEIGHT - (int)(33.3 * scale),OVERLAY_HISTORY * 2,1,80,80,80,255);
+    for (i = 0; i < OVERLAY_HISTORY; i++)
+    {
+        //oldest on the left
+        index = (gf2d_perf_overlay.historyIndex + i) % OVERLAY_HISTORY;
+        h = MIN((int)(gf2d_perf_overlay.cpuMs[index] * scale),OVERLAY_GRAPH_HEIGHT);
+        if (h > 0)gf2d_perf_overlay_fill(x + i * 2,y + OVERLAY_GRAPH_HEIGHT - h,2,h,60,200,90,255);
+        //gpu time is drawn over the cpu bar, it is almost always the shorter one
+        h = MIN((int)(gf2d_perf_overlay.gpuMs[index] * scale),OVERLAY_GRAPH_HEIGHT);
+        if (h > 0)gf2d_perf_overlay_fill(x + i * 2,y + OVERLAY_GRAPH_HEIGHT - h,2,h,240,150,40,255);
+    }
+}
+
+void gf2d_perf_overlay_paint()
+{
+    Uint32 i;
+    int x,y,w;
+    char line[128];
+    float cpuMs,gpuMs;
+    const FrameStats *stats;
+    stats = gf3d_stats_get();
+    i = (gf2d_perf_overlay.historyIndex + OVERLAY_HISTORY - 1) % OVERLAY_HISTORY;
+    cpuMs = gf2d_perf_overlay.cpuMs[i];
+    gpuMs = gf2d_perf_overlay.gpuMs[i];
+
+    SDL_FillRect(gf2d_perf_overlay.canvas,NULL,SDL_MapRGBA(gf2d_perf_overlay.canvas->format,0,0,0,170));
+    x = OVERLAY_MARGIN;
+    y = OVERLAY_MARGIN;
+    gf2d_perf_overlay_paint_graph(x,y);
+    y += OVERLAY_GRAPH_HEIGHT + OVERLAY_MARGIN;
+
+    snprintf(line,sizeof(line),"cpu %.2fms (%.0f fps)",cpuMs,cpuMs > 0?1000.0 / cpuMs:0);
+    w = gf2d_perf_overlay_text(line,x,y,60,200,90);
+    if (gf3d_profiler_enabled())
+    {
+        snprintf(line,sizeof(line),"  gpu %.2fms",gpuMs);
+        gf2d_perf_overlay_text(line,w,y,240,150,40);
+    }
+    y += gf2d_perf_overlay.lineHeight;
+    snprintf(line,sizeof(line),"draws %lu  binds %lu  writes %lu",
+        (unsigned long)stats->counters[SC_DrawCalls],
+        (unsigned long)stats->counters[SC_Binds],
+        (unsigned long)stats->counters[SC_DescriptorWrites]);
+    gf2d_perf_overlay_text(line,x,y,255,255,255);
+    y += gf2d_perf_overlay.lineHeight;
+    snprintf(line,sizeof(line),"staged %.1fKB  submits %lu (%.2fms)",
+        stats->counters[SC_StagingBytes] / 1024.0,
+        (unsigned long)stats->counters[SC_SingleTimeSubmits],
+        stats->stallMs);
+    gf2d_perf_overlay_text(line,x,y,255,255,255);
+    y += gf2d_perf_overlay.lineHeight;
+    snprintf(line,sizeof(line),"textures %u  sprites %u  meshes %u",stats->textures,stats->sprites,stats->meshes);
+    gf2d_perf_overlay_text(line,x,y,255,255,255);
+    y += gf2d_perf_overlay.lineHeight;
+
+    for (i = 0; i < stats->heapCount; i++)
+    {
+        snprintf(line,sizeof(line),"heap %u: %.1f / %.0fMB",i,stats->heapUsed[i] / (1024.0 * 1024.0),stats->heapSize[i] / (1024.0 * 1024.0));
+        gf2d_perf_overlay_text(line,x,y,200,200,255);
+        y += gf2d_perf_overlay.lineHeight;
+        gf2d_perf_overlay_fill(x,y,OVERLAY_HISTORY * 2,OVERLAY_BAR_HEIGHT,50,50,70,255);
+        if (stats->heapSize[i])
+        {
+            w = (int)((double)stats->heapUsed[i] / (double)stats->heapSize[i] * OVERLAY_HISTORY * 2);
+            if (w > 0)gf2d_perf_overlay_fill(x,y,MIN(w,OVERLAY_HISTORY * 2),OVERLAY_BAR_HEIGHT,120,120,255,255);
+        }
+        y += OVERLAY_BAR_HEIGHT;
+    }
+}
+
+void gf2d_perf_overlay_draw()
+{
+    Uint32 now;
+    GFC_Vector2D resolution;
+    if (!gf2d_perf_overlay.canvas)return;
+    gf2d_perf_overlay_sample();
+    if (!gf2d_perf_overlay.shown)return;
+    now = SDL_GetTicks();
+    if ((!gf2d_perf_overlay.lastRefresh)||(now - gf2d_perf_overlay.lastRefresh >= gf2d_perf_overlay.refreshMs))
+    {
+        gf2d_perf_overlay.lastRefresh = now;
+        gf2d_perf_overlay_paint();
+        //recorded into the next frame's commands, so the overlay does not add submits or stalls of its own
+        gf3d_texture_stream(gf2d_perf_overlay.sprite->texture);
+    }
+    resolution = gf3d_vgraphics_get_resolution();
+    gf2d_sprite_draw_image(gf2d_perf_overlay.sprite,gfc_vector2d(resolution.x - gf2d_perf_overlay.canvas->w - OVERLAY_MARGIN,OVERLAY_MARGIN));
+}
+
+/*eol@eof*/
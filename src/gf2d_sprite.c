@@ -10,6 +10,10 @@
 #include "gf3d_vgraphics.h"
 #include "gf3d_pipeline.h"
 #include "gf3d_commands.h"
+#include "gf3d_registry.h"
+#include "gf3d_pool.h"
+#include "gf2d_atlas.h"
+#include "gf3d_bindless.h"
 #include "gf2d_sprite.h"
 
 #define SPRITE_ATTRIBUTE_COUNT 2
@@ -44,8 +48,8 @@ typedef struct
 
 typedef struct
 {
-    Sprite         *sprite_list;      /**<pre-allocated space for sprites*/
-    Uint32          max_sprites;      /**<maximum concurrent sprites supported*/
+    Pool           *sprite_pool;      /**<space for sprites, grows as needed*/
+    Registry       *sprite_names;     /**<loaded sprites by filename*/
     Uint32          chain_length;     /**<length of swap chain*/
     VkDevice        device;           /**<logical vulkan device*/
     Pipeline       *pipe;             /**<the pipeline associated with sprite rendering*/
@@ -74,23 +78,15 @@ static SpriteManager gf2d_sprite = {0};
 
 void gf2d_sprite_manager_close()
 {
-    int i;
-    for (i = 0; i < gf2d_sprite.max_sprites;i++)
+    Uint32 i,c;
+    c = gf3d_pool_get_capacity(gf2d_sprite.sprite_pool);
+    for (i = 0; i < c;i++)
     {
-        gf2d_sprite_delete(&gf2d_sprite.sprite_list[i]);
-    }
-    if (gf2d_sprite.sprite_list)
-    {
-        free(gf2d_sprite.sprite_list);
-    }
-    if (gf2d_sprite.faceBuffer != VK_NULL_HANDLE)
-    {
-        vkDestroyBuffer(gf2d_sprite.device, gf2d_sprite.faceBuffer, NULL);
-    }
-    if (gf2d_sprite.faceBufferMemory != VK_NULL_HANDLE)
-    {
-        vkFreeMemory(gf2d_sprite.device, gf2d_sprite.faceBufferMemory, NULL);
+        gf2d_sprite_delete(gf3d_pool_get_nth(gf2d_sprite.sprite_pool,i));
     }
+    gf3d_pool_free(gf2d_sprite.sprite_pool);
+    gf3d_registry_free(gf2d_sprite.sprite_names);
+    gf3d_buffer_free(gf2d_sprite.faceBuffer,gf2d_sprite.faceBufferMemory);
 
     memset(&gf2d_sprite,0,sizeof(SpriteManager));
     if(__DEBUG)slog("sprite manager closed");
@@ -111,8 +107,8 @@ void gf2d_sprite_manager_init(Uint32 max_sprites)
         return;
     }
     gf2d_sprite.chain_length = gf3d_swapchain_get_chain_length();
-    gf2d_sprite.sprite_list = (Sprite *)gfc_allocate_array(sizeof(Sprite),max_sprites);
-    gf2d_sprite.max_sprites = max_sprites;
+    gf2d_sprite.sprite_pool = gf3d_pool_new(sizeof(Sprite),max_sprites,0);
+    gf2d_sprite.sprite_names = gf3d_registry_new(max_sprites);
     gf2d_sprite.device = gf3d_vgraphics_get_default_logical_device();
     
     // setup the face buffer, which will be used for ALL sprites
@@ -125,31 +121,52 @@ void gf2d_sprite_manager_init(Uint32 max_sprites)
 
     bufferSize = sizeof(SpriteFace) * 2;
     
-    gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory);
-
-    vkMapMemory(gf2d_sprite.device, stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, faces, (size_t) bufferSize);
-    vkUnmapMemory(gf2d_sprite.device, stagingBufferMemory);
-
-    gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &gf2d_sprite.faceBuffer, &gf2d_sprite.faceBufferMemory);
+    if (gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory))
+    {
+        vkMapMemory(gf2d_sprite.device, stagingBufferMemory, 0, bufferSize, 0, &data);
+        memcpy(data, faces, (size_t) bufferSize);
+        vkUnmapMemory(gf2d_sprite.device, stagingBufferMemory);
 
-    gf3d_buffer_copy(stagingBuffer, gf2d_sprite.faceBuffer, bufferSize);
+        if (gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &gf2d_sprite.faceBuffer, &gf2d_sprite.faceBufferMemory))
+        {
+            gf3d_buffer_copy(stagingBuffer, gf2d_sprite.faceBuffer, bufferSize);
+        }
+        gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+    }
+    if (gf2d_sprite.faceBuffer == VK_NULL_HANDLE)slog("failed to create the sprite face buffer");
 
-    vkDestroyBuffer(gf2d_sprite.device, stagingBuffer, NULL);
-    vkFreeMemory(gf2d_sprite.device, stagingBufferMemory, NULL);
+    gf2d_atlas_init(1024,256,8);
 
     gf2d_sprite_get_attribute_descriptions(&count);
-    gf2d_sprite.pipe = gf3d_pipeline_create_from_config(
-        gf3d_vgraphics_get_default_logical_device(),
-        "config/overlay_pipeline.cfg",
-        gf3d_vgraphics_get_view_extent(),
-        max_sprites,
-        gf2d_sprite_get_bind_description(),
-        gf2d_sprite_get_attribute_descriptions(NULL),
-        count,
-        sizeof(SpriteUBO),
-        VK_INDEX_TYPE_UINT16
-    );     
+    if (gf3d_bindless_enabled())
+    {
+        //sprites pick their texture by index, so no texture descriptor is written per draw
+        gf2d_sprite.pipe = gf3d_pipeline_create_from_config(
+            gf3d_vgraphics_get_default_logical_device(),
+            "config/overlay_pipeline_bindless.cfg",
+            gf3d_vgraphics_get_view_extent(),
+            max_sprites,
+            gf2d_sprite_get_bind_description(),
+            gf2d_sprite_get_attribute_descriptions(NULL),
+            count,
+            sizeof(SpriteUBO),
+            VK_INDEX_TYPE_UINT16
+        );
+    }
+    if (!gf2d_sprite.pipe)
+    {
+        gf2d_sprite.pipe = gf3d_pipeline_create_from_config(
+            gf3d_vgraphics_get_default_logical_device(),
+            "config/overlay_pipeline.cfg",
+            gf3d_vgraphics_get_view_extent(),
+            max_sprites,
+            gf2d_sprite_get_bind_description(),
+            gf2d_sprite_get_attribute_descriptions(NULL),
+            count,
+            sizeof(SpriteUBO),
+            VK_INDEX_TYPE_UINT16
+        );
+    }
     
     if(__DEBUG)slog("sprite manager initiliazed");
     atexit(gf2d_sprite_manager_close);
@@ -171,30 +188,21 @@ void gf3d_sprite_submit_pipe_commands()
 
 Sprite *gf2d_sprite_get_by_filename(const char *filename)
 {
-    int i;
     if (!filename)return NULL;
-    for (i = 0; i < gf2d_sprite.max_sprites; i++)
-    {
-        if (!gf2d_sprite.sprite_list[i]._inuse)continue;
-        if (gfc_line_cmp(gf2d_sprite.sprite_list[i].filename,filename) == 0)
-        {
-            return &gf2d_sprite.sprite_list[i];
-        }
-    }
-    return NULL;
+    return gf3d_registry_get(gf2d_sprite.sprite_names,filename);
 }
 
 Sprite *gf2d_sprite_new()
 {
-    int i;
-    for (i = 0; i < gf2d_sprite.max_sprites; i++)
+    Sprite *sprite;
+    sprite = gf3d_pool_alloc(gf2d_sprite.sprite_pool);
+    if (!sprite)
     {
-        if (gf2d_sprite.sprite_list[i]._inuse)continue;
-        gf2d_sprite.sprite_list[i]._inuse = 1;
-        return &gf2d_sprite.sprite_list[i];
+        slog("gf2d_sprite_new: no free slots for new sprites");
+        return NULL;
     }
-    slog("gf2d_sprite_new: no free slots for new sprites");
-    return NULL;
+    sprite->_inuse = 1;
+    return sprite;
 }
 
 Sprite * gf2d_sprite_from_surface(SDL_Surface *surface,int frame_width,int frame_height, Uint32 frames_per_line)
@@ -208,14 +216,16 @@ Sprite * gf2d_sprite_from_surface(SDL_Surface *surface,int frame_width,int frame
     sprite = gf2d_sprite_new();
     if (!sprite)
     {
+        SDL_FreeSurface(surface);
         return NULL;
     }
-    sprite->texture = gf3d_texture_convert_surface(surface);
+    sprite->texture = gf3d_texture_convert_surface_flags(surface,TF_NoMips | TF_KeepSurface);
     if (!sprite->texture)
     {
         gf2d_sprite_free(sprite);
         return NULL;
     }
+    gf3d_texture_set_sampler(sprite->texture,SP_Sprite);
     if (frame_width <= 0)frame_width = sprite->texture->width;
     if (frame_height <= 0)frame_height = sprite->texture->height;
     sprite->frameWidth = frame_width;
@@ -225,7 +235,8 @@ Sprite * gf2d_sprite_from_surface(SDL_Surface *surface,int frame_width,int frame
     if (frames_per_line)sprite->framesPerLine = frames_per_line;
     else sprite->framesPerLine = 1;
     gf2d_sprite_create_vertex_buffer(sprite);
-    sprite->surface = surface;
+    //the texture converted the surface and freed the original
+    sprite->surface = sprite->texture->surface;
     return sprite;
 }
 
@@ -255,12 +266,70 @@ Sprite *gf2d_sprite_parse(SJson *json)
     return gf2d_sprite_load(str,frameWidth,frameHeight, framesPerLine);
 }
 
+/**
+ * @brief get the texture for a sprite, packing it into the atlas if it is small enough
+ * @note sets the sprite frame size to the size of the image
+ */
+Texture *gf2d_sprite_load_texture(Sprite *sprite,const char *filename,Uint32 textureFlags)
+{
+    SDL_Surface *surface;
+    Texture *texture = NULL;
+    //shared textures and images that must stay on the cpu are not packed
+    if ((!(textureFlags & TF_KeepSurface))&&(!gf3d_texture_get_sampled(filename,SP_Sprite)))
+    {
+        surface = gf3d_texture_load_surface(filename);
+        if (surface)
+        {
+            sprite->frameWidth = surface->w;
+            sprite->frameHeight = surface->h;
+            if (gf2d_atlas_accepts(surface->w,surface->h))
+            {
+                texture = gf2d_atlas_add(surface,&sprite->atlasOffset);
+                if (texture)
+                {
+                    SDL_FreeSurface(surface);
+                    sprite->inAtlas = 1;
+                    return texture;
+                }
+            }
+            //too big for the atlas or no room left in it, the decoded image becomes its own texture
+            return gf3d_texture_convert_surface_named(surface,filename,textureFlags,SP_Sprite);
+        }
+    }
+    texture = gf3d_texture_load_sampled(filename,textureFlags,SP_Sprite);
+    if (!texture)return NULL;
+    sprite->frameWidth = texture->width;
+    sprite->frameHeight = texture->height;
+    return texture;
+}
+
 Sprite * gf2d_sprite_load(const char * filename,int frame_width,int frame_height, Uint32 frames_per_line)
+{
+    return gf2d_sprite_load_flags(filename,frame_width,frame_height,frames_per_line,TF_NoMips);
+}
+
+Sprite * gf2d_sprite_load_flags(const char * filename,int frame_width,int frame_height, Uint32 frames_per_line,Uint32 textureFlags)
 {
     Sprite *sprite;
+    Texture *texture;
     sprite = gf2d_sprite_get_by_filename(filename);
     if (sprite)
     {
+        if ((textureFlags & TF_KeepSurface)&&(!sprite->surface)&&(sprite->inAtlas))
+        {
+            //atlas pages do not keep images, so the sprite holds its own
+            sprite->surface = gf3d_texture_load_surface(filename);
+        }
+        else if ((textureFlags & TF_KeepSurface)&&(!sprite->surface))
+        {
+            //loading again restores the cpu image on the shared texture
+            texture = gf3d_texture_load_sampled(filename,textureFlags,SP_Sprite);
+            if (texture)
+            {
+                sprite->surface = texture->surface;
+                gf3d_texture_free(texture);
+            }
+        }
         sprite->_inuse++;
         return sprite;
     }
@@ -269,7 +338,7 @@ Sprite * gf2d_sprite_load(const char * filename,int frame_width,int frame_height
     {
         return NULL;
     }
-    sprite->texture = gf3d_texture_load(filename);
+    sprite->texture = gf2d_sprite_load_texture(sprite,filename,textureFlags);
     if (!sprite->texture)
     {
         slog("gf2d_sprite_load: failed to load texture for sprite");
@@ -277,8 +346,8 @@ Sprite * gf2d_sprite_load(const char * filename,int frame_width,int frame_height
         return NULL;
     }
     sprite->surface = sprite->texture->surface;
-    if (frame_width <= 0)frame_width = sprite->texture->width;
-    if (frame_height <= 0)frame_height = sprite->texture->height;
+    if (frame_width <= 0)frame_width = sprite->frameWidth;
+    if (frame_height <= 0)frame_height = sprite->frameHeight;
     sprite->frameWidth = frame_width;
     sprite->frameHeight = frame_height;
     sprite->widthPercent = sprite->frameWidth / (float)sprite->texture->width;
@@ -286,6 +355,7 @@ Sprite * gf2d_sprite_load(const char * filename,int frame_width,int frame_height
     if (frames_per_line)sprite->framesPerLine = frames_per_line;
     else sprite->framesPerLine = 1;
     gfc_line_cpy(sprite->filename,filename);
+    gf3d_registry_insert(gf2d_sprite.sprite_names,sprite->filename,sprite);
     gf2d_sprite_create_vertex_buffer(sprite);
     return sprite;
 }
@@ -297,21 +367,26 @@ void gf2d_sprite_free(Sprite *sprite)
     if (sprite->_inuse <= 0)gf2d_sprite_delete(sprite);
 }
 
+Uint32 gf2d_sprite_get_count()
+{
+    if (!gf2d_sprite.sprite_pool)return 0;
+    return gf3d_pool_get_count(gf2d_sprite.sprite_pool);
+}
+
 void gf2d_sprite_delete(Sprite *sprite)
 {
     if (!sprite)return;
-    
-    if (sprite->buffer != VK_NULL_HANDLE)
-    {
-        vkDestroyBuffer(gf2d_sprite.device, sprite->buffer, NULL);
-    }
-    if (sprite->bufferMemory != VK_NULL_HANDLE)
+    if (sprite->filename[0])gf3d_registry_remove(gf2d_sprite.sprite_names,sprite->filename,sprite);
+    gf3d_buffer_free(sprite->buffer,sprite->bufferMemory);
+
+    if (sprite->inAtlas)
     {
-        vkFreeMemory(gf2d_sprite.device, sprite->bufferMemory, NULL);
+        if (sprite->surface)SDL_FreeSurface(sprite->surface);
+        gf2d_atlas_release(sprite->texture);
     }
-
     gf3d_texture_free(sprite->texture);
     memset(sprite,0,sizeof(Sprite));
+    gf3d_pool_release(gf2d_sprite.sprite_pool,sprite);
 }
 
 void gf2d_sprite_draw_full(
@@ -451,18 +526,22 @@ void gf2d_sprite_create_vertex_buffer(Sprite *sprite)
     };
     bufferSize = sizeof(SpriteVertex) * 4;
     
-    gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory);
+    if (!gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory))
+    {
+        slog("failed to create sprite vertex buffer");
+        return;
+    }
     
     vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
     memcpy(data, vertices, (size_t) bufferSize);
     vkUnmapMemory(device, stagingBufferMemory);
 
-    gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT|VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &sprite->buffer, &sprite->bufferMemory);
-
-    gf3d_buffer_copy(stagingBuffer, sprite->buffer, bufferSize);
+    if (gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT|VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &sprite->buffer, &sprite->bufferMemory))
+    {
+        gf3d_buffer_copy(stagingBuffer, sprite->buffer, bufferSize);
+    }
 
-    vkDestroyBuffer(device, stagingBuffer, NULL);
-    vkFreeMemory(device, stagingBufferMemory, NULL);    
+    gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
 }
 
 void gf2d_sprite_draw_to_surface(
@@ -556,8 +635,8 @@ SpriteUBO gf2d_sprite_get_uniform_buffer(
     }
     
     gfc_vector4d_copy(spriteUBO.clip,clip);
-    spriteUBO.frame_offset.x = (frame%sprite->framesPerLine * sprite->frameWidth)/(float)sprite->texture->width;
-    spriteUBO.frame_offset.y = (frame/sprite->framesPerLine * sprite->frameHeight)/(float)sprite->texture->height;
+    spriteUBO.frame_offset.x = (sprite->atlasOffset.x + frame%sprite->framesPerLine * sprite->frameWidth)/(float)sprite->texture->width;
+    spriteUBO.frame_offset.y = (sprite->atlasOffset.y + frame/sprite->framesPerLine * sprite->frameHeight)/(float)sprite->texture->height;
     return spriteUBO;
 }
 
@@ -0,0 +1,1087 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "simple_logger.h"
+#include "simple_json.h"
+
+#include "gf3d_gltf_parse.h"
+#include "gf3d_animation.h"
+
+#if defined(__SSE2__)||defined(_M_X64)
+#include <emmintrin.h>
+#define GF3D_ANIMATION_SSE
+#endif
+
+/*
+ * Poses and scratch world matrices are stored with the instance as the innermost index,
+ * so four instances of the same joint and channel sit next to each other in memory.
+ * World matrices are affine: 12 floats, rows 0-2 are the basis and row 3 is the translation
+ */
+#define CHANNEL(batch,j,c) (&(batch)->channels[((size_t)(j) * AC_MAX + (c)) * (batch)->stride])
+#define WORLD(batch,j,e) (&(batch)->world[((size_t)(j) * 12 + (e)) * (batch)->stride])
+
+extern int __DEBUG;
+
+static Bool gf3d_animation_simd = 1;
+
+void gf3d_animation_set_simd(Bool enable)
+{
+    gf3d_animation_simd = enable;
+}
+
+const char *gf3d_animation_get_kernel_name()
+{
+#ifdef GF3D_ANIMATION_SSE
+    if (gf3d_animation_simd)return "sse";
+#endif
+    return "scalar";
+}
+
+Skeleton *gf3d_animation_skeleton_new(Uint32 jointCount)
+{
+    Uint32 i;
+    Skeleton *skeleton;
+    if (!jointCount)return NULL;
+    skeleton = gfc_allocate_array(sizeof(Skeleton),1);
+    if (!skeleton)return NULL;
+    skeleton->jointCount = jointCount;
+    skeleton->parent = gfc_allocate_array(sizeof(Sint32),jointCount);
+    skeleton->skinJoint = gfc_allocate_array(sizeof(Uint32),jointCount);
+    skeleton->node = gfc_allocate_array(sizeof(Uint32),jointCount);
+    skeleton->inverseBind = gfc_allocate_array(sizeof(GFC_Matrix4),jointCount);
+    skeleton->rest = gfc_allocate_array(sizeof(float) * AC_MAX,jointCount);
+    if ((!skeleton->parent)||(!skeleton->skinJoint)||(!skeleton->node)||(!skeleton->inverseBind)||(!skeleton->rest))
+    {
+        gf3d_animation_skeleton_free(skeleton);
+        return NULL;
+    }
+    for (i = 0; i < jointCount; i++)
+    {
+        skeleton->parent[i] = -1;
+        skeleton->skinJoint[i] = i;
+        skeleton->node[i] = i;
+        gfc_matrix4_identity(skeleton->inverseBind[i]);
+        skeleton->rest[i * AC_MAX + AC_RW] = 1;
+        skeleton->rest[i * AC_MAX + AC_SX] = 1;
+        skeleton->rest[i * AC_MAX + AC_SY] = 1;
+        skeleton->rest[i * AC_MAX + AC_SZ] = 1;
+    }
+    return skeleton;
+}
+
+void gf3d_animation_skeleton_free(Skeleton *skeleton)
+{
+    if (!skeleton)return;
+    if (skeleton->parent)free(skeleton->parent);
+    if (skeleton->skinJoint)free(skeleton->skinJoint);
+    if (skeleton->node)free(skeleton->node);
+    if (skeleton->inverseBind)free(skeleton->inverseBind);
+    if (skeleton->rest)free(skeleton->rest);
+    if (skeleton->rootParent)free(skeleton->rootParent);
+    free(skeleton);
+}
+
+AnimationClip *gf3d_animation_clip_new(Uint32 trackCount,Uint32 dataCount)
+{
+    AnimationClip *clip;
+    clip = gfc_allocate_array(sizeof(AnimationClip),1);
+    if (!clip)return NULL;
+    clip->tracks = gfc_allocate_array(sizeof(AnimationTrack),trackCount);
+    clip->data = gfc_allocate_array(sizeof(float),dataCount);
+    if ((!clip->tracks)||(!clip->data))
+    {
+        gf3d_animation_clip_free(clip);
+        return NULL;
+    }
+    clip->trackCount = trackCount;
+    clip->dataCount = dataCount;
+    return clip;
+}
+
+void gf3d_animation_clip_free(AnimationClip *clip)
+{
+    if (!clip)return;
+    if (clip->tracks)free(clip->tracks);
+    if (clip->data)free(clip->data);
+    free(clip);
+}
+
+AnimationPoseBatch *gf3d_animation_pose_batch_new(Skeleton *skeleton,Uint32 instanceCount)
+{
+    AnimationPoseBatch *batch;
+    if ((!skeleton)||(!instanceCount))return NULL;
+    batch = gfc_allocate_array(sizeof(AnimationPoseBatch),1);
+    if (!batch)return NULL;
+    batch->jointCount = skeleton->jointCount;
+    batch->instanceCount = instanceCount;
+    batch->stride = (instanceCount + 3) & ~3;
+    batch->channels = gfc_allocate_array(sizeof(float),(size_t)AC_MAX * batch->jointCount * batch->stride);
+    batch->world = gfc_allocate_array(sizeof(float),(size_t)12 * batch->jointCount * batch->stride);
+    batch->time = gfc_allocate_array(sizeof(float),batch->stride);
+    batch->key = gfc_allocate_array(sizeof(Uint32),batch->stride);
+    batch->next = gfc_allocate_array(sizeof(Uint32),batch->stride);
+    batch->factor = gfc_allocate_array(sizeof(float),batch->stride);
+    if ((!batch->channels)||(!batch->world)||(!batch->time)||(!batch->key)||(!batch->next)||(!batch->factor))
+    {
+        slog("failed to allocate poses for %i instances of %i joints",instanceCount,skeleton->jointCount);
+        gf3d_animation_pose_batch_free(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+void gf3d_animation_pose_batch_free(AnimationPoseBatch *batch)
+{
+    if (!batch)return;
+    if (batch->channels)free(batch->channels);
+    if (batch->world)free(batch->world);
+    if (batch->time)free(batch->time);
+    if (batch->key)free(batch->key);
+    if (batch->next)free(batch->next);
+    if (batch->factor)free(batch->factor);
+    free(batch);
+}
+
+/**
+ * @brief find the pair of keys around each instance's time
+ */
+void gf3d_animation_find_keys(AnimationTrack *track,AnimationPoseBatch *batch,Uint32 first,Uint32 count)
+{
+    Uint32 i,lo,hi,mid,last;
+    float t,span;
+    const float *times = track->times;
+    last = track->keyCount - 1;
+    for (i = first; i < first + count; i++)
+    {
+        t = batch->time[i];
+        if ((!last)||(t <= times[0]))
+        {
+            batch->key[i] = batch->next[i] = 0;
+            batch->factor[i] = 0;
+            continue;
+        }
+        if (t >= times[last])
+        {
+            batch->key[i] = batch->next[i] = last;
+            batch->factor[i] = 0;
+            continue;
+        }
+        lo = 0;
+        hi = last;
+        while (hi - lo > 1)
+        {
+            mid = (lo + hi) / 2;
+            if (times[mid] <= t)lo = mid;
+            else hi = mid;
+        }
+        batch->key[i] = lo;
+        batch->next[i] = hi;
+        span = times[hi] - times[lo];
+        batch->factor[i] = (span > 0)?(t - times[lo]) / span:0;
+    }
+}
+
+/**
+ * @brief sample a cubic spline track between two keys.  Tangents are scaled by the time between the keys
+ */
+void gf3d_animation_hermite(AnimationTrack *track,Uint32 k,Uint32 n,float f,float *out)
+{
+    Uint32 c,K = track->keyCount;
+    Uint32 components = (track->path == AP_Rotation)?4:3;
+    float f2 = f * f,f3 = f2 * f;
+    float h00 = 2*f3 - 3*f2 + 1,h10 = f3 - 2*f2 + f,h01 = -2*f3 + 3*f2,h11 = f3 - f2;
+    float dt = track->times[n] - track->times[k];
+    for (c = 0; c < components; c++)
+    {
+        //key k leaves along its out tangent and key n arrives along its in tangent
+        out[c] = h00 * track->values[c * K + k]
+            + h10 * dt * track->tangents[(components + c) * K + k]
+            + h01 * track->values[c * K + n]
+            + h11 * dt * track->tangents[c * K + n];
+    }
+}
+
+void gf3d_animation_lerp_scalar(AnimationTrack *track,AnimationPoseBatch *batch,Uint32 first,Uint32 count)
+{
+    Uint32 i,c,k,n,K;
+    Uint32 components = (track->path == AP_Rotation)?4:3;
+    float f,dot,len,a[4],b[4],out[4];
+    K = track->keyCount;
+    for (i = first; i < first + count; i++)
+    {
+        k = batch->key[i];
+        n = batch->next[i];
+        f = (track->interpolation == AI_Step)?0:batch->factor[i];
+        if ((track->interpolation == AI_CubicSpline)&&(track->tangents))gf3d_animation_hermite(track,k,n,f,out);
+        else
+        {
+            for (c = 0; c < components; c++)
+            {
+                a[c] = track->values[c * K + k];
+                b[c] = track->values[c * K + n];
+            }
+            if (track->path == AP_Rotation)
+            {
+                //take the short way around
+                dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+                if (dot < 0)
+                {
+                    for (c = 0; c < 4; c++)b[c] = -b[c];
+                }
+            }
+            for (c = 0; c < components; c++)
+            {
+                out[c] = a[c] + (b[c] - a[c]) * f;
+            }
+        }
+        if (track->path == AP_Rotation)
+        {
+            len = sqrtf(out[0]*out[0] + out[1]*out[1] + out[2]*out[2] + out[3]*out[3]);
+            if (len > 0.000001)
+            {
+                for (c = 0; c < 4; c++)out[c] /= len;
+            }
+        }
+        for (c = 0; c < components; c++)
+        {
+            CHANNEL(batch,track->joint,track->path + c)[i] = out[c];
+        }
+    }
+}
+
+#ifdef GF3D_ANIMATION_SSE
+/**
+ * @brief lerp / nlerp four instances at a time.  Returns how many instances were handled
+ */
+Uint32 gf3d_animation_lerp_sse(AnimationTrack *track,AnimationPoseBatch *batch,Uint32 first,Uint32 count)
+{
+    Uint32 i,c,K;
+    Uint32 components = (track->path == AP_Rotation)?4:3;
+    const Uint32 *key,*next;
+    const float *v;
+    __m128 f,a[4],b[4],dot,flip,len;
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 tiny = _mm_set1_ps(0.000001f);
+    //cubic splines are left to the scalar kernel
+    if (track->interpolation == AI_CubicSpline)return 0;
+    K = track->keyCount;
+    for (i = first; i + 4 <= first + count; i += 4)
+    {
+        key = &batch->key[i];
+        next = &batch->next[i];
+        f = (track->interpolation == AI_Step)?_mm_setzero_ps():_mm_loadu_ps(&batch->factor[i]);
+        for (c = 0; c < components; c++)
+        {
+            v = &track->values[c * K];
+            a[c] = _mm_setr_ps(v[key[0]],v[key[1]],v[key[2]],v[key[3]]);
+            b[c] = _mm_setr_ps(v[next[0]],v[next[1]],v[next[2]],v[next[3]]);
+        }
+        if (track->path == AP_Rotation)
+        {
+            dot = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0],b[0]),_mm_mul_ps(a[1],b[1])),
+                _mm_add_ps(_mm_mul_ps(a[2],b[2]),_mm_mul_ps(a[3],b[3])));
+            flip = _mm_and_ps(dot,sign);
+            for (c = 0; c < 4; c++)
+            {
+                b[c] = _mm_xor_ps(b[c],flip);
+            }
+        }
+        for (c = 0; c < components; c++)
+        {
+            a[c] = _mm_add_ps(a[c],_mm_mul_ps(_mm_sub_ps(b[c],a[c]),f));
+        }
+        if (track->path == AP_Rotation)
+        {
+            len = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0],a[0]),_mm_mul_ps(a[1],a[1])),
+                _mm_add_ps(_mm_mul_ps(a[2],a[2]),_mm_mul_ps(a[3],a[3])));
+            len = _mm_sqrt_ps(_mm_max_ps(len,tiny));
+            for (c = 0; c < 4; c++)
+            {
+                a[c] = _mm_div_ps(a[c],len);
+            }
+        }
+        for (c = 0; c < components; c++)
+        {
+            _mm_storeu_ps(&CHANNEL(batch,track->joint,track->path + c)[i],a[c]);
+        }
+    }
+    return i - first;
+}
+#endif
+
+void gf3d_animation_sample_batch(
+    AnimationClip *clip,
+    Skeleton *skeleton,
+    AnimationPoseBatch *batch,
+    Uint32 first,
+    Uint32 count,
+    const float *times,
+    Bool loop)
+{
+    Uint32 i,j,c,t,done;
+    float time,rest,*channel;
+    const float *lastTimes = NULL;
+    Uint32 lastKeyCount = 0;
+    AnimationTrack *track;
+    if ((!clip)||(!skeleton)||(!batch)||(!times))return;
+    if (skeleton->jointCount != batch->jointCount)
+    {
+        slog("pose batch does not match the skeleton");
+        return;
+    }
+    if (first >= batch->instanceCount)return;
+    if (first + count > batch->instanceCount)count = batch->instanceCount - first;
+    //start from the rest pose, the clip may not animate every joint
+    for (j = 0; j < skeleton->jointCount; j++)
+    {
+        for (c = 0; c < AC_MAX; c++)
+        {
+            rest = skeleton->rest[j * AC_MAX + c];
+            channel = CHANNEL(batch,j,c);
+            for (i = first; i < first + count; i++)channel[i] = rest;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        time = times[i];
+        if ((loop)&&(clip->duration > 0))
+        {
+            time = fmodf(time,clip->duration);
+            if (time < 0)time += clip->duration;
+        }
+        else
+        {
+            if (time < 0)time = 0;
+            if (time > clip->duration)time = clip->duration;
+        }
+        batch->time[first + i] = time;
+    }
+    for (t = 0; t < clip->trackCount; t++)
+    {
+        track = &clip->tracks[t];
+        if ((!track->keyCount)||(track->joint >= skeleton->jointCount))continue;
+        //tracks that share key times share the search
+        if ((track->times != lastTimes)||(track->keyCount != lastKeyCount))
+        {
+            gf3d_animation_find_keys(track,batch,first,count);
+            lastTimes = track->times;
+            lastKeyCount = track->keyCount;
+        }
+        done = 0;
+#ifdef GF3D_ANIMATION_SSE
+        if (gf3d_animation_simd)done = gf3d_animation_lerp_sse(track,batch,first,count);
+#endif
+        if (done < count)gf3d_animation_lerp_scalar(track,batch,first + done,count - done);
+    }
+}
+
+/**
+ * @brief out = a * b for affine 12 float matrices (row vector convention)
+ */
+void gf3d_animation_affine_multiply(float *out,const float *a,const float *b)
+{
+    int r,k;
+    for (r = 0; r < 4; r++)
+    {
+        for (k = 0; k < 3; k++)
+        {
+            out[r*3 + k] = a[r*3]*b[k] + a[r*3 + 1]*b[3 + k] + a[r*3 + 2]*b[6 + k] + ((r == 3)?b[9 + k]:0);
+        }
+    }
+}
+
+/**
+ * @brief translation, rotation quaternion and scale to an affine matrix, applied scale then rotation then translation
+ */
+void gf3d_animation_trs_to_affine(float *m,const float *trs)
+{
+    float x = trs[AC_RX],y = trs[AC_RY],z = trs[AC_RZ],w = trs[AC_RW];
+    m[0] = (1 - 2*(y*y + z*z)) * trs[AC_SX];
+    m[1] = 2*(x*y + w*z) * trs[AC_SX];
+    m[2] = 2*(x*z - w*y) * trs[AC_SX];
+    m[3] = 2*(x*y - w*z) * trs[AC_SY];
+    m[4] = (1 - 2*(x*x + z*z)) * trs[AC_SY];
+    m[5] = 2*(y*z + w*x) * trs[AC_SY];
+    m[6] = 2*(x*z + w*y) * trs[AC_SZ];
+    m[7] = 2*(y*z - w*x) * trs[AC_SZ];
+    m[8] = (1 - 2*(x*x + y*y)) * trs[AC_SZ];
+    m[9] = trs[AC_TX];
+    m[10] = trs[AC_TY];
+    m[11] = trs[AC_TZ];
+}
+
+void gf3d_animation_write_palette_matrix(GFC_Matrix4 out,const float *m)
+{
+    int r;
+    for (r = 0; r < 4; r++)
+    {
+        out[r][0] = m[r*3];
+        out[r][1] = m[r*3 + 1];
+        out[r][2] = m[r*3 + 2];
+        out[r][3] = (r == 3)?1:0;
+    }
+}
+
+void gf3d_animation_inverse_bind_affine(float *out,GFC_Matrix4 m)
+{
+    int r;
+    for (r = 0; r < 4; r++)
+    {
+        out[r*3] = m[r][0];
+        out[r*3 + 1] = m[r][1];
+        out[r*3 + 2] = m[r][2];
+    }
+}
+
+void gf3d_animation_build_scalar(Skeleton *skeleton,AnimationPoseBatch *batch,Uint32 j,Uint32 first,Uint32 count,GFC_Matrix4 **palettes)
+{
+    Uint32 i,e;
+    Sint32 parent = skeleton->parent[j];
+    float trs[AC_MAX],local[12],world[12],parentWorld[12],ib[12],skin[12];
+    const float *rootParent = ((parent < 0)&&(skeleton->rootParent))?&skeleton->rootParent[j * 12]:NULL;
+    gf3d_animation_inverse_bind_affine(ib,skeleton->inverseBind[j]);
+    for (i = first; i < first + count; i++)
+    {
+        for (e = 0; e < AC_MAX; e++)trs[e] = CHANNEL(batch,j,e)[i];
+        gf3d_animation_trs_to_affine(local,trs);
+        if (parent >= 0)
+        {
+            for (e = 0; e < 12; e++)parentWorld[e] = WORLD(batch,parent,e)[i];
+            gf3d_animation_affine_multiply(world,local,parentWorld);
+        }
+        else if (rootParent)gf3d_animation_affine_multiply(world,local,rootParent);
+        else memcpy(world,local,sizeof(world));
+        for (e = 0; e < 12; e++)WORLD(batch,j,e)[i] = world[e];
+        gf3d_animation_affine_multiply(skin,ib,world);
+        if (palettes[i])gf3d_animation_write_palette_matrix(palettes[i][skeleton->skinJoint[j]],skin);
+    }
+}
+
+#ifdef GF3D_ANIMATION_SSE
+Uint32 gf3d_animation_build_sse(Skeleton *skeleton,AnimationPoseBatch *batch,Uint32 j,Uint32 first,Uint32 count,GFC_Matrix4 **palettes)
+{
+    Uint32 i,e,r,k,l;
+    Sint32 parent = skeleton->parent[j];
+    float ib[12];
+    float out[12][4];
+    const float *rootParent = ((parent < 0)&&(skeleton->rootParent))?&skeleton->rootParent[j * 12]:NULL;
+    __m128 t[AC_MAX],local[12],world[12],p[12],x2,y2,z2,xy,xz,yz,wx,wy,wz;
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    gf3d_animation_inverse_bind_affine(ib,skeleton->inverseBind[j]);
+    for (i = first; i + 4 <= first + count; i += 4)
+    {
+        for (e = 0; e < AC_MAX; e++)t[e] = _mm_loadu_ps(&CHANNEL(batch,j,e)[i]);
+        x2 = _mm_mul_ps(t[AC_RX],t[AC_RX]);
+        y2 = _mm_mul_ps(t[AC_RY],t[AC_RY]);
+        z2 = _mm_mul_ps(t[AC_RZ],t[AC_RZ]);
+        xy = _mm_mul_ps(t[AC_RX],t[AC_RY]);
+        xz = _mm_mul_ps(t[AC_RX],t[AC_RZ]);
+        yz = _mm_mul_ps(t[AC_RY],t[AC_RZ]);
+        wx = _mm_mul_ps(t[AC_RW],t[AC_RX]);
+        wy = _mm_mul_ps(t[AC_RW],t[AC_RY]);
+        wz = _mm_mul_ps(t[AC_RW],t[AC_RZ]);
+        local[0] = _mm_mul_ps(_mm_sub_ps(one,_mm_mul_ps(two,_mm_add_ps(y2,z2))),t[AC_SX]);
+        local[1] = _mm_mul_ps(_mm_mul_ps(two,_mm_add_ps(xy,wz)),t[AC_SX]);
+        local[2] = _mm_mul_ps(_mm_mul_ps(two,_mm_sub_ps(xz,wy)),t[AC_SX]);
+        local[3] = _mm_mul_ps(_mm_mul_ps(two,_mm_sub_ps(xy,wz)),t[AC_SY]);
+        local[4] = _mm_mul_ps(_mm_sub_ps(one,_mm_mul_ps(two,_mm_add_ps(x2,z2))),t[AC_SY]);
+        local[5] = _mm_mul_ps(_mm_mul_ps(two,_mm_add_ps(yz,wx)),t[AC_SY]);
+        local[6] = _mm_mul_ps(_mm_mul_ps(two,_mm_add_ps(xz,wy)),t[AC_SZ]);
+        local[7] = _mm_mul_ps(_mm_mul_ps(two,_mm_sub_ps(yz,wx)),t[AC_SZ]);
+        local[8] = _mm_mul_ps(_mm_sub_ps(one,_mm_mul_ps(two,_mm_add_ps(x2,y2))),t[AC_SZ]);
+        local[9] = t[AC_TX];
+        local[10] = t[AC_TY];
+        local[11] = t[AC_TZ];
+        if ((parent >= 0)||(rootParent))
+        {
+            if (parent >= 0)
+            {
+                for (e = 0; e < 12; e++)p[e] = _mm_loadu_ps(&WORLD(batch,parent,e)[i]);
+            }
+            else
+            {
+                for (e = 0; e < 12; e++)p[e] = _mm_set1_ps(rootParent[e]);
+            }
+            for (r = 0; r < 4; r++)
+            {
+                for (k = 0; k < 3; k++)
+                {
+                    world[r*3 + k] = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(local[r*3],p[k]),_mm_mul_ps(local[r*3 + 1],p[3 + k])),
+                        _mm_mul_ps(local[r*3 + 2],p[6 + k]));
+                    if (r == 3)world[r*3 + k] = _mm_add_ps(world[r*3 + k],p[9 + k]);
+                }
+            }
+        }
+        else memcpy(world,local,sizeof(world));
+        for (e = 0; e < 12; e++)_mm_storeu_ps(&WORLD(batch,j,e)[i],world[e]);
+        //the inverse bind is the same for every instance
+        for (r = 0; r < 4; r++)
+        {
+            for (k = 0; k < 3; k++)
+            {
+                p[r*3 + k] = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ib[r*3]),world[k]),_mm_mul_ps(_mm_set1_ps(ib[r*3 + 1]),world[3 + k])),
+                    _mm_mul_ps(_mm_set1_ps(ib[r*3 + 2]),world[6 + k]));
+                if (r == 3)p[r*3 + k] = _mm_add_ps(p[r*3 + k],world[9 + k]);
+                _mm_storeu_ps(out[r*3 + k],p[r*3 + k]);
+            }
+        }
+        for (l = 0; l < 4; l++)
+        {
+            if (!palettes[i + l])continue;
+            for (r = 0; r < 4; r++)
+            {
+                palettes[i + l][skeleton->skinJoint[j]][r][0] = out[r*3][l];
+                palettes[i + l][skeleton->skinJoint[j]][r][1] = out[r*3 + 1][l];
+                palettes[i + l][skeleton->skinJoint[j]][r][2] = out[r*3 + 2][l];
+                palettes[i + l][skeleton->skinJoint[j]][r][3] = (r == 3)?1:0;
+            }
+        }
+    }
+    return i - first;
+}
+#endif
+
+void gf3d_animation_build_palettes(
+    Skeleton *skeleton,
+    AnimationPoseBatch *batch,
+    Uint32 first,
+    Uint32 count,
+    GFC_Matrix4 **palettes)
+{
+    Uint32 j,done;
+    if ((!skeleton)||(!batch)||(!palettes))return;
+    if (skeleton->jointCount != batch->jointCount)
+    {
+        slog("pose batch does not match the skeleton");
+        return;
+    }
+    if (first >= batch->instanceCount)return;
+    if (first + count > batch->instanceCount)count = batch->instanceCount - first;
+    //palettes are indexed from the first instance
+    palettes -= first;
+    //flattened order means every parent's world matrix is ready before its children need it
+    for (j = 0; j < skeleton->jointCount; j++)
+    {
+        done = 0;
+#ifdef GF3D_ANIMATION_SSE
+        if (gf3d_animation_simd)done = gf3d_animation_build_sse(skeleton,batch,j,first,count,palettes);
+#endif
+        if (done < count)gf3d_animation_build_scalar(skeleton,batch,j,first + done,count - done,palettes);
+    }
+}
+
+/*
+ * gltf loading
+ */
+
+Uint32 gf3d_animation_json_floats(SJson *array,float *out,Uint32 count)
+{
+    Uint32 i,c;
+    if (!array)return 0;
+    c = sj_array_get_count(array);
+    if (c > count)c = count;
+    for (i = 0; i < c; i++)
+    {
+        sj_get_float_value(sj_array_get_nth(array,i),&out[i]);
+    }
+    return c;
+}
+
+/**
+ * @brief split a gltf node matrix (column major, which matches GFC_Matrix4 row vector layout) into translation, rotation and scale
+ */
+void gf3d_animation_matrix_decompose(const float *m,float *trs)
+{
+    int i;
+    float s[3],r[3][3],trace,q;
+    for (i = 0; i < 3; i++)
+    {
+        s[i] = sqrtf(m[i*4]*m[i*4] + m[i*4 + 1]*m[i*4 + 1] + m[i*4 + 2]*m[i*4 + 2]);
+        if (s[i] <= 0.000001)s[i] = 1;
+        //r is the rotation in column vector form: column i is basis row i
+        r[0][i] = m[i*4] / s[i];
+        r[1][i] = m[i*4 + 1] / s[i];
+        r[2][i] = m[i*4 + 2] / s[i];
+    }
+    trs[AC_TX] = m[12];
+    trs[AC_TY] = m[13];
+    trs[AC_TZ] = m[14];
+    trs[AC_SX] = s[0];
+    trs[AC_SY] = s[1];
+    trs[AC_SZ] = s[2];
+    trace = r[0][0] + r[1][1] + r[2][2];
+    if (trace > 0)
+    {
+        q = sqrtf(trace + 1) * 2;
+        trs[AC_RW] = 0.25 * q;
+        trs[AC_RX] = (r[2][1] - r[1][2]) / q;
+        trs[AC_RY] = (r[0][2] - r[2][0]) / q;
+        trs[AC_RZ] = (r[1][0] - r[0][1]) / q;
+    }
+    else if ((r[0][0] > r[1][1])&&(r[0][0] > r[2][2]))
+    {
+        q = sqrtf(1 + r[0][0] - r[1][1] - r[2][2]) * 2;
+        trs[AC_RW] = (r[2][1] - r[1][2]) / q;
+        trs[AC_RX] = 0.25 * q;
+        trs[AC_RY] = (r[0][1] + r[1][0]) / q;
+        trs[AC_RZ] = (r[0][2] + r[2][0]) / q;
+    }
+    else if (r[1][1] > r[2][2])
+    {
+        q = sqrtf(1 + r[1][1] - r[0][0] - r[2][2]) * 2;
+        trs[AC_RW] = (r[0][2] - r[2][0]) / q;
+        trs[AC_RX] = (r[0][1] + r[1][0]) / q;
+        trs[AC_RY] = 0.25 * q;
+        trs[AC_RZ] = (r[1][2] + r[2][1]) / q;
+    }
+    else
+    {
+        q = sqrtf(1 + r[2][2] - r[0][0] - r[1][1]) * 2;
+        trs[AC_RW] = (r[1][0] - r[0][1]) / q;
+        trs[AC_RX] = (r[0][2] + r[2][0]) / q;
+        trs[AC_RY] = (r[1][2] + r[2][1]) / q;
+        trs[AC_RZ] = 0.25 * q;
+    }
+}
+
+void gf3d_animation_node_rest(SJson *node,float *rest)
+{
+    float m[16];
+    if (!node)return;
+    if (gf3d_animation_json_floats(sj_object_get_value(node,"matrix"),m,16) == 16)
+    {
+        gf3d_animation_matrix_decompose(m,rest);
+        return;
+    }
+    gf3d_animation_json_floats(sj_object_get_value(node,"translation"),&rest[AC_TX],3);
+    gf3d_animation_json_floats(sj_object_get_value(node,"rotation"),&rest[AC_RX],4);
+    gf3d_animation_json_floats(sj_object_get_value(node,"scale"),&rest[AC_SX],3);
+}
+
+/**
+ * @brief a gltf node's local transform as an affine matrix
+ */
+void gf3d_animation_node_affine(SJson *node,float *m)
+{
+    int r;
+    float full[16],trs[AC_MAX] = {0};
+    if (gf3d_animation_json_floats(sj_object_get_value(node,"matrix"),full,16) == 16)
+    {
+        //column major, so each basis is already a row.  The last column is always 0,0,0,1
+        for (r = 0; r < 4; r++)
+        {
+            m[r*3] = full[r*4];
+            m[r*3 + 1] = full[r*4 + 1];
+            m[r*3 + 2] = full[r*4 + 2];
+        }
+        return;
+    }
+    trs[AC_RW] = trs[AC_SX] = trs[AC_SY] = trs[AC_SZ] = 1;
+    gf3d_animation_node_rest(node,trs);
+    gf3d_animation_trs_to_affine(m,trs);
+}
+
+/**
+ * @brief the world transform of a node, from its own local transform and those of all of its ancestors
+ */
+void gf3d_animation_node_world(SJson *nodes,const int *nodeParent,int nodeCount,int n,float *world)
+{
+    int steps;
+    float local[12],temp[12];
+    memset(world,0,sizeof(float) * 12);
+    world[0] = world[4] = world[8] = 1;
+    for (steps = 0; (n >= 0)&&(steps < nodeCount); steps++)
+    {
+        gf3d_animation_node_affine(sj_array_get_nth(nodes,n),local);
+        gf3d_animation_affine_multiply(temp,world,local);
+        memcpy(world,temp,sizeof(temp));
+        n = nodeParent[n];
+    }
+}
+
+Skeleton *gf3d_animation_skeleton_load(GLTF *gltf,SJson *skin)
+{
+    int i,j,c,n,p,steps,top;
+    int nodeCount,jointCount,index;
+    int *nodeParent = NULL,*nodeJoint = NULL,*jointNode = NULL,*jointParent = NULL,*order = NULL,*skinToFlat = NULL,*stack = NULL;
+    SJson *nodes,*joints,*children;
+    GLTF_AccessorView view;
+    Skeleton *skeleton = NULL;
+
+    nodes = sj_object_get_value(gltf->json,"nodes");
+    joints = sj_object_get_value(skin,"joints");
+    nodeCount = sj_array_get_count(nodes);
+    jointCount = sj_array_get_count(joints);
+    if ((!nodeCount)||(!jointCount))
+    {
+        slog("skin in %s has no joints",gltf->filename);
+        return NULL;
+    }
+    if (jointCount > 65535)
+    {
+        slog("skin in %s has too many joints (%i)",gltf->filename,jointCount);
+        return NULL;
+    }
+    nodeParent = gfc_allocate_array(sizeof(int),nodeCount);
+    nodeJoint = gfc_allocate_array(sizeof(int),nodeCount);
+    jointNode = gfc_allocate_array(sizeof(int),jointCount);
+    jointParent = gfc_allocate_array(sizeof(int),jointCount);
+    order = gfc_allocate_array(sizeof(int),jointCount);
+    skinToFlat = gfc_allocate_array(sizeof(int),jointCount);
+    stack = gfc_allocate_array(sizeof(int),jointCount);
+    if ((!nodeParent)||(!nodeJoint)||(!jointNode)||(!jointParent)||(!order)||(!skinToFlat)||(!stack))goto done;
+
+    for (i = 0; i < nodeCount; i++)nodeParent[i] = nodeJoint[i] = -1;
+    for (i = 0; i < nodeCount; i++)
+    {
+        children = sj_object_get_value(sj_array_get_nth(nodes,i),"children");
+        c = sj_array_get_count(children);
+        for (j = 0; j < c; j++)
+        {
+            if ((sj_get_integer_value(sj_array_get_nth(children,j),&n))&&(n >= 0)&&(n < nodeCount))nodeParent[n] = i;
+        }
+    }
+    for (j = 0; j < jointCount; j++)
+    {
+        n = -1;
+        sj_get_integer_value(sj_array_get_nth(joints,j),&n);
+        if ((n < 0)||(n >= nodeCount))
+        {
+            slog("skin joint %i in %s references a missing node",j,gltf->filename);
+            goto done;
+        }
+        jointNode[j] = n;
+        nodeJoint[n] = j;
+    }
+    //a joint's parent is its closest ancestor that is also a joint
+    for (j = 0; j < jointCount; j++)
+    {
+        p = nodeParent[jointNode[j]];
+        for (steps = 0; (p >= 0)&&(nodeJoint[p] < 0)&&(steps < nodeCount); steps++)p = nodeParent[p];
+        jointParent[j] = ((p >= 0)&&(steps < nodeCount))?nodeJoint[p]:-1;
+    }
+    //depth first, so parents come before children and each subtree stays together
+    for (j = jointCount - 1,top = 0; j >= 0; j--)
+    {
+        if (jointParent[j] < 0)stack[top++] = j;
+    }
+    for (i = 0; (top > 0)&&(i < jointCount);)
+    {
+        p = stack[--top];
+        order[i++] = p;
+        for (j = jointCount - 1; j >= 0; j--)
+        {
+            if ((jointParent[j] == p)&&(top < jointCount))stack[top++] = j;
+        }
+    }
+    if (i != jointCount)
+    {
+        slog("skin joints in %s do not form a tree",gltf->filename);
+        goto done;
+    }
+    skeleton = gf3d_animation_skeleton_new(jointCount);
+    if (!skeleton)goto done;
+    for (i = 0; i < jointCount; i++)skinToFlat[order[i]] = i;
+    for (i = 0; i < jointCount; i++)
+    {
+        skeleton->skinJoint[i] = order[i];
+        skeleton->node[i] = jointNode[order[i]];
+        skeleton->parent[i] = (jointParent[order[i]] >= 0)?skinToFlat[jointParent[order[i]]]:-1;
+        gf3d_animation_node_rest(sj_array_get_nth(nodes,skeleton->node[i]),&skeleton->rest[i * AC_MAX]);
+    }
+    //nodes above a root that are not joints themselves, like a Blender armature, still place the whole rig
+    for (i = 0; i < jointCount; i++)
+    {
+        p = nodeParent[skeleton->node[i]];
+        if ((skeleton->parent[i] >= 0)||(p < 0))continue;
+        if (!skeleton->rootParent)
+        {
+            skeleton->rootParent = gfc_allocate_array(sizeof(float) * 12,jointCount);
+            if (!skeleton->rootParent)
+            {
+                slog("failed to allocate root transforms for the skin in %s",gltf->filename);
+                gf3d_animation_skeleton_free(skeleton);
+                skeleton = NULL;
+                goto done;
+            }
+            for (j = 0; j < jointCount; j++)
+            {
+                skeleton->rootParent[j * 12] = skeleton->rootParent[j * 12 + 4] = skeleton->rootParent[j * 12 + 8] = 1;
+            }
+        }
+        gf3d_animation_node_world(nodes,nodeParent,nodeCount,p,&skeleton->rootParent[i * 12]);
+    }
+    if ((sj_object_get_value_as_int(skin,"inverseBindMatrices",&index))&&(gf3d_gltf_accessor_get_view(gltf,index,&view)))
+    {
+        for (i = 0; i < jointCount; i++)
+        {
+            if (order[i] >= view.count)continue;
+            for (c = 0; c < 16; c++)
+            {
+                //column major gltf matrices are already in GFC_Matrix4 row vector layout
+                skeleton->inverseBind[i][c / 4][c % 4] = gf3d_gltf_accessor_get_float(&view,order[i],c);
+            }
+        }
+    }
+done:
+    if (nodeParent)free(nodeParent);
+    if (nodeJoint)free(nodeJoint);
+    if (jointNode)free(jointNode);
+    if (jointParent)free(jointParent);
+    if (order)free(order);
+    if (skinToFlat)free(skinToFlat);
+    if (stack)free(stack);
+    return skeleton;
+}
+
+int gf3d_animation_track_compare(const void *a,const void *b)
+{
+    const AnimationTrack *ta = a,*tb = b;
+    if (ta->joint != tb->joint)return (ta->joint < tb->joint)?-1:1;
+    return (int)ta->path - (int)tb->path;
+}
+
+int gf3d_animation_find_joint(Skeleton *skeleton,int node)
+{
+    Uint32 i;
+    for (i = 0; i < skeleton->jointCount; i++)
+    {
+        if (skeleton->node[i] == node)return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief check a channel and get what is needed to load it
+ * @return 0 if the channel does not animate a joint's translation, rotation or scale
+ */
+int gf3d_animation_channel_info(
+    GLTF *gltf,
+    Skeleton *skeleton,
+    SJson *samplers,
+    SJson *channel,
+    AnimationTrack *track,
+    int *input,
+    GLTF_AccessorView *inView,
+    GLTF_AccessorView *outView)
+{
+    int node = -1,samplerIndex = -1,output = -1,joint;
+    const char *path,*interpolation;
+    SJson *target,*sampler;
+    Uint32 components;
+    target = sj_object_get_value(channel,"target");
+    if (!sj_object_get_value_as_int(target,"node",&node))return 0;
+    joint = gf3d_animation_find_joint(skeleton,node);
+    if (joint < 0)return 0;
+    path = sj_object_get_value_as_string(target,"path");
+    if (!path)return 0;
+    if (strcmp(path,"translation") == 0)track->path = AP_Translation;
+    else if (strcmp(path,"rotation") == 0)track->path = AP_Rotation;
+    else if (strcmp(path,"scale") == 0)track->path = AP_Scale;
+    else return 0;//morph target weights are not supported
+    if (!sj_object_get_value_as_int(channel,"sampler",&samplerIndex))return 0;
+    sampler = sj_array_get_nth(samplers,samplerIndex);
+    if (!sampler)return 0;
+    if ((!sj_object_get_value_as_int(sampler,"input",input))||(!sj_object_get_value_as_int(sampler,"output",&output)))return 0;
+    if ((!gf3d_gltf_accessor_get_view(gltf,*input,inView))||(!gf3d_gltf_accessor_get_view(gltf,output,outView)))return 0;
+    interpolation = sj_object_get_value_as_string(sampler,"interpolation");
+    if ((interpolation)&&(strcmp(interpolation,"STEP") == 0))track->interpolation = AI_Step;
+    else if ((interpolation)&&(strcmp(interpolation,"CUBICSPLINE") == 0))track->interpolation = AI_CubicSpline;
+    else track->interpolation = AI_Linear;
+    components = (track->path == AP_Rotation)?4:3;
+    if ((!inView->count)||(outView->componentCount < components))return 0;
+    //cubic splines store an in tangent, the value and an out tangent for each key
+    if (outView->count < inView->count * ((track->interpolation == AI_CubicSpline)?3:1))return 0;
+    track->joint = joint;
+    track->keyCount = inView->count;
+    return 1;
+}
+
+AnimationClip *gf3d_animation_clip_load(GLTF *gltf,Skeleton *skeleton,SJson *animation,Uint32 index)
+{
+    int i,c,k,channelCount,trackCount = 0,input,cubic;
+    int *inputs = NULL;
+    Uint32 *inputOffsets = NULL;
+    Uint32 dataCount = 0,cursor = 0,components,t = 0,inputCount = 0,offset;
+    const char *name;
+    SJson *channels,*samplers,*channel;
+    AnimationTrack track;
+    AnimationTrack *out;
+    GLTF_AccessorView inView,outView;
+    AnimationClip *clip = NULL;
+
+    channels = sj_object_get_value(animation,"channels");
+    samplers = sj_object_get_value(animation,"samplers");
+    channelCount = sj_array_get_count(channels);
+    if (!channelCount)return NULL;
+    inputs = gfc_allocate_array(sizeof(int),channelCount);
+    inputOffsets = gfc_allocate_array(sizeof(Uint32),channelCount);
+    if ((!inputs)||(!inputOffsets))goto done;
+    //first pass sizes the clip so all of its keys fit in one block
+    for (i = 0; i < channelCount; i++)
+    {
+        memset(&track,0,sizeof(AnimationTrack));
+        if (!gf3d_animation_channel_info(gltf,skeleton,samplers,sj_array_get_nth(channels,i),&track,&input,&inView,&outView))continue;
+        for (k = 0; k < inputCount; k++)
+        {
+            if (inputs[k] == input)break;
+        }
+        if (k == inputCount)
+        {
+            inputs[inputCount++] = input;
+            dataCount += track.keyCount;
+        }
+        components = (track.path == AP_Rotation)?4:3;
+        dataCount += track.keyCount * components * ((track.interpolation == AI_CubicSpline)?3:1);
+        trackCount++;
+    }
+    if (!trackCount)goto done;
+    clip = gf3d_animation_clip_new(trackCount,dataCount);
+    if (!clip)goto done;
+    inputCount = 0;
+    for (i = 0; (i < channelCount)&&(t < trackCount); i++)
+    {
+        channel = sj_array_get_nth(channels,i);
+        out = &clip->tracks[t];
+        if (!gf3d_animation_channel_info(gltf,skeleton,samplers,channel,out,&input,&inView,&outView))continue;
+        //channels driven by the same sampler input share the key times
+        for (k = 0; k < inputCount; k++)
+        {
+            if (inputs[k] == input)break;
+        }
+        if (k == inputCount)
+        {
+            inputs[inputCount] = input;
+            inputOffsets[inputCount++] = cursor;
+            gf3d_gltf_accessor_read_floats(&inView,&clip->data[cursor],1);
+            offset = cursor;
+            cursor += out->keyCount;
+        }
+        else offset = inputOffsets[k];
+        out->times = &clip->data[offset];
+        clip->duration = MAX(clip->duration,out->times[out->keyCount - 1]);
+        components = (out->path == AP_Rotation)?4:3;
+        //cubic splines store in tangent, value, out tangent for each key
+        cubic = (out->interpolation == AI_CubicSpline);
+        out->values = &clip->data[cursor];
+        for (c = 0; c < components; c++)
+        {
+            for (k = 0; k < out->keyCount; k++)
+            {
+                out->values[c * out->keyCount + k] = gf3d_gltf_accessor_get_float(&outView,cubic?(k * 3 + 1):k,c);
+            }
+        }
+        cursor += out->keyCount * components;
+        if (cubic)
+        {
+            out->tangents = &clip->data[cursor];
+            for (c = 0; c < components; c++)
+            {
+                for (k = 0; k < out->keyCount; k++)
+                {
+                    out->tangents[c * out->keyCount + k] = gf3d_gltf_accessor_get_float(&outView,k * 3,c);
+                    out->tangents[(components + c) * out->keyCount + k] = gf3d_gltf_accessor_get_float(&outView,k * 3 + 2,c);
+                }
+            }
+            cursor += out->keyCount * components * 2;
+        }
+        t++;
+    }
+    clip->trackCount = t;
+    qsort(clip->tracks,clip->trackCount,sizeof(AnimationTrack),gf3d_animation_track_compare);
+    name = sj_object_get_value_as_string(animation,"name");
+    if (name)gfc_line_cpy(clip->name,name);
+    else gfc_line_sprintf(clip->name,"clip%i",index);
+done:
+    if (inputs)free(inputs);
+    if (inputOffsets)free(inputOffsets);
+    return clip;
+}
+
+AnimationSet *gf3d_animation_set_load(const char *filename)
+{
+    int i,c;
+    GLTF *gltf;
+    SJson *skin,*animations;
+    AnimationSet *set;
+    AnimationClip *clip;
+    if (!filename)return NULL;
+    gltf = gf3d_gltf_load(filename);
+    if (!gltf)return NULL;
+    skin = sj_array_get_nth(sj_object_get_value(gltf->json,"skins"),0);
+    if (!skin)
+    {
+        slog("%s has no skin to animate",filename);
+        gf3d_gltf_free(gltf);
+        return NULL;
+    }
+    set = gfc_allocate_array(sizeof(AnimationSet),1);
+    if (!set)
+    {
+        gf3d_gltf_free(gltf);
+        return NULL;
+    }
+    gfc_line_cpy(set->filename,filename);
+    set->skeleton = gf3d_animation_skeleton_load(gltf,skin);
+    if (!set->skeleton)
+    {
+        slog("failed to load skeleton from %s",filename);
+        gf3d_gltf_free(gltf);
+        gf3d_animation_set_free(set);
+        return NULL;
+    }
+    set->clips = gfc_list_new();
+    animations = sj_object_get_value(gltf->json,"animations");
+    c = sj_array_get_count(animations);
+    for (i = 0; i < c; i++)
+    {
+        clip = gf3d_animation_clip_load(gltf,set->skeleton,sj_array_get_nth(animations,i),i);
+        if (clip)gfc_list_append(set->clips,clip);
+    }
+    gf3d_gltf_free(gltf);
+    if (__DEBUG)slog("loaded %i joints and %i clips from %s",set->skeleton->jointCount,gfc_list_get_count(set->clips),filename);
+    return set;
+}
+
+void gf3d_animation_set_free(AnimationSet *set)
+{
+    int i,c;
+    if (!set)return;
+    c = gfc_list_get_count(set->clips);
+    for (i = 0; i < c; i++)
+    {
+        gf3d_animation_clip_free(gfc_list_get_nth(set->clips,i));
+    }
+    if (set->clips)gfc_list_delete(set->clips);
+    gf3d_animation_skeleton_free(set->skeleton);
+    free(set);
+}
+
+AnimationClip *gf3d_animation_set_get_clip(AnimationSet *set,const char *name)
+{
+    int i,c;
+    AnimationClip *clip;
+    if ((!set)||(!name))return NULL;
+    c = gfc_list_get_count(set->clips);
+    for (i = 0; i < c; i++)
+    {
+        clip = gfc_list_get_nth(set->clips,i);
+        if (!clip)continue;
+        if (gfc_line_cmp(clip->name,name) == 0)return clip;
+    }
+    return NULL;
+}
+
+AnimationClip *gf3d_animation_set_get_clip_by_index(AnimationSet *set,Uint32 index)
+{
+    if (!set)return NULL;
+    return gfc_list_get_nth(set->clips,index);
+}
+
+/*eol@eof*/
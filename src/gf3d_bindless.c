@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_swapchain.h"
+#include "gf3d_device.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
+#include "gf3d_bindless.h"
+
+#define BINDLESS_MAX_FRAMES 32  /**<frames are tracked as bits in a mask*/
+
+typedef struct
+{
+    Uint32  index;
+    Uint32  frame;          /**<frame count when it was released*/
+}BindlessRetired;
+
+typedef struct
+{
+    Bool                    enabled;
+    VkDevice                device;
+    Uint32                  maxTextures;
+    Uint32                  chainLength;
+    Uint32                  frameCount;     /**<frames started, for knowing when released slots are safe to reuse*/
+    VkDescriptorSetLayout   layout;
+    VkDescriptorPool        pool;
+    VkDescriptorSet        *sets;           /**<one per swap chain image*/
+    Texture               **slots;          /**<the texture in each slot, slot 0 is never used*/
+    Uint32                 *dirty;          /**<per slot, a bit for each frame whose set needs the slot written*/
+    Uint32                  pendingFrames;  /**<a bit for each frame with dirty slots*/
+    Uint32                 *freeList;
+    Uint32                  freeCount;
+    BindlessRetired        *retired;
+    Uint32                  retiredCount;
+    VkDescriptorImageInfo  *imageInfo;      /**<scratch space for writing slots*/
+    VkWriteDescriptorSet   *writes;
+}BindlessManager;
+
+extern int __DEBUG;
+static BindlessManager gf3d_bindless = {0};
+
+void gf3d_bindless_close()
+{
+    if (gf3d_bindless.pool != VK_NULL_HANDLE)
+    {
+        gf3d_tracker_destroy(TC_DescriptorPool,gf3d_bindless.pool);
+        vkDestroyDescriptorPool(gf3d_bindless.device, gf3d_bindless.pool, NULL);
+    }
+    if (gf3d_bindless.layout != VK_NULL_HANDLE)
+    {
+        gf3d_tracker_destroy(TC_DescriptorSetLayout,gf3d_bindless.layout);
+        vkDestroyDescriptorSetLayout(gf3d_bindless.device, gf3d_bindless.layout, NULL);
+    }
+    if (gf3d_bindless.sets)free(gf3d_bindless.sets);
+    if (gf3d_bindless.slots)free(gf3d_bindless.slots);
+    if (gf3d_bindless.dirty)free(gf3d_bindless.dirty);
+    if (gf3d_bindless.freeList)free(gf3d_bindless.freeList);
+    if (gf3d_bindless.retired)free(gf3d_bindless.retired);
+    if (gf3d_bindless.imageInfo)free(gf3d_bindless.imageInfo);
+    if (gf3d_bindless.writes)free(gf3d_bindless.writes);
+    memset(&gf3d_bindless,0,sizeof(BindlessManager));
+    if (__DEBUG)slog("bindless textures closed");
+}
+
+Uint32 gf3d_bindless_device_limit(Uint32 maxTextures)
+{
+    VkPhysicalDeviceDescriptorIndexingProperties indexing = {0};
+    VkPhysicalDeviceProperties2 properties = {0};
+    indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexing;
+    vkGetPhysicalDeviceProperties2(gf3d_vgraphics_get_default_physical_device(), &properties);
+    maxTextures = MIN(maxTextures,indexing.maxDescriptorSetUpdateAfterBindSampledImages);
+    maxTextures = MIN(maxTextures,indexing.maxDescriptorSetUpdateAfterBindSamplers);
+    maxTextures = MIN(maxTextures,indexing.maxPerStageDescriptorUpdateAfterBindSampledImages);
+    maxTextures = MIN(maxTextures,indexing.maxPerStageDescriptorUpdateAfterBindSamplers);
+    return maxTextures;
+}
+
+int gf3d_bindless_create_sets()
+{
+    Uint32 i;
+    VkDescriptorSetLayoutBinding binding = {0};
+    VkDescriptorBindingFlags bindingFlags;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {0};
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {0};
+    VkDescriptorPoolSize poolSize = {0};
+    VkDescriptorPoolCreateInfo poolInfo = {0};
+    VkDescriptorSetAllocateInfo allocInfo = {0};
+    VkDescriptorSetLayout *layouts;
+
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = gf3d_bindless.maxTextures;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    //slots without a texture are never sampled, and slots may be written while the set is bound
+    bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.bindingCount = 1;
+    flagsInfo.pBindingFlags = &bindingFlags;
+
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(gf3d_bindless.device, &layoutInfo, NULL, &gf3d_bindless.layout) != VK_SUCCESS)
+    {
+        slog("failed to create bindless descriptor set layout");
+        gf3d_bindless.layout = VK_NULL_HANDLE;
+        return 0;
+    }
+    gf3d_tracker_create(TC_DescriptorSetLayout,gf3d_bindless.layout,0,"bindless textures");
+
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = gf3d_bindless.maxTextures * gf3d_bindless.chainLength;
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = gf3d_bindless.chainLength;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(gf3d_bindless.device, &poolInfo, NULL, &gf3d_bindless.pool) != VK_SUCCESS)
+    {
+        slog("failed to create bindless descriptor pool");
+        gf3d_bindless.pool = VK_NULL_HANDLE;
+        return 0;
+    }
+    gf3d_tracker_create(TC_DescriptorPool,gf3d_bindless.pool,0,"bindless textures");
+
+    layouts = gfc_allocate_array(sizeof(VkDescriptorSetLayout),gf3d_bindless.chainLength);
+    if (!layouts)return 0;
+    for (i = 0; i < gf3d_bindless.chainLength; i++)
+    {
+        layouts[i] = gf3d_bindless.layout;
+    }
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = gf3d_bindless.pool;
+    allocInfo.descriptorSetCount = gf3d_bindless.chainLength;
+    allocInfo.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(gf3d_bindless.device, &allocInfo, gf3d_bindless.sets) != VK_SUCCESS)
+    {
+        slog("failed to allocate bindless descriptor sets");
+        free(layouts);
+        return 0;
+    }
+    free(layouts);
+    return 1;
+}
+
+void gf3d_bindless_init(Uint32 maxTextures)
+{
+    Uint32 i;
+    if (!gf3d_device_bindless_enabled())
+    {
+        if (__DEBUG)slog("bindless textures not enabled");
+        return;
+    }
+    atexit(gf3d_bindless_close);
+    gf3d_bindless.device = gf3d_vgraphics_get_default_logical_device();
+    gf3d_bindless.chainLength = gf3d_swapchain_get_swap_image_count();
+    if ((!gf3d_bindless.chainLength)||(gf3d_bindless.chainLength > BINDLESS_MAX_FRAMES))
+    {
+        slog("cannot setup bindless textures for %i swap chain images",gf3d_bindless.chainLength);
+        return;
+    }
+    gf3d_bindless.maxTextures = gf3d_bindless_device_limit(maxTextures);
+    if (gf3d_bindless.maxTextures < 2)
+    {
+        slog("device does not allow enough bindless textures");
+        return;
+    }
+    gf3d_bindless.sets = gfc_allocate_array(sizeof(VkDescriptorSet),gf3d_bindless.chainLength);
+    gf3d_bindless.slots = gfc_allocate_array(sizeof(Texture *),gf3d_bindless.maxTextures);
+    gf3d_bindless.dirty = gfc_allocate_array(sizeof(Uint32),gf3d_bindless.maxTextures);
+    gf3d_bindless.freeList = gfc_allocate_array(sizeof(Uint32),gf3d_bindless.maxTextures);
+    gf3d_bindless.retired = gfc_allocate_array(sizeof(BindlessRetired),gf3d_bindless.maxTextures);
+    gf3d_bindless.imageInfo = gfc_allocate_array(sizeof(VkDescriptorImageInfo),gf3d_bindless.maxTextures);
+    gf3d_bindless.writes = gfc_allocate_array(sizeof(VkWriteDescriptorSet),gf3d_bindless.maxTextures);
+    if ((!gf3d_bindless.sets)||(!gf3d_bindless.slots)||(!gf3d_bindless.dirty)||(!gf3d_bindless.freeList)||
+        (!gf3d_bindless.retired)||(!gf3d_bindless.imageInfo)||(!gf3d_bindless.writes))
+    {
+        slog("failed to allocate bindless texture data");
+        return;
+    }
+    if (!gf3d_bindless_create_sets())return;
+    //pushed in reverse so slots are handed out from 1 up, 0 means no texture
+    for (i = gf3d_bindless.maxTextures - 1; i > 0; i--)
+    {
+        gf3d_bindless.freeList[gf3d_bindless.freeCount++] = i;
+    }
+    gf3d_bindless.enabled = true;
+    if (__DEBUG)slog("bindless textures initialized for %i textures",gf3d_bindless.maxTextures);
+}
+
+Bool gf3d_bindless_enabled()
+{
+    return gf3d_bindless.enabled;
+}
+
+VkDescriptorSetLayout gf3d_bindless_get_layout()
+{
+    if (!gf3d_bindless.enabled)return VK_NULL_HANDLE;
+    return gf3d_bindless.layout;
+}
+
+VkDescriptorSet *gf3d_bindless_get_descriptor_set(Uint32 frame)
+{
+    if ((!gf3d_bindless.enabled)||(frame >= gf3d_bindless.chainLength))return NULL;
+    return &gf3d_bindless.sets[frame];
+}
+
+void gf3d_bindless_mark_dirty(Uint32 index)
+{
+    Uint32 allFrames = (gf3d_bindless.chainLength >= 32)?0xFFFFFFFF:((1u << gf3d_bindless.chainLength) - 1);
+    gf3d_bindless.dirty[index] = allFrames;
+    gf3d_bindless.pendingFrames = allFrames;
+}
+
+void gf3d_bindless_add_texture(Texture *tex)
+{
+    Uint32 index;
+    if ((!gf3d_bindless.enabled)||(!tex)||(tex->bindlessIndex))return;
+    if ((tex->textureImageView == VK_NULL_HANDLE)||(tex->textureSampler == VK_NULL_HANDLE))return;
+    if (!gf3d_bindless.freeCount)
+    {
+        slog("bindless texture array is full, %i textures",gf3d_bindless.maxTextures);
+        return;
+    }
+    index = gf3d_bindless.freeList[--gf3d_bindless.freeCount];
+    gf3d_bindless.slots[index] = tex;
+    tex->bindlessIndex = index;
+    gf3d_bindless_mark_dirty(index);
+}
+
+void gf3d_bindless_update_texture(Texture *tex)
+{
+    if ((!gf3d_bindless.enabled)||(!tex))return;
+    if (!tex->bindlessIndex)
+    {
+        gf3d_bindless_add_texture(tex);
+        return;
+    }
+    gf3d_bindless_mark_dirty(tex->bindlessIndex);
+}
+
+void gf3d_bindless_remove_texture(Texture *tex)
+{
+    Uint32 index;
+    if ((!gf3d_bindless.enabled)||(!tex)||(!tex->bindlessIndex))return;
+    index = tex->bindlessIndex;
+    tex->bindlessIndex = 0;
+    if ((index >= gf3d_bindless.maxTextures)||(gf3d_bindless.slots[index] != tex))return;
+    gf3d_bindless.slots[index] = NULL;
+    gf3d_bindless.dirty[index] = 0;
+    //frames already recorded may still sample this slot, it is reused once they are done
+    gf3d_bindless.retired[gf3d_bindless.retiredCount].index = index;
+    gf3d_bindless.retired[gf3d_bindless.retiredCount].frame = gf3d_bindless.frameCount;
+    gf3d_bindless.retiredCount++;
+}
+
+void gf3d_bindless_recycle()
+{
+    Uint32 i;
+    for (i = 0; i < gf3d_bindless.retiredCount;)
+    {
+        if (gf3d_bindless.frameCount - gf3d_bindless.retired[i].frame <= gf3d_bindless.chainLength)
+        {
+            i++;
+            continue;
+        }
+        gf3d_bindless.freeList[gf3d_bindless.freeCount++] = gf3d_bindless.retired[i].index;
+        gf3d_bindless.retired[i] = gf3d_bindless.retired[--gf3d_bindless.retiredCount];
+    }
+}
+
+void gf3d_bindless_begin_frame(Uint32 frame)
+{
+    Uint32 i,count = 0;
+    Uint32 bit;
+    Texture *tex;
+    if ((!gf3d_bindless.enabled)||(frame >= gf3d_bindless.chainLength))return;
+    gf3d_bindless.frameCount++;
+    if (gf3d_bindless.retiredCount)gf3d_bindless_recycle();
+    bit = 1u << frame;
+    if (!(gf3d_bindless.pendingFrames & bit))return;
+    for (i = 1; i < gf3d_bindless.maxTextures; i++)
+    {
+        if (!(gf3d_bindless.dirty[i] & bit))continue;
+        gf3d_bindless.dirty[i] &= ~bit;
+        tex = gf3d_bindless.slots[i];
+        if (!tex)continue;
+        gf3d_bindless.imageInfo[count].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        gf3d_bindless.imageInfo[count].imageView = tex->textureImageView;
+        gf3d_bindless.imageInfo[count].sampler = tex->textureSampler;
+        memset(&gf3d_bindless.writes[count],0,sizeof(VkWriteDescriptorSet));
+        gf3d_bindless.writes[count].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        gf3d_bindless.writes[count].dstSet = gf3d_bindless.sets[frame];
+        gf3d_bindless.writes[count].dstBinding = 0;
+        gf3d_bindless.writes[count].dstArrayElement = i;
+        gf3d_bindless.writes[count].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        gf3d_bindless.writes[count].descriptorCount = 1;
+        gf3d_bindless.writes[count].pImageInfo = &gf3d_bindless.imageInfo[count];
+        count++;
+    }
+    gf3d_bindless.pendingFrames &= ~bit;
+    if (!count)return;
+    vkUpdateDescriptorSets(gf3d_bindless.device, count, gf3d_bindless.writes, 0, NULL);
+    gf3d_stats_add(SC_DescriptorWrites,count);
+}
+
+/*eol@eof*/
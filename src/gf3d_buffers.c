@@ -1,6 +1,8 @@
 #include "simple_logger.h"
 
 #include "gf3d_vgraphics.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
 #include "gf3d_buffers.h"
 
 void gf3d_buffer_copy(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
@@ -16,11 +18,29 @@ void gf3d_buffer_copy(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
     
 }
 
-int gf3d_buffer_create(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer * buffer, VkDeviceMemory * bufferMemory)
+/**
+ * @brief what a buffer is for, from how it is used, for the object tracker
+ */
+const char *gf3d_buffer_get_tag(VkBufferUsageFlags usage,VkMemoryPropertyFlags properties)
+{
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT)&&(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))return "staging buffer";
+    if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)return "vertex buffer";
+    if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)return "index buffer";
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)return "uniform buffer";
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)return "storage buffer";
+    return "buffer";
+}
+
+int gf3d_buffer_create_at(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer * buffer, VkDeviceMemory * bufferMemory,const char *file,int line)
 {
     VkBufferCreateInfo bufferInfo = {0};
     VkMemoryRequirements memRequirements;
     VkMemoryAllocateInfo allocInfo = {0};
+    const char *tag;
+
+    *buffer = VK_NULL_HANDLE;
+    *bufferMemory = VK_NULL_HANDLE;
+    tag = gf3d_buffer_get_tag(usage,properties);
 
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
@@ -30,8 +50,10 @@ int gf3d_buffer_create(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryProp
     if (vkCreateBuffer(gf3d_vgraphics_get_default_logical_device(), &bufferInfo, NULL, buffer) != VK_SUCCESS)
     {
         slog("failed to create buffer!");
+        *buffer = VK_NULL_HANDLE;
         return 0;
     }
+    gf3d_tracker_create_at(TC_Buffer,(Uint64)*buffer,0,tag,file,line);//its bytes are counted with the memory
 
     vkGetBufferMemoryRequirements(gf3d_vgraphics_get_default_logical_device(), *buffer, &memRequirements);
 
@@ -43,11 +65,37 @@ int gf3d_buffer_create(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryProp
     if (vkAllocateMemory(gf3d_vgraphics_get_default_logical_device(), &allocInfo, NULL, bufferMemory) != VK_SUCCESS)
     {
         slog("failed to allocate buffer memory!");
+        *bufferMemory = VK_NULL_HANDLE;
+        gf3d_buffer_free(*buffer,VK_NULL_HANDLE);
+        *buffer = VK_NULL_HANDLE;
         return 0;
     }
+    gf3d_stats_memory_alloc(*bufferMemory,allocInfo.allocationSize,allocInfo.memoryTypeIndex);
+    gf3d_tracker_create_at(TC_Memory,(Uint64)*bufferMemory,allocInfo.allocationSize,tag,file,line);
+    //host visible transfer sources are the staging buffers, they are filled once and copied from
+    if ((usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT)&&(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+    {
+        gf3d_stats_add(SC_StagingBytes,size);
+    }
 
     vkBindBufferMemory(gf3d_vgraphics_get_default_logical_device(), *buffer, *bufferMemory, 0);
     return 1;
 }
 
+void gf3d_buffer_free(VkBuffer buffer,VkDeviceMemory bufferMemory)
+{
+    VkDevice device = gf3d_vgraphics_get_default_logical_device();
+    if (buffer != VK_NULL_HANDLE)
+    {
+        gf3d_tracker_destroy(TC_Buffer,buffer);
+        vkDestroyBuffer(device, buffer, NULL);
+    }
+    if (bufferMemory != VK_NULL_HANDLE)
+    {
+        gf3d_stats_memory_free(bufferMemory);
+        gf3d_tracker_destroy(TC_Memory,bufferMemory);
+        vkFreeMemory(device, bufferMemory, NULL);
+    }
+}
+
 /*eol@eof*/
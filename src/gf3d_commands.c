@@ -6,6 +6,10 @@
 #include "gf3d_vgraphics.h"
 #include "gf3d_vqueues.h"
 #include "gf3d_swapchain.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
+#include "gf3d_profiler.h"
+#include "gf3d_texture.h"
 
 
 extern int __DEBUG;
@@ -75,6 +79,7 @@ void gf3d_command_free(Command *com)
     if ((!com)||(!com->_inuse))return;
     if (com->commandPool != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_CommandPool,com->commandPool);
         vkDestroyCommandPool(gf3d_commands.device, com->commandPool, NULL);
     }
     if (com->commandBuffers)
@@ -105,8 +110,11 @@ Command * gf3d_command_graphics_pool_setup(Uint32 count)
     if (vkCreateCommandPool(gf3d_commands.device, &poolInfo, NULL, &com->commandPool) != VK_SUCCESS)
     {
         slog("failed to create command pool!");
+        com->commandPool = VK_NULL_HANDLE;
+        gf3d_command_free(com);
         return NULL;
     }
+    gf3d_tracker_create(TC_CommandPool,com->commandPool,0,"graphics commands");
     
     com->commandBuffers = (VkCommandBuffer*)gfc_allocate_array(sizeof(VkCommandBuffer),count);
     if (!com->commandBuffers)
@@ -171,6 +179,8 @@ VkCommandBuffer gf3d_command_rendering_begin(Uint32 index,Pipeline *pipe)
     VkCommandBuffer commandBuffer;
     
     commandBuffer = gf3d_command_begin_single_time(gf3d_vgraphics_get_graphics_command_pool());
+    gf3d_profiler_reset_queries(commandBuffer);
+    gf3d_texture_record_streams(commandBuffer);
     
     gf3d_command_configure_render_pass(
             commandBuffer,
@@ -207,6 +217,7 @@ void gf3d_command_configure_render_pass(VkCommandBuffer commandBuffer, VkRenderP
     
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    gf3d_stats_add(SC_Binds,1);
 }
 
 VkCommandBuffer gf3d_command_begin_single_time(Command* com)
@@ -237,6 +248,7 @@ VkCommandBuffer gf3d_command_begin_single_time(Command* com)
 void gf3d_command_end_single_time(Command *com, VkCommandBuffer commandBuffer)
 {
     VkSubmitInfo submitInfo = {0};
+    Uint64 start;
     
     vkEndCommandBuffer(commandBuffer);
 
@@ -245,7 +257,10 @@ void gf3d_command_end_single_time(Command *com, VkCommandBuffer commandBuffer)
     submitInfo.pCommandBuffers = &commandBuffer;
 
     vkQueueSubmit(gf3d_vqueues_get_graphics_queue(), 1, &submitInfo, VK_NULL_HANDLE);
+    start = SDL_GetPerformanceCounter();
     vkQueueWaitIdle(gf3d_vqueues_get_graphics_queue());
+    gf3d_stats_add(SC_SingleTimeSubmits,1);
+    gf3d_stats_add_stall((SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
 
     vkFreeCommandBuffers(gf3d_commands.device, com->commandPool, 1, &commandBuffer);
 }
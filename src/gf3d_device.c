@@ -22,6 +22,8 @@ typedef struct
     int bestDevice;                 /**<index of the chosen physical device*/
     GF3D_Device *chosen_gpu;        /**< physical device to use for logical device*/
     VkSurfaceKHR renderSurface;     /**<vulkan surface target for the screen/window  owned by graphics*/
+    Bool bindless;                  /**<if descriptor indexing is enabled for bindless textures*/
+    VkPhysicalDeviceDescriptorIndexingFeatures bindlessFeatures;   /**<the descriptor indexing features turned on*/
 }GF3D_DeviceManager;
 
 static GF3D_DeviceManager gf3d_device_manager = {0};
@@ -31,6 +33,7 @@ void gf3d_device_manager_determine_best();
 GF3D_Device *gf3d_device_get_info(VkPhysicalDevice device);
 VkDevice gf3d_device_create_logic_device(Bool enableValidationLayers);
 VkDeviceCreateInfo gf3d_device_get_logical_device_info(Bool enableValidationLayers);
+void gf3d_device_setup_bindless();
 
 
 void gf3d_device_manager_close()
@@ -100,6 +103,7 @@ void gf3d_device_manager_init(const char *config, VkInstance instance, VkSurface
     
     //setup device extensions
     gf3d_extensions_device_init(gf3d_device_manager.chosen_gpu->device,config);
+    gf3d_device_setup_bindless();
 
     gf3d_device_create_logic_device(enable_validation);
     
@@ -111,6 +115,7 @@ GF3D_Device *gf3d_device_get_info(VkPhysicalDevice device)
 {
     GF3D_Device *device_info;
     SJson *device_config;
+    VkPhysicalDeviceFeatures2 features2 = {0};
     
     if (!device)return NULL;
     device_info = gfc_allocate_array(sizeof(GF3D_Device),1);
@@ -119,6 +124,14 @@ GF3D_Device *gf3d_device_get_info(VkPhysicalDevice device)
     device_info->device = device;
     vkGetPhysicalDeviceFeatures(device, &device_info->deviceFeatures);
     vkGetPhysicalDeviceProperties(device, &device_info->deviceProperties);
+    if (device_info->deviceProperties.apiVersion >= VK_API_VERSION_1_1)
+    {
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &device_info->indexingFeatures;
+        device_info->indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+        device_info->indexingFeatures.pNext = NULL;
+    }
     
     device_config = sj_object_get_value(gf3d_device_manager.config,"devices");
     if (device_config)
@@ -254,6 +267,42 @@ VkDevice gf3d_device_get()
     return gf3d_device_manager.device;
 }
 
+void gf3d_device_setup_bindless()
+{
+    short int enable = false;
+    GF3D_Device *gpu = gf3d_device_manager.chosen_gpu;
+    VkPhysicalDeviceDescriptorIndexingFeatures *features;
+    sj_get_bool_value(sj_object_get_value(gf3d_device_manager.config,"bindless_textures"),&enable);
+    if ((!enable)||(!gpu))return;
+    features = &gpu->indexingFeatures;
+    if ((!features->runtimeDescriptorArray)||
+        (!features->descriptorBindingPartiallyBound)||
+        (!features->descriptorBindingSampledImageUpdateAfterBind))
+    {
+        slog("device does not support descriptor indexing, bindless textures disabled");
+        return;
+    }
+    //core since 1.2, older devices need the extension
+    if ((gpu->deviceProperties.apiVersion < VK_API_VERSION_1_2)&&
+        (!gf3d_extensions_enable(ET_Device,VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)))
+    {
+        slog("failed to enable %s, bindless textures disabled",VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        return;
+    }
+    gf3d_device_manager.bindlessFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    gf3d_device_manager.bindlessFeatures.runtimeDescriptorArray = VK_TRUE;
+    gf3d_device_manager.bindlessFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    gf3d_device_manager.bindlessFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    gf3d_device_manager.bindlessFeatures.shaderSampledImageArrayNonUniformIndexing = features->shaderSampledImageArrayNonUniformIndexing;
+    gf3d_device_manager.bindless = true;
+    if (__DEBUG)slog("bindless textures enabled");
+}
+
+Bool gf3d_device_bindless_enabled()
+{
+    return gf3d_device_manager.bindless;
+}
+
 VkDevice gf3d_device_create_logic_device(Bool enableValidationLayers)
 {
     VkPhysicalDevice gpu;
@@ -304,6 +353,7 @@ VkDeviceCreateInfo gf3d_device_get_logical_device_info(Bool enableValidationLaye
     createInfo.queueCreateInfoCount = count;
 
     createInfo.pEnabledFeatures = &gf3d_device_manager.chosen_gpu->deviceFeatures;
+    if (gf3d_device_manager.bindless)createInfo.pNext = &gf3d_device_manager.bindlessFeatures;
     
     
     createInfo.ppEnabledExtensionNames = gf3d_extensions_get_device_enabled_names(&count);
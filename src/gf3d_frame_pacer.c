@@ -0,0 +1,141 @@
+#include <math.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_swapchain.h"
+#include "gf3d_trace.h"
+#include "gf3d_frame_pacer.h"
+
+#define PACER_SPIN_MS 2     /**<the end of a wait is spun instead of slept, SDL_Delay can overshoot by about this much*/
+#define PACER_CHECK_FRAMES 120  /**<frames averaged before checking the pacing holds the target*/
+
+typedef struct
+{
+    Uint64          frequency;
+    Uint64          interval;       /**<ticks between frame starts, 0 to not wait*/
+    Uint64          next;           /**<when the next frame should start*/
+    Uint64          last;           /**<when the last wait returned*/
+    Uint64          windowStart;    /**<when the current check window began*/
+    Uint32          windowFrames;
+    FramePacing     pacing;
+}FramePacer;
+
+extern int __DEBUG;
+static FramePacer gf3d_frame_pacer = {0};
+
+void gf3d_frame_pacer_init(float targetFps,float refreshRate)
+{
+    VkPresentModeKHR mode;
+    float intervals;
+    memset(&gf3d_frame_pacer,0,sizeof(FramePacer));
+    gf3d_frame_pacer.frequency = SDL_GetPerformanceFrequency();
+    if (refreshRate <= 0)refreshRate = 60;
+    mode = gf3d_swapchain_get_present_mode();
+    gf3d_frame_pacer.pacing.refreshMs = 1000.0 / refreshRate;
+    gf3d_frame_pacer.pacing.vsync = (mode == VK_PRESENT_MODE_FIFO_KHR)||(mode == VK_PRESENT_MODE_FIFO_RELAXED_KHR);
+    if (targetFps > 0)
+    {
+        gf3d_frame_pacer.pacing.targetMs = 1000.0 / targetFps;
+        if (gf3d_frame_pacer.pacing.vsync)
+        {
+            //only whole refresh intervals can be shown.  The vsync wait happens inside the frame, so frame starts
+            //are paced the full target apart and fifo lines each frame up with the vblank
+            intervals = MAX(floor(gf3d_frame_pacer.pacing.targetMs / gf3d_frame_pacer.pacing.refreshMs + 0.1),1);
+            gf3d_frame_pacer.pacing.targetMs = intervals * gf3d_frame_pacer.pacing.refreshMs;
+            if (intervals > 1)
+            {
+                gf3d_frame_pacer.interval = (Uint64)(gf3d_frame_pacer.pacing.targetMs * gf3d_frame_pacer.frequency / 1000.0);
+            }
+        }
+        else gf3d_frame_pacer.interval = (Uint64)(gf3d_frame_pacer.pacing.targetMs * gf3d_frame_pacer.frequency / 1000.0);
+    }
+    else if (gf3d_frame_pacer.pacing.vsync)gf3d_frame_pacer.pacing.targetMs = gf3d_frame_pacer.pacing.refreshMs;
+    slog("frame pacing: %s, %.2fms frames on a %.2fms display",
+        gf3d_swapchain_present_mode_name(mode),
+        gf3d_frame_pacer.pacing.targetMs,
+        gf3d_frame_pacer.pacing.refreshMs);
+}
+
+/**
+ * @brief check the mean frame time over a window against the target, eg a 30 fps target on a 60hz display
+ * should give frames of about 33ms, not the display's 16.7
+ */
+void gf3d_frame_pacer_check(Uint64 now)
+{
+    FramePacing *pacing = &gf3d_frame_pacer.pacing;
+    if (!gf3d_frame_pacer.windowStart)
+    {
+        gf3d_frame_pacer.windowStart = now;
+        return;
+    }
+    if (++gf3d_frame_pacer.windowFrames < PACER_CHECK_FRAMES)return;
+    pacing->windowMs = (float)(now - gf3d_frame_pacer.windowStart) * 1000.0 / gf3d_frame_pacer.frequency / gf3d_frame_pacer.windowFrames;
+    gf3d_frame_pacer.windowStart = now;
+    gf3d_frame_pacer.windowFrames = 0;
+    if (pacing->targetMs <= 0)return;
+    if (fabs(pacing->windowMs - pacing->targetMs) > pacing->refreshMs * 0.25)
+    {
+        slog("frame pacing off target: %.2fms frames over the last %i for a %.2fms target",
+            pacing->windowMs,PACER_CHECK_FRAMES,pacing->targetMs);
+    }
+}
+
+void gf3d_frame_pacer_measure(Uint64 now,float waitMs)
+{
+    FramePacing *pacing = &gf3d_frame_pacer.pacing;
+    pacing->waitMs = waitMs;
+    if (!gf3d_frame_pacer.last)return;
+    pacing->frames++;
+    pacing->frameMs = (float)(now - gf3d_frame_pacer.last) * 1000.0 / gf3d_frame_pacer.frequency;
+    pacing->averageMs = (pacing->frames == 1)?pacing->frameMs:(pacing->averageMs * 0.95) + (pacing->frameMs * 0.05);
+    pacing->intervals = pacing->frameMs / pacing->refreshMs;
+    if ((pacing->targetMs > 0)&&(pacing->frameMs > pacing->targetMs + pacing->refreshMs * 0.5))
+    {
+        pacing->missed++;
+        if (__DEBUG)slog("frame took %.2fms (%.1f refresh intervals) for a %.2fms slot",pacing->frameMs,pacing->intervals,pacing->targetMs);
+    }
+}
+
+void gf3d_frame_pacer_wait()
+{
+    Uint64 now,start;
+    Sint64 remaining;
+    TraceZone zone;
+    if (!gf3d_frame_pacer.frequency)return;
+    now = start = SDL_GetPerformanceCounter();
+    if ((gf3d_frame_pacer.interval)&&(gf3d_frame_pacer.next))
+    {
+        zone = gf3d_trace_begin("frame_pacer");
+        remaining = (Sint64)(gf3d_frame_pacer.next - now);
+        if (remaining > 0)
+        {
+            remaining = remaining * 1000 / (Sint64)gf3d_frame_pacer.frequency;
+            if (remaining > PACER_SPIN_MS)SDL_Delay((Uint32)(remaining - PACER_SPIN_MS));
+            while ((now = SDL_GetPerformanceCounter()) < gf3d_frame_pacer.next);
+        }
+        gf3d_trace_end(zone);
+        //hold a steady cadence, unless a whole frame was lost and it is better to start over
+        if (now - gf3d_frame_pacer.next < gf3d_frame_pacer.interval)gf3d_frame_pacer.next += gf3d_frame_pacer.interval;
+        else gf3d_frame_pacer.next = now + gf3d_frame_pacer.interval;
+    }
+    else gf3d_frame_pacer.next = now + gf3d_frame_pacer.interval;
+    gf3d_frame_pacer_measure(now,(float)(now - start) * 1000.0 / gf3d_frame_pacer.frequency);
+    gf3d_frame_pacer_check(now);
+    gf3d_frame_pacer.last = now;
+}
+
+const FramePacing *gf3d_frame_pacer_get()
+{
+    return &gf3d_frame_pacer.pacing;
+}
+
+float gf3d_frame_pacer_get_fps()
+{
+    if (gf3d_frame_pacer.pacing.averageMs <= 0)return 0;
+    return 1000.0 / gf3d_frame_pacer.pacing.averageMs;
+}
+
+/*eol@eof*/
@@ -0,0 +1,262 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_swapchain.h"
+#include "gf3d_buffers.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
+#include "gf3d_frame_ubo.h"
+
+typedef struct
+{
+    VkDevice                device;
+    Uint32                  chainLength;
+    VkDescriptorSetLayout   layout;
+    VkDescriptorPool        pool;
+    VkDescriptorSet        *sets;       /**<one per swap frame*/
+    VkBuffer               *buffers;
+    VkDeviceMemory         *memory;
+    FrameUBO              **mapped;     /**<persistently mapped buffer memory*/
+    FrameUBO                data;       /**<cpu copy of the last update*/
+    Uint32                  startTicks;
+    Uint32                  lastTicks;
+    Uint32                  frameCount;
+    FrameUBOLatch           latch;      /**<if set, rewrites the view right before submit*/
+    void                   *latchData;
+}FrameUBOManager;
+
+extern int __DEBUG;
+static FrameUBOManager gf3d_frame_ubo = {0};
+
+void gf3d_frame_ubo_close()
+{
+    Uint32 i;
+    for (i = 0; (gf3d_frame_ubo.buffers)&&(gf3d_frame_ubo.memory)&&(gf3d_frame_ubo.mapped)&&(i < gf3d_frame_ubo.chainLength); i++)
+    {
+        if (gf3d_frame_ubo.mapped[i])vkUnmapMemory(gf3d_frame_ubo.device,gf3d_frame_ubo.memory[i]);
+        gf3d_buffer_free(gf3d_frame_ubo.buffers[i],gf3d_frame_ubo.memory[i]);
+    }
+    if (gf3d_frame_ubo.pool != VK_NULL_HANDLE)
+    {
+        gf3d_tracker_destroy(TC_DescriptorPool,gf3d_frame_ubo.pool);
+        vkDestroyDescriptorPool(gf3d_frame_ubo.device,gf3d_frame_ubo.pool,NULL);
+    }
+    if (gf3d_frame_ubo.layout != VK_NULL_HANDLE)
+    {
+        gf3d_tracker_destroy(TC_DescriptorSetLayout,gf3d_frame_ubo.layout);
+        vkDestroyDescriptorSetLayout(gf3d_frame_ubo.device,gf3d_frame_ubo.layout,NULL);
+    }
+    if (gf3d_frame_ubo.sets)free(gf3d_frame_ubo.sets);
+    if (gf3d_frame_ubo.buffers)free(gf3d_frame_ubo.buffers);
+    if (gf3d_frame_ubo.memory)free(gf3d_frame_ubo.memory);
+    if (gf3d_frame_ubo.mapped)free(gf3d_frame_ubo.mapped);
+    memset(&gf3d_frame_ubo,0,sizeof(FrameUBOManager));
+    if (__DEBUG)slog("frame ubo closed");
+}
+
+int gf3d_frame_ubo_create_sets()
+{
+    Uint32 i;
+    VkDescriptorSetLayoutBinding binding = {0};
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {0};
+    VkDescriptorPoolSize poolSize = {0};
+    VkDescriptorPoolCreateInfo poolInfo = {0};
+    VkDescriptorSetAllocateInfo allocInfo = {0};
+    VkDescriptorSetLayout *layouts;
+    VkDescriptorBufferInfo bufferInfo = {0};
+    VkWriteDescriptorSet write = {0};
+
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(gf3d_frame_ubo.device, &layoutInfo, NULL, &gf3d_frame_ubo.layout) != VK_SUCCESS)
+    {
+        slog("failed to create frame ubo descriptor set layout");
+        gf3d_frame_ubo.layout = VK_NULL_HANDLE;
+        return 0;
+    }
+    gf3d_tracker_create(TC_DescriptorSetLayout,gf3d_frame_ubo.layout,0,"frame ubo");
+
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSize.descriptorCount = gf3d_frame_ubo.chainLength;
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = gf3d_frame_ubo.chainLength;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(gf3d_frame_ubo.device, &poolInfo, NULL, &gf3d_frame_ubo.pool) != VK_SUCCESS)
+    {
+        slog("failed to create frame ubo descriptor pool");
+        gf3d_frame_ubo.pool = VK_NULL_HANDLE;
+        return 0;
+    }
+    gf3d_tracker_create(TC_DescriptorPool,gf3d_frame_ubo.pool,0,"frame ubo");
+
+    layouts = gfc_allocate_array(sizeof(VkDescriptorSetLayout),gf3d_frame_ubo.chainLength);
+    if (!layouts)return 0;
+    for (i = 0; i < gf3d_frame_ubo.chainLength; i++)
+    {
+        layouts[i] = gf3d_frame_ubo.layout;
+    }
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = gf3d_frame_ubo.pool;
+    allocInfo.descriptorSetCount = gf3d_frame_ubo.chainLength;
+    allocInfo.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(gf3d_frame_ubo.device, &allocInfo, gf3d_frame_ubo.sets) != VK_SUCCESS)
+    {
+        slog("failed to allocate frame ubo descriptor sets");
+        free(layouts);
+        return 0;
+    }
+    free(layouts);
+
+    //each set always points at its own frame's buffer, so they are only written once
+    for (i = 0; i < gf3d_frame_ubo.chainLength; i++)
+    {
+        bufferInfo.buffer = gf3d_frame_ubo.buffers[i];
+        bufferInfo.offset = 0;
+        bufferInfo.range = sizeof(FrameUBO);
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = gf3d_frame_ubo.sets[i];
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(gf3d_frame_ubo.device, 1, &write, 0, NULL);
+        gf3d_stats_add(SC_DescriptorWrites,1);
+    }
+    return 1;
+}
+
+void gf3d_frame_ubo_init()
+{
+    Uint32 i;
+    gf3d_frame_ubo.device = gf3d_vgraphics_get_default_logical_device();
+    gf3d_frame_ubo.chainLength = gf3d_swapchain_get_swap_image_count();
+    if (!gf3d_frame_ubo.chainLength)
+    {
+        slog("cannot setup frame ubo without a swap chain");
+        return;
+    }
+    gf3d_frame_ubo.sets = gfc_allocate_array(sizeof(VkDescriptorSet),gf3d_frame_ubo.chainLength);
+    gf3d_frame_ubo.buffers = gfc_allocate_array(sizeof(VkBuffer),gf3d_frame_ubo.chainLength);
+    gf3d_frame_ubo.memory = gfc_allocate_array(sizeof(VkDeviceMemory),gf3d_frame_ubo.chainLength);
+    gf3d_frame_ubo.mapped = gfc_allocate_array(sizeof(FrameUBO *),gf3d_frame_ubo.chainLength);
+    if ((!gf3d_frame_ubo.sets)||(!gf3d_frame_ubo.buffers)||(!gf3d_frame_ubo.memory)||(!gf3d_frame_ubo.mapped))
+    {
+        slog("failed to allocate frame ubo lists");
+        gf3d_frame_ubo_close();
+        return;
+    }
+    atexit(gf3d_frame_ubo_close);
+    for (i = 0; i < gf3d_frame_ubo.chainLength; i++)
+    {
+        if (!gf3d_buffer_create(
+            sizeof(FrameUBO),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &gf3d_frame_ubo.buffers[i],
+            &gf3d_frame_ubo.memory[i]))
+        {
+            slog("failed to create frame ubo buffer for frame %i",i);
+            return;
+        }
+        vkMapMemory(gf3d_frame_ubo.device,gf3d_frame_ubo.memory[i],0,sizeof(FrameUBO),0,(void **)&gf3d_frame_ubo.mapped[i]);
+    }
+    if (!gf3d_frame_ubo_create_sets())return;
+    gf3d_frame_ubo.startTicks = gf3d_frame_ubo.lastTicks = SDL_GetTicks();
+    if (__DEBUG)slog("frame ubo initialized");
+}
+
+/**
+ * @brief fill in the fields that come from the view and projection
+ */
+void gf3d_frame_ubo_update_camera(FrameUBO *ubo)
+{
+    int i,j,k;
+    //column major, the same as the shaders' proj * view
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            ubo->viewProj[i][j] = 0;
+            for (k = 0; k < 4; k++)
+            {
+                ubo->viewProj[i][j] += ubo->proj[k][j] * ubo->view[i][k];
+            }
+        }
+    }
+    //camera position is the view translation brought back into world space
+    for (i = 0; i < 3; i++)
+    {
+        ((float *)&ubo->camera)[i] = -(ubo->view[3][0]*ubo->view[i][0] + ubo->view[3][1]*ubo->view[i][1] + ubo->view[3][2]*ubo->view[i][2]);
+    }
+    ubo->camera.w = 1;
+}
+
+void gf3d_frame_ubo_update(Uint32 frame)
+{
+    Uint32 now;
+    GFC_Vector2D extent;
+    FrameUBO *ubo = &gf3d_frame_ubo.data;
+    if ((frame >= gf3d_frame_ubo.chainLength)||(!gf3d_frame_ubo.mapped)||(!gf3d_frame_ubo.mapped[frame]))return;
+    gf3d_vgraphics_get_view(&ubo->view);
+    gf3d_vgraphics_get_projection_matrix(&ubo->proj);
+    gf3d_frame_ubo_update_camera(ubo);
+    now = SDL_GetTicks();
+    ubo->time.x = (now - gf3d_frame_ubo.startTicks) * 0.001;
+    ubo->time.y = (now - gf3d_frame_ubo.lastTicks) * 0.001;
+    ubo->time.z = gf3d_frame_ubo.frameCount++;
+    gf3d_frame_ubo.lastTicks = now;
+    extent = gf3d_vgraphics_get_view_extent_as_vector2d();
+    ubo->resolution.x = extent.x;
+    ubo->resolution.y = extent.y;
+    ubo->resolution.z = extent.x?1.0/extent.x:0;
+    ubo->resolution.w = extent.y?1.0/extent.y:0;
+    memcpy(gf3d_frame_ubo.mapped[frame],ubo,sizeof(FrameUBO));
+}
+
+void gf3d_frame_ubo_set_late_latch(FrameUBOLatch latch,void *data)
+{
+    gf3d_frame_ubo.latch = latch;
+    gf3d_frame_ubo.latchData = data;
+    if (__DEBUG)slog("frame ubo late latch %s",latch?"on":"off");
+}
+
+Bool gf3d_frame_ubo_late_latch(Uint32 frame)
+{
+    FrameUBO *ubo = &gf3d_frame_ubo.data;
+    if (!gf3d_frame_ubo.latch)return 0;
+    if ((frame >= gf3d_frame_ubo.chainLength)||(!gf3d_frame_ubo.mapped)||(!gf3d_frame_ubo.mapped[frame]))return 0;
+    gf3d_frame_ubo.latch(ubo->view,gf3d_frame_ubo.latchData);
+    memcpy(gf3d_vgraphics_get_view_matrix(),ubo->view,sizeof(GFC_Matrix4));
+    gf3d_frame_ubo_update_camera(ubo);
+    //only the camera changed, time and resolution stay as written at render start
+    memcpy(gf3d_frame_ubo.mapped[frame],ubo,offsetof(FrameUBO,time));
+    return 1;
+}
+
+VkDescriptorSetLayout gf3d_frame_ubo_get_layout()
+{
+    return gf3d_frame_ubo.layout;
+}
+
+VkDescriptorSet *gf3d_frame_ubo_get_descriptor_set(Uint32 frame)
+{
+    if ((!gf3d_frame_ubo.sets)||(frame >= gf3d_frame_ubo.chainLength))return NULL;
+    return &gf3d_frame_ubo.sets[frame];
+}
+
+const FrameUBO *gf3d_frame_ubo_get()
+{
+    return &gf3d_frame_ubo.data;
+}
+
+/*eol@eof*/
@@ -1,3 +1,11 @@
+#include <stdio.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "simple_logger.h"
 #include "simple_json.h"
 
@@ -11,9 +19,13 @@
 
 #include "gf3d_gltf_parse.h"
 
+#define GLB_MAGIC       0x46546C67  /**<"glTF"*/
+#define GLB_CHUNK_JSON  0x4E4F534A  /**<"JSON"*/
+#define GLB_CHUNK_BIN   0x004E4942  /**<"BIN\0"*/
 
 void gf3d_gltf_reorg_obj(ObjData *obj);
 char *gf3d_gltf_decode(SJson *gltf, Uint32 bufferIndex);
+SJson *gf3d_gltf_parse_get_buffer_view(SJson *gltf,Uint32 index);
 
 
 GLTF *gf3d_gltf_new()
@@ -23,45 +35,255 @@ GLTF *gf3d_gltf_new()
     return gltf;
 }
 
+/**
+ * @brief map a file into memory if it exists on disk, otherwise extract it from the pak
+ * @param filename the file to get
+ * @param size [output] the size of the returned block
+ * @param mapped [output] set to 1 if the block was mapped, 0 if it was allocated
+ * @return NULL if the file could not be found, the file contents otherwise
+ */
+void *gf3d_gltf_map_file(const char *filename,size_t *size,Uint8 *mapped)
+{
+#ifndef _WIN32
+    int fd;
+    struct stat st;
+    void *mem;
+#endif
+    if ((!filename)||(!size)||(!mapped))return NULL;
+    *mapped = 0;
+#ifndef _WIN32
+    fd = open(filename,O_RDONLY);
+    if (fd >= 0)
+    {
+        if ((fstat(fd,&st) == 0)&&(st.st_size > 0))
+        {
+            mem = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+            if (mem != MAP_FAILED)
+            {
+                close(fd);
+                *size = st.st_size;
+                *mapped = 1;
+                return mem;
+            }
+        }
+        close(fd);
+    }
+#endif
+    return gfc_pak_file_extract(filename,size);
+}
+
+void gf3d_gltf_buffer_release(GLTF_Buffer *buffer)
+{
+    if ((!buffer)||(!buffer->block))return;
+    if (buffer->mapped)
+    {
+#ifndef _WIN32
+        munmap(buffer->block,buffer->blockSize);
+#endif
+    }
+    else
+    {
+        free(buffer->block);
+    }
+    buffer->block = NULL;
+}
+
 void gf3d_gltf_free(GLTF *gltf)
 {
     int i,c;
-    char *buffer;
+    GLTF_Buffer *buffer;
     if (!gltf)return;
     c = gfc_list_get_count(gltf->buffers);
     for (i = 0; i < c; i++)
     {
         buffer = gfc_list_get_nth(gltf->buffers,i);
         if (!buffer)continue;
+        gf3d_gltf_buffer_release(buffer);
         free(buffer);
     }
     gfc_list_delete(gltf->buffers);
+    gf3d_gltf_buffer_release(&gltf->glb);
     sj_free(gltf->json);
     free(gltf);
 }
 
+Uint32 gf3d_gltf_read_le32(const char *data)
+{
+    Uint32 value;
+    memcpy(&value,data,sizeof(Uint32));
+    return SDL_SwapLE32(value);
+}
+
+/**
+ * @brief parse the chunks of a glb container, loading the json and locating the BIN chunk
+ * @param gltf the gltf with glb already mapped
+ * @param bin [output] set to the start of the BIN chunk, if there is one
+ * @param binSize [output] set to the length of the BIN chunk
+ * @return 0 on error, 1 otherwise
+ */
+int gf3d_gltf_parse_glb(GLTF *gltf,char **bin,size_t *binSize)
+{
+    const char *data;
+    char *jsonText;
+    size_t size,position;
+    Uint32 chunkLength,chunkType;
+    if ((!gltf)||(!gltf->glb.block))return 0;
+    data = gltf->glb.block;
+    size = gltf->glb.blockSize;
+    if ((size < 12)||(gf3d_gltf_read_le32(data) != GLB_MAGIC))
+    {
+        slog("file %s is not a binary gltf",gltf->filename);
+        return 0;
+    }
+    if (gf3d_gltf_read_le32(&data[4]) != 2)
+    {
+        slog("binary gltf %s is version %i, only version 2 is supported",gltf->filename,gf3d_gltf_read_le32(&data[4]));
+        return 0;
+    }
+    if (gf3d_gltf_read_le32(&data[8]) < size)size = gf3d_gltf_read_le32(&data[8]);
+    position = 12;
+    while (position + 8 <= size)
+    {
+        chunkLength = gf3d_gltf_read_le32(&data[position]);
+        chunkType = gf3d_gltf_read_le32(&data[position + 4]);
+        position += 8;
+        if (position + chunkLength > size)
+        {
+            slog("binary gltf %s has a truncated chunk",gltf->filename);
+            return 0;
+        }
+        if ((chunkType == GLB_CHUNK_JSON)&&(!gltf->json))
+        {
+            jsonText = gfc_allocate_array(sizeof(char),chunkLength + 1);
+            if (!jsonText)return 0;
+            memcpy(jsonText,&data[position],chunkLength);
+            gltf->json = sj_parse_buffer(jsonText,chunkLength);
+            free(jsonText);
+        }
+        else if ((chunkType == GLB_CHUNK_BIN)&&(bin)&&(!*bin))
+        {
+            *bin = (char *)&data[position];
+            if (binSize)*binSize = chunkLength;
+        }
+        position += chunkLength;
+    }
+    if (!gltf->json)
+    {
+        slog("binary gltf %s has no json chunk",gltf->filename);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief resolve a uri relative to the directory of the gltf file
+ */
+void gf3d_gltf_get_uri_path(GFC_TextLine out,const char *gltfFile,const char *uri)
+{
+    const char *slash;
+    slash = strrchr(gltfFile,'/');
+    if (!slash)
+    {
+        gfc_line_cpy(out,uri);
+        return;
+    }
+    snprintf(out,sizeof(GFC_TextLine),"%.*s/%s",(int)(slash - gltfFile),gltfFile,uri);
+}
+
+/**
+ * @brief get the bytes for one buffer of the gltf.  data: uris are decoded, external files are mapped and
+ * a uri-less buffer refers to the BIN chunk of the glb container in place.
+ */
+GLTF_Buffer *gf3d_gltf_load_buffer(GLTF *gltf,Uint32 bufferIndex,char *bin,size_t binSize)
+{
+    SJson *buffer;
+    GLTF_Buffer *out;
+    const char *uri;
+    GFC_TextLine path;
+    int byteLength = 0;
+
+    buffer = sj_array_get_nth(sj_object_get_value(gltf->json,"buffers"),bufferIndex);
+    if (!buffer)return NULL;
+    out = gfc_allocate_array(sizeof(GLTF_Buffer),1);
+    if (!out)return NULL;
+    sj_object_get_value_as_int(buffer,"byteLength",&byteLength);
+    uri = sj_object_get_value_as_string(buffer,"uri");
+    if (!uri)
+    {
+        if (!bin)
+        {
+            slog("buffer %i of %s has no uri and there is no glb BIN chunk",bufferIndex,gltf->filename);
+            return out;
+        }
+        out->data = bin;
+        out->size = binSize;
+    }
+    else if (strncmp(uri,"data:",5) == 0)
+    {
+        out->block = gf3d_gltf_decode(gltf->json, bufferIndex);
+        out->data = out->block;
+        if (out->data)out->size = byteLength;
+    }
+    else
+    {
+        gf3d_gltf_get_uri_path(path,gltf->filename,uri);
+        out->block = gf3d_gltf_map_file(path,&out->blockSize,&out->mapped);
+        if (!out->block)
+        {
+            slog("failed to load buffer file %s for %s",path,gltf->filename);
+            return out;
+        }
+        out->data = out->block;
+        out->size = out->blockSize;
+    }
+    if ((byteLength > 0)&&((size_t)byteLength < out->size))out->size = byteLength;
+    return out;
+}
+
+int gf3d_gltf_filename_is_glb(const char *filename)
+{
+    size_t length;
+    length = strlen(filename);
+    if (length < 4)return 0;
+    return (SDL_strcasecmp(&filename[length - 4],".glb") == 0);
+}
+
 GLTF *gf3d_gltf_load(const char *filename)
 {
-    SJson *json;
     SJson *buffers;
     int i,c;
     GLTF *gltf;
+    char *bin = NULL;
+    size_t binSize = 0;
     if (!filename)return NULL;
-    json = gfc_pak_load_json(filename);
-    if (!json)return NULL;
     gltf = gf3d_gltf_new();
-    if (!gltf)
+    if (!gltf)return NULL;
+    gfc_line_cpy(gltf->filename,filename);
+    if (gf3d_gltf_filename_is_glb(filename))
     {
-        sj_free(json);
-        return NULL;
+        gltf->glb.block = gf3d_gltf_map_file(filename,&gltf->glb.blockSize,&gltf->glb.mapped);
+        if ((!gltf->glb.block)||(!gf3d_gltf_parse_glb(gltf,&bin,&binSize)))
+        {
+            gf3d_gltf_free(gltf);
+            return NULL;
+        }
+        gltf->glb.data = gltf->glb.block;
+        gltf->glb.size = gltf->glb.blockSize;
     }
-    gltf->json = json;
-    gfc_line_cpy(gltf->filename,filename);
-    buffers = sj_object_get_value(json,"buffers");
+    else
+    {
+        gltf->json = gfc_pak_load_json(filename);
+        if (!gltf->json)
+        {
+            gf3d_gltf_free(gltf);
+            return NULL;
+        }
+    }
+    buffers = sj_object_get_value(gltf->json,"buffers");
     c = sj_array_get_count(buffers);
     for (i = 0;i < c; i++)
     {
-        gfc_list_append(gltf->buffers,gf3d_gltf_decode(json, i));
+        gfc_list_append(gltf->buffers,gf3d_gltf_load_buffer(gltf,i,bin,binSize));
     }
 //    slog("decoded %i buffers from %s",c,filename);
     return gltf;
@@ -104,11 +326,12 @@ char *gf3d_gltf_decode(SJson *gltf, Uint32 bufferIndex)
     if (!data)return NULL;
         
     data = strchr(data, ',');
+    if (!data)return NULL;
     data++;// move past the header
     return gfc_base64_decode (data, strlen(data), NULL);
 }
 
-const char *gf3d_gltf_get_buffer(GLTF *gltf,Uint32 index)
+GLTF_Buffer *gf3d_gltf_get_buffer(GLTF *gltf,Uint32 index)
 {
     if (!gltf)return NULL;
     return gfc_list_get_nth(gltf->buffers,index);
@@ -116,17 +339,22 @@ const char *gf3d_gltf_get_buffer(GLTF *gltf,Uint32 index)
 
 const char *gf3d_gltf_get_buffer_data(GLTF *gltf,Uint32 index,size_t offset)
 {
-    const char *data;
+    GLTF_Buffer *buffer;
     
     if (!gltf)return NULL;
-    data = gf3d_gltf_get_buffer(gltf,index);    
-    if (!data)
+    buffer = gf3d_gltf_get_buffer(gltf,index);    
+    if ((!buffer)||(!buffer->data))
     {
         slog("failed to get buffer %i from file %s",index,gltf->filename);
         return NULL;
     }
+    if (offset > buffer->size)
+    {
+        slog("offset %i is outside of buffer %i in file %s",(int)offset,index,gltf->filename);
+        return NULL;
+    }
     
-    return &data[offset];
+    return &buffer->data[offset];
 }
 
 Uint8 gf3d_gltf_parse_copy_buffer_data(SJson *gltf,Uint32 index,size_t offset,size_t length, char *output)
@@ -148,6 +376,7 @@ Uint8 gf3d_gltf_parse_copy_buffer_data(SJson *gltf,Uint32 index,size_t offset,si
 Uint8 gf3d_gltf_get_data_from_buffer(GLTF *gltf,Uint32 buffer,size_t offset,size_t length, char *output)
 {
     const char *data;
+    GLTF_Buffer *source;
     
     if (!output)
     {
@@ -156,6 +385,12 @@ Uint8 gf3d_gltf_get_data_from_buffer(GLTF *gltf,Uint32 buffer,size_t offset,size
     }
     data = gf3d_gltf_get_buffer_data(gltf,buffer,offset);
     if (!data)return 0;
+    source = gf3d_gltf_get_buffer(gltf,buffer);
+    if (offset + length > source->size)
+    {
+        slog("range %i + %i is outside of buffer %i in file %s",(int)offset,(int)length,buffer,gltf->filename);
+        return 0;
+    }
     memcpy(output,data,length);
     return 1;
 }
@@ -164,7 +399,7 @@ Uint8 gf3d_gltf_get_data_from_buffer(GLTF *gltf,Uint32 buffer,size_t offset,size
 void gf3d_gltf_get_buffer_view_data(GLTF *gltf,Uint32 viewIndex,char *buffer)
 {
     SJson *bufferView;
-    int index,byteLength,byteOffset;
+    int index = 0,byteLength = 0,byteOffset = 0;
     if ((!gltf)||(!buffer))return;
     bufferView = gf3d_gltf_parse_get_buffer_view(gltf->json,viewIndex);
     if (!bufferView)
@@ -178,7 +413,6 @@ void gf3d_gltf_get_buffer_view_data(GLTF *gltf,Uint32 viewIndex,char *buffer)
     gf3d_gltf_get_data_from_buffer(gltf,index,byteOffset,byteLength, buffer);
 }
 
-//TODO: report on componentType so the data can be parsed correctly
 const char *gf3d_gltf_accessor_get_details(GLTF* gltf,Uint32 accessorIndex, int *bufferIndex, int *count)
 {
     SJson *accessor;
@@ -196,12 +430,254 @@ const char *gf3d_gltf_accessor_get_details(GLTF* gltf,Uint32 accessorIndex, int
     return sj_object_get_value_as_string(accessor,"type");
 }
 
+Uint32 gf3d_gltf_component_size(GLTF_componentType componentType)
+{
+    switch (componentType)
+    {
+        case G_CT_signedByte:
+        case G_CT_unsignedByte:
+            return 1;
+        case G_CT_signedShort:
+        case G_CT_unsignedShort:
+            return 2;
+        case G_CT_unsignedInt:
+        case G_CT_float:
+            return 4;
+    }
+    return 0;
+}
+
+Uint32 gf3d_gltf_type_component_count(const char *type)
+{
+    if (!type)return 0;
+    if (strcmp(type,"SCALAR")==0)return 1;
+    if (strcmp(type,"VEC2")==0)return 2;
+    if (strcmp(type,"VEC3")==0)return 3;
+    if (strcmp(type,"VEC4")==0)return 4;
+    if (strcmp(type,"MAT2")==0)return 4;
+    if (strcmp(type,"MAT3")==0)return 9;
+    if (strcmp(type,"MAT4")==0)return 16;
+    return 0;
+}
+
+int gf3d_gltf_accessor_get_view(GLTF *gltf,Uint32 accessorIndex,GLTF_AccessorView *view)
+{
+    SJson *accessor,*bufferView;
+    GLTF_Buffer *buffer;
+    short int normalized = 0;
+    int viewIndex = -1,componentType = 0,count = 0;
+    int accessorOffset = 0,viewOffset = 0,viewLength = 0,byteStride = 0,bufferIndex = 0;
+    Uint32 elementSize;
+    size_t start,end;
+
+    if ((!gltf)||(!view))return 0;
+    memset(view,0,sizeof(GLTF_AccessorView));
+    accessor = gf3d_gltf_parse_get_accessor(gltf,accessorIndex);
+    if (!accessor)
+    {
+        slog("failed to find accessor %i in %s",accessorIndex,gltf->filename);
+        return 0;
+    }
+    if (sj_object_get_value(accessor,"sparse"))
+    {
+        slog("accessor %i in %s is sparse, which is not supported",accessorIndex,gltf->filename);
+        return 0;
+    }
+    if (!sj_object_get_value_as_int(accessor,"bufferView",&viewIndex))
+    {
+        slog("accessor %i in %s has no buffer view",accessorIndex,gltf->filename);
+        return 0;
+    }
+    sj_object_get_value_as_int(accessor,"componentType",&componentType);
+    sj_object_get_value_as_int(accessor,"count",&count);
+    sj_object_get_value_as_int(accessor,"byteOffset",&accessorOffset);
+    sj_get_bool_value(sj_object_get_value(accessor,"normalized"),&normalized);
+
+    view->componentType = componentType;
+    view->componentCount = gf3d_gltf_type_component_count(sj_object_get_value_as_string(accessor,"type"));
+    view->count = count;
+    view->normalized = normalized;
+    elementSize = gf3d_gltf_component_size(view->componentType) * view->componentCount;
+    if (!elementSize)
+    {
+        slog("accessor %i in %s has an unknown type or component type",accessorIndex,gltf->filename);
+        return 0;
+    }
+
+    bufferView = gf3d_gltf_parse_get_buffer_view(gltf->json,viewIndex);
+    if (!bufferView)
+    {
+        slog("failed to find buffer view %i in %s",viewIndex,gltf->filename);
+        return 0;
+    }
+    sj_object_get_value_as_int(bufferView,"buffer",&bufferIndex);
+    sj_object_get_value_as_int(bufferView,"byteOffset",&viewOffset);
+    sj_object_get_value_as_int(bufferView,"byteLength",&viewLength);
+    sj_object_get_value_as_int(bufferView,"byteStride",&byteStride);
+    view->stride = (byteStride > 0)?byteStride:elementSize;
+
+    buffer = gf3d_gltf_get_buffer(gltf,bufferIndex);
+    if ((!buffer)||(!buffer->data))
+    {
+        slog("buffer %i for accessor %i in %s is not loaded",bufferIndex,accessorIndex,gltf->filename);
+        return 0;
+    }
+    start = (size_t)viewOffset + accessorOffset;
+    end = start;
+    if (count > 0)end += (size_t)view->stride * (count - 1) + elementSize;
+    if ((end > (size_t)viewOffset + viewLength)||(end > buffer->size))
+    {
+        slog("accessor %i in %s reads outside of its buffer",accessorIndex,gltf->filename);
+        return 0;
+    }
+    view->data = &buffer->data[start];
+    return 1;
+}
+
+float gf3d_gltf_accessor_get_float(GLTF_AccessorView *view,Uint32 element,Uint32 component)
+{
+    const char *data;
+    Sint8 sb;
+    Sint16 ss;
+    Uint16 us;
+    Uint32 ui;
+    float f;
+    if ((!view)||(!view->data))return 0;
+    if ((element >= view->count)||(component >= view->componentCount))return 0;
+    data = view->data + (size_t)element * view->stride + component * gf3d_gltf_component_size(view->componentType);
+    switch (view->componentType)
+    {
+        case G_CT_signedByte:
+            sb = *(Sint8 *)data;
+            if (!view->normalized)return sb;
+            return MAX(sb / 127.0f,-1.0f);
+        case G_CT_unsignedByte:
+            if (!view->normalized)return *(Uint8 *)data;
+            return *(Uint8 *)data / 255.0f;
+        case G_CT_signedShort:
+            memcpy(&ss,data,sizeof(Sint16));
+            if (!view->normalized)return ss;
+            return MAX(ss / 32767.0f,-1.0f);
+        case G_CT_unsignedShort:
+            memcpy(&us,data,sizeof(Uint16));
+            if (!view->normalized)return us;
+            return us / 65535.0f;
+        case G_CT_unsignedInt:
+            memcpy(&ui,data,sizeof(Uint32));
+            return ui;
+        case G_CT_float:
+            memcpy(&f,data,sizeof(float));
+            return f;
+    }
+    return 0;
+}
+
+Uint32 gf3d_gltf_accessor_get_uint(GLTF_AccessorView *view,Uint32 element,Uint32 component)
+{
+    const char *data;
+    Uint16 us;
+    Uint32 ui;
+    if ((!view)||(!view->data))return 0;
+    if ((element >= view->count)||(component >= view->componentCount))return 0;
+    data = view->data + (size_t)element * view->stride + component * gf3d_gltf_component_size(view->componentType);
+    switch (view->componentType)
+    {
+        case G_CT_signedByte:
+        case G_CT_unsignedByte:
+            return *(Uint8 *)data;
+        case G_CT_signedShort:
+        case G_CT_unsignedShort:
+            memcpy(&us,data,sizeof(Uint16));
+            return us;
+        case G_CT_unsignedInt:
+            memcpy(&ui,data,sizeof(Uint32));
+            return ui;
+        case G_CT_float:
+            return (Uint32)gf3d_gltf_accessor_get_float(view,element,component);
+    }
+    return 0;
+}
+
+Uint32 gf3d_gltf_accessor_read_floats(GLTF_AccessorView *view,float *output,Uint32 components)
+{
+    Uint32 i,j;
+    if ((!view)||(!view->data)||(!output)||(!components))return 0;
+    if ((view->componentType == G_CT_float)&&(components == view->componentCount)&&(view->stride == components * sizeof(float)))
+    {
+        memcpy(output,view->data,(size_t)view->count * view->stride);
+        return view->count;
+    }
+    for (i = 0; i < view->count; i++)
+    {
+        for (j = 0; j < components; j++)
+        {
+            *output++ = (j < view->componentCount)?gf3d_gltf_accessor_get_float(view,i,j):0;
+        }
+    }
+    return view->count;
+}
+
+Uint32 gf3d_gltf_accessor_read_uint16(GLTF_AccessorView *view,Uint16 *output)
+{
+    Uint32 i,j,value;
+    Uint8 clamped = 0;
+    if ((!view)||(!view->data)||(!output))return 0;
+    if ((view->componentType == G_CT_unsignedShort)&&(view->stride == view->componentCount * sizeof(Uint16)))
+    {
+        memcpy(output,view->data,(size_t)view->count * view->stride);
+        return view->count;
+    }
+    for (i = 0; i < view->count; i++)
+    {
+        for (j = 0; j < view->componentCount; j++)
+        {
+            value = gf3d_gltf_accessor_get_uint(view,i,j);
+            if (value > 0xFFFF)
+            {
+                value = 0xFFFF;
+                clamped = 1;
+            }
+            *output++ = value;
+        }
+    }
+    if (clamped)slog("accessor values exceed 16 bits and were clamped");
+    return view->count;
+}
+
+Uint32 gf3d_gltf_accessor_read_uint8(GLTF_AccessorView *view,Uint8 *output)
+{
+    Uint32 i,j,value;
+    Uint8 clamped = 0;
+    if ((!view)||(!view->data)||(!output))return 0;
+    if ((view->componentType == G_CT_unsignedByte)&&(view->stride == view->componentCount))
+    {
+        memcpy(output,view->data,(size_t)view->count * view->stride);
+        return view->count;
+    }
+    for (i = 0; i < view->count; i++)
+    {
+        for (j = 0; j < view->componentCount; j++)
+        {
+            value = gf3d_gltf_accessor_get_uint(view,i,j);
+            if (value > 0xFF)
+            {
+                value = 0xFF;
+                clamped = 1;
+            }
+            *output++ = value;
+        }
+    }
+    if (clamped)slog("accessor values exceed 8 bits and were clamped");
+    return view->count;
+}
+
 ObjData *gf3d_gltf_parse_primitive(GLTF *gltf,SJson *primitive)
 {
     ObjData *obj;
     GFC_Vector3D min,max;
-    int index,bufferIndex;
+    int index;
     SJson *attributes,*accessor;
+    GLTF_AccessorView view;
 
     if ((!gltf)||(!primitive))return NULL;
     obj = gf3d_obj_new();
@@ -218,11 +694,12 @@ ObjData *gf3d_gltf_parse_primitive(GLTF *gltf,SJson *primitive)
     
     if (sj_object_get_value_as_int(attributes,"POSITION",&index))
     {
-        if (gf3d_gltf_accessor_get_details(gltf,index, &bufferIndex, (int *)&obj->vertex_count))
+        if (gf3d_gltf_accessor_get_view(gltf,index,&view))
         {
+            obj->vertex_count = view.count;
             obj->vertices = (GFC_Vector3D *)gfc_allocate_array(sizeof(GFC_Vector3D),obj->vertex_count);
             
-            gf3d_gltf_get_buffer_view_data(gltf,bufferIndex,(char *)obj->vertices);
+            gf3d_gltf_accessor_read_floats(&view,(float *)obj->vertices,3);
             
             accessor = gf3d_gltf_parse_get_accessor(gltf,index);
             gfc_vector3d_clear(min);
@@ -235,22 +712,24 @@ ObjData *gf3d_gltf_parse_primitive(GLTF *gltf,SJson *primitive)
     }
     if (sj_object_get_value_as_int(attributes,"NORMAL",&index))
     {
-        if (gf3d_gltf_accessor_get_details(gltf,index, &bufferIndex, (int *)&obj->normal_count))
+        if (gf3d_gltf_accessor_get_view(gltf,index,&view))
         {
+            obj->normal_count = view.count;
             obj->normals = (GFC_Vector3D *)gfc_allocate_array(sizeof(GFC_Vector3D),obj->normal_count);
             
-            gf3d_gltf_get_buffer_view_data(gltf,bufferIndex,(char *)obj->normals);            
+            gf3d_gltf_accessor_read_floats(&view,(float *)obj->normals,3);
         }
         else slog("failed to get accessor detials");
     }
     
     if (sj_object_get_value_as_int(attributes,"TEXCOORD_0",&index))
     {
-        if (gf3d_gltf_accessor_get_details(gltf,index, &bufferIndex, (int *)&obj->texel_count))
+        if (gf3d_gltf_accessor_get_view(gltf,index,&view))
         {
+            obj->texel_count = view.count;
             obj->texels = (GFC_Vector2D *)gfc_allocate_array(sizeof(GFC_Vector2D),obj->texel_count);
             
-            gf3d_gltf_get_buffer_view_data(gltf,bufferIndex,(char *)obj->texels);            
+            gf3d_gltf_accessor_read_floats(&view,(float *)obj->texels,2);
         }
         else slog("failed to get accessor detials");
     }
@@ -258,35 +737,37 @@ ObjData *gf3d_gltf_parse_primitive(GLTF *gltf,SJson *primitive)
     //bone indices
     if (sj_object_get_value_as_int(attributes,"JOINTS_0",&index))
     {
-        if (gf3d_gltf_accessor_get_details(gltf,index, &bufferIndex, (int *)&obj->bone_count))
+        if (gf3d_gltf_accessor_get_view(gltf,index,&view))
         {
+            obj->bone_count = view.count;
             obj->boneIndices = (GFC_Vector4UI8 *)gfc_allocate_array(sizeof(GFC_Vector4UI8),obj->bone_count);
             
-            gf3d_gltf_get_buffer_view_data(gltf,bufferIndex,(char *)obj->boneIndices);
-            
+            gf3d_gltf_accessor_read_uint8(&view,(Uint8 *)obj->boneIndices);
         }
         else slog("failed to get accessor detials");
     }
     //bone weights
     if (sj_object_get_value_as_int(attributes,"WEIGHTS_0",&index))
     {
-        if (gf3d_gltf_accessor_get_details(gltf,index, &bufferIndex, (int *)&obj->weight_count))
+        if (gf3d_gltf_accessor_get_view(gltf,index,&view))
         {
+            obj->weight_count = view.count;
             obj->boneWeights = (GFC_Vector4D *)gfc_allocate_array(sizeof(GFC_Vector4D),obj->weight_count);
             
-            gf3d_gltf_get_buffer_view_data(gltf,bufferIndex,(char *)obj->boneWeights);
+            gf3d_gltf_accessor_read_floats(&view,(float *)obj->boneWeights,4);
         }
         else slog("failed to get accessor detials");
     }
 
     if (sj_object_get_value_as_int(primitive,"indices",&index))
     {
-        if (gf3d_gltf_accessor_get_details(gltf,index, &bufferIndex, (int *)&obj->face_count))
+        if (gf3d_gltf_accessor_get_view(gltf,index,&view))
         {
-            obj->face_count /= 3;
+            obj->face_count = view.count / 3;
             obj->outFace = (Face *)gfc_allocate_array(sizeof(Face),obj->face_count);
+            view.count = obj->face_count * 3;//drop any trailing partial triangle
 
-            gf3d_gltf_get_buffer_view_data(gltf,bufferIndex,(char *)obj->outFace);            
+            gf3d_gltf_accessor_read_uint16(&view,(Uint16 *)obj->outFace);
         }
         else slog("failed to get accessor detials");
     }
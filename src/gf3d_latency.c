@@ -0,0 +1,255 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_swapchain.h"
+#include "gf3d_frame_pacer.h"
+#include "gf3d_tracker.h"
+#include "gf3d_latency.h"
+
+typedef struct
+{
+    VkFence     fence;
+    Bool        pending;        /**<submitted and not yet seen complete*/
+    Uint64      input;          /**<0 if no input was stamped for the frame*/
+    Uint64      submit;
+    Uint64      present;
+}LatencyFrame;
+
+typedef struct
+{
+    float       submit;
+    float       present;
+    float       gpu;
+    float       photon;
+}LatencySample;
+
+typedef struct
+{
+    VkDevice        device;
+    Uint64          frequency;
+    Uint64          input;          /**<the input stamp waiting for the next submit*/
+    LatencyFrame   *frames;         /**<one per swap chain image*/
+    Uint32          chainLength;
+    LatencySample  *samples;        /**<ring of the most recent frames*/
+    Uint32          sampleMax;
+    Uint32          sampleCount;
+    Uint32          sampleNext;
+}LatencyTest;
+
+extern int __DEBUG;
+static LatencyTest gf3d_latency = {0};
+
+void gf3d_latency_close()
+{
+    Uint32 i;
+    if (gf3d_latency.frames)
+    {
+        vkDeviceWaitIdle(gf3d_latency.device);
+        gf3d_latency_poll();
+        gf3d_latency_report();
+        for (i = 0; i < gf3d_latency.chainLength; i++)
+        {
+            if (!gf3d_latency.frames[i].fence)continue;
+            gf3d_tracker_destroy(TC_Fence,gf3d_latency.frames[i].fence);
+            vkDestroyFence(gf3d_latency.device,gf3d_latency.frames[i].fence,NULL);
+        }
+        free(gf3d_latency.frames);
+    }
+    if (gf3d_latency.samples)free(gf3d_latency.samples);
+    memset(&gf3d_latency,0,sizeof(LatencyTest));
+}
+
+void gf3d_latency_init(Uint32 samples)
+{
+    Uint32 i;
+    VkFenceCreateInfo fenceInfo = {0};
+    if (gf3d_latency.frames)return;
+    if (!samples)samples = 1024;
+    gf3d_latency.device = gf3d_vgraphics_get_default_logical_device();
+    gf3d_latency.chainLength = gf3d_swapchain_get_swap_image_count();
+    gf3d_latency.frequency = SDL_GetPerformanceFrequency();
+    if ((!gf3d_latency.device)||(!gf3d_latency.chainLength))
+    {
+        slog("cannot start latency test before graphics are initialized");
+        return;
+    }
+    gf3d_latency.frames = gfc_allocate_array(sizeof(LatencyFrame),gf3d_latency.chainLength);
+    gf3d_latency.samples = gfc_allocate_array(sizeof(LatencySample),samples);
+    if ((!gf3d_latency.frames)||(!gf3d_latency.samples))
+    {
+        slog("failed to allocate latency test");
+        gf3d_latency_close();
+        return;
+    }
+    gf3d_latency.sampleMax = samples;
+    atexit(gf3d_latency_close);
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    for (i = 0; i < gf3d_latency.chainLength; i++)
+    {
+        if (vkCreateFence(gf3d_latency.device,&fenceInfo,NULL,&gf3d_latency.frames[i].fence) != VK_SUCCESS)
+        {
+            slog("failed to create latency test fence");
+            gf3d_latency_close();
+            return;
+        }
+        gf3d_tracker_create(TC_Fence,gf3d_latency.frames[i].fence,0,"latency");
+    }
+    slog("latency test enabled, photons are estimated as gpu completion plus half a refresh interval");
+}
+
+Bool gf3d_latency_enabled()
+{
+    return gf3d_latency.frames != NULL;
+}
+
+void gf3d_latency_mark_input()
+{
+    if (!gf3d_latency.frames)return;
+    gf3d_latency.input = SDL_GetPerformanceCounter();
+}
+
+float gf3d_latency_ms(Uint64 from,Uint64 to)
+{
+    return (float)(to - from) * 1000.0 / gf3d_latency.frequency;
+}
+
+/**
+ * @brief record a frame whose fence was just seen signaled and reset the fence for its next use
+ */
+void gf3d_latency_complete(LatencyFrame *frame,Uint64 now)
+{
+    LatencySample *sample;
+    frame->pending = 0;
+    vkResetFences(gf3d_latency.device,1,&frame->fence);
+    if (!frame->input)return;
+    sample = &gf3d_latency.samples[gf3d_latency.sampleNext];
+    sample->submit = gf3d_latency_ms(frame->input,frame->submit);
+    sample->present = frame->present?gf3d_latency_ms(frame->input,frame->present):sample->submit;
+    sample->gpu = gf3d_latency_ms(frame->input,now);
+    sample->photon = sample->gpu + gf3d_frame_pacer_get()->refreshMs * 0.5;
+    gf3d_latency.sampleNext = (gf3d_latency.sampleNext + 1) % gf3d_latency.sampleMax;
+    if (gf3d_latency.sampleCount < gf3d_latency.sampleMax)gf3d_latency.sampleCount++;
+}
+
+void gf3d_latency_poll()
+{
+    Uint32 i;
+    Uint64 now;
+    LatencyFrame *frame;
+    if (!gf3d_latency.frames)return;
+    now = SDL_GetPerformanceCounter();
+    for (i = 0; i < gf3d_latency.chainLength; i++)
+    {
+        frame = &gf3d_latency.frames[i];
+        if ((!frame->pending)||(vkGetFenceStatus(gf3d_latency.device,frame->fence) != VK_SUCCESS))continue;
+        //completion is only seen when polled, so this is an upper bound by up to a frame
+        gf3d_latency_complete(frame,now);
+    }
+}
+
+VkFence gf3d_latency_submit(Uint32 frame)
+{
+    LatencyFrame *latency;
+    if ((!gf3d_latency.frames)||(frame >= gf3d_latency.chainLength))return VK_NULL_HANDLE;
+    latency = &gf3d_latency.frames[frame];
+    if (latency->pending)
+    {
+        //the image was acquired again, so its last frame should have finished even if the poll has not caught it
+        if (vkWaitForFences(gf3d_latency.device,1,&latency->fence,VK_TRUE,1000000000) != VK_SUCCESS)
+        {
+            //the fence is still tied to that work, so this frame goes unmeasured rather than reusing it
+            if (__DEBUG)slog("latency test: frame %i has not completed, not measuring this one",frame);
+            gf3d_latency.input = 0;
+            return VK_NULL_HANDLE;
+        }
+        gf3d_latency_complete(latency,SDL_GetPerformanceCounter());
+    }
+    latency->input = gf3d_latency.input;
+    latency->submit = SDL_GetPerformanceCounter();
+    latency->present = 0;
+    latency->pending = 1;
+    gf3d_latency.input = 0;
+    return latency->fence;
+}
+
+void gf3d_latency_submit_failed(Uint32 frame)
+{
+    if ((!gf3d_latency.frames)||(frame >= gf3d_latency.chainLength))return;
+    //nothing was queued, so the fence was never tied to any work and can be used as is
+    gf3d_latency.frames[frame].pending = 0;
+}
+
+void gf3d_latency_present(Uint32 frame)
+{
+    if ((!gf3d_latency.frames)||(frame >= gf3d_latency.chainLength))return;
+    gf3d_latency.frames[frame].present = SDL_GetPerformanceCounter();
+}
+
+int gf3d_latency_compare_float(const void *a,const void *b)
+{
+    float fa = *(const float *)a,fb = *(const float *)b;
+    if (fa < fb)return -1;
+    if (fa > fb)return 1;
+    return 0;
+}
+
+void gf3d_latency_stage(LatencyStage *stage,float *values,Uint32 count)
+{
+    Uint32 i;
+    double sum = 0;
+    for (i = 0; i < count; i++)sum += values[i];
+    qsort(values,count,sizeof(float),gf3d_latency_compare_float);
+    stage->average = sum / count;
+    stage->p50 = values[(count - 1) / 2];
+    stage->p99 = values[MIN((Uint32)(count * 0.99),count - 1)];
+}
+
+void gf3d_latency_get(LatencyStats *stats)
+{
+    Uint32 i,count;
+    float *values;
+    if (!stats)return;
+    memset(stats,0,sizeof(LatencyStats));
+    count = gf3d_latency.sampleCount;
+    if (!count)return;
+    values = gfc_allocate_array(sizeof(float),count);
+    if (!values)return;
+    stats->frames = count;
+    for (i = 0; i < count; i++)values[i] = gf3d_latency.samples[i].submit;
+    gf3d_latency_stage(&stats->submit,values,count);
+    for (i = 0; i < count; i++)values[i] = gf3d_latency.samples[i].present;
+    gf3d_latency_stage(&stats->present,values,count);
+    for (i = 0; i < count; i++)values[i] = gf3d_latency.samples[i].gpu;
+    gf3d_latency_stage(&stats->gpu,values,count);
+    for (i = 0; i < count; i++)values[i] = gf3d_latency.samples[i].photon;
+    gf3d_latency_stage(&stats->photon,values,count);
+    free(values);
+}
+
+void gf3d_latency_report()
+{
+    LatencyStats stats;
+    if (!gf3d_latency.frames)
+    {
+        slog("latency test is not enabled");
+        return;
+    }
+    gf3d_latency_get(&stats);
+    if (!stats.frames)
+    {
+        slog("latency: no frames measured");
+        return;
+    }
+    slog("latency over %i frames: %-8s %8s %8s %8s",stats.frames,"stage","avg ms","p50 ms","p99 ms");
+    slog("latency over %i frames: %-8s %8.2f %8.2f %8.2f",stats.frames,"submit",stats.submit.average,stats.submit.p50,stats.submit.p99);
+    slog("latency over %i frames: %-8s %8.2f %8.2f %8.2f",stats.frames,"present",stats.present.average,stats.present.p50,stats.present.p99);
+    slog("latency over %i frames: %-8s %8.2f %8.2f %8.2f",stats.frames,"gpu",stats.gpu.average,stats.gpu.p50,stats.gpu.p99);
+    slog("latency over %i frames: %-8s %8.2f %8.2f %8.2f",stats.frames,"photon",stats.photon.average,stats.photon.p50,stats.photon.p99);
+}
+
+/*eol@eof*/
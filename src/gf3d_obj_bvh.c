@@ -0,0 +1,479 @@
+#include <float.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_obj_bvh.h"
+
+#define BVH_BIN_COUNT       12      /**<number of bins for the SAH sweep*/
+#define BVH_LEAF_SIZE       4       /**<always make a leaf at or below this many triangles*/
+#define BVH_MAX_LEAF_SIZE   16      /**<never make a leaf above this many triangles, even if SAH says so*/
+#define BVH_STACK_DEPTH     64
+
+extern int __DEBUG;
+
+typedef struct
+{
+    float   min[3];
+    float   max[3];
+}BVHBounds;
+
+typedef struct
+{
+    BVHBounds   bounds;
+    Uint32      count;
+}BVHBin;
+
+typedef struct
+{
+    Uint32  node;
+    float   tmin;
+}BVHStackEntry;
+
+void gf3d_obj_bvh_bounds_clear(BVHBounds *b)
+{
+    b->min[0] = b->min[1] = b->min[2] = FLT_MAX;
+    b->max[0] = b->max[1] = b->max[2] = -FLT_MAX;
+}
+
+void gf3d_obj_bvh_bounds_add_point(BVHBounds *b,const float *p)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        if (p[i] < b->min[i])b->min[i] = p[i];
+        if (p[i] > b->max[i])b->max[i] = p[i];
+    }
+}
+
+void gf3d_obj_bvh_bounds_add(BVHBounds *b,const BVHBounds *a)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        if (a->min[i] < b->min[i])b->min[i] = a->min[i];
+        if (a->max[i] > b->max[i])b->max[i] = a->max[i];
+    }
+}
+
+float gf3d_obj_bvh_bounds_area(const BVHBounds *b)
+{
+    float x,y,z;
+    if (b->min[0] > b->max[0])return 0;
+    x = b->max[0] - b->min[0];
+    y = b->max[1] - b->min[1];
+    z = b->max[2] - b->min[2];
+    return x*y + y*z + z*x;
+}
+
+void gf3d_obj_bvh_free(ObjBVH *bvh)
+{
+    if (!bvh)return;
+    if (bvh->nodes)free(bvh->nodes);
+    if (bvh->faces)free(bvh->faces);
+    if (bvh->verts)free(bvh->verts);
+    free(bvh);
+}
+
+/**
+ * @brief find the best binned SAH split for a range of triangles
+ * @return 1 if a split was found that is cheaper than a leaf, 0 otherwise
+ */
+int gf3d_obj_bvh_find_split(
+    Uint32 *faces,
+    Uint32 count,
+    const BVHBounds *triBounds,
+    const float *centroids,
+    const BVHBounds *nodeBounds,
+    int *bestAxis,
+    float *bestPosition)
+{
+    int axis,i,b;
+    Uint32 f;
+    BVHBounds centroidBounds,left,right;
+    BVHBin bins[BVH_BIN_COUNT];
+    Uint32 leftCount[BVH_BIN_COUNT - 1],rightCount;
+    float leftArea[BVH_BIN_COUNT - 1];
+    float extent,scale,cost,bestCost,leafCost;
+
+    gf3d_obj_bvh_bounds_clear(&centroidBounds);
+    for (i = 0; i < count; i++)
+    {
+        gf3d_obj_bvh_bounds_add_point(&centroidBounds,&centroids[faces[i] * 3]);
+    }
+    leafCost = gf3d_obj_bvh_bounds_area(nodeBounds) * count;
+    bestCost = FLT_MAX;
+    *bestAxis = -1;
+    for (axis = 0; axis < 3; axis++)
+    {
+        extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+        if (extent <= 0)continue;
+        for (b = 0; b < BVH_BIN_COUNT; b++)
+        {
+            gf3d_obj_bvh_bounds_clear(&bins[b].bounds);
+            bins[b].count = 0;
+        }
+        scale = BVH_BIN_COUNT / extent;
+        for (i = 0; i < count; i++)
+        {
+            f = faces[i];
+            b = (int)((centroids[f * 3 + axis] - centroidBounds.min[axis]) * scale);
+            if (b >= BVH_BIN_COUNT)b = BVH_BIN_COUNT - 1;
+            bins[b].count++;
+            gf3d_obj_bvh_bounds_add(&bins[b].bounds,&triBounds[f]);
+        }
+        //sweep from the left to get the cost of everything left of each plane
+        gf3d_obj_bvh_bounds_clear(&left);
+        for (b = 0,i = 0; b < BVH_BIN_COUNT - 1; b++)
+        {
+            i += bins[b].count;
+            gf3d_obj_bvh_bounds_add(&left,&bins[b].bounds);
+            leftCount[b] = i;
+            leftArea[b] = gf3d_obj_bvh_bounds_area(&left);
+        }
+        //then from the right
+        gf3d_obj_bvh_bounds_clear(&right);
+        rightCount = 0;
+        for (b = BVH_BIN_COUNT - 1; b > 0; b--)
+        {
+            rightCount += bins[b].count;
+            gf3d_obj_bvh_bounds_add(&right,&bins[b].bounds);
+            if ((!rightCount)||(!leftCount[b - 1]))continue;
+            cost = leftArea[b - 1] * leftCount[b - 1] + gf3d_obj_bvh_bounds_area(&right) * rightCount;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                *bestAxis = axis;
+                *bestPosition = centroidBounds.min[axis] + (b / scale);
+            }
+        }
+    }
+    if (*bestAxis < 0)return 0;
+    if ((bestCost >= leafCost)&&(count <= BVH_MAX_LEAF_SIZE))return 0;
+    return 1;
+}
+
+ObjBVH *gf3d_obj_bvh_build(ObjData *obj)
+{
+    ObjBVH *bvh;
+    BVHBounds *triBounds;
+    BVHBounds nodeBounds;
+    float *centroids;
+    Uint32 stack[BVH_STACK_DEPTH];
+    Uint32 depthStack[BVH_STACK_DEPTH];
+    Uint32 stackCount = 0;
+    Uint32 i,j,f,nodeIndex,first,count,mid,depth;
+    ObjBVHNode *node;
+    const float *p;
+    int axis;
+    float position;
+    Uint32 temp;
+
+    if ((!obj)||(!obj->outFace)||(!obj->faceVertices)||(!obj->face_count))return NULL;
+    bvh = gfc_allocate_array(sizeof(ObjBVH),1);
+    if (!bvh)return NULL;
+    bvh->triangleCount = obj->face_count;
+    bvh->nodes = gfc_allocate_array(sizeof(ObjBVHNode),obj->face_count * 2);
+    bvh->faces = gfc_allocate_array(sizeof(Uint32),obj->face_count);
+    bvh->verts = gfc_allocate_array(sizeof(GFC_Vector3D),obj->face_count * 3);
+    triBounds = gfc_allocate_array(sizeof(BVHBounds),obj->face_count);
+    centroids = gfc_allocate_array(sizeof(float),obj->face_count * 3);
+    if ((!bvh->nodes)||(!bvh->faces)||(!bvh->verts)||(!triBounds)||(!centroids))
+    {
+        slog("failed to allocate bvh for %i triangles",obj->face_count);
+        if (triBounds)free(triBounds);
+        if (centroids)free(centroids);
+        gf3d_obj_bvh_free(bvh);
+        return NULL;
+    }
+    for (i = 0; i < obj->face_count; i++)
+    {
+        bvh->faces[i] = i;
+        gf3d_obj_bvh_bounds_clear(&triBounds[i]);
+        for (j = 0; j < 3; j++)
+        {
+            p = (const float *)&obj->faceVertices[obj->outFace[i].verts[j]].vertex;
+            gf3d_obj_bvh_bounds_add_point(&triBounds[i],p);
+        }
+        for (j = 0; j < 3; j++)
+        {
+            centroids[i * 3 + j] = (triBounds[i].min[j] + triBounds[i].max[j]) * 0.5;
+        }
+    }
+    //root covers everything
+    bvh->nodeCount = 1;
+    bvh->nodes[0].first = 0;
+    bvh->nodes[0].count = obj->face_count;
+    bvh->depth = 1;
+    depthStack[stackCount] = 1;
+    stack[stackCount++] = 0;
+    while (stackCount)
+    {
+        nodeIndex = stack[--stackCount];
+        depth = depthStack[stackCount];
+        if (depth > bvh->depth)bvh->depth = depth;
+        node = &bvh->nodes[nodeIndex];
+        first = node->first;
+        count = node->count;
+        gf3d_obj_bvh_bounds_clear(&nodeBounds);
+        for (i = first; i < first + count; i++)
+        {
+            gf3d_obj_bvh_bounds_add(&nodeBounds,&triBounds[bvh->faces[i]]);
+        }
+        memcpy(node->min,nodeBounds.min,sizeof(float)*3);
+        memcpy(node->max,nodeBounds.max,sizeof(float)*3);
+        if ((count <= BVH_LEAF_SIZE)||(stackCount + 2 > BVH_STACK_DEPTH))continue;
+        if (!gf3d_obj_bvh_find_split(&bvh->faces[first],count,triBounds,centroids,&nodeBounds,&axis,&position))
+        {
+            if (count <= BVH_MAX_LEAF_SIZE)continue;
+            //SAH found nothing useful (all centroids coincide), split the range in half
+            mid = first + count / 2;
+        }
+        else
+        {
+            //partition the range around the split plane
+            i = first;
+            j = first + count;
+            while (i < j)
+            {
+                if (centroids[bvh->faces[i] * 3 + axis] < position)i++;
+                else
+                {
+                    j--;
+                    temp = bvh->faces[i];
+                    bvh->faces[i] = bvh->faces[j];
+                    bvh->faces[j] = temp;
+                }
+            }
+            mid = i;
+            if ((mid == first)||(mid == first + count))mid = first + count / 2;
+        }
+        node->first = bvh->nodeCount;
+        node->count = 0;
+        bvh->nodes[bvh->nodeCount].first = first;
+        bvh->nodes[bvh->nodeCount].count = mid - first;
+        bvh->nodes[bvh->nodeCount + 1].first = mid;
+        bvh->nodes[bvh->nodeCount + 1].count = first + count - mid;
+        depthStack[stackCount] = depth + 1;
+        stack[stackCount++] = bvh->nodeCount;
+        depthStack[stackCount] = depth + 1;
+        stack[stackCount++] = bvh->nodeCount + 1;
+        bvh->nodeCount += 2;
+    }
+    //copy the triangle vertices in leaf order
+    for (i = 0; i < obj->face_count; i++)
+    {
+        f = bvh->faces[i];
+        for (j = 0; j < 3; j++)
+        {
+            bvh->verts[i * 3 + j] = obj->faceVertices[obj->outFace[f].verts[j]].vertex;
+        }
+    }
+    free(triBounds);
+    free(centroids);
+    if (__DEBUG)slog("built bvh with %i nodes, %i deep, for %i triangles",bvh->nodeCount,bvh->depth,bvh->triangleCount);
+    return bvh;
+}
+
+/**
+ * @brief segment vs box slab test
+ * @return 1 if the segment between tmin and tmax passes through the box, with tmin updated to the entry point
+ */
+int gf3d_obj_bvh_ray_box(const ObjBVHNode *node,const float *origin,const float *invDir,float *tmin,float tmax)
+{
+    int i;
+    float t0,t1,temp;
+    float enter = *tmin,leave = tmax;
+    for (i = 0; i < 3; i++)
+    {
+        t0 = (node->min[i] - origin[i]) * invDir[i];
+        t1 = (node->max[i] - origin[i]) * invDir[i];
+        if (t0 > t1)
+        {
+            temp = t0;
+            t0 = t1;
+            t1 = temp;
+        }
+        if (t0 > enter)enter = t0;
+        if (t1 < leave)leave = t1;
+        if (enter > leave)return 0;
+    }
+    *tmin = enter;
+    return 1;
+}
+
+/**
+ * @brief Moller-Trumbore segment vs triangle, double sided
+ * @return 1 if hit with t set to the parametric distance along the segment
+ */
+int gf3d_obj_bvh_ray_triangle(const float *origin,const float *dir,const GFC_Vector3D *tri,float *t)
+{
+    float e1[3],e2[3],p[3],s[3],q[3];
+    float det,invDet,u,v;
+    e1[0] = tri[1].x - tri[0].x;
+    e1[1] = tri[1].y - tri[0].y;
+    e1[2] = tri[1].z - tri[0].z;
+    e2[0] = tri[2].x - tri[0].x;
+    e2[1] = tri[2].y - tri[0].y;
+    e2[2] = tri[2].z - tri[0].z;
+    p[0] = dir[1] * e2[2] - dir[2] * e2[1];
+    p[1] = dir[2] * e2[0] - dir[0] * e2[2];
+    p[2] = dir[0] * e2[1] - dir[1] * e2[0];
+    det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if ((det > -FLT_EPSILON)&&(det < FLT_EPSILON))return 0;
+    invDet = 1.0 / det;
+    s[0] = origin[0] - tri[0].x;
+    s[1] = origin[1] - tri[0].y;
+    s[2] = origin[2] - tri[0].z;
+    u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+    if ((u < 0)||(u > 1))return 0;
+    q[0] = s[1] * e1[2] - s[2] * e1[1];
+    q[1] = s[2] * e1[0] - s[0] * e1[2];
+    q[2] = s[0] * e1[1] - s[1] * e1[0];
+    v = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) * invDet;
+    if ((v < 0)||(u + v > 1))return 0;
+    *t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+    return 1;
+}
+
+/**
+ * @brief test every triangle, for when there is no room to traverse the tree
+ * @return index into the leaf ordered triangle list of the closest hit, or -1 for no hit
+ */
+int gf3d_obj_bvh_brute_force(ObjBVH *bvh,const float *origin,const float *dir,Uint8 anyHit,float *tHit)
+{
+    Uint32 i;
+    float tBest = 1.0,t;
+    int best = -1;
+    for (i = 0; i < bvh->triangleCount; i++)
+    {
+        if (!gf3d_obj_bvh_ray_triangle(origin,dir,&bvh->verts[i * 3],&t))continue;
+        if ((t < 0)||(t > tBest))continue;
+        tBest = t;
+        best = i;
+        if (anyHit)break;
+    }
+    if (tHit)*tHit = tBest;
+    return best;
+}
+
+/**
+ * @brief shared traversal for closest hit and any hit queries
+ * @return index into the leaf ordered triangle list of the closest hit, or -1 for no hit
+ */
+int gf3d_obj_bvh_traverse(ObjBVH *bvh,GFC_Edge3D e,Uint8 anyHit,float *tHit)
+{
+    BVHStackEntry localStack[BVH_STACK_DEPTH];
+    BVHStackEntry *stack = localStack;
+    Uint32 stackSize,stackCount = 0;
+    Uint32 i;
+    float origin[3],dir[3],invDir[3];
+    float tBest = 1.0,t,tLeft,tRight;
+    int hitLeft,hitRight,best = -1;
+    const ObjBVHNode *node,*left,*right;
+    BVHStackEntry entry;
+
+    if ((!bvh)||(!bvh->nodeCount))return -1;
+    origin[0] = e.a.x;
+    origin[1] = e.a.y;
+    origin[2] = e.a.z;
+    dir[0] = e.b.x - e.a.x;
+    dir[1] = e.b.y - e.a.y;
+    dir[2] = e.b.z - e.a.z;
+    for (i = 0; i < 3; i++)
+    {
+        invDir[i] = (dir[i] != 0)?1.0 / dir[i]:FLT_MAX;
+    }
+    entry.node = 0;
+    entry.tmin = 0;
+    if (!gf3d_obj_bvh_ray_box(&bvh->nodes[0],origin,invDir,&entry.tmin,tBest))return -1;
+    //each level above a node leaves at most one far child waiting, plus the two children pushed at the bottom
+    stackSize = bvh->depth + 1;
+    if (stackSize > BVH_STACK_DEPTH)
+    {
+        stack = gfc_allocate_array(sizeof(BVHStackEntry),stackSize);
+        if (!stack)
+        {
+            slog("no room for a bvh traversal stack %i deep, testing every triangle",stackSize);
+            return gf3d_obj_bvh_brute_force(bvh,origin,dir,anyHit,tHit);
+        }
+    }
+    stack[stackCount++] = entry;
+    while (stackCount)
+    {
+        entry = stack[--stackCount];
+        if (entry.tmin > tBest)continue;//something closer was already found
+        node = &bvh->nodes[entry.node];
+        if (node->count)
+        {
+            for (i = node->first; i < node->first + node->count; i++)
+            {
+                if (!gf3d_obj_bvh_ray_triangle(origin,dir,&bvh->verts[i * 3],&t))continue;
+                if ((t < 0)||(t > tBest))continue;
+                tBest = t;
+                best = i;
+                if (anyHit)break;
+            }
+            if ((anyHit)&&(best >= 0))break;
+            continue;
+        }
+        left = &bvh->nodes[node->first];
+        right = &bvh->nodes[node->first + 1];
+        tLeft = tRight = 0;
+        hitLeft = gf3d_obj_bvh_ray_box(left,origin,invDir,&tLeft,tBest);
+        hitRight = gf3d_obj_bvh_ray_box(right,origin,invDir,&tRight,tBest);
+        //push the far child first so the near one is tested first
+        if ((hitLeft)&&(hitRight))
+        {
+            if (tLeft <= tRight)
+            {
+                stack[stackCount].node = node->first + 1;
+                stack[stackCount++].tmin = tRight;
+                stack[stackCount].node = node->first;
+                stack[stackCount++].tmin = tLeft;
+            }
+            else
+            {
+                stack[stackCount].node = node->first;
+                stack[stackCount++].tmin = tLeft;
+                stack[stackCount].node = node->first + 1;
+                stack[stackCount++].tmin = tRight;
+            }
+        }
+        else if (hitLeft)
+        {
+            stack[stackCount].node = node->first;
+            stack[stackCount++].tmin = tLeft;
+        }
+        else if (hitRight)
+        {
+            stack[stackCount].node = node->first + 1;
+            stack[stackCount++].tmin = tRight;
+        }
+    }
+    if (stack != localStack)free(stack);
+    if (tHit)*tHit = tBest;
+    return best;
+}
+
+int gf3d_obj_bvh_edge_test(ObjBVH *bvh,GFC_Edge3D e,GFC_Vector3D *contact,Uint32 *faceIndex)
+{
+    int hit;
+    float t;
+    hit = gf3d_obj_bvh_traverse(bvh,e,0,&t);
+    if (hit < 0)return 0;
+    if (contact)
+    {
+        contact->x = e.a.x + (e.b.x - e.a.x) * t;
+        contact->y = e.a.y + (e.b.y - e.a.y) * t;
+        contact->z = e.a.z + (e.b.z - e.a.z) * t;
+    }
+    if (faceIndex)*faceIndex = bvh->faces[hit];
+    return 1;
+}
+
+int gf3d_obj_bvh_edge_occluded(ObjBVH *bvh,GFC_Edge3D e)
+{
+    return (gf3d_obj_bvh_traverse(bvh,e,1,NULL) >= 0);
+}
+
+/*eol@eof*/
@@ -1,12 +1,15 @@
 #include <stdio.h>
+#include <math.h>
 
 #include "simple_logger.h"
 
 #include "gfc_pak.h"
 
 #include "gf3d_obj_load.h"
+#include "gf3d_obj_bvh.h"
+#include "gf3d_vertex_batch.h"
 
-int gf3d_obj_edge_test(ObjData *obj,GFC_Matrix4 offset, GFC_Edge3D e,GFC_Vector3D *contact)
+int gf3d_obj_edge_test_linear(ObjData *obj,GFC_Matrix4 offset, GFC_Edge3D e,GFC_Vector3D *contact)
 {
     int i;
     GFC_Vector4D out;
@@ -29,6 +32,118 @@ int gf3d_obj_edge_test(ObjData *obj,GFC_Matrix4 offset, GFC_Edge3D e,GFC_Vector3
     return 0;
 }
 
+/**
+ * @brief general 4x4 inverse by cofactors
+ * @return 0 if the matrix is singular, 1 otherwise
+ */
+int gf3d_obj_matrix4_invert(GFC_Matrix4 out,GFC_Matrix4 in)
+{
+    const float *m = &in[0][0];
+    float inv[16],det;
+    int i;
+
+    inv[0] = m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+    inv[4] = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+    inv[8] = m[4]*m[9]*m[15] - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+    inv[12] = -m[4]*m[9]*m[14] + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+    inv[1] = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+    inv[5] = m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+    inv[9] = -m[0]*m[9]*m[15] + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+    inv[13] = m[0]*m[9]*m[14] - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+    inv[2] = m[1]*m[6]*m[15] - m[1]*m[7]*m[14] - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7] - m[13]*m[3]*m[6];
+    inv[6] = -m[0]*m[6]*m[15] + m[0]*m[7]*m[14] + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7] + m[12]*m[3]*m[6];
+    inv[10] = m[0]*m[5]*m[15] - m[0]*m[7]*m[13] - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7] - m[12]*m[3]*m[5];
+    inv[14] = -m[0]*m[5]*m[14] + m[0]*m[6]*m[13] + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6] + m[12]*m[2]*m[5];
+    inv[3] = -m[1]*m[6]*m[11] + m[1]*m[7]*m[10] + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9]*m[2]*m[7] + m[9]*m[3]*m[6];
+    inv[7] = m[0]*m[6]*m[11] - m[0]*m[7]*m[10] - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8]*m[2]*m[7] - m[8]*m[3]*m[6];
+    inv[11] = -m[0]*m[5]*m[11] + m[0]*m[7]*m[9] + m[4]*m[1]*m[11] - m[4]*m[3]*m[9] - m[8]*m[1]*m[7] + m[8]*m[3]*m[5];
+    inv[15] = m[0]*m[5]*m[10] - m[0]*m[6]*m[9] - m[4]*m[1]*m[10] + m[4]*m[2]*m[9] + m[8]*m[1]*m[6] - m[8]*m[2]*m[5];
+
+    det = m[0]*inv[0] + m[1]*inv[4] + m[2]*inv[8] + m[3]*inv[12];
+    if (fabs(det) < 1e-12)return 0;
+    det = 1.0 / det;
+    for (i = 0; i < 16; i++)
+    {
+        (&out[0][0])[i] = inv[i] * det;
+    }
+    return 1;
+}
+
+void gf3d_obj_build_bvh(ObjData *obj)
+{
+    if (!obj)return;
+    if (obj->bvh)gf3d_obj_bvh_free(obj->bvh);
+    obj->bvh = gf3d_obj_bvh_build(obj);
+}
+
+/**
+ * @brief test one edge against the bvh, where inverse takes the edge into the space the triangles are stored in.
+ * @note the offset is applied to the triangles with w = 0, same as the linear test, so the edge is brought back the same way
+ */
+int gf3d_obj_edge_test_bvh(ObjData *obj,GFC_Matrix4 offset,GFC_Matrix4 inverse,GFC_Edge3D e,GFC_Vector3D *contact)
+{
+    GFC_Vector4D out;
+    GFC_Vector3D local;
+    gfc_matrix4_multiply_v(&out,inverse,gfc_vector3dw(e.a,0));
+    e.a = gfc_vector4dxyz(out);
+    gfc_matrix4_multiply_v(&out,inverse,gfc_vector3dw(e.b,0));
+    e.b = gfc_vector4dxyz(out);
+    if (!gf3d_obj_bvh_edge_test(obj->bvh,e,&local,NULL))return 0;
+    if (contact)
+    {
+        gfc_matrix4_multiply_v(&out,offset,gfc_vector3dw(local,0));
+        *contact = gfc_vector4dxyz(out);
+    }
+    return 1;
+}
+
+Uint32 gf3d_obj_edge_test_batch(ObjData *obj,GFC_Matrix4 offset,GFC_Edge3D *edges,Uint32 count,Uint8 *hits,GFC_Vector3D *contacts)
+{
+    Uint32 i,hitCount = 0;
+    int hit;
+    GFC_Matrix4 inverse;
+    if ((!obj)||(!obj->outFace)||(!edges))return 0;
+    if (!obj->bvh)gf3d_obj_build_bvh(obj);
+    if ((!obj->bvh)||(!gf3d_obj_matrix4_invert(inverse,offset)))
+    {
+        //no bvh or a degenerate offset, fall back to transforming the triangles
+        for (i = 0; i < count; i++)
+        {
+            hit = gf3d_obj_edge_test_linear(obj,offset,edges[i],contacts?&contacts[i]:NULL);
+            if (hits)hits[i] = hit;
+            hitCount += hit;
+        }
+        return hitCount;
+    }
+    for (i = 0; i < count; i++)
+    {
+        hit = gf3d_obj_edge_test_bvh(obj,offset,inverse,edges[i],contacts?&contacts[i]:NULL);
+        if (hits)hits[i] = hit;
+        hitCount += hit;
+    }
+    return hitCount;
+}
+
+int gf3d_obj_edge_test(ObjData *obj,GFC_Matrix4 offset, GFC_Edge3D e,GFC_Vector3D *contact)
+{
+    Uint8 hit = 0;
+    gf3d_obj_edge_test_batch(obj,offset,&e,1,&hit,contact);
+    return hit;
+}
+
+int gf3d_obj_ray_test(ObjData *obj,GFC_Matrix4 offset,GFC_Vector3D origin,GFC_Vector3D direction,float distance,GFC_Vector3D *contact)
+{
+    GFC_Edge3D e;
+    float length;
+    length = gfc_vector3d_magnitude(direction);
+    if (length <= 0)return 0;
+    e.a = origin;
+    e.b.x = origin.x + direction.x * distance / length;
+    e.b.y = origin.y + direction.y * distance / length;
+    e.b.z = origin.z + direction.z * distance / length;
+    return gf3d_obj_edge_test(obj,offset,e,contact);
+}
+
 void gf3d_obj_get_counts_from_file(ObjData *obj, const char *mem,size_t fileSize);
 void gf3d_obj_load_get_data_from_file(ObjData *obj, const char *mem,size_t fileSize);
 
@@ -83,6 +198,7 @@ void gf3d_obj_free(ObjData *obj)
     {
         free(obj->outFace);
     }
+    gf3d_obj_bvh_free(obj->bvh);
     
     free(obj);
 }
@@ -126,20 +242,17 @@ void gf3d_obj_load_reorg(ObjData *obj)
 
 void gf3d_obj_get_bounds(ObjData *obj)
 {
-    int i;
+    GFC_Vector3D min,max;
     if (!obj)return;
-    for (i = 0; i < obj->vertex_count; i++)
-    {
-        if (obj->vertices[i].x < obj->bounds.x)obj->bounds.x = obj->vertices[i].x;
-        if (obj->vertices[i].y < obj->bounds.y)obj->bounds.y = obj->vertices[i].y;
-        if (obj->vertices[i].z < obj->bounds.z)obj->bounds.z = obj->vertices[i].z;
-        if (obj->vertices[i].x > obj->bounds.w)obj->bounds.w = obj->vertices[i].x;
-        if (obj->vertices[i].y > obj->bounds.h)obj->bounds.h = obj->vertices[i].y;
-        if (obj->vertices[i].z > obj->bounds.d)obj->bounds.d = obj->vertices[i].z;
-    }
-    obj->bounds.w -= obj->bounds.x;
-    obj->bounds.h -= obj->bounds.y;
-    obj->bounds.d -= obj->bounds.z;
+    if ((obj->vertices)&&(obj->vertex_count))
+    {
+        gf3d_vertex_batch_points_bounds(obj->vertices,obj->vertex_count,&min,&max);
+    }
+    else
+    {
+        gf3d_vertex_batch_bounds(obj->faceVertices,obj->face_vert_count,&min,&max);
+    }
+    obj->bounds = gfc_box(min.x,min.y,min.z,max.x - min.x,max.y - min.y,max.z - min.z);
 }
 
 ObjData *gf3d_obj_load_from_file(const char *filename)
@@ -326,29 +439,26 @@ void gf3d_obj_load_get_data_from_file(ObjData *obj, const char *mem,size_t fileS
 
 void gf3d_obj_move(ObjData *obj,GFC_Vector3D offset,GFC_Vector3D rotation)
 {
-    GFC_Vector4D outV = {0};
     GFC_Matrix4 matrix = {0};
-    int i;
+    GFC_Vector3D min,max;
     if (!obj)return;
-    for (i = 0; i < obj->face_vert_count;i++)
-    {
-        //update the vertices
-        gfc_matrix4_from_vectors(
-            matrix,
-            offset,
-            rotation,
-            gfc_vector3d(1,1,1));//TODO add the scale too
-        gfc_matrix4_v_multiply(&outV,gfc_vector3dw(obj->faceVertices[i].vertex,1.0),matrix);
-        gfc_vector3d_copy(obj->faceVertices[i].vertex,outV);
-        //update the normal, without the translation
-        gfc_matrix4_from_vectors(
-            matrix,
-            gfc_vector3d(0,0,0),
-            rotation,
-            gfc_vector3d(1,1,1));
-        gfc_matrix4_v_multiply(&outV,gfc_vector3dw(obj->faceVertices[i].normal,1.0),matrix);
-        gfc_vector3d_copy(obj->faceVertices[i].normal,outV);
-
+    if (obj->bvh)
+    {
+        //the bvh is in the old space now
+        gf3d_obj_bvh_free(obj->bvh);
+        obj->bvh = NULL;
+    }
+    gfc_matrix4_from_vectors(
+        matrix,
+        offset,
+        rotation,
+        gfc_vector3d(1,1,1));//TODO add the scale too
+    //normals get the same matrix with w = 0, so they skip the translation
+    gf3d_vertex_batch_transform(obj->faceVertices,obj->faceVertices,obj->face_vert_count,matrix);
+    if (obj->face_vert_count)
+    {
+        gf3d_vertex_batch_bounds(obj->faceVertices,obj->face_vert_count,&min,&max);
+        obj->bounds = gfc_box(min.x,min.y,min.z,max.x - min.x,max.y - min.y,max.z - min.z);
     }
 }
 
@@ -482,8 +592,8 @@ ObjData *gf3d_obj_duplicate(ObjData *in)
 ObjData *gf3d_obj_merge(ObjData *ObjA,GFC_Vector3D offsetA,ObjData *ObjB,GFC_Vector3D offsetB,GFC_Vector3D rotation)
 {
     int i;
-    GFC_Vector4D outV = {0};
     GFC_Matrix4 matrix;
+    GFC_Vector3D min,max;
     ObjData *ObjNew;
     if ((!ObjA)||(!ObjB))return NULL;
     if ((!ObjA->faceVertices)||(!ObjB->faceVertices))
@@ -509,10 +619,7 @@ ObjData *gf3d_obj_merge(ObjData *ObjA,GFC_Vector3D offsetA,ObjData *ObjB,GFC_Vec
         return NULL;
     }
     //copy the old data into the ObjNew
-    for (i = 0; i < ObjA->face_count;i++)
-    {
-        memcpy(&ObjNew->outFace[i],&ObjA->outFace[i],sizeof(Face));
-    }
+    memcpy(ObjNew->outFace,ObjA->outFace,sizeof(Face)*ObjA->face_count);
     for (i = 0; i < ObjB->face_count;i++)
     {
         memcpy(&ObjNew->outFace[i + ObjA->face_count],&ObjB->outFace[i],sizeof(Face));
@@ -521,31 +628,22 @@ ObjData *gf3d_obj_merge(ObjData *ObjA,GFC_Vector3D offsetA,ObjData *ObjB,GFC_Vec
         ObjNew->outFace[i + ObjA->face_count].verts[1]+= ObjA->face_vert_count;
         ObjNew->outFace[i + ObjA->face_count].verts[2]+= ObjA->face_vert_count;
     }
-    for (i = 0; i < ObjA->face_vert_count;i++)
-    {
-        memcpy(&ObjNew->faceVertices[i],&ObjA->faceVertices[i],sizeof(Vertex));
-        gfc_vector3d_add(ObjNew->faceVertices[i].vertex,ObjNew->faceVertices[i].vertex,offsetA);
-    }
-    for (i = 0; i < ObjB->face_vert_count;i++)
-    {
-        //update the vertices
-        memcpy(&ObjNew->faceVertices[i + ObjA->face_vert_count],&ObjB->faceVertices[i],sizeof(Vertex));
-        gfc_matrix4_from_vectors(
-            matrix,
-            offsetB,
-            rotation,
-            gfc_vector3d(1,1,1));
-        gfc_matrix4_v_multiply(&outV,gfc_vector3dw(ObjNew->faceVertices[i + ObjA->face_vert_count].vertex,1.0),matrix);
-        gfc_vector3d_copy(ObjNew->faceVertices[i + ObjA->face_vert_count].vertex,outV);
-        //update the normal, without the translation
-        gfc_matrix4_from_vectors(
-            matrix,
-            gfc_vector3d(0,0,0),
-            rotation,
-            gfc_vector3d(1,1,1));
-        gfc_matrix4_v_multiply(&outV,gfc_vector3dw(ObjNew->faceVertices[i + ObjA->face_vert_count].normal,1.0),matrix);
-        gfc_vector3d_copy(ObjNew->faceVertices[i + ObjA->face_vert_count].normal,outV);
-    }
+    //A is only translated
+    gfc_matrix4_from_vectors(
+        matrix,
+        offsetA,
+        gfc_vector3d(0,0,0),
+        gfc_vector3d(1,1,1));
+    gf3d_vertex_batch_transform(ObjNew->faceVertices,ObjA->faceVertices,ObjA->face_vert_count,matrix);
+    //B is translated and rotated
+    gfc_matrix4_from_vectors(
+        matrix,
+        offsetB,
+        rotation,
+        gfc_vector3d(1,1,1));
+    gf3d_vertex_batch_transform(&ObjNew->faceVertices[ObjA->face_vert_count],ObjB->faceVertices,ObjB->face_vert_count,matrix);
+    gf3d_vertex_batch_bounds(ObjNew->faceVertices,ObjNew->face_vert_count,&min,&max);
+    ObjNew->bounds = gfc_box(min.x,min.y,min.z,max.x - min.x,max.y - min.y,max.z - min.z);
     return ObjNew;
 }
 
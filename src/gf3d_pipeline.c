@@ -11,13 +11,18 @@
 #include "gf3d_vgraphics.h"
 #include "gf3d_shaders.h"
 #include "gf3d_pipeline.h"
+#include "gf3d_pool.h"
+#include "gf3d_bindless.h"
+#include "gf3d_frame_ubo.h"
+#include "gf3d_profiler.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
 
 extern int __DEBUG;
 
 typedef struct
 {
-    Uint32              maxPipelines;
-    Pipeline           *pipelineList;
+    Pool               *pipelinePool;
     Uint32              chainLength;
 }PipelineManager;
 
@@ -37,13 +42,12 @@ void gf3d_pipeline_init(Uint32 max_pipelines)
         slog("cannot initialize zero pipelines");
         return;
     }
-    gf3d_pipeline.pipelineList = (Pipeline *)gfc_allocate_array(sizeof(Pipeline),max_pipelines);
-    if (!gf3d_pipeline.pipelineList)
+    gf3d_pipeline.pipelinePool = gf3d_pool_new(sizeof(Pipeline),max_pipelines,0);
+    if (!gf3d_pipeline.pipelinePool)
     {
         slog("failed to allocate pipeline manager");
         return;
     }
-    gf3d_pipeline.maxPipelines = max_pipelines;
     gf3d_pipeline.chainLength = gf3d_swapchain_get_swap_image_count();
     atexit(gf3d_pipeline_close);
     if (__DEBUG)slog("pipeline system initialized");
@@ -51,14 +55,15 @@ void gf3d_pipeline_init(Uint32 max_pipelines)
 
 void gf3d_pipeline_close()
 {
-    int i;
-    if (gf3d_pipeline.pipelineList != 0)
+    Uint32 i,c;
+    if (gf3d_pipeline.pipelinePool != NULL)
     {
-        for (i = 0; i < gf3d_pipeline.maxPipelines; i++)
+        c = gf3d_pool_get_capacity(gf3d_pipeline.pipelinePool);
+        for (i = 0; i < c; i++)
         {
-            gf3d_pipeline_free(&gf3d_pipeline.pipelineList[i]);
+            gf3d_pipeline_free(gf3d_pool_get_nth(gf3d_pipeline.pipelinePool,i));
         }
-        free(gf3d_pipeline.pipelineList);
+        gf3d_pool_free(gf3d_pipeline.pipelinePool);
     }
     memset(&gf3d_pipeline,0,sizeof(PipelineManager));
     if (__DEBUG)slog("pipeline system closed");
@@ -75,56 +80,81 @@ void gf3d_pipeline_call_render(
     if ((!pipe)||(!descriptorSet))return;
     vkCmdBindVertexBuffers(pipe->commandBuffer, 0, 1, &vertexBuffer, offsets);
     if (indexBuffer != VK_NULL_HANDLE)vkCmdBindIndexBuffer(pipe->commandBuffer, indexBuffer, 0, pipe->indexType);
-    vkCmdBindDescriptorSets(pipe->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe->pipelineLayout, 0, 1, descriptorSet, 0, NULL);
+    vkCmdBindDescriptorSets(pipe->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe->pipelineLayout, pipe->frameUBO?1:0, 1, descriptorSet, 0, NULL);
+    gf3d_stats_add(SC_Binds,(indexBuffer != VK_NULL_HANDLE)?3:2);
     if (indexBuffer != VK_NULL_HANDLE)vkCmdDrawIndexed(pipe->commandBuffer, vertexCount, 1, 0, 0, 0);
     else vkCmdDraw(pipe->commandBuffer, vertexCount,1,0,0);
 }
 
 void gf3d_pipeline_update_descriptor_set(Pipeline *pipe, PipelineDrawCall *drawCall)
 {
-    int count = 1;
+    int count = 0;
     int frame;
     UniformBuffer *buffer;
     VkDescriptorImageInfo imageInfo = {0};
-    VkWriteDescriptorSet descriptorWrite[2] = {0};
+    VkWriteDescriptorSet descriptorWrite[3] = {0};
     VkDescriptorBufferInfo bufferInfo = {0};
+    VkDescriptorBufferInfo storageInfo = {0};
     if ((!pipe)||(!drawCall))return;    
 
-    frame = gf3d_vgraphics_get_current_buffer_frame();
-    buffer = gf3d_uniform_buffer_list_get_nth_buffer(pipe->uboBigBuffer, 0, frame);
-    bufferInfo.buffer = buffer->uniformBuffer;
-    bufferInfo.offset = drawCall->index * pipe->uboDataSize;
-    bufferInfo.range = pipe->uboDataSize;
-
-    descriptorWrite[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite[0].dstSet = *(drawCall->descriptorSet);
-    descriptorWrite[0].dstBinding = 0;
-    descriptorWrite[0].dstArrayElement = 0;
-    descriptorWrite[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descriptorWrite[0].descriptorCount = 1;
-    descriptorWrite[0].pBufferInfo = &bufferInfo;
+    if (pipe->uboBigBuffer)
+    {
+        frame = gf3d_vgraphics_get_current_buffer_frame();
+        buffer = gf3d_uniform_buffer_list_get_nth_buffer(pipe->uboBigBuffer, 0, frame);
+        bufferInfo.buffer = buffer->uniformBuffer;
+        bufferInfo.offset = drawCall->index * pipe->uboDataSize;
+        bufferInfo.range = pipe->uboDataSize;
 
-    if (drawCall->texture)
+        descriptorWrite[count].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[count].dstSet = *(drawCall->descriptorSet);
+        descriptorWrite[count].dstBinding = 0;
+        descriptorWrite[count].dstArrayElement = 0;
+        descriptorWrite[count].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrite[count].descriptorCount = 1;
+        descriptorWrite[count].pBufferInfo = &bufferInfo;
+        count++;
+    }
+    if ((drawCall->texture)&&(!pipe->bindless))
     {
-        count = 2;
         imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
         imageInfo.imageView = drawCall->texture->textureImageView;
         imageInfo.sampler = drawCall->texture->textureSampler;
-        descriptorWrite[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite[1].dstSet = *drawCall->descriptorSet;
-        descriptorWrite[1].dstBinding = 1;
-        descriptorWrite[1].dstArrayElement = 0;
-        descriptorWrite[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrite[1].descriptorCount = 1;                        
-        descriptorWrite[1].pImageInfo = &imageInfo;
-        descriptorWrite[1].pTexelBufferView = NULL; // Optional
+        descriptorWrite[count].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[count].dstSet = *drawCall->descriptorSet;
+        descriptorWrite[count].dstBinding = 1;
+        descriptorWrite[count].dstArrayElement = 0;
+        descriptorWrite[count].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite[count].descriptorCount = 1;                        
+        descriptorWrite[count].pImageInfo = &imageInfo;
+        descriptorWrite[count].pTexelBufferView = NULL; // Optional
+        count++;
+    }
+    if (drawCall->storageBuffer != VK_NULL_HANDLE)
+    {
+        storageInfo.buffer = drawCall->storageBuffer;
+        storageInfo.offset = 0;
+        storageInfo.range = drawCall->storageRange;
+        descriptorWrite[count].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite[count].dstSet = *drawCall->descriptorSet;
+        descriptorWrite[count].dstBinding = 2;
+        descriptorWrite[count].dstArrayElement = 0;
+        descriptorWrite[count].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite[count].descriptorCount = 1;
+        descriptorWrite[count].pBufferInfo = &storageInfo;
+        count++;
     }
+    if (!count)return;
     vkUpdateDescriptorSets(pipe->device, count, descriptorWrite, 0, NULL);
+    gf3d_stats_add(SC_DescriptorWrites,count);
 }
 
 void gf3d_pipeline_render_drawcall(Pipeline *pipe,PipelineDrawCall *drawCall)
 {
     if ((!pipe)||(!drawCall))return;
+    if (pipe->pushConstantRange)
+    {
+        vkCmdPushConstants(pipe->commandBuffer, pipe->pipelineLayout, pipe->pushConstantStages, 0, pipe->pushConstantRange, drawCall->pushData);
+    }
     gf3d_pipeline_call_render(
         pipe,
         drawCall->descriptorSet,
@@ -136,12 +166,33 @@ void gf3d_pipeline_render_drawcall(Pipeline *pipe,PipelineDrawCall *drawCall)
 void gf3d_pipeline_render_all_drawcalls(Pipeline *pipe)
 {
     int i;
-    if (!pipe)return;
+    Uint32 frame;
+    Uint32 drawCalls = 0;
+    VkDescriptorSet *shared;
+    if ((!pipe)||(!pipe->drawCallCount))return;
+    frame = gf3d_vgraphics_get_current_buffer_frame();
+    //frame data and the texture array are the same for every draw, so they are bound once
+    if (pipe->frameUBO)
+    {
+        shared = gf3d_frame_ubo_get_descriptor_set(frame);
+        if (!shared)return;
+        vkCmdBindDescriptorSets(pipe->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe->pipelineLayout, 0, 1, shared, 0, NULL);
+        gf3d_stats_add(SC_Binds,1);
+    }
+    if (pipe->bindless)
+    {
+        shared = gf3d_bindless_get_descriptor_set(frame);
+        if (!shared)return;
+        vkCmdBindDescriptorSets(pipe->commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe->pipelineLayout, pipe->frameUBO?2:1, 1, shared, 0, NULL);
+        gf3d_stats_add(SC_Binds,1);
+    }
     for (i = 0; i < pipe->drawCallCount; i++)
     {
         if (!pipe->drawCallList[i].inuse)continue;
         gf3d_pipeline_render_drawcall(pipe,&pipe->drawCallList[i]);
+        drawCalls++;
     }
+    gf3d_stats_add_pipeline_draws(pipe->name,drawCalls);
 }
 
 
@@ -169,14 +220,15 @@ PipelineDrawCall *gf3d_pipeline_draw_call_new(Pipeline *pipe)
     i = pipe->drawCallCount;
     pipe->drawCallList[i].inuse = 1;
     //setup the data pointer to write to our cpu side ubo buffer
-    ptr = ptr + (i * pipe->uboDataSize);
+    if (ptr)ptr = ptr + (i * pipe->uboDataSize);
     pipe->drawCallList[i].uboData = ptr;
+    if (pipe->pushConstantData)pipe->drawCallList[i].pushData = pipe->pushConstantData + (i * pipe->pushConstantRange);
     pipe->drawCallList[i].index = i;
     pipe->drawCallCount++;
     return &pipe->drawCallList[i];
 }
 
-void gf3d_pipeline_queue_render(
+PipelineDrawCall *gf3d_pipeline_queue_render(
     Pipeline *pipe,
     VkBuffer vertexBuffer,
     Uint32 vertexCount,
@@ -184,20 +236,41 @@ void gf3d_pipeline_queue_render(
     void *uboData,
     Texture *texture)
 {
+    return gf3d_pipeline_queue_render_push(pipe,vertexBuffer,vertexCount,indexBuffer,uboData,NULL,texture);
+}
+
+PipelineDrawCall *gf3d_pipeline_queue_render_push(
+    Pipeline *pipe,
+    VkBuffer vertexBuffer,
+    Uint32 vertexCount,
+    VkBuffer indexBuffer,
+    void *uboData,
+    void *pushData,
+    Texture *texture)
+{
+    Uint32 textureIndex;
     PipelineDrawCall *drawCall;
-    if (!pipe)return;
+    if (!pipe)return NULL;
     drawCall = gf3d_pipeline_draw_call_new(pipe);
     if (!drawCall)
     {
         slog("failed to get a drawcall for pipeline");
-        return;
+        return NULL;
     }
     drawCall->descriptorSet = gf3d_pipeline_get_descriptor_set(pipe, gf3d_vgraphics_get_current_buffer_frame());
     drawCall->vertexBuffer = vertexBuffer;
     drawCall->vertexCount = vertexCount;
     drawCall->indexBuffer = indexBuffer;
     drawCall->texture = texture;
-    memcpy(drawCall->uboData,uboData,pipe->uboDataSize);
+    if ((uboData)&&(pipe->uboDataSize))memcpy(drawCall->uboData,uboData,pipe->uboDataSize);
+    if ((pushData)&&(pipe->pushConstantSize))memcpy(drawCall->pushData,pushData,pipe->pushConstantSize);
+    if ((pipe->bindless)&&(drawCall->pushData))
+    {
+        //the texture index follows the pipeline's own push data
+        textureIndex = texture?texture->bindlessIndex:0;
+        memcpy((char *)drawCall->pushData + pipe->pushConstantSize,&textureIndex,sizeof(Uint32));
+    }
+    return drawCall;
 }
 
 void gf3_pipeline_update_ubos(Pipeline *pipe)
@@ -206,7 +279,7 @@ void gf3_pipeline_update_ubos(Pipeline *pipe)
     void *data;
     UniformBuffer *buffer;
     VkDevice device;
-    if ((!pipe)||(!pipe->drawCallCount))return;//skip if there are no queued calls
+    if ((!pipe)||(!pipe->drawCallCount)||(!pipe->uboBigBuffer))return;//skip if there are no queued calls
     
     device = gf3d_vgraphics_get_default_logical_device();
     frame = gf3d_vgraphics_get_current_buffer_frame();
@@ -224,15 +297,15 @@ void gf3_pipeline_update_ubos(Pipeline *pipe)
 
 Pipeline *gf3d_pipeline_new()
 {
-    int i;
-    for (i = 0; i < gf3d_pipeline.maxPipelines; i++)
+    Pipeline *pipe;
+    pipe = gf3d_pool_alloc(gf3d_pipeline.pipelinePool);
+    if (!pipe)
     {
-        if (gf3d_pipeline.pipelineList[i].inUse)continue;
-        gf3d_pipeline.pipelineList[i].inUse = true;
-        return &gf3d_pipeline.pipelineList[i];
+        slog("no free pipelines");
+        return NULL;
     }
-    slog("no free pipelines");
-    return NULL;
+    pipe->inUse = true;
+    return pipe;
 }
 
 VkFormat gf3d_pipeline_find_supported_format(VkFormat * candidates, Uint32 candidateCount, VkImageTiling tiling, VkFormatFeatureFlags features)
@@ -331,6 +404,7 @@ int gf3d_pipeline_render_pass_create(VkDevice device,SJson *config,VkRenderPass
         slog("failed to create render pass!");
         return 0;
     }
+    gf3d_tracker_create(TC_RenderPass,*renderPass,0,"pipeline");
     if (__DEBUG)slog("created renderpass for pipeline");
     return 1;
 }
@@ -400,6 +474,10 @@ Pipeline *gf3d_pipeline_create_from_config(
     VkPipelineColorBlendAttachmentState colorBlendAttachment = {0};
     VkPipelineColorBlendStateCreateInfo colorBlending = {0};
     VkPipelineDepthStencilStateCreateInfo depthStencil = {0};
+    VkDescriptorSetLayout setLayouts[3];
+    VkPushConstantRange pushConstant = {0};
+    VkPhysicalDeviceProperties properties;
+    short int b = 0;
     
     if (!vertexInputDescription)
     {
@@ -429,11 +507,20 @@ Pipeline *gf3d_pipeline_create_from_config(
         return NULL;
     }
 
+    //set before anything is made with it, so gf3d_pipeline_free can clean up a partial pipeline
+    pipe->device = device;
     vertFile = sj_object_get_value_as_string(config,"vertex_shader");
     if (vertFile)
     {
         pipe->vertShader = (char *)gf3d_shaders_load_data(vertFile,&pipe->vertSize);
-        pipe->vertModule = gf3d_shaders_create_module(pipe->vertShader,pipe->vertSize,device);
+        if (pipe->vertShader)pipe->vertModule = gf3d_shaders_create_module(pipe->vertShader,pipe->vertSize,device);
+        if (pipe->vertModule == VK_NULL_HANDLE)
+        {
+            slog("failed to create vertex shader %s for pipeline %s",vertFile,configFile);
+            sj_free(file);
+            gf3d_pipeline_free(pipe);
+            return NULL;
+        }
         vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
         vertShaderStageInfo.module = pipe->vertModule;
@@ -451,7 +538,14 @@ Pipeline *gf3d_pipeline_create_from_config(
     if (fragFile)
     {
         pipe->fragShader = (char *)gf3d_shaders_load_data(fragFile,&pipe->fragSize);
-        pipe->fragModule = gf3d_shaders_create_module(pipe->fragShader,pipe->fragSize,device);
+        if (pipe->fragShader)pipe->fragModule = gf3d_shaders_create_module(pipe->fragShader,pipe->fragSize,device);
+        if (pipe->fragModule == VK_NULL_HANDLE)
+        {
+            slog("failed to create fragment shader %s for pipeline %s",fragFile,configFile);
+            sj_free(file);
+            gf3d_pipeline_free(pipe);
+            return NULL;
+        }
         fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         fragShaderStageInfo.module = pipe->fragModule;
@@ -460,13 +554,60 @@ Pipeline *gf3d_pipeline_create_from_config(
     }
     else
     {
-        slog("no vertex_shader provided");
+        slog("no fragment_shader provided");
         sj_free(file);
         gf3d_pipeline_free(pipe);
         return NULL;
     }
 
-    pipe->device = device;
+    sj_get_bool_value(sj_object_get_value(config,"bindless"),&b);
+    if ((b)&&(!gf3d_bindless_enabled()))
+    {
+        slog("pipeline %s needs bindless textures, which are not enabled",configFile);
+        sj_free(file);
+        gf3d_pipeline_free(pipe);
+        return NULL;
+    }
+    pipe->bindless = b;
+    
+    b = 0;
+    sj_get_bool_value(sj_object_get_value(config,"frameUBO"),&b);
+    if ((b)&&(gf3d_frame_ubo_get_layout() == VK_NULL_HANDLE))
+    {
+        slog("pipeline %s uses the frame ubo, which is not setup",configFile);
+        sj_free(file);
+        gf3d_pipeline_free(pipe);
+        return NULL;
+    }
+    pipe->frameUBO = b;
+    
+    item = sj_object_get_value(config,"pushConstants");
+    if (item)
+    {
+        sj_object_get_value_as_uint32(item,"size",&pipe->pushConstantSize);
+        pipe->pushConstantStages = gf3d_config_shader_stage_flags(sj_object_get_value(item,"stageFlags"));
+    }
+    pipe->pushConstantRange = pipe->pushConstantSize;
+    if (pipe->bindless)
+    {
+        pipe->pushConstantRange += sizeof(Uint32);
+        pipe->pushConstantStages |= VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    vkGetPhysicalDeviceProperties(gf3d_vgraphics_get_default_physical_device(), &properties);
+    if ((pipe->pushConstantSize % 4)||(pipe->pushConstantRange > properties.limits.maxPushConstantsSize))
+    {
+        slog("pipeline %s push constant size %i is not valid, the device allows up to %i bytes",configFile,pipe->pushConstantRange,properties.limits.maxPushConstantsSize);
+        sj_free(file);
+        gf3d_pipeline_free(pipe);
+        return NULL;
+    }
+    if ((pipe->pushConstantRange)&&(!pipe->pushConstantStages))
+    {
+        slog("pipeline %s push constants have no stageFlags",configFile);
+        sj_free(file);
+        gf3d_pipeline_free(pipe);
+        return NULL;
+    }
     
     sj_object_get_value_as_uint32(config,"descriptorCount",&descriptorCount);
     pipe->descriptorSetCount = descriptorCount;
@@ -527,6 +668,24 @@ Pipeline *gf3d_pipeline_create_from_config(
     pipelineLayoutInfo.pSetLayouts = &pipe->descriptorSetLayout; // Optional 
     pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
     pipelineLayoutInfo.pPushConstantRanges = NULL; // Optional
+    if ((pipe->frameUBO)||(pipe->bindless))
+    {
+        //the frame ubo comes before the pipeline's own set, the shared texture array after it
+        pipelineLayoutInfo.setLayoutCount = 0;
+        if (pipe->frameUBO)setLayouts[pipelineLayoutInfo.setLayoutCount++] = gf3d_frame_ubo_get_layout();
+        setLayouts[pipelineLayoutInfo.setLayoutCount++] = pipe->descriptorSetLayout;
+        if (pipe->bindless)setLayouts[pipelineLayoutInfo.setLayoutCount++] = gf3d_bindless_get_layout();
+        pipelineLayoutInfo.pSetLayouts = setLayouts;
+    }
+    if (pipe->pushConstantRange)
+    {
+        //one range for all stages, per-draw data is pushed instead of written to the UBO
+        pushConstant.stageFlags = pipe->pushConstantStages;
+        pushConstant.offset = 0;
+        pushConstant.size = pipe->pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstant;
+    }
 
     item = sj_object_get_value(config,"renderPass");
     if (!item)
@@ -547,10 +706,12 @@ Pipeline *gf3d_pipeline_create_from_config(
     if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, NULL, &pipe->pipelineLayout) != VK_SUCCESS)
     {
         slog("failed to create pipeline layout!");
+        pipe->pipelineLayout = VK_NULL_HANDLE;
         sj_free(file);
         gf3d_pipeline_free(pipe);
         return NULL;
     }
+    gf3d_tracker_create(TC_PipelineLayout,pipe->pipelineLayout,0,"pipeline");
     
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = 2;
@@ -574,19 +735,24 @@ Pipeline *gf3d_pipeline_create_from_config(
     if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &pipe->pipeline) != VK_SUCCESS)
     {   
         slog("failed to create pipeline!");
-        
+        pipe->pipeline = VK_NULL_HANDLE;
         gf3d_pipeline_free(pipe);
         return NULL;
     }
+    gf3d_tracker_create(TC_Pipeline,pipe->pipeline,0,"pipeline");
     pipe->drawCallList = gfc_allocate_array(sizeof(PipelineDrawCall),descriptorCount);
     if (pipe->drawCallList)
     {
         pipe->drawCallListCount = descriptorCount;
     }
-    pipe->uboBufferSize = bufferSize * descriptorCount;
-    pipe->uboData = gfc_allocate_array(bufferSize,descriptorCount);
     pipe->uboDataSize = bufferSize;
-    pipe->uboBigBuffer = gf3d_uniform_buffer_list_new(device,bufferSize*descriptorCount,1,gf3d_swapchain_get_swap_image_count());
+    if (bufferSize)
+    {
+        pipe->uboBufferSize = bufferSize * descriptorCount;
+        pipe->uboData = gfc_allocate_array(bufferSize,descriptorCount);
+        pipe->uboBigBuffer = gf3d_uniform_buffer_list_new(device,bufferSize*descriptorCount,1,gf3d_swapchain_get_swap_image_count());
+    }
+    if (pipe->pushConstantRange)pipe->pushConstantData = gfc_allocate_array(pipe->pushConstantRange,descriptorCount);
     gfc_line_cpy(pipe->name,configFile);
     pipe->indexType = indexType;
     if (__DEBUG)slog("pipeline created from file '%s'",configFile);
@@ -607,6 +773,7 @@ void gf3d_pipeline_free(Pipeline *pipe)
         gf3d_uniform_buffer_list_free(pipe->uboBigBuffer);
     }
     if (pipe->uboData)free(pipe->uboData);
+    if (pipe->pushConstantData)free(pipe->pushConstantData);
     if (pipe->descriptorCursor)
     {
         free(pipe->descriptorCursor);
@@ -618,6 +785,7 @@ void gf3d_pipeline_free(Pipeline *pipe)
         {
             if (pipe->descriptorPool[i] != VK_NULL_HANDLE)
             {
+                gf3d_tracker_destroy(TC_DescriptorPool,pipe->descriptorPool[i]);
                 vkDestroyDescriptorPool(pipe->device, pipe->descriptorPool[i], NULL);
             }
         }
@@ -625,26 +793,32 @@ void gf3d_pipeline_free(Pipeline *pipe)
     }
     if (pipe->descriptorSetLayout != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_DescriptorSetLayout,pipe->descriptorSetLayout);
         vkDestroyDescriptorSetLayout(pipe->device, pipe->descriptorSetLayout, NULL);
     }
     if (pipe->pipeline != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_Pipeline,pipe->pipeline);
         vkDestroyPipeline(pipe->device, pipe->pipeline, NULL);
     }
     if (pipe->pipelineLayout != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_PipelineLayout,pipe->pipelineLayout);
         vkDestroyPipelineLayout(pipe->device, pipe->pipelineLayout, NULL);
     }
     if (pipe->renderPass)
     {
+        gf3d_tracker_destroy(TC_RenderPass,pipe->renderPass);
         vkDestroyRenderPass(pipe->device, pipe->renderPass, NULL);
     }
     if (pipe->fragModule != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_ShaderModule,pipe->fragModule);
         vkDestroyShaderModule(pipe->device, pipe->fragModule, NULL);
     }
     if (pipe->vertModule != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_ShaderModule,pipe->vertModule);
         vkDestroyShaderModule(pipe->device, pipe->vertModule, NULL);
     }
     if (pipe->fragShader != NULL)
@@ -656,6 +830,7 @@ void gf3d_pipeline_free(Pipeline *pipe)
         free (pipe->vertShader);
     }
     memset(pipe,0,sizeof(Pipeline));
+    gf3d_pool_release(gf3d_pipeline.pipelinePool,pipe);
 }
 
 void gf3d_pipeline_create_basic_descriptor_pool_from_config(Pipeline *pipe,SJson *config)
@@ -717,8 +892,10 @@ void gf3d_pipeline_create_basic_descriptor_pool(Pipeline *pipe,VkDescriptorPoolS
         if (vkCreateDescriptorPool(pipe->device, &poolInfo, NULL, &pipe->descriptorPool[i]) != VK_SUCCESS)
         {
             slog("failed to create descriptor pool!");
+            pipe->descriptorPool[i] = VK_NULL_HANDLE;
             return;
         }
+        gf3d_tracker_create(TC_DescriptorPool,pipe->descriptorPool[i],0,"pipeline");
     }
     if (__DEBUG)
     {
@@ -729,12 +906,15 @@ void gf3d_pipeline_create_basic_descriptor_pool(Pipeline *pipe,VkDescriptorPoolS
 
 void gf3d_pipeline_reset_all_pipes()
 {
-    int i;
+    Uint32 i,c;
+    Pipeline *pipe;
     Uint32 bufferFrame = gf3d_vgraphics_get_current_buffer_frame();
-    for (i = 0; i < gf3d_pipeline.maxPipelines;i++)
+    c = gf3d_pool_get_capacity(gf3d_pipeline.pipelinePool);
+    for (i = 0; i < c;i++)
     {
-        if (!gf3d_pipeline.pipelineList[i].inUse)continue;
-        gf3d_pipeline_reset_frame(&gf3d_pipeline.pipelineList[i],bufferFrame);
+        pipe = gf3d_pool_get_nth(gf3d_pipeline.pipelinePool,i);
+        if ((!pipe)||(!pipe->inUse))continue;
+        gf3d_pipeline_reset_frame(pipe,bufferFrame);
     }
 }
 
@@ -751,7 +931,8 @@ void gf3d_pipeline_reset_frame(Pipeline *pipe,Uint32 frame)
     pipe->commandBuffer = gf3d_command_rendering_begin(frame,pipe);
     pipe->drawCallCount = 0;
     memset(pipe->drawCallList,0,sizeof(PipelineDrawCall)*pipe->drawCallListCount);//clear this out
-    memset(pipe->uboData,0,pipe->uboBufferSize);
+    if (pipe->uboData)memset(pipe->uboData,0,pipe->uboBufferSize);
+    if (pipe->pushConstantData)memset(pipe->pushConstantData,0,pipe->pushConstantRange * pipe->drawCallListCount);
 }
 
 void gf3d_pipeline_submit_commands(Pipeline *pipe)
@@ -762,18 +943,24 @@ void gf3d_pipeline_submit_commands(Pipeline *pipe)
 
 void gf3d_pipeline_submit_all_pipe_commands()
 {
-    int i;
-    for (i = 0; i < gf3d_pipeline.maxPipelines;i++)
+    Uint32 i,c;
+    Sint32 zone;
+    Pipeline *pipe;
+    c = gf3d_pool_get_capacity(gf3d_pipeline.pipelinePool);
+    for (i = 0; i < c;i++)
     {
-        if (!gf3d_pipeline.pipelineList[i].inUse)continue;
+        pipe = gf3d_pool_get_nth(gf3d_pipeline.pipelinePool,i);
+        if ((!pipe)||(!pipe->inUse))continue;
         //Update UBOS
-        gf3_pipeline_update_ubos(&gf3d_pipeline.pipelineList[i]);
+        gf3_pipeline_update_ubos(pipe);
         //Update Descriptor sets
-        gf3d_pipeline_update_descriptor_sets(&gf3d_pipeline.pipelineList[i]);
+        gf3d_pipeline_update_descriptor_sets(pipe);
         //Set commands
-        gf3d_pipeline_render_all_drawcalls(&gf3d_pipeline.pipelineList[i]);
+        zone = gf3d_profiler_zone_begin(pipe->commandBuffer,pipe->name);
+        gf3d_pipeline_render_all_drawcalls(pipe);
+        gf3d_profiler_zone_end(pipe->commandBuffer,zone);
         //submit commands
-        gf3d_pipeline_submit_commands(&gf3d_pipeline.pipelineList[i]);
+        gf3d_pipeline_submit_commands(pipe);
     }
 }
 
@@ -860,7 +1047,9 @@ void gf3d_pipeline_create_basic_descriptor_set_layout_from_config(Pipeline *pipe
     if (vkCreateDescriptorSetLayout(pipe->device, &layoutInfo, NULL, &pipe->descriptorSetLayout) != VK_SUCCESS)
     {
         slog("failed to create descriptor set layout!");
+        pipe->descriptorSetLayout = VK_NULL_HANDLE;
     }
+    else gf3d_tracker_create(TC_DescriptorSetLayout,pipe->descriptorSetLayout,0,"pipeline");
     free(bindings);
 }
 
@@ -0,0 +1,201 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_pool.h"
+
+#define POOL_ALIGN 16
+
+typedef struct
+{
+    Uint32  index;
+    Uint32  generation;
+    Uint32  nextFree;       /**<next slot on the free list while this one is free*/
+    Uint32  live;
+}PoolSlot;
+
+#define POOL_HEADER_SIZE (((sizeof(PoolSlot) + POOL_ALIGN - 1) / POOL_ALIGN) * POOL_ALIGN)
+
+extern int __DEBUG;
+
+PoolSlot *gf3d_pool_get_slot(Pool *pool,Uint32 index)
+{
+    return (PoolSlot *)(pool->chunks[index / pool->chunkSize] + (size_t)(index % pool->chunkSize) * pool->slotSize);
+}
+
+void *gf3d_pool_slot_element(PoolSlot *slot)
+{
+    return (Uint8 *)slot + POOL_HEADER_SIZE;
+}
+
+PoolSlot *gf3d_pool_element_slot(void *element)
+{
+    return (PoolSlot *)((Uint8 *)element - POOL_HEADER_SIZE);
+}
+
+int gf3d_pool_grow(Pool *pool)
+{
+    Uint32 i,first;
+    Uint8 **chunks;
+    Uint8 *chunk;
+    PoolSlot *slot;
+    if ((pool->maxCapacity)&&(pool->capacity + pool->chunkSize > pool->maxCapacity))
+    {
+        slog("pool is at its maximum capacity of %i",pool->maxCapacity);
+        return 0;
+    }
+    chunk = gfc_allocate_array(pool->slotSize,pool->chunkSize);
+    if (!chunk)
+    {
+        slog("failed to allocate pool chunk");
+        return 0;
+    }
+    chunks = realloc(pool->chunks,sizeof(Uint8 *) * (pool->chunkCount + 1));
+    if (!chunks)
+    {
+        slog("failed to grow pool chunk list");
+        free(chunk);
+        return 0;
+    }
+    pool->chunks = chunks;
+    pool->chunks[pool->chunkCount++] = chunk;
+    first = pool->capacity;
+    pool->capacity += pool->chunkSize;
+    //push in reverse so the new slots are handed out in order
+    for (i = pool->capacity; i > first; i--)
+    {
+        slot = gf3d_pool_get_slot(pool,i - 1);
+        slot->index = i - 1;
+        slot->generation = 1;
+        slot->nextFree = pool->freeHead;
+        pool->freeHead = i - 1;
+        pool->freeCount++;
+    }
+    if ((__DEBUG)&&(pool->chunkCount > 1))slog("pool grew to %i elements",pool->capacity);
+    return 1;
+}
+
+Pool *gf3d_pool_new(size_t elementSize,Uint32 chunkSize,Uint32 maxCapacity)
+{
+    Pool *pool;
+    if ((!elementSize)||(!chunkSize))
+    {
+        slog("cannot make a pool of zero sized elements or chunks");
+        return NULL;
+    }
+    pool = gfc_allocate_array(sizeof(Pool),1);
+    if (!pool)return NULL;
+    pool->elementSize = elementSize;
+    pool->slotSize = POOL_HEADER_SIZE + ((elementSize + POOL_ALIGN - 1) / POOL_ALIGN) * POOL_ALIGN;
+    pool->chunkSize = chunkSize;
+    pool->maxCapacity = maxCapacity;
+    if ((maxCapacity)&&(chunkSize > maxCapacity))pool->chunkSize = maxCapacity;
+    if (!gf3d_pool_grow(pool))
+    {
+        gf3d_pool_free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void gf3d_pool_free(Pool *pool)
+{
+    Uint32 i;
+    if (!pool)return;
+    for (i = 0; i < pool->chunkCount; i++)
+    {
+        free(pool->chunks[i]);
+    }
+    if (pool->chunks)free(pool->chunks);
+    free(pool);
+}
+
+void *gf3d_pool_alloc(Pool *pool)
+{
+    PoolSlot *slot;
+    void *element;
+    if (!pool)return NULL;
+    if (!pool->freeCount)
+    {
+        if (!gf3d_pool_grow(pool))return NULL;
+    }
+    slot = gf3d_pool_get_slot(pool,pool->freeHead);
+    pool->freeHead = slot->nextFree;
+    pool->freeCount--;
+    pool->count++;
+    slot->live = 1;
+    element = gf3d_pool_slot_element(slot);
+    memset(element,0,pool->elementSize);
+    return element;
+}
+
+void gf3d_pool_release(Pool *pool,void *element)
+{
+    PoolSlot *slot;
+    if ((!pool)||(!element))return;
+    slot = gf3d_pool_element_slot(element);
+    if ((slot->index >= pool->capacity)||(gf3d_pool_get_slot(pool,slot->index) != slot))
+    {
+        slog("element does not belong to this pool");
+        return;
+    }
+    if (!slot->live)return;
+    slot->live = 0;
+    slot->generation++;
+    if (!slot->generation)slot->generation = 1;
+    slot->nextFree = pool->freeHead;
+    pool->freeHead = slot->index;
+    pool->freeCount++;
+    pool->count--;
+}
+
+PoolHandle gf3d_pool_get_handle(Pool *pool,void *element)
+{
+    PoolHandle handle = {0};
+    PoolSlot *slot;
+    if ((!pool)||(!element))return handle;
+    slot = gf3d_pool_element_slot(element);
+    if ((slot->index >= pool->capacity)||(!slot->live))return handle;
+    handle.index = slot->index;
+    handle.generation = slot->generation;
+    return handle;
+}
+
+void *gf3d_pool_get(Pool *pool,PoolHandle handle)
+{
+    PoolSlot *slot;
+    if ((!pool)||(handle.index >= pool->capacity))return NULL;
+    slot = gf3d_pool_get_slot(pool,handle.index);
+    if ((!slot->live)||(slot->generation != handle.generation))return NULL;
+    return gf3d_pool_slot_element(slot);
+}
+
+void *gf3d_pool_get_nth(Pool *pool,Uint32 index)
+{
+    PoolSlot *slot;
+    if ((!pool)||(index >= pool->capacity))return NULL;
+    slot = gf3d_pool_get_slot(pool,index);
+    if (!slot->live)return NULL;
+    return gf3d_pool_slot_element(slot);
+}
+
+Uint32 gf3d_pool_get_capacity(Pool *pool)
+{
+    if (!pool)return 0;
+    return pool->capacity;
+}
+
+Uint32 gf3d_pool_get_count(Pool *pool)
+{
+    if (!pool)return 0;
+    return pool->count;
+}
+
+Uint32 gf3d_pool_get_free_count(Pool *pool)
+{
+    if (!pool)return 0;
+    return pool->freeCount;
+}
+
+/*eol@eof*/
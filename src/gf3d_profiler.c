@@ -0,0 +1,327 @@
+#include <string.h>
+
+#include "simple_logger.h"
+#include "simple_json.h"
+
+#include "gfc_pak.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_swapchain.h"
+#include "gf3d_vqueues.h"
+#include "gf3d_tracker.h"
+#include "gf3d_profiler.h"
+
+#define PROFILER_MAX_NAMED 128  /**<distinct zone names that are tracked*/
+
+typedef struct
+{
+    Uint32  zone;           /**<index into the named zones*/
+    Bool    topLevel;       /**<not nested in another zone, counts towards the frame time*/
+}ZoneInstance;
+
+typedef struct
+{
+    VkQueryPool     pool;
+    ZoneInstance   *instances;      /**<each instance uses queries 2i and 2i + 1*/
+    Uint32          instanceCount;
+    Bool            pending;        /**<queries were written and not yet read back*/
+    Bool            reset;          /**<the reset of the queries has been recorded this frame*/
+}ProfilerFrame;
+
+typedef struct
+{
+    Bool            enabled;
+    VkDevice        device;
+    Uint32          chainLength;
+    Uint32          maxZones;           /**<zone instances per frame*/
+    float           timestampPeriod;    /**<nanoseconds per timestamp tick*/
+    Uint64          timestampMask;      /**<valid bits of a timestamp*/
+    ProfilerFrame  *frames;
+    Uint32          current;            /**<swap chain frame being recorded*/
+    Uint32          openZones;          /**<zones begun and not ended, for nesting*/
+    Uint32          frameCount;         /**<frames read back*/
+    Uint64         *results;            /**<readback space, value and availability for each query*/
+    ProfilerZone    zones[PROFILER_MAX_NAMED];
+    float           zoneSum[PROFILER_MAX_NAMED];    /**<time per zone for the frame being read back*/
+    Uint32          zoneCount;
+    float           frameMs;
+}GPUProfiler;
+
+extern int __DEBUG;
+static GPUProfiler gf3d_profiler = {0};
+
+void gf3d_profiler_close()
+{
+    Uint32 i;
+    for (i = 0; (gf3d_profiler.frames)&&(i < gf3d_profiler.chainLength); i++)
+    {
+        if (gf3d_profiler.frames[i].pool != VK_NULL_HANDLE)
+        {
+            gf3d_tracker_destroy(TC_QueryPool,gf3d_profiler.frames[i].pool);
+            vkDestroyQueryPool(gf3d_profiler.device,gf3d_profiler.frames[i].pool,NULL);
+        }
+        if (gf3d_profiler.frames[i].instances)free(gf3d_profiler.frames[i].instances);
+    }
+    if (gf3d_profiler.frames)free(gf3d_profiler.frames);
+    if (gf3d_profiler.results)free(gf3d_profiler.results);
+    memset(&gf3d_profiler,0,sizeof(GPUProfiler));
+    if (__DEBUG)slog("gpu profiler closed");
+}
+
+Bool gf3d_profiler_config_enabled(const char *config)
+{
+    SJson *json;
+    short int enable = 0;
+    if (!config)return false;
+    json = gfc_pak_load_json(config);
+    if (!json)return false;
+    sj_get_bool_value(sj_object_get_value(json,"gpu_profiler"),&enable);
+    sj_free(json);
+    return enable;
+}
+
+void gf3d_profiler_init(const char *config,Uint32 maxZones)
+{
+    Uint32 i,count = 0;
+    Sint32 family;
+    VkPhysicalDevice gpu;
+    VkPhysicalDeviceProperties properties;
+    VkQueueFamilyProperties *families;
+    VkQueryPoolCreateInfo queryInfo = {0};
+    Uint32 validBits = 0;
+
+    if (!gf3d_profiler_config_enabled(config))return;
+    if (!maxZones)
+    {
+        slog("cannot profile zero zones");
+        return;
+    }
+    gpu = gf3d_vgraphics_get_default_physical_device();
+    vkGetPhysicalDeviceProperties(gpu,&properties);
+    family = gf3d_vqueues_get_graphics_queue_family();
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu,&count,NULL);
+    if ((family >= 0)&&((Uint32)family < count))
+    {
+        families = gfc_allocate_array(sizeof(VkQueueFamilyProperties),count);
+        if (families)
+        {
+            vkGetPhysicalDeviceQueueFamilyProperties(gpu,&count,families);
+            validBits = families[family].timestampValidBits;
+            free(families);
+        }
+    }
+    if ((!validBits)||(properties.limits.timestampPeriod <= 0))
+    {
+        slog("graphics queue does not support timestamps, gpu profiler disabled");
+        return;
+    }
+    gf3d_profiler.timestampMask = (validBits >= 64)?0xFFFFFFFFFFFFFFFFULL:((1ULL << validBits) - 1);
+    gf3d_profiler.timestampPeriod = properties.limits.timestampPeriod;
+    gf3d_profiler.device = gf3d_vgraphics_get_default_logical_device();
+    gf3d_profiler.chainLength = gf3d_swapchain_get_swap_image_count();
+    gf3d_profiler.maxZones = maxZones;
+    gf3d_profiler.frames = gfc_allocate_array(sizeof(ProfilerFrame),gf3d_profiler.chainLength);
+    gf3d_profiler.results = gfc_allocate_array(sizeof(Uint64) * 2,maxZones * 2);
+    if ((!gf3d_profiler.frames)||(!gf3d_profiler.results))
+    {
+        slog("failed to allocate gpu profiler");
+        gf3d_profiler_close();
+        return;
+    }
+    atexit(gf3d_profiler_close);
+    queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = maxZones * 2;
+    for (i = 0; i < gf3d_profiler.chainLength; i++)
+    {
+        gf3d_profiler.frames[i].instances = gfc_allocate_array(sizeof(ZoneInstance),maxZones);
+        if ((!gf3d_profiler.frames[i].instances)||
+            (vkCreateQueryPool(gf3d_profiler.device,&queryInfo,NULL,&gf3d_profiler.frames[i].pool) != VK_SUCCESS))
+        {
+            slog("failed to create gpu profiler query pool");
+            gf3d_profiler.frames[i].pool = VK_NULL_HANDLE;
+            return;
+        }
+        gf3d_tracker_create(TC_QueryPool,gf3d_profiler.frames[i].pool,0,"gpu profiler");
+    }
+    gf3d_profiler.current = gf3d_profiler.chainLength;
+    gf3d_profiler.enabled = true;
+    if (__DEBUG)slog("gpu profiler initialized for %i zones per frame",maxZones);
+}
+
+Bool gf3d_profiler_enabled()
+{
+    return gf3d_profiler.enabled;
+}
+
+Uint32 gf3d_profiler_find_zone(const char *name)
+{
+    Uint32 i;
+    for (i = 0; i < gf3d_profiler.zoneCount; i++)
+    {
+        if (strncmp(gf3d_profiler.zones[i].name,name,sizeof(GFC_TextLine) - 1) == 0)return i;
+    }
+    if (gf3d_profiler.zoneCount >= PROFILER_MAX_NAMED)return PROFILER_MAX_NAMED;
+    memset(&gf3d_profiler.zones[i],0,sizeof(ProfilerZone));
+    gfc_line_cpy(gf3d_profiler.zones[i].name,name);
+    gf3d_profiler.zoneCount++;
+    return i;
+}
+
+void gf3d_profiler_zone_add_sample(ProfilerZone *zone,float ms)
+{
+    Uint32 i;
+    zone->lastMs = ms;
+    zone->history[zone->historyIndex] = ms;
+    zone->historyIndex = (zone->historyIndex + 1) % PROFILER_HISTORY;
+    if (zone->historyCount < PROFILER_HISTORY)zone->historyCount++;
+    zone->averageMs = 0;
+    zone->maxMs = 0;
+    for (i = 0; i < zone->historyCount; i++)
+    {
+        zone->averageMs += zone->history[i];
+        zone->maxMs = MAX(zone->maxMs,zone->history[i]);
+    }
+    zone->averageMs /= zone->historyCount;
+}
+
+void gf3d_profiler_read_frame(ProfilerFrame *frame)
+{
+    Uint32 i;
+    Uint64 *begin,*end;
+    float ms,frameMs = 0;
+    VkResult result;
+    if (!frame->instanceCount)return;
+    //availability is returned with each result, so this never waits on the GPU
+    result = vkGetQueryPoolResults(
+        gf3d_profiler.device,
+        frame->pool,
+        0,
+        frame->instanceCount * 2,
+        sizeof(Uint64) * 4 * frame->instanceCount,
+        gf3d_profiler.results,
+        sizeof(Uint64) * 2,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if ((result != VK_SUCCESS)&&(result != VK_NOT_READY))return;
+    gf3d_profiler.frameCount++;
+    for (i = 0; i < frame->instanceCount; i++)
+    {
+        begin = &gf3d_profiler.results[i * 4];
+        end = &gf3d_profiler.results[i * 4 + 2];
+        if ((!begin[1])||(!end[1]))continue;
+        ms = ((end[0] - begin[0]) & gf3d_profiler.timestampMask) * gf3d_profiler.timestampPeriod * 0.000001f;
+        if (gf3d_profiler.zones[frame->instances[i].zone].lastFrame != gf3d_profiler.frameCount)
+        {
+            gf3d_profiler.zones[frame->instances[i].zone].lastFrame = gf3d_profiler.frameCount;
+            gf3d_profiler.zoneSum[frame->instances[i].zone] = 0;
+        }
+        gf3d_profiler.zoneSum[frame->instances[i].zone] += ms;
+        if (frame->instances[i].topLevel)frameMs += ms;
+    }
+    for (i = 0; i < gf3d_profiler.zoneCount; i++)
+    {
+        if (gf3d_profiler.zones[i].lastFrame != gf3d_profiler.frameCount)continue;
+        gf3d_profiler_zone_add_sample(&gf3d_profiler.zones[i],gf3d_profiler.zoneSum[i]);
+    }
+    gf3d_profiler.frameMs = frameMs;
+}
+
+void gf3d_profiler_begin_frame(Uint32 frame)
+{
+    ProfilerFrame *profilerFrame;
+    if ((!gf3d_profiler.enabled)||(frame >= gf3d_profiler.chainLength))return;
+    profilerFrame = &gf3d_profiler.frames[frame];
+    if (profilerFrame->pending)gf3d_profiler_read_frame(profilerFrame);
+    profilerFrame->instanceCount = 0;
+    profilerFrame->pending = false;
+    profilerFrame->reset = false;
+    gf3d_profiler.openZones = 0;
+    gf3d_profiler.current = frame;
+}
+
+void gf3d_profiler_reset_queries(VkCommandBuffer commandBuffer)
+{
+    ProfilerFrame *frame;
+    if ((!gf3d_profiler.enabled)||(!commandBuffer)||(gf3d_profiler.current >= gf3d_profiler.chainLength))return;
+    frame = &gf3d_profiler.frames[gf3d_profiler.current];
+    if (frame->reset)return;
+    //queries must be reset outside of a render pass, so this goes ahead of the first pipeline's render pass
+    vkCmdResetQueryPool(commandBuffer,frame->pool,0,gf3d_profiler.maxZones * 2);
+    frame->reset = true;
+}
+
+Sint32 gf3d_profiler_zone_begin(VkCommandBuffer commandBuffer,const char *name)
+{
+    Uint32 zone;
+    ProfilerFrame *frame;
+    if ((!gf3d_profiler.enabled)||(!name)||(gf3d_profiler.current >= gf3d_profiler.chainLength))return -1;
+    frame = &gf3d_profiler.frames[gf3d_profiler.current];
+    if (!frame->reset)return -1;
+    if (frame->instanceCount >= gf3d_profiler.maxZones)
+    {
+        if (__DEBUG)slog("gpu profiler out of zones this frame");
+        return -1;
+    }
+    zone = gf3d_profiler_find_zone(name);
+    if (zone >= PROFILER_MAX_NAMED)return -1;
+    frame->instances[frame->instanceCount].zone = zone;
+    frame->instances[frame->instanceCount].topLevel = (gf3d_profiler.openZones == 0);
+    vkCmdWriteTimestamp(commandBuffer,VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,frame->pool,frame->instanceCount * 2);
+    gf3d_profiler.openZones++;
+    frame->pending = true;
+    return frame->instanceCount++;
+}
+
+void gf3d_profiler_zone_end(VkCommandBuffer commandBuffer,Sint32 zone)
+{
+    ProfilerFrame *frame;
+    if ((!gf3d_profiler.enabled)||(zone < 0)||(gf3d_profiler.current >= gf3d_profiler.chainLength))return;
+    frame = &gf3d_profiler.frames[gf3d_profiler.current];
+    if ((Uint32)zone >= frame->instanceCount)return;
+    vkCmdWriteTimestamp(commandBuffer,VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,frame->pool,zone * 2 + 1);
+    if (gf3d_profiler.openZones)gf3d_profiler.openZones--;
+}
+
+Uint32 gf3d_profiler_get_zone_count()
+{
+    return gf3d_profiler.zoneCount;
+}
+
+const ProfilerZone *gf3d_profiler_get_zone(Uint32 index)
+{
+    if (index >= gf3d_profiler.zoneCount)return NULL;
+    return &gf3d_profiler.zones[index];
+}
+
+const ProfilerZone *gf3d_profiler_get_zone_by_name(const char *name)
+{
+    Uint32 i;
+    if (!name)return NULL;
+    for (i = 0; i < gf3d_profiler.zoneCount; i++)
+    {
+        if (strncmp(gf3d_profiler.zones[i].name,name,sizeof(GFC_TextLine) - 1) == 0)return &gf3d_profiler.zones[i];
+    }
+    return NULL;
+}
+
+float gf3d_profiler_get_frame_ms()
+{
+    return gf3d_profiler.frameMs;
+}
+
+void gf3d_profiler_log()
+{
+    Uint32 i;
+    if (!gf3d_profiler.enabled)return;
+    slog("gpu frame: %.3fms",gf3d_profiler.frameMs);
+    for (i = 0; i < gf3d_profiler.zoneCount; i++)
+    {
+        slog("gpu zone %s: avg %.3fms, last %.3fms, max %.3fms",
+            gf3d_profiler.zones[i].name,
+            gf3d_profiler.zones[i].averageMs,
+            gf3d_profiler.zones[i].lastMs,
+            gf3d_profiler.zones[i].maxMs);
+    }
+}
+
+/*eol@eof*/
@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_registry.h"
+
+#define REGISTRY_MIN_CAPACITY 16
+
+extern int __DEBUG;
+
+void gf3d_registry_table_free(Registry *reg);
+
+static Registry *gf3d_registry_strings = NULL;  /**<the intern table, key and data are the same interned copy*/
+static Uint32    gf3d_registry_live = 0;        /**<registries that still hold interned keys*/
+static Bool      gf3d_registry_closing = 0;     /**<program exit has started, free the strings with the last registry*/
+
+void gf3d_registry_strings_free()
+{
+    Uint32 i;
+    if (!gf3d_registry_strings)return;
+    for (i = 0; i < gf3d_registry_strings->capacity; i++)
+    {
+        if (gf3d_registry_strings->entries[i].data)free(gf3d_registry_strings->entries[i].data);
+    }
+    if (__DEBUG)slog("freed %i interned strings",gf3d_registry_strings->count);
+    gf3d_registry_table_free(gf3d_registry_strings);
+    gf3d_registry_strings = NULL;
+}
+
+/**
+ * @brief managers that registered their close before the first intern still hold interned keys when this runs,
+ * so the strings are only freed once the last registry has been freed
+ */
+void gf3d_registry_strings_close()
+{
+    gf3d_registry_closing = 1;
+    if (!gf3d_registry_live)gf3d_registry_strings_free();
+}
+
+Uint32 gf3d_registry_hash(const char *key)
+{
+    Uint32 i;
+    Uint32 hash = 2166136261u;
+    if (!key)return 1;
+    //FNV-1a
+    for (i = 0; (i < GFCLINELEN)&&(key[i]); i++)
+    {
+        hash ^= (Uint8)key[i];
+        hash *= 16777619u;
+    }
+    return hash?hash:1;
+}
+
+int gf3d_registry_key_equal(const char *a,const char *b)
+{
+    if (a == b)return 1;
+    return strncmp(a,b,GFCLINELEN) == 0;
+}
+
+Registry *gf3d_registry_table_new(Uint32 capacity)
+{
+    Uint32 size = REGISTRY_MIN_CAPACITY;
+    Registry *reg;
+    //keep the table at most half full
+    while (size < capacity * 2)size <<= 1;
+    reg = gfc_allocate_array(sizeof(Registry),1);
+    if (!reg)return NULL;
+    reg->entries = gfc_allocate_array(sizeof(RegistryEntry),size);
+    if (!reg->entries)
+    {
+        slog("failed to allocate registry for %i entries",capacity);
+        free(reg);
+        return NULL;
+    }
+    reg->capacity = size;
+    return reg;
+}
+
+void gf3d_registry_table_free(Registry *reg)
+{
+    if (!reg)return;
+    if (reg->entries)free(reg->entries);
+    free(reg);
+}
+
+Registry *gf3d_registry_new(Uint32 capacity)
+{
+    Registry *reg;
+    reg = gf3d_registry_table_new(capacity);
+    if (reg)gf3d_registry_live++;
+    return reg;
+}
+
+void gf3d_registry_free(Registry *reg)
+{
+    if (!reg)return;
+    gf3d_registry_table_free(reg);
+    if (gf3d_registry_live)gf3d_registry_live--;
+    if ((gf3d_registry_closing)&&(!gf3d_registry_live))gf3d_registry_strings_free();
+}
+
+void gf3d_registry_clear(Registry *reg)
+{
+    if (!reg)return;
+    memset(reg->entries,0,sizeof(RegistryEntry) * reg->capacity);
+    reg->count = 0;
+    reg->used = 0;
+}
+
+/**
+ * @brief find the slot holding a live key
+ * @return the index of the slot, or capacity if not found
+ */
+Uint32 gf3d_registry_find(Registry *reg,const char *key,Uint32 hash)
+{
+    Uint32 i,index,mask = reg->capacity - 1;
+    RegistryEntry *entry;
+    for (i = 0,index = hash & mask; i < reg->capacity; i++,index = (index + 1) & mask)
+    {
+        entry = &reg->entries[index];
+        if (!entry->key)break;//end of the probe chain
+        if (!entry->data)continue;//removed
+        if ((entry->hash == hash)&&(gf3d_registry_key_equal(entry->key,key)))return index;
+    }
+    return reg->capacity;
+}
+
+/**
+ * @brief place an interned key that is known not to be in the registry
+ */
+void gf3d_registry_place(Registry *reg,const char *key,Uint32 hash,void *data)
+{
+    Uint32 index,mask = reg->capacity - 1;
+    RegistryEntry *entry;
+    for (index = hash & mask;; index = (index + 1) & mask)
+    {
+        entry = &reg->entries[index];
+        if ((entry->key)&&(entry->data))continue;
+        if (!entry->key)reg->used++;
+        entry->key = key;
+        entry->hash = hash;
+        entry->data = data;
+        reg->count++;
+        return;
+    }
+}
+
+int gf3d_registry_rehash(Registry *reg)
+{
+    Uint32 i,size = REGISTRY_MIN_CAPACITY;
+    RegistryEntry *old;
+    Uint32 oldCapacity;
+    while (size < (reg->count + 1) * 2)size <<= 1;
+    old = reg->entries;
+    oldCapacity = reg->capacity;
+    reg->entries = gfc_allocate_array(sizeof(RegistryEntry),size);
+    if (!reg->entries)
+    {
+        slog("failed to grow registry to %i entries",size);
+        reg->entries = old;
+        return 0;
+    }
+    reg->capacity = size;
+    reg->count = 0;
+    reg->used = 0;
+    for (i = 0; i < oldCapacity; i++)
+    {
+        if ((!old[i].key)||(!old[i].data))continue;
+        gf3d_registry_place(reg,old[i].key,old[i].hash,old[i].data);
+    }
+    free(old);
+    return 1;
+}
+
+int gf3d_registry_insert_interned(Registry *reg,const char *key,Uint32 hash,void *data)
+{
+    Uint32 index;
+    index = gf3d_registry_find(reg,key,hash);
+    if (index < reg->capacity)
+    {
+        reg->entries[index].data = data;
+        return 1;
+    }
+    //removed slots count against the load so probe chains stay short
+    if ((reg->used + 1) * 4 > reg->capacity * 3)
+    {
+        if (!gf3d_registry_rehash(reg))return 0;
+    }
+    gf3d_registry_place(reg,key,hash,data);
+    return 1;
+}
+
+const char *gf3d_registry_intern(const char *str)
+{
+    Uint32 hash,index;
+    size_t length;
+    char *copy;
+    if (!str)return NULL;
+    if (!gf3d_registry_strings)
+    {
+        gf3d_registry_strings = gf3d_registry_table_new(1024);
+        if (!gf3d_registry_strings)return NULL;
+        atexit(gf3d_registry_strings_close);
+    }
+    hash = gf3d_registry_hash(str);
+    index = gf3d_registry_find(gf3d_registry_strings,str,hash);
+    if (index < gf3d_registry_strings->capacity)return gf3d_registry_strings->entries[index].key;
+    length = strnlen(str,GFCLINELEN);
+    copy = malloc(length + 1);
+    if (!copy)return NULL;
+    memcpy(copy,str,length);
+    copy[length] = '\0';
+    if (!gf3d_registry_insert_interned(gf3d_registry_strings,copy,hash,copy))
+    {
+        free(copy);
+        return NULL;
+    }
+    return copy;
+}
+
+int gf3d_registry_insert(Registry *reg,const char *key,void *data)
+{
+    const char *interned;
+    if ((!reg)||(!key)||(!data))return 0;
+    if (!key[0])return 0;
+    interned = gf3d_registry_intern(key);
+    if (!interned)return 0;
+    return gf3d_registry_insert_interned(reg,interned,gf3d_registry_hash(interned),data);
+}
+
+void *gf3d_registry_get(Registry *reg,const char *key)
+{
+    Uint32 index;
+    if ((!reg)||(!key))return NULL;
+    index = gf3d_registry_find(reg,key,gf3d_registry_hash(key));
+    if (index >= reg->capacity)return NULL;
+    return reg->entries[index].data;
+}
+
+int gf3d_registry_remove(Registry *reg,const char *key,void *data)
+{
+    Uint32 index;
+    if ((!reg)||(!key))return 0;
+    index = gf3d_registry_find(reg,key,gf3d_registry_hash(key));
+    if (index >= reg->capacity)return 0;
+    if ((data)&&(reg->entries[index].data != data))return 0;
+    //leave the key so the probe chain is not broken
+    reg->entries[index].data = NULL;
+    reg->count--;
+    return 1;
+}
+
+/*eol@eof*/
@@ -0,0 +1,229 @@
+#include <string.h>
+
+#include "simple_logger.h"
+#include "simple_json.h"
+
+#include "gfc_pak.h"
+
+#include "gf3d_vgraphics.h"
+#include "gf3d_tracker.h"
+#include "gf3d_sampler.h"
+
+#define SAMPLER_CACHE_MAX 32
+
+typedef struct
+{
+    SamplerSettings settings;
+    VkSampler       sampler;
+}SamplerEntry;
+
+typedef struct
+{
+    VkDevice        device;
+    SamplerEntry    cache[SAMPLER_CACHE_MAX];
+    Uint32          count;
+    SamplerSettings presets[SP_MAX];
+    float           maxAnisotropy;      /**<device limit, 0 if the device does not support anisotropic filtering*/
+}SamplerManager;
+
+extern int __DEBUG;
+static SamplerManager gf3d_sampler = {0};
+
+static const char *gf3d_sampler_preset_names[SP_MAX] = {"texture","sprite","pixel"};
+
+void gf3d_sampler_close()
+{
+    Uint32 i;
+    for (i = 0; i < gf3d_sampler.count; i++)
+    {
+        if (gf3d_sampler.cache[i].sampler != VK_NULL_HANDLE)
+        {
+            gf3d_tracker_destroy(TC_Sampler,gf3d_sampler.cache[i].sampler);
+            vkDestroySampler(gf3d_sampler.device, gf3d_sampler.cache[i].sampler, NULL);
+        }
+    }
+    if (__DEBUG)slog("freed %i samplers",gf3d_sampler.count);
+    memset(&gf3d_sampler,0,sizeof(SamplerManager));
+}
+
+VkFilter gf3d_sampler_filter_from_str(const char *str)
+{
+    if (!str)return VK_FILTER_LINEAR;
+    if (strcmp(str,"VK_FILTER_NEAREST")==0)return VK_FILTER_NEAREST;
+    return VK_FILTER_LINEAR;
+}
+
+VkSamplerMipmapMode gf3d_sampler_mipmap_mode_from_str(const char *str)
+{
+    if (!str)return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    if (strcmp(str,"VK_SAMPLER_MIPMAP_MODE_NEAREST")==0)return VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+}
+
+VkSamplerAddressMode gf3d_sampler_address_mode_from_str(const char *str)
+{
+    if (!str)return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    if (strcmp(str,"VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT")==0)return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+    if (strcmp(str,"VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE")==0)return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (strcmp(str,"VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER")==0)return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+}
+
+void gf3d_sampler_parse_settings(SJson *json,SamplerSettings *settings)
+{
+    const char *str;
+    short int b;
+    if ((!json)||(!settings))return;
+    str = sj_object_get_value_as_string(json,"filter");
+    if (str)settings->filter = gf3d_sampler_filter_from_str(str);
+    str = sj_object_get_value_as_string(json,"mipmapMode");
+    if (str)settings->mipmapMode = gf3d_sampler_mipmap_mode_from_str(str);
+    str = sj_object_get_value_as_string(json,"addressMode");
+    if (str)settings->addressMode = gf3d_sampler_address_mode_from_str(str);
+    sj_get_float_value(sj_object_get_value(json,"maxAnisotropy"),&settings->maxAnisotropy);
+    if (sj_get_bool_value(sj_object_get_value(json,"mipmaps"),&b))settings->useMips = b;
+}
+
+void gf3d_sampler_config(const char *config)
+{
+    SJson *json,*samplers;
+    int i;
+    if (!config)return;
+    json = gfc_pak_load_json(config);
+    if (!json)return;
+    samplers = sj_object_get_value(json,"samplers");
+    if (samplers)
+    {
+        for (i = 0; i < SP_MAX; i++)
+        {
+            gf3d_sampler_parse_settings(sj_object_get_value(samplers,gf3d_sampler_preset_names[i]),&gf3d_sampler.presets[i]);
+        }
+    }
+    sj_free(json);
+}
+
+void gf3d_sampler_init(const char *config)
+{
+    VkPhysicalDeviceFeatures features;
+    VkPhysicalDeviceProperties properties;
+    VkPhysicalDevice gpu;
+
+    gf3d_sampler.device = gf3d_vgraphics_get_default_logical_device();
+    gpu = gf3d_vgraphics_get_default_physical_device();
+    vkGetPhysicalDeviceFeatures(gpu, &features);
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+    gf3d_sampler.maxAnisotropy = features.samplerAnisotropy?properties.limits.maxSamplerAnisotropy:0;
+
+    gf3d_sampler.presets[SP_Texture].filter = VK_FILTER_LINEAR;
+    gf3d_sampler.presets[SP_Texture].mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    gf3d_sampler.presets[SP_Texture].addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    gf3d_sampler.presets[SP_Texture].maxAnisotropy = 16;
+    gf3d_sampler.presets[SP_Texture].useMips = 1;
+
+    gf3d_sampler.presets[SP_Sprite].filter = VK_FILTER_LINEAR;
+    gf3d_sampler.presets[SP_Sprite].mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    gf3d_sampler.presets[SP_Sprite].addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    gf3d_sampler.presets[SP_Pixel].filter = VK_FILTER_NEAREST;
+    gf3d_sampler.presets[SP_Pixel].mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    gf3d_sampler.presets[SP_Pixel].addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+    gf3d_sampler_config(config);
+    atexit(gf3d_sampler_close);
+    if (__DEBUG)slog("sampler cache initialized, max anisotropy %f",gf3d_sampler.maxAnisotropy);
+}
+
+int gf3d_sampler_settings_equal(const SamplerSettings *a,const SamplerSettings *b)
+{
+    return (a->filter == b->filter)&&
+        (a->mipmapMode == b->mipmapMode)&&
+        (a->addressMode == b->addressMode)&&
+        (a->maxAnisotropy == b->maxAnisotropy)&&
+        ((a->useMips?1:0) == (b->useMips?1:0));
+}
+
+VkSampler gf3d_sampler_create(const SamplerSettings *settings)
+{
+    VkSamplerCreateInfo samplerInfo = {0};
+    VkSampler sampler = VK_NULL_HANDLE;
+    float anisotropy;
+
+    anisotropy = MIN(settings->maxAnisotropy,gf3d_sampler.maxAnisotropy);
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = settings->filter;
+    samplerInfo.minFilter = settings->filter;
+    samplerInfo.addressModeU = settings->addressMode;
+    samplerInfo.addressModeV = settings->addressMode;
+    samplerInfo.addressModeW = settings->addressMode;
+    samplerInfo.anisotropyEnable = (anisotropy > 1)?VK_TRUE:VK_FALSE;
+    samplerInfo.maxAnisotropy = (anisotropy > 1)?anisotropy:1;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = settings->mipmapMode;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    //the image view limits the levels, so one sampler serves every mip count
+    samplerInfo.maxLod = settings->useMips?VK_LOD_CLAMP_NONE:0.0f;
+
+    if (vkCreateSampler(gf3d_sampler.device, &samplerInfo, NULL, &sampler) != VK_SUCCESS)
+    {
+        slog("failed to create texture sampler!");
+        return VK_NULL_HANDLE;
+    }
+    gf3d_tracker_create(TC_Sampler,sampler,0,"sampler");
+    return sampler;
+}
+
+VkSampler gf3d_sampler_get(const SamplerSettings *settings)
+{
+    Uint32 i;
+    VkSampler sampler;
+    if (!settings)return VK_NULL_HANDLE;
+    for (i = 0; i < gf3d_sampler.count; i++)
+    {
+        if (gf3d_sampler_settings_equal(&gf3d_sampler.cache[i].settings,settings))return gf3d_sampler.cache[i].sampler;
+    }
+    if (gf3d_sampler.count >= SAMPLER_CACHE_MAX)
+    {
+        slog("sampler cache is full, cannot make more than %i samplers",SAMPLER_CACHE_MAX);
+        return VK_NULL_HANDLE;
+    }
+    sampler = gf3d_sampler_create(settings);
+    if (sampler == VK_NULL_HANDLE)return VK_NULL_HANDLE;
+    memcpy(&gf3d_sampler.cache[gf3d_sampler.count].settings,settings,sizeof(SamplerSettings));
+    gf3d_sampler.cache[gf3d_sampler.count].sampler = sampler;
+    gf3d_sampler.count++;
+    if (__DEBUG)slog("created sampler %i",gf3d_sampler.count);
+    return sampler;
+}
+
+VkSampler gf3d_sampler_get_preset(SamplerPreset preset)
+{
+    if ((preset < 0)||(preset >= SP_MAX))
+    {
+        slog("no such sampler preset %i",preset);
+        return VK_NULL_HANDLE;
+    }
+    return gf3d_sampler_get(&gf3d_sampler.presets[preset]);
+}
+
+void gf3d_sampler_set_preset(SamplerPreset preset,const SamplerSettings *settings)
+{
+    if ((!settings)||(preset < 0)||(preset >= SP_MAX))return;
+    memcpy(&gf3d_sampler.presets[preset],settings,sizeof(SamplerSettings));
+}
+
+const SamplerSettings *gf3d_sampler_get_preset_settings(SamplerPreset preset)
+{
+    if ((preset < 0)||(preset >= SP_MAX))return NULL;
+    return &gf3d_sampler.presets[preset];
+}
+
+Uint32 gf3d_sampler_get_count()
+{
+    return gf3d_sampler.count;
+}
+
+/*eol@eof*/
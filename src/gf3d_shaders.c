@@ -5,6 +5,7 @@
 
 #include "gfc_pak.h"
 
+#include "gf3d_tracker.h"
 #include "gf3d_shaders.h"
 
 
@@ -20,7 +21,9 @@ VkShaderModule gf3d_shaders_create_module(const char *shader,size_t size,VkDevic
     if (vkCreateShaderModule(device, &createInfo, NULL, &module) != VK_SUCCESS)
     {
         slog("failed to create shader module");
+        return VK_NULL_HANDLE;
     }
+    gf3d_tracker_create(TC_ShaderModule,module,0,"shader");
     return module;
 }
 
@@ -0,0 +1,331 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_buffers.h"
+#include "gf3d_swapchain.h"
+#include "gf3d_vgraphics.h"
+#include "gf3d_vertex_batch.h"
+#include "gf3d_skin.h"
+
+#define SKIN_ATTRIBUTE_COUNT 5
+
+extern int __DEBUG;
+
+typedef struct
+{
+    Pipeline       *pipe;               /**<the pipeline for skinned meshes*/
+    VkDevice        device;
+    Uint32          chainLength;
+    Uint32          maxJoints;          /**<how many joint matrices fit in a palette buffer*/
+    Uint32          jointCursor;        /**<how many have been used this frame*/
+    Uint32          meshCount;          /**<skinned meshes alive*/
+    VkBuffer       *paletteBuffer;      /**<one storage buffer per swap frame*/
+    VkDeviceMemory *paletteMemory;
+    GFC_Matrix4   **paletteData;        /**<persistently mapped palette memory*/
+    VkVertexInputAttributeDescription   attributeDescriptions[SKIN_ATTRIBUTE_COUNT];
+    VkVertexInputBindingDescription     bindingDescription;
+}SkinManager;
+
+static SkinManager gf3d_skin = {0};
+
+VkVertexInputBindingDescription *gf3d_skin_get_bind_description();
+VkVertexInputAttributeDescription *gf3d_skin_get_attribute_descriptions(Uint32 *count);
+
+void gf3d_skin_close()
+{
+    int i;
+    for (i = 0; (gf3d_skin.paletteBuffer)&&(gf3d_skin.paletteMemory)&&(gf3d_skin.paletteData)&&(i < gf3d_skin.chainLength); i++)
+    {
+        if (gf3d_skin.paletteData[i])vkUnmapMemory(gf3d_skin.device,gf3d_skin.paletteMemory[i]);
+        gf3d_buffer_free(gf3d_skin.paletteBuffer[i],gf3d_skin.paletteMemory[i]);
+    }
+    if (gf3d_skin.paletteBuffer)free(gf3d_skin.paletteBuffer);
+    if (gf3d_skin.paletteMemory)free(gf3d_skin.paletteMemory);
+    if (gf3d_skin.paletteData)free(gf3d_skin.paletteData);
+    memset(&gf3d_skin,0,sizeof(SkinManager));
+    if (__DEBUG)slog("skin system closed");
+}
+
+void gf3d_skin_init(Uint32 maxDraws,Uint32 maxJoints,const char *pipeConfig)
+{
+    int i;
+    Uint32 count;
+    VkDeviceSize bufferSize;
+    if ((!maxDraws)||(!maxJoints))
+    {
+        slog("cannot initialize skin system for zero draws or joints");
+        return;
+    }
+    gf3d_skin.device = gf3d_vgraphics_get_default_logical_device();
+    gf3d_skin.chainLength = gf3d_swapchain_get_swap_image_count();
+    gf3d_skin.maxJoints = maxJoints;
+    gf3d_skin.paletteBuffer = gfc_allocate_array(sizeof(VkBuffer),gf3d_skin.chainLength);
+    gf3d_skin.paletteMemory = gfc_allocate_array(sizeof(VkDeviceMemory),gf3d_skin.chainLength);
+    gf3d_skin.paletteData = gfc_allocate_array(sizeof(GFC_Matrix4 *),gf3d_skin.chainLength);
+    if ((!gf3d_skin.paletteBuffer)||(!gf3d_skin.paletteMemory)||(!gf3d_skin.paletteData))
+    {
+        slog("failed to allocate skin palette lists");
+        gf3d_skin_close();
+        return;
+    }
+    atexit(gf3d_skin_close);
+    bufferSize = sizeof(GFC_Matrix4) * maxJoints;
+    for (i = 0; i < gf3d_skin.chainLength; i++)
+    {
+        if (!gf3d_buffer_create(
+            bufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &gf3d_skin.paletteBuffer[i],
+            &gf3d_skin.paletteMemory[i]))
+        {
+            slog("failed to create skin palette buffer for frame %i",i);
+            return;
+        }
+        //palettes are rewritten every frame, so keep them mapped
+        vkMapMemory(gf3d_skin.device,gf3d_skin.paletteMemory[i],0,bufferSize,0,(void **)&gf3d_skin.paletteData[i]);
+    }
+    gf3d_skin_get_attribute_descriptions(&count);
+    gf3d_skin.pipe = gf3d_pipeline_create_from_config(
+        gf3d_skin.device,
+        pipeConfig?pipeConfig:"config/skinned_pipeline.cfg",
+        gf3d_vgraphics_get_view_extent(),
+        maxDraws,
+        gf3d_skin_get_bind_description(),
+        gf3d_skin_get_attribute_descriptions(NULL),
+        count,
+        0,
+        VK_INDEX_TYPE_UINT16);
+    if (!gf3d_skin.pipe)
+    {
+        slog("failed to create the skinned mesh pipeline");
+        return;
+    }
+    if (__DEBUG)slog("skin system initialized with %i joints per frame",maxJoints);
+}
+
+void gf3d_skin_reset_frame()
+{
+    gf3d_skin.jointCursor = 0;
+}
+
+Pipeline *gf3d_skin_get_pipeline()
+{
+    return gf3d_skin.pipe;
+}
+
+int gf3d_skin_upload_palette(GFC_Matrix4 *palette,Uint32 jointCount,Uint32 *jointBase)
+{
+    Uint32 frame;
+    if ((!palette)||(!jointCount)||(!gf3d_skin.paletteData))return 0;
+    if (gf3d_skin.jointCursor + jointCount > gf3d_skin.maxJoints)
+    {
+        if (__DEBUG)slog("skin palette buffer full this frame, cannot fit %i more joints",jointCount);
+        return 0;
+    }
+    frame = gf3d_vgraphics_get_current_buffer_frame();
+    if ((frame >= gf3d_skin.chainLength)||(!gf3d_skin.paletteData[frame]))return 0;
+    memcpy(&gf3d_skin.paletteData[frame][gf3d_skin.jointCursor],palette,sizeof(GFC_Matrix4)*jointCount);
+    if (jointBase)*jointBase = gf3d_skin.jointCursor;
+    gf3d_skin.jointCursor += jointCount;
+    return 1;
+}
+
+void gf3d_skin_draw_palette(SkinnedMesh *mesh,GFC_Matrix4 modelMat,GFC_Color color,Uint32 jointBase,Texture *texture)
+{
+    Uint32 frame;
+    SkinPushConstants push = {0};
+    PipelineDrawCall *drawCall;
+    if ((!mesh)||(!gf3d_skin.pipe))return;
+    frame = gf3d_vgraphics_get_current_buffer_frame();
+    if (frame >= gf3d_skin.chainLength)return;
+    gfc_matrix4_copy(push.model,modelMat);
+    push.color = gfc_color_to_vector4f(color);
+    push.jointBase = jointBase;
+    push.jointCount = mesh->jointCount;
+    drawCall = gf3d_pipeline_queue_render_push(
+        gf3d_skin.pipe,
+        mesh->vertexBuffer,
+        mesh->faceCount * 3,
+        mesh->faceBuffer,
+        NULL,
+        &push,
+        texture);
+    if (!drawCall)return;
+    drawCall->storageBuffer = gf3d_skin.paletteBuffer[frame];
+    drawCall->storageRange = VK_WHOLE_SIZE;
+}
+
+void gf3d_skin_draw(SkinnedMesh *mesh,GFC_Matrix4 modelMat,GFC_Color color,GFC_Matrix4 *palette,Uint32 jointCount,Texture *texture)
+{
+    Uint32 jointBase = 0;
+    if (!mesh)return;
+    if (!gf3d_skin_upload_palette(palette,jointCount,&jointBase))return;
+    gf3d_skin_draw_palette(mesh,modelMat,color,jointBase,texture);
+}
+
+/**
+ * @brief copy data into a new device local buffer through a staging buffer
+ */
+int gf3d_skin_upload_buffer(void *source,VkDeviceSize size,VkBufferUsageFlags usage,VkBuffer *buffer,VkDeviceMemory *bufferMemory)
+{
+    void *data = NULL;
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    if (!gf3d_buffer_create(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory))
+    {
+        return 0;
+    }
+    vkMapMemory(gf3d_skin.device, stagingBufferMemory, 0, size, 0, &data);
+    memcpy(data, source, (size_t) size);
+    vkUnmapMemory(gf3d_skin.device, stagingBufferMemory);
+
+    if (!gf3d_buffer_create(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory))
+    {
+        gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+        return 0;
+    }
+    gf3d_buffer_copy(stagingBuffer, *buffer, size);
+
+    gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+    return 1;
+}
+
+SkinnedMesh *gf3d_skin_mesh_from_obj(ObjData *obj)
+{
+    int i,j;
+    float sum;
+    Bool hasBones;
+    GFC_Vector3D min,max;
+    SkinnedVertex *vertices;
+    SkinnedMesh *mesh;
+    if (!obj)return NULL;
+    if ((!obj->faceVertices)||(!obj->outFace)||(!obj->face_count))
+    {
+        slog("skinned mesh needs obj data in buffer order");
+        return NULL;
+    }
+    if (!gf3d_skin.device)
+    {
+        slog("skin system not initialized");
+        return NULL;
+    }
+    vertices = gfc_allocate_array(sizeof(SkinnedVertex),obj->face_vert_count);
+    if (!vertices)return NULL;
+    mesh = gfc_allocate_array(sizeof(SkinnedMesh),1);
+    if (!mesh)
+    {
+        free(vertices);
+        return NULL;
+    }
+    gf3d_skin.meshCount++;
+    //gltf bone data is indexed the same as the vertices
+    hasBones = ((obj->boneIndices)&&(obj->boneWeights)&&
+        (obj->bone_count >= obj->face_vert_count)&&(obj->weight_count >= obj->face_vert_count));
+    if ((!hasBones)&&(__DEBUG))slog("skinned mesh built from obj without bone data, binding to joint 0");
+    for (i = 0; i < obj->face_vert_count; i++)
+    {
+        vertices[i].vertex = obj->faceVertices[i].vertex;
+        vertices[i].normal = obj->faceVertices[i].normal;
+        vertices[i].texel = obj->faceVertices[i].texel;
+        if (!hasBones)
+        {
+            vertices[i].weights.x = 1;
+            continue;
+        }
+        vertices[i].joints[0] = obj->boneIndices[i].x;
+        vertices[i].joints[1] = obj->boneIndices[i].y;
+        vertices[i].joints[2] = obj->boneIndices[i].z;
+        vertices[i].joints[3] = obj->boneIndices[i].w;
+        vertices[i].weights = obj->boneWeights[i];
+        sum = vertices[i].weights.x + vertices[i].weights.y + vertices[i].weights.z + vertices[i].weights.w;
+        if (sum > 0.0001)
+        {
+            vertices[i].weights.x /= sum;
+            vertices[i].weights.y /= sum;
+            vertices[i].weights.z /= sum;
+            vertices[i].weights.w /= sum;
+        }
+        else
+        {
+            vertices[i].weights.x = 1;
+        }
+        for (j = 0; j < 4; j++)
+        {
+            if (vertices[i].joints[j] >= mesh->jointCount)mesh->jointCount = vertices[i].joints[j] + 1;
+        }
+    }
+    if (!mesh->jointCount)mesh->jointCount = 1;
+    gf3d_vertex_batch_bounds(obj->faceVertices,obj->face_vert_count,&min,&max);
+    mesh->bounds = gfc_box(min.x,min.y,min.z,max.x - min.x,max.y - min.y,max.z - min.z);
+    mesh->vertexCount = obj->face_vert_count;
+    mesh->faceCount = obj->face_count;
+    if ((!gf3d_skin_upload_buffer(vertices,sizeof(SkinnedVertex) * mesh->vertexCount,VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,&mesh->vertexBuffer,&mesh->vertexBufferMemory))||
+        (!gf3d_skin_upload_buffer(obj->outFace,sizeof(Face) * mesh->faceCount,VK_BUFFER_USAGE_INDEX_BUFFER_BIT,&mesh->faceBuffer,&mesh->faceBufferMemory)))
+    {
+        slog("failed to create skinned mesh buffers");
+        free(vertices);
+        gf3d_skin_mesh_free(mesh);
+        return NULL;
+    }
+    free(vertices);
+    if (__DEBUG)slog("created skinned mesh with %i vertices and %i joints",mesh->vertexCount,mesh->jointCount);
+    return mesh;
+}
+
+void gf3d_skin_mesh_free(SkinnedMesh *mesh)
+{
+    if (!mesh)return;
+    gf3d_buffer_free(mesh->vertexBuffer,mesh->vertexBufferMemory);
+    gf3d_buffer_free(mesh->faceBuffer,mesh->faceBufferMemory);
+    free(mesh);
+    if (gf3d_skin.meshCount)gf3d_skin.meshCount--;
+}
+
+Uint32 gf3d_skin_get_mesh_count()
+{
+    return gf3d_skin.meshCount;
+}
+
+VkVertexInputBindingDescription *gf3d_skin_get_bind_description()
+{
+    gf3d_skin.bindingDescription.binding = 0;
+    gf3d_skin.bindingDescription.stride = sizeof(SkinnedVertex);
+    gf3d_skin.bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return &gf3d_skin.bindingDescription;
+}
+
+VkVertexInputAttributeDescription *gf3d_skin_get_attribute_descriptions(Uint32 *count)
+{
+    gf3d_skin.attributeDescriptions[0].binding = 0;
+    gf3d_skin.attributeDescriptions[0].location = 0;
+    gf3d_skin.attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    gf3d_skin.attributeDescriptions[0].offset = offsetof(SkinnedVertex, vertex);
+
+    gf3d_skin.attributeDescriptions[1].binding = 0;
+    gf3d_skin.attributeDescriptions[1].location = 1;
+    gf3d_skin.attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    gf3d_skin.attributeDescriptions[1].offset = offsetof(SkinnedVertex, normal);
+
+    gf3d_skin.attributeDescriptions[2].binding = 0;
+    gf3d_skin.attributeDescriptions[2].location = 2;
+    gf3d_skin.attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+    gf3d_skin.attributeDescriptions[2].offset = offsetof(SkinnedVertex, texel);
+
+    gf3d_skin.attributeDescriptions[3].binding = 0;
+    gf3d_skin.attributeDescriptions[3].location = 3;
+    gf3d_skin.attributeDescriptions[3].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    gf3d_skin.attributeDescriptions[3].offset = offsetof(SkinnedVertex, weights);
+
+    gf3d_skin.attributeDescriptions[4].binding = 0;
+    gf3d_skin.attributeDescriptions[4].location = 4;
+    gf3d_skin.attributeDescriptions[4].format = VK_FORMAT_R8G8B8A8_UINT;
+    gf3d_skin.attributeDescriptions[4].offset = offsetof(SkinnedVertex, joints);
+    if (count)*count = SKIN_ATTRIBUTE_COUNT;
+    return gf3d_skin.attributeDescriptions;
+}
+
+/*eol@eof*/
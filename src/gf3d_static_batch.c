@@ -0,0 +1,272 @@
+#include "simple_logger.h"
+
+#include "gf3d_vertex_batch.h"
+#include "gf3d_static_batch.h"
+
+#define STATIC_BATCH_MAX_VERTICES 65536     /**<Face indices are Uint16*/
+
+extern int __DEBUG;
+
+typedef struct
+{
+    ObjData    *obj;
+    GFC_Matrix4 transform;
+    Texture    *texture;
+    Uint32      order;
+    StaticBatchGroup *group;    /**<set during build*/
+}StaticBatchEntry;
+
+StaticBatch *gf3d_static_batch_new()
+{
+    StaticBatch *batch;
+    batch = gfc_allocate_array(sizeof(StaticBatch),1);
+    if (!batch)return NULL;
+    batch->entries = gfc_list_new();
+    batch->groups = gfc_list_new();
+    return batch;
+}
+
+void gf3d_static_batch_group_free(StaticBatchGroup *group)
+{
+    if (!group)return;
+    gf3d_obj_free(group->obj);
+    if (group->ranges)free(group->ranges);
+    free(group);
+}
+
+void gf3d_static_batch_clear_entries(StaticBatch *batch)
+{
+    int i,c;
+    c = gfc_list_get_count(batch->entries);
+    for (i = 0; i < c; i++)
+    {
+        free(gfc_list_get_nth(batch->entries,i));
+    }
+    gfc_list_delete(batch->entries);
+    batch->entries = gfc_list_new();
+}
+
+void gf3d_static_batch_free(StaticBatch *batch)
+{
+    int i,c;
+    if (!batch)return;
+    gf3d_static_batch_clear_entries(batch);
+    gfc_list_delete(batch->entries);
+    c = gfc_list_get_count(batch->groups);
+    for (i = 0; i < c; i++)
+    {
+        gf3d_static_batch_group_free(gfc_list_get_nth(batch->groups,i));
+    }
+    gfc_list_delete(batch->groups);
+    free(batch);
+}
+
+void gf3d_static_batch_add(StaticBatch *batch,ObjData *obj,GFC_Matrix4 transform,Texture *texture)
+{
+    StaticBatchEntry *entry;
+    if ((!batch)||(!obj))return;
+    if ((!obj->faceVertices)||(!obj->outFace))
+    {
+        slog("static batch: obj must be reorganized before it can be batched");
+        return;
+    }
+    if (obj->face_vert_count > STATIC_BATCH_MAX_VERTICES)
+    {
+        slog("static batch: obj has too many vertices (%i) to batch",obj->face_vert_count);
+        return;
+    }
+    entry = gfc_allocate_array(sizeof(StaticBatchEntry),1);
+    if (!entry)return;
+    entry->obj = obj;
+    memcpy(entry->transform,transform,sizeof(GFC_Matrix4));
+    entry->texture = texture;
+    entry->order = gfc_list_get_count(batch->entries);
+    gfc_list_append(batch->entries,entry);
+}
+
+/**
+ * @brief find the open group for a texture that still has room, or start a new one
+ */
+StaticBatchGroup *gf3d_static_batch_get_open_group(GFC_List *groups,int firstGroup,Texture *texture,Uint32 *groupVerts,Uint32 vertexCount)
+{
+    int i,c;
+    StaticBatchGroup *group;
+    c = gfc_list_get_count(groups);
+    for (i = c - 1; i >= firstGroup; i--)
+    {
+        group = gfc_list_get_nth(groups,i);
+        if (group->texture != texture)continue;
+        //only the newest group for a texture is open
+        if (groupVerts[i] + vertexCount <= STATIC_BATCH_MAX_VERTICES)
+        {
+            groupVerts[i] += vertexCount;
+            return group;
+        }
+        break;
+    }
+    group = gfc_allocate_array(sizeof(StaticBatchGroup),1);
+    if (!group)return NULL;
+    group->texture = texture;
+    group->obj = gf3d_obj_new();
+    if (!group->obj)
+    {
+        free(group);
+        return NULL;
+    }
+    groupVerts[c] = vertexCount;
+    gfc_list_append(groups,group);
+    return group;
+}
+
+/**
+ * @brief undo a failed build, freeing the groups it added.  The queued pieces are cleared as well
+ */
+void gf3d_static_batch_build_abort(StaticBatch *batch,int firstGroup)
+{
+    int g;
+    StaticBatchGroup *group;
+    for (g = gfc_list_get_count(batch->groups) - 1; g >= firstGroup; g--)
+    {
+        group = gfc_list_get_nth(batch->groups,g);
+        gfc_list_delete_data(batch->groups,group);
+        gf3d_static_batch_group_free(group);
+    }
+    gf3d_static_batch_clear_entries(batch);
+}
+
+Uint32 gf3d_static_batch_build(StaticBatch *batch)
+{
+    int i,c,g,groupCount,firstGroup;
+    Uint32 f,*groupVerts;
+    StaticBatchEntry *entry;
+    StaticBatchGroup *group;
+    StaticBatchRange *range;
+    GFC_Vector3D min,max,groupMin,groupMax;
+    Face *face;
+
+    if (!batch)return 0;
+    c = gfc_list_get_count(batch->entries);
+    if (!c)return 0;
+    firstGroup = gfc_list_get_count(batch->groups);
+    if ((firstGroup)&&(__DEBUG))
+    {
+        slog("static batch: already built, pieces added since will form new groups");
+    }
+    groupVerts = gfc_allocate_array(sizeof(Uint32),firstGroup + c);
+    if (!groupVerts)return 0;
+    //first pass: assign every piece to a group and size the groups
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(batch->entries,i);
+        entry->group = gf3d_static_batch_get_open_group(batch->groups,firstGroup,entry->texture,groupVerts,entry->obj->face_vert_count);
+        if (!entry->group)
+        {
+            slog("static batch: failed to allocate a group");
+            free(groupVerts);
+            gf3d_static_batch_build_abort(batch,firstGroup);
+            return 0;
+        }
+        entry->group->obj->face_vert_count += entry->obj->face_vert_count;
+        entry->group->obj->face_count += entry->obj->face_count;
+        entry->group->rangeCount++;
+    }
+    free(groupVerts);
+    groupCount = gfc_list_get_count(batch->groups);
+    for (g = firstGroup; g < groupCount; g++)
+    {
+        group = gfc_list_get_nth(batch->groups,g);
+        group->obj->faceVertices = gfc_allocate_array(sizeof(Vertex),group->obj->face_vert_count);
+        group->obj->outFace = gfc_allocate_array(sizeof(Face),group->obj->face_count);
+        group->ranges = gfc_allocate_array(sizeof(StaticBatchRange),group->rangeCount);
+        if ((!group->obj->faceVertices)||(!group->obj->outFace)||(!group->ranges))
+        {
+            slog("static batch: failed to allocate a group of %i vertices",group->obj->face_vert_count);
+            gf3d_static_batch_build_abort(batch,firstGroup);
+            return 0;
+        }
+        //reused as cursors for the second pass
+        group->obj->face_vert_count = 0;
+        group->obj->face_count = 0;
+        group->rangeCount = 0;
+    }
+    //second pass: every piece is transformed straight into its final place
+    for (i = 0; i < c; i++)
+    {
+        entry = gfc_list_get_nth(batch->entries,i);
+        group = entry->group;
+        if ((!group)||(!group->ranges))continue;
+        range = &group->ranges[group->rangeCount++];
+        range->entry = entry->order;
+        range->firstVertex = group->obj->face_vert_count;
+        range->vertexCount = entry->obj->face_vert_count;
+        range->firstFace = group->obj->face_count;
+        range->faceCount = entry->obj->face_count;
+        gf3d_vertex_batch_transform(
+            &group->obj->faceVertices[range->firstVertex],
+            entry->obj->faceVertices,
+            range->vertexCount,
+            entry->transform);
+        for (f = 0; f < range->faceCount; f++)
+        {
+            face = &group->obj->outFace[range->firstFace + f];
+            face->verts[0] = entry->obj->outFace[f].verts[0] + range->firstVertex;
+            face->verts[1] = entry->obj->outFace[f].verts[1] + range->firstVertex;
+            face->verts[2] = entry->obj->outFace[f].verts[2] + range->firstVertex;
+        }
+        gf3d_vertex_batch_bounds(&group->obj->faceVertices[range->firstVertex],range->vertexCount,&min,&max);
+        range->bounds = gfc_box(min.x,min.y,min.z,max.x - min.x,max.y - min.y,max.z - min.z);
+        group->obj->face_vert_count += range->vertexCount;
+        group->obj->face_count += range->faceCount;
+    }
+    for (g = firstGroup; g < groupCount; g++)
+    {
+        group = gfc_list_get_nth(batch->groups,g);
+        if ((!group->obj)||(!group->ranges))continue;
+        gf3d_vertex_batch_bounds(group->obj->faceVertices,group->obj->face_vert_count,&groupMin,&groupMax);
+        group->bounds = gfc_box(groupMin.x,groupMin.y,groupMin.z,groupMax.x - groupMin.x,groupMax.y - groupMin.y,groupMax.z - groupMin.z);
+        group->obj->bounds = group->bounds;
+    }
+    if (__DEBUG)slog("static batch: merged %i pieces into %i groups",c,groupCount - firstGroup);
+    gf3d_static_batch_clear_entries(batch);
+    return groupCount - firstGroup;
+}
+
+Uint32 gf3d_static_batch_get_group_count(StaticBatch *batch)
+{
+    if (!batch)return 0;
+    return gfc_list_get_count(batch->groups);
+}
+
+StaticBatchGroup *gf3d_static_batch_get_group(StaticBatch *batch,Uint32 index)
+{
+    if (!batch)return NULL;
+    return gfc_list_get_nth(batch->groups,index);
+}
+
+Uint32 gf3d_static_batch_group_cull(
+    StaticBatchGroup *group,
+    Bool (*visible)(GFC_Box *bounds,void *data),
+    void *data,
+    StaticBatchDrawRange *out)
+{
+    Uint32 i,count = 0;
+    StaticBatchRange *range;
+    if ((!group)||(!out))return 0;
+    for (i = 0; i < group->rangeCount; i++)
+    {
+        range = &group->ranges[i];
+        if ((visible)&&(!visible(&range->bounds,data)))continue;
+        if ((count)&&(out[count - 1].firstIndex + out[count - 1].indexCount == range->firstFace * 3))
+        {
+            //follows right after the last visible piece, so draw them together
+            out[count - 1].indexCount += range->faceCount * 3;
+            continue;
+        }
+        out[count].firstIndex = range->firstFace * 3;
+        out[count].indexCount = range->faceCount * 3;
+        count++;
+    }
+    return count;
+}
+
+/*eol@eof*/
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_texture.h"
+#include "gf3d_skin.h"
+#include "gf2d_sprite.h"
+#include "gf3d_stats.h"
+
+typedef struct
+{
+    VkDeviceMemory  memory;     /**<VK_NULL_HANDLE for an empty slot*/
+    VkDeviceSize    size;
+    Uint32          heap;
+}StatsAllocation;
+
+typedef struct
+{
+    FrameStats                          current;        /**<the frame being counted*/
+    FrameStats                          last;           /**<the most recently finished frame*/
+    VkPhysicalDeviceMemoryProperties    memoryProperties;
+    StatsAllocation                    *allocations;    /**<open addressed by memory handle*/
+    Uint32                              allocationCapacity;
+    Uint32                              allocationCount;
+    Uint64                              lastCounter;
+    FILE                               *csv;
+    Bool                                csvHeader;      /**<set once the csv header has been written*/
+}StatsManager;
+
+extern int __DEBUG;
+static StatsManager gf3d_stats = {0};
+
+void gf3d_stats_close()
+{
+    gf3d_stats_csv_close();
+    if (gf3d_stats.allocations)free(gf3d_stats.allocations);
+    memset(&gf3d_stats,0,sizeof(StatsManager));
+    if (__DEBUG)slog("stats closed");
+}
+
+void gf3d_stats_init(VkPhysicalDevice physicalDevice)
+{
+    Uint32 i;
+    gf3d_stats.allocationCapacity = 256;
+    gf3d_stats.allocations = gfc_allocate_array(sizeof(StatsAllocation),gf3d_stats.allocationCapacity);
+    if (!gf3d_stats.allocations)
+    {
+        slog("failed to allocate stats memory table");
+        return;
+    }
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice,&gf3d_stats.memoryProperties);
+    gf3d_stats.current.heapCount = MIN(gf3d_stats.memoryProperties.memoryHeapCount,VK_MAX_MEMORY_HEAPS);
+    for (i = 0; i < gf3d_stats.current.heapCount; i++)
+    {
+        gf3d_stats.current.heapSize[i] = gf3d_stats.memoryProperties.memoryHeaps[i].size;
+    }
+    memcpy(&gf3d_stats.last,&gf3d_stats.current,sizeof(FrameStats));
+    gf3d_stats.lastCounter = SDL_GetPerformanceCounter();
+    atexit(gf3d_stats_close);
+    if (__DEBUG)slog("stats initialized for %i memory heaps",gf3d_stats.current.heapCount);
+}
+
+void gf3d_stats_add(StatCounter counter,Uint64 amount)
+{
+    if (counter >= SC_MAX)return;
+    gf3d_stats.current.counters[counter] += amount;
+}
+
+void gf3d_stats_add_pipeline_draws(const char *pipeline,Uint32 drawCalls)
+{
+    Uint32 i;
+    StatsPipeline *stats;
+    if (!pipeline)return;
+    gf3d_stats.current.counters[SC_DrawCalls] += drawCalls;
+    for (i = 0; i < gf3d_stats.current.pipelineCount; i++)
+    {
+        stats = &gf3d_stats.current.pipelines[i];
+        if (gfc_line_cmp(stats->name,pipeline) != 0)continue;
+        stats->drawCalls += drawCalls;
+        return;
+    }
+    if (gf3d_stats.current.pipelineCount >= STATS_MAX_PIPELINES)return;
+    stats = &gf3d_stats.current.pipelines[gf3d_stats.current.pipelineCount++];
+    gfc_line_cpy(stats->name,pipeline);
+    stats->drawCalls = drawCalls;
+}
+
+void gf3d_stats_add_stall(float ms)
+{
+    gf3d_stats.current.stallMs += ms;
+}
+
+Uint32 gf3d_stats_memory_hash(VkDeviceMemory memory)
+{
+    Uint64 key = 0;
+    //handles are pointers or 64 bit ints depending on the platform
+    memcpy(&key,&memory,MIN(sizeof(VkDeviceMemory),sizeof(Uint64)));
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (Uint32)key & (gf3d_stats.allocationCapacity - 1);
+}
+
+void gf3d_stats_memory_insert(StatsAllocation *allocation)
+{
+    Uint32 slot;
+    slot = gf3d_stats_memory_hash(allocation->memory);
+    while (gf3d_stats.allocations[slot].memory != VK_NULL_HANDLE)
+    {
+        slot = (slot + 1) & (gf3d_stats.allocationCapacity - 1);
+    }
+    memcpy(&gf3d_stats.allocations[slot],allocation,sizeof(StatsAllocation));
+}
+
+int gf3d_stats_memory_grow()
+{
+    Uint32 i,oldCapacity;
+    StatsAllocation *old;
+    old = gf3d_stats.allocations;
+    oldCapacity = gf3d_stats.allocationCapacity;
+    gf3d_stats.allocations = gfc_allocate_array(sizeof(StatsAllocation),oldCapacity * 2);
+    if (!gf3d_stats.allocations)
+    {
+        gf3d_stats.allocations = old;
+        return 0;
+    }
+    gf3d_stats.allocationCapacity = oldCapacity * 2;
+    for (i = 0; i < oldCapacity; i++)
+    {
+        if (old[i].memory == VK_NULL_HANDLE)continue;
+        gf3d_stats_memory_insert(&old[i]);
+    }
+    free(old);
+    return 1;
+}
+
+void gf3d_stats_memory_alloc(VkDeviceMemory memory,VkDeviceSize size,Uint32 memoryTypeIndex)
+{
+    StatsAllocation allocation;
+    if ((!gf3d_stats.allocations)||(memory == VK_NULL_HANDLE))return;
+    if (memoryTypeIndex >= gf3d_stats.memoryProperties.memoryTypeCount)return;
+    //kept at most half full so probe runs stay short
+    if (((gf3d_stats.allocationCount + 1) * 2 > gf3d_stats.allocationCapacity)&&(!gf3d_stats_memory_grow()))
+    {
+        slog("failed to grow stats memory table");
+        return;
+    }
+    allocation.memory = memory;
+    allocation.size = size;
+    allocation.heap = gf3d_stats.memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    gf3d_stats_memory_insert(&allocation);
+    gf3d_stats.allocationCount++;
+    if (allocation.heap < VK_MAX_MEMORY_HEAPS)gf3d_stats.current.heapUsed[allocation.heap] += size;
+}
+
+void gf3d_stats_memory_free(VkDeviceMemory memory)
+{
+    Uint32 slot,next,home;
+    StatsAllocation *allocation;
+    if ((!gf3d_stats.allocations)||(memory == VK_NULL_HANDLE))return;
+    slot = gf3d_stats_memory_hash(memory);
+    while (gf3d_stats.allocations[slot].memory != memory)
+    {
+        if (gf3d_stats.allocations[slot].memory == VK_NULL_HANDLE)return;//not tracked
+        slot = (slot + 1) & (gf3d_stats.allocationCapacity - 1);
+    }
+    allocation = &gf3d_stats.allocations[slot];
+    if ((allocation->heap < VK_MAX_MEMORY_HEAPS)&&(gf3d_stats.current.heapUsed[allocation->heap] >= allocation->size))
+    {
+        gf3d_stats.current.heapUsed[allocation->heap] -= allocation->size;
+    }
+    memset(allocation,0,sizeof(StatsAllocation));
+    gf3d_stats.allocationCount--;
+    //shift back any entries in the same probe run that can now sit closer to home
+    next = (slot + 1) & (gf3d_stats.allocationCapacity - 1);
+    while (gf3d_stats.allocations[next].memory != VK_NULL_HANDLE)
+    {
+        home = gf3d_stats_memory_hash(gf3d_stats.allocations[next].memory);
+        if (((next - home) & (gf3d_stats.allocationCapacity - 1)) >= ((next - slot) & (gf3d_stats.allocationCapacity - 1)))
+        {
+            memcpy(&gf3d_stats.allocations[slot],&gf3d_stats.allocations[next],sizeof(StatsAllocation));
+            memset(&gf3d_stats.allocations[next],0,sizeof(StatsAllocation));
+            slot = next;
+        }
+        next = (next + 1) & (gf3d_stats.allocationCapacity - 1);
+    }
+}
+
+void gf3d_stats_csv_write_header()
+{
+    Uint32 i;
+    const FrameStats *stats = &gf3d_stats.last;
+    fprintf(gf3d_stats.csv,"frame,frame_ms,draw_calls,binds,descriptor_writes,staging_bytes,single_time_submits,stall_ms,textures,sprites,meshes");
+    for (i = 0; i < stats->heapCount; i++)
+    {
+        fprintf(gf3d_stats.csv,",heap%i_bytes",i);
+    }
+    //every pipeline slot gets a column up front, so pipelines that first draw later still have one
+    for (i = 0; i < STATS_MAX_PIPELINES; i++)
+    {
+        fprintf(gf3d_stats.csv,",pipeline%i,pipeline%i_draws",i,i);
+    }
+    fprintf(gf3d_stats.csv,"\n");
+    gf3d_stats.csvHeader = 1;
+}
+
+void gf3d_stats_csv_write_row()
+{
+    Uint32 i;
+    const FrameStats *stats = &gf3d_stats.last;
+    if (!gf3d_stats.csvHeader)gf3d_stats_csv_write_header();
+    fprintf(gf3d_stats.csv,"%u,%.3f,%lu,%lu,%lu,%lu,%lu,%.3f,%u,%u,%u",
+        stats->frame,
+        stats->frameMs,
+        (unsigned long)stats->counters[SC_DrawCalls],
+        (unsigned long)stats->counters[SC_Binds],
+        (unsigned long)stats->counters[SC_DescriptorWrites],
+        (unsigned long)stats->counters[SC_StagingBytes],
+        (unsigned long)stats->counters[SC_SingleTimeSubmits],
+        stats->stallMs,
+        stats->textures,
+        stats->sprites,
+        stats->meshes);
+    for (i = 0; i < stats->heapCount; i++)
+    {
+        fprintf(gf3d_stats.csv,",%lu",(unsigned long)stats->heapUsed[i]);
+    }
+    //pipelines keep the slot they first drew in, each row names them so slots filled later are readable
+    for (i = 0; i < STATS_MAX_PIPELINES; i++)
+    {
+        if (i < stats->pipelineCount)fprintf(gf3d_stats.csv,",%s,%u",stats->pipelines[i].name,stats->pipelines[i].drawCalls);
+        else fprintf(gf3d_stats.csv,",,0");
+    }
+    fprintf(gf3d_stats.csv,"\n");
+}
+
+void gf3d_stats_end_frame()
+{
+    Uint32 i;
+    Uint64 now;
+    FrameStats *current = &gf3d_stats.current;
+    now = SDL_GetPerformanceCounter();
+    current->frameMs = (float)((now - gf3d_stats.lastCounter) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    gf3d_stats.lastCounter = now;
+    current->textures = gf3d_texture_get_count();
+    current->sprites = gf2d_sprite_get_count();
+    current->meshes = gf3d_skin_get_mesh_count();
+    memcpy(&gf3d_stats.last,current,sizeof(FrameStats));
+    if (gf3d_stats.csv)gf3d_stats_csv_write_row();
+    //per frame counts start over, the pipeline list and memory totals carry on
+    current->frame++;
+    memset(current->counters,0,sizeof(current->counters));
+    current->stallMs = 0;
+    for (i = 0; i < current->pipelineCount; i++)
+    {
+        current->pipelines[i].drawCalls = 0;
+    }
+}
+
+const FrameStats *gf3d_stats_get()
+{
+    return &gf3d_stats.last;
+}
+
+void gf3d_stats_log()
+{
+    Uint32 i;
+    const FrameStats *stats = &gf3d_stats.last;
+    slog("frame %i: %.2fms, %lu draws, %lu binds, %lu descriptor writes, %.1fKB staged, %lu single time submits (%.2fms stalled)",
+        stats->frame,
+        stats->frameMs,
+        (unsigned long)stats->counters[SC_DrawCalls],
+        (unsigned long)stats->counters[SC_Binds],
+        (unsigned long)stats->counters[SC_DescriptorWrites],
+        stats->counters[SC_StagingBytes] / 1024.0,
+        (unsigned long)stats->counters[SC_SingleTimeSubmits],
+        stats->stallMs);
+    for (i = 0; i < stats->pipelineCount; i++)
+    {
+        slog("  %s: %i draws",stats->pipelines[i].name,stats->pipelines[i].drawCalls);
+    }
+    slog("  alive: %i textures, %i sprites, %i meshes",stats->textures,stats->sprites,stats->meshes);
+    for (i = 0; i < stats->heapCount; i++)
+    {
+        slog("  heap %i: %.2fMB of %.2fMB",i,stats->heapUsed[i] / (1024.0 * 1024.0),stats->heapSize[i] / (1024.0 * 1024.0));
+    }
+}
+
+int gf3d_stats_csv_open(const char *filename)
+{
+    if (!filename)return 0;
+    gf3d_stats_csv_close();
+    gf3d_stats.csv = fopen(filename,"w");
+    if (!gf3d_stats.csv)
+    {
+        slog("failed to open stats file %s",filename);
+        return 0;
+    }
+    gf3d_stats.csvHeader = 0;
+    return 1;
+}
+
+void gf3d_stats_csv_close()
+{
+    if (!gf3d_stats.csv)return;
+    fclose(gf3d_stats.csv);
+    gf3d_stats.csv = NULL;
+}
+
+/*eol@eof*/
@@ -6,6 +6,8 @@
 #include "gf3d_swapchain.h"
 #include "gf3d_vqueues.h"
 #include "gf3d_vgraphics.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
 
 extern int __DEBUG;
 
@@ -34,16 +36,31 @@ typedef struct
 
 static vSwapChain gf3d_swapchain = {0};
 
+typedef struct
+{
+    const char         *name;
+    VkPresentModeKHR    mode;
+}PresentModeName;
+
+static PresentModeName gf3d_swapchain_present_mode_names[] =
+{
+    {"immediate",VK_PRESENT_MODE_IMMEDIATE_KHR},
+    {"mailbox",VK_PRESENT_MODE_MAILBOX_KHR},
+    {"fifo",VK_PRESENT_MODE_FIFO_KHR},
+    {"fifo_relaxed",VK_PRESENT_MODE_FIFO_RELAXED_KHR},
+    {NULL}
+};
+
 
 void gf3d_swapchain_create(VkDevice device,VkSurfaceKHR surface);
 void gf3d_swapchain_close();
 int gf3d_swapchain_choose_format();
 void gf3d_swapchain_create_depth_image();
-int gf3d_swapchain_get_presentation_mode();
+int gf3d_swapchain_get_presentation_mode(VkPresentModeKHR preferred);
 VkExtent2D gf3d_swapchain_configure_extent(Uint32 width,Uint32 height);
 uint32_t gf3d_swapchain_find_Memory_type(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
-void gf3d_swapchain_init(VkPhysicalDevice device,VkDevice logicalDevice,VkSurfaceKHR surface,Uint32 width,Uint32 height)
+void gf3d_swapchain_init(VkPhysicalDevice device,VkDevice logicalDevice,VkSurfaceKHR surface,Uint32 width,Uint32 height,VkPresentModeKHR presentMode)
 {
     int i;
 
@@ -83,7 +100,13 @@ void gf3d_swapchain_init(VkPhysicalDevice device,VkDevice logicalDevice,VkSurfac
     
     gf3d_swapchain.chosenFormat = gf3d_swapchain_choose_format();
     
-    gf3d_swapchain.chosenPresentMode = gf3d_swapchain_get_presentation_mode();
+    gf3d_swapchain.chosenPresentMode = gf3d_swapchain_get_presentation_mode(presentMode);
+    if (gf3d_swapchain.chosenPresentMode < 0)
+    {
+        slog("surface has no presentation modes");
+        return;
+    }
+    slog("presenting with %s",gf3d_swapchain_present_mode_name(gf3d_swapchain_get_present_mode()));
     
     gf3d_swapchain.extent = gf3d_swapchain_configure_extent(width,height);
     
@@ -118,7 +141,9 @@ void gf3d_swapchain_create_frame_buffer(VkFramebuffer *buffer,VkImageView *image
     if (vkCreateFramebuffer(gf3d_swapchain.device, &framebufferInfo, NULL, buffer) != VK_SUCCESS)
     {
         slog("failed to create framebuffer!");
+        return;
     }
+    gf3d_tracker_create(TC_Framebuffer,*buffer,0,"swap chain");
 }
 
 void gf3d_swapchain_setup_frame_buffers(Pipeline *pipe)
@@ -232,19 +257,62 @@ VkExtent2D gf3d_swapchain_get_extent()
 }
 
 
-int gf3d_swapchain_get_presentation_mode()
+int gf3d_swapchain_find_presentation_mode(VkPresentModeKHR mode)
 {
     int i;
-    int chosen = -1;
-    for (i = 0; i < gf3d_swapchain.formatCount; i++)
+    for (i = 0; i < gf3d_swapchain.presentModeCount; i++)
     {
-        if (gf3d_swapchain.presentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)
-            return i;
-        chosen = i;
+        if (gf3d_swapchain.presentModes[i] == mode)return i;
+    }
+    return -1;
+}
+
+int gf3d_swapchain_get_presentation_mode(VkPresentModeKHR preferred)
+{
+    int chosen;
+    chosen = gf3d_swapchain_find_presentation_mode(preferred);
+    if (chosen >= 0)return chosen;
+    //mailbox keeps latency low without tearing, fifo is always supported
+    chosen = gf3d_swapchain_find_presentation_mode(VK_PRESENT_MODE_MAILBOX_KHR);
+    if (chosen < 0)chosen = gf3d_swapchain_find_presentation_mode(VK_PRESENT_MODE_FIFO_KHR);
+    if (chosen < 0)chosen = gf3d_swapchain.presentModeCount?0:-1;
+    if (chosen >= 0)
+    {
+        slog("present mode %s is not supported, falling back to %s",
+            gf3d_swapchain_present_mode_name(preferred),
+            gf3d_swapchain_present_mode_name(gf3d_swapchain.presentModes[chosen]));
     }
     return chosen;
 }
 
+VkPresentModeKHR gf3d_swapchain_get_present_mode()
+{
+    if ((!gf3d_swapchain.presentModes)||(gf3d_swapchain.chosenPresentMode < 0))return VK_PRESENT_MODE_FIFO_KHR;
+    return gf3d_swapchain.presentModes[gf3d_swapchain.chosenPresentMode];
+}
+
+VkPresentModeKHR gf3d_swapchain_present_mode_from_name(const char *name,VkPresentModeKHR defaultMode)
+{
+    int i;
+    if (!name)return defaultMode;
+    for (i = 0; gf3d_swapchain_present_mode_names[i].name; i++)
+    {
+        if (strcmp(gf3d_swapchain_present_mode_names[i].name,name) == 0)return gf3d_swapchain_present_mode_names[i].mode;
+    }
+    slog("unknown present mode %s",name);
+    return defaultMode;
+}
+
+const char *gf3d_swapchain_present_mode_name(VkPresentModeKHR mode)
+{
+    int i;
+    for (i = 0; gf3d_swapchain_present_mode_names[i].name; i++)
+    {
+        if (gf3d_swapchain_present_mode_names[i].mode == mode)return gf3d_swapchain_present_mode_names[i].name;
+    }
+    return "unknown";
+}
+
 int gf3d_swapchain_choose_format()
 {
     int i;
@@ -265,20 +333,25 @@ void gf3d_swapchain_close()
     
     if (gf3d_swapchain.depthImageView != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_ImageView,gf3d_swapchain.depthImageView);
         vkDestroyImageView(gf3d_swapchain.device, gf3d_swapchain.depthImageView, NULL);
     }
     if (gf3d_swapchain.depthImage != VK_NULL_HANDLE)
     {
+        gf3d_tracker_destroy(TC_Image,gf3d_swapchain.depthImage);
         vkDestroyImage(gf3d_swapchain.device, gf3d_swapchain.depthImage, NULL);
     }
     if (gf3d_swapchain.depthImageMemory != VK_NULL_HANDLE)
     {
+        gf3d_stats_memory_free(gf3d_swapchain.depthImageMemory);
+        gf3d_tracker_destroy(TC_Memory,gf3d_swapchain.depthImageMemory);
         vkFreeMemory(gf3d_swapchain.device, gf3d_swapchain.depthImageMemory, NULL);
     }
     if (gf3d_swapchain.frameBuffers)
     {
         for (i = 0;i < gf3d_swapchain.framebufferCount; i++)
         {
+            gf3d_tracker_destroy(TC_Framebuffer,gf3d_swapchain.frameBuffers[i]);
             vkDestroyFramebuffer(gf3d_swapchain.device, gf3d_swapchain.frameBuffers[i], NULL);
         }
         free (gf3d_swapchain.frameBuffers);
@@ -288,6 +361,7 @@ void gf3d_swapchain_close()
     {
         for (i = 0;i < gf3d_swapchain.swapImageCount;i++)
         {
+            gf3d_tracker_destroy(TC_ImageView,gf3d_swapchain.imageViews[i]);
             vkDestroyImageView(gf3d_swapchain.device,gf3d_swapchain.imageViews[i],NULL);
         }
         free(gf3d_swapchain.imageViews);
@@ -372,6 +446,7 @@ VkImageView gf3d_swapchain_create_image_view(VkImage image, VkFormat format, VkI
         slog("failed to create texture image view!");
         return VK_NULL_HANDLE;
     }
+    gf3d_tracker_create(TC_ImageView,imageView,0,"swap chain");
 
     return imageView;
 }
@@ -509,7 +584,11 @@ void gf3d_swapchain_create_image(uint32_t width, uint32_t height, VkFormat forma
     if (vkCreateImage(gf3d_swapchain.device, &imageInfo, NULL, image) != VK_SUCCESS)
     {
         slog("failed to create image!");
+        *image = VK_NULL_HANDLE;
+        *imageMemory = VK_NULL_HANDLE;
+        return;
     }
+    gf3d_tracker_create(TC_Image,*image,0,"swap chain");
 
     vkGetImageMemoryRequirements(gf3d_swapchain.device, *image, &memRequirements);
 
@@ -520,7 +599,14 @@ void gf3d_swapchain_create_image(uint32_t width, uint32_t height, VkFormat forma
     if (vkAllocateMemory(gf3d_swapchain.device, &allocInfo, NULL, imageMemory) != VK_SUCCESS)
     {
         slog("failed to allocate image memory!");
+        gf3d_tracker_destroy(TC_Image,*image);
+        vkDestroyImage(gf3d_swapchain.device, *image, NULL);
+        *image = VK_NULL_HANDLE;
+        *imageMemory = VK_NULL_HANDLE;
+        return;
     }
+    gf3d_stats_memory_alloc(*imageMemory,allocInfo.allocationSize,allocInfo.memoryTypeIndex);
+    gf3d_tracker_create(TC_Memory,*imageMemory,allocInfo.allocationSize,"swap chain");
 
     vkBindImageMemory(gf3d_swapchain.device, *image, *imageMemory, 0);
 }
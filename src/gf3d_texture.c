@@ -8,12 +8,23 @@
 #include "gf3d_buffers.h"
 #include "gf3d_swapchain.h"
 #include "gf3d_texture.h"
+#include "gf3d_registry.h"
+#include "gf3d_pool.h"
+#include "gf3d_texture_compressed.h"
+#include "gf3d_bindless.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
+
+#define TEXTURE_MAX_STREAMS 16  /**<textures that can have an upload queued at once*/
 
 typedef struct
 {
-    Uint32          max_textures;
-    Texture       * texture_list;
+    Pool          * texture_pool;
+    Registry      * texture_names;  /**<loaded textures by filename*/
     VkDevice        device;
+    int             blitSupported;  /**<-1 until checked, then whether the texture format can be linearly blitted for mip generation*/
+    Texture        *streams[TEXTURE_MAX_STREAMS];  /**<textures waiting for gf3d_texture_record_streams*/
+    Uint32          streamCount;
 }TextureManager;
 
 extern int __DEBUG;
@@ -22,6 +33,7 @@ static TextureManager gf3d_texture = {0};
 void gf3d_texture_close();
 void gf3d_texture_delete(Texture *tex);
 void gf3d_texture_delete_all();
+void gf3d_texture_stream_free(Texture *tex);
 
 void gf3d_texture_init(Uint32 max_textures)
 {
@@ -30,14 +42,16 @@ void gf3d_texture_init(Uint32 max_textures)
         slog("cannot initialize texture system for 0 textures");
         return;
     }
-    gf3d_texture.texture_list = gfc_allocate_array(sizeof(Texture),max_textures);
-    if (!gf3d_texture.texture_list)
+    //max_textures is the chunk size, the pool grows if more are needed
+    gf3d_texture.texture_pool = gf3d_pool_new(sizeof(Texture),max_textures,0);
+    if (!gf3d_texture.texture_pool)
     {
         slog("failed to initialize texture system: not enough memory");
         return;
     }
-    gf3d_texture.max_textures = max_textures;
+    gf3d_texture.texture_names = gf3d_registry_new(max_textures);
     gf3d_texture.device = gf3d_vgraphics_get_default_logical_device();
+    gf3d_texture.blitSupported = -1;
     atexit(gf3d_texture_close);
     if (__DEBUG)slog("texture system initialized");
 }
@@ -46,63 +60,88 @@ void gf3d_texture_close()
 {
     if (__DEBUG)slog("cleaning up textures");
     gf3d_texture_delete_all();
-    if (gf3d_texture.texture_list != NULL)
+    gf3d_pool_free(gf3d_texture.texture_pool);
+    gf3d_registry_free(gf3d_texture.texture_names);
+    memset(&gf3d_texture,0,sizeof(TextureManager));
+}
+
+/**
+ * @brief delete every texture that is only kept around in case it is loaded again
+ * @return how many were deleted
+ */
+Uint32 gf3d_texture_reclaim_unused()
+{
+    Uint32 i,c,count = 0;
+    Texture *tex;
+    c = gf3d_pool_get_capacity(gf3d_texture.texture_pool);
+    for (i = 0; i < c; i++)
     {
-        free(gf3d_texture.texture_list);
+        tex = gf3d_pool_get_nth(gf3d_texture.texture_pool,i);
+        if ((!tex)||(tex->_refcount))continue;
+        gf3d_texture_delete(tex);
+        count++;
     }
+    return count;
 }
 
 Texture *gf3d_texture_new()
 {
-    int i;
-    for (i = 0; i < gf3d_texture.max_textures; i++)
-    {
-        if (!gf3d_texture.texture_list[i]._inuse)
-        {
-            gf3d_texture.texture_list[i]._inuse = 1;
-            gf3d_texture.texture_list[i]._refcount = 1;
-            return &gf3d_texture.texture_list[i];
-        }
-    }
-    for (i = 0; i < gf3d_texture.max_textures; i++)
+    Texture *tex;
+    //prefer reusing the space of unreferenced textures over growing the pool
+    if (!gf3d_pool_get_free_count(gf3d_texture.texture_pool))gf3d_texture_reclaim_unused();
+    tex = gf3d_pool_alloc(gf3d_texture.texture_pool);
+    if (!tex)
     {
-        if (!gf3d_texture.texture_list[i]._refcount)
-        {
-            gf3d_texture_delete(&gf3d_texture.texture_list[i]);
-            gf3d_texture.texture_list[i]._refcount = 1;
-            gf3d_texture.texture_list[i]._inuse = 1;
-            return &gf3d_texture.texture_list[i];
-        }
+        slog("no free texture space");
+        return NULL;
     }
-    slog("no free texture space");
-    return NULL;
+    tex->_inuse = 1;
+    tex->_refcount = 1;
+    return tex;
+}
+
+/**
+ * @brief build the name a texture is shared under.  The default sampler uses the plain filename
+ */
+void gf3d_texture_make_key(GFC_TextLine key,const char *filename,SamplerPreset preset)
+{
+    if (preset == SP_Texture)gfc_line_cpy(key,filename);
+    else gfc_line_sprintf(key,"%s#%i",filename,preset);
 }
 
 void gf3d_texture_delete(Texture *tex)
 {
+    GFC_TextLine key;
     if (!tex)return;
-    
-    if ((tex->textureSampler)&&(tex->textureSampler != VK_NULL_HANDLE))
+    if (tex->filename[0])
     {
-        vkDestroySampler(gf3d_texture.device, tex->textureSampler, NULL);
+        gf3d_texture_make_key(key,tex->filename,tex->samplerPreset);
+        gf3d_registry_remove(gf3d_texture.texture_names,key,tex);
     }
+    gf3d_bindless_remove_texture(tex);
     if ((tex->textureImageView)&&(tex->textureImageView != VK_NULL_HANDLE))
     {
+        gf3d_tracker_destroy(TC_ImageView,tex->textureImageView);
         vkDestroyImageView(gf3d_texture.device, tex->textureImageView, NULL);
     }
     if ((tex->textureImage)&&(tex->textureImage != VK_NULL_HANDLE))
     {
+        gf3d_tracker_destroy(TC_Image,tex->textureImage);
         vkDestroyImage(gf3d_texture.device, tex->textureImage, NULL);
     }
     if ((tex->textureImage)&&(tex->textureImageMemory != VK_NULL_HANDLE))
     {
+        gf3d_stats_memory_free(tex->textureImageMemory);
+        gf3d_tracker_destroy(TC_Memory,tex->textureImageMemory);
         vkFreeMemory(gf3d_texture.device, tex->textureImageMemory, NULL);
     }
+    gf3d_texture_stream_free(tex);
     if (tex->surface)
     {
         SDL_FreeSurface(tex->surface);
     }
     memset(tex,0,sizeof(Texture));
+    gf3d_pool_release(gf3d_texture.texture_pool,tex);
 }
 
 void gf3d_texture_free(Texture *tex)
@@ -113,26 +152,25 @@ void gf3d_texture_free(Texture *tex)
 
 void gf3d_texture_delete_all()
 {
-    int i;
-    for (i = 0; i < gf3d_texture.max_textures; i++)
+    Uint32 i,c;
+    c = gf3d_pool_get_capacity(gf3d_texture.texture_pool);
+    for (i = 0; i < c; i++)
     {
-        gf3d_texture_delete(&gf3d_texture.texture_list[i]);
+        gf3d_texture_delete(gf3d_pool_get_nth(gf3d_texture.texture_pool,i));
     }
 }
 
 Texture *gf3d_texture_get_by_filename(const char * filename)
 {
-    int i;
+    return gf3d_texture_get_sampled(filename,SP_Texture);
+}
+
+Texture *gf3d_texture_get_sampled(const char * filename,SamplerPreset preset)
+{
+    GFC_TextLine key;
     if (!filename)return NULL;
-    for (i = 0; i < gf3d_texture.max_textures; i++)
-    {
-        if (!gf3d_texture.texture_list[i]._inuse)continue;
-        if (gfc_line_cmp(gf3d_texture.texture_list[i].filename,filename)==0)
-        {
-            return &gf3d_texture.texture_list[i];
-        }
-    }
-    return NULL;
+    gf3d_texture_make_key(key,filename,preset);
+    return gf3d_registry_get(gf3d_texture.texture_names,key);
 }
 
 void gf3d_texture_copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
@@ -176,44 +214,313 @@ void gf3d_texture_copy_buffer_to_image(VkBuffer buffer, VkImage image, uint32_t
 
 void gf3d_texture_create_sampler(Texture *tex)
 {
-    VkSamplerCreateInfo samplerInfo = {0};
+    if (!tex)return;
+    tex->textureSampler = gf3d_sampler_get_preset(SP_Texture);
+    gf3d_bindless_add_texture(tex);
+}
 
+void gf3d_texture_set_sampler(Texture *tex,SamplerPreset preset)
+{
+    VkSampler sampler;
     if (!tex)return;
+    sampler = gf3d_sampler_get_preset(preset);
+    if (sampler == VK_NULL_HANDLE)return;
+    tex->textureSampler = sampler;
+    gf3d_bindless_update_texture(tex);
+}
 
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = 16;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE;
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.mipLodBias = 0.0f;
-    samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
+Uint32 gf3d_texture_get_mip_levels(Uint32 width,Uint32 height)
+{
+    Uint32 levels = 1;
+    Uint32 size = MAX(width,height);
+    while (size > 1)
+    {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+int gf3d_texture_blit_supported(VkFormat format)
+{
+    VkFormatProperties formatProperties;
+    if (gf3d_texture.blitSupported >= 0)return gf3d_texture.blitSupported;
+    vkGetPhysicalDeviceFormatProperties(gf3d_vgraphics_get_default_physical_device(), format, &formatProperties);
+    gf3d_texture.blitSupported = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)?1:0;
+    if (!gf3d_texture.blitSupported)slog("texture format does not support linear blits, textures will not have mipmaps");
+    return gf3d_texture.blitSupported;
+}
+
+/**
+ * @brief copy the staging buffer into the top level of the texture, build the rest of the mip chain from it
+ * and leave every level ready for the shaders.  All done in one command buffer
+ */
+void gf3d_texture_upload(VkBuffer buffer,Texture *tex)
+{
+    Uint32 i;
+    Sint32 mipWidth,mipHeight;
+    VkCommandBuffer commandBuffer;
+    Command * commandPool;
+    VkBufferImageCopy region = {0};
+    VkImageMemoryBarrier barrier = {0};
+    VkImageBlit blit = {0};
+
+    commandPool = gf3d_vgraphics_get_graphics_command_pool();
+    commandBuffer = gf3d_command_begin_single_time(commandPool);
+
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = tex->textureImage;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    //every level starts as a transfer destination
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = tex->mipLevels;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.width = tex->width;
+    region.imageExtent.height = tex->height;
+    region.imageExtent.depth = 1;
+    vkCmdCopyBufferToImage(commandBuffer, buffer, tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.subresourceRange.levelCount = 1;
+    mipWidth = tex->width;
+    mipHeight = tex->height;
+    for (i = 1; i < tex->mipLevels; i++)
+    {
+        //the level above becomes the source for this one
+        barrier.subresourceRange.baseMipLevel = i - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+        blit.srcOffsets[1].x = mipWidth;
+        blit.srcOffsets[1].y = mipHeight;
+        blit.srcOffsets[1].z = 1;
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = i - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[1].x = mipWidth > 1 ? mipWidth / 2 : 1;
+        blit.dstOffsets[1].y = mipHeight > 1 ? mipHeight / 2 : 1;
+        blit.dstOffsets[1].z = 1;
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = i;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+        vkCmdBlitImage(commandBuffer,
+            tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &blit, VK_FILTER_LINEAR);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+        if (mipWidth > 1)mipWidth /= 2;
+        if (mipHeight > 1)mipHeight /= 2;
+    }
+
+    //the last level was only ever written to
+    barrier.subresourceRange.baseMipLevel = tex->mipLevels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    gf3d_command_end_single_time(commandPool, commandBuffer);
+}
+
+/**
+ * @brief create the vulkan image for a texture and bind device memory to it, from the texture's size, format and mip levels
+ * @return 0 on error, 1 otherwise
+ */
+int gf3d_texture_create_image(Texture *tex,VkImageUsageFlags usage)
+{
+    VkImageCreateInfo imageInfo = {0};
+    VkMemoryRequirements memRequirements;
+    VkMemoryAllocateInfo allocInfo = {0};
+
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = tex->width;
+    imageInfo.extent.height = tex->height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = tex->mipLevels;
+    imageInfo.arrayLayers = 1;    
+    imageInfo.format = tex->format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.flags = 0; // Optional
     
-    if (vkCreateSampler(gf3d_texture.device, &samplerInfo, NULL, &tex->textureSampler) != VK_SUCCESS)
+    if (vkCreateImage(gf3d_texture.device, &imageInfo, NULL, &tex->textureImage) != VK_SUCCESS)
     {
-        slog("failed to create texture sampler!");
-        return;
+        slog("failed to create image!");
+        tex->textureImage = VK_NULL_HANDLE;
+        return 0;
+    }
+    gf3d_tracker_create(TC_Image,tex->textureImage,0,"texture");
+    vkGetImageMemoryRequirements(gf3d_texture.device, tex->textureImage, &memRequirements);
+    tex->gpuBytes = memRequirements.size;
+
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = gf3d_vgraphics_find_memory_type(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (vkAllocateMemory(gf3d_texture.device, &allocInfo, NULL, &tex->textureImageMemory) != VK_SUCCESS)
+    {
+        slog("failed to allocate image memory!");
+        tex->textureImageMemory = VK_NULL_HANDLE;
+        return 0;
     }
+    gf3d_stats_memory_alloc(tex->textureImageMemory,allocInfo.allocationSize,allocInfo.memoryTypeIndex);
+    gf3d_tracker_create(TC_Memory,tex->textureImageMemory,allocInfo.allocationSize,"texture");
+
+    vkBindImageMemory(gf3d_texture.device, tex->textureImage, tex->textureImageMemory, 0);    
+    return 1;
+}
+
+/**
+ * @brief copy every level of a compressed image from the staging buffer and leave them ready for the shaders
+ */
+void gf3d_texture_upload_levels(VkBuffer buffer,Texture *tex,VkDeviceSize *offsets)
+{
+    Uint32 i;
+    VkCommandBuffer commandBuffer;
+    Command * commandPool;
+    VkBufferImageCopy regions[GF3D_COMPRESSED_MAX_LEVELS];
+    VkImageMemoryBarrier barrier = {0};
+
+    commandPool = gf3d_vgraphics_get_graphics_command_pool();
+    commandBuffer = gf3d_command_begin_single_time(commandPool);
+
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = tex->textureImage;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = tex->mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    memset(regions,0,sizeof(regions));
+    for (i = 0; i < tex->mipLevels; i++)
+    {
+        regions[i].bufferOffset = offsets[i];
+        regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        regions[i].imageSubresource.mipLevel = i;
+        regions[i].imageSubresource.baseArrayLayer = 0;
+        regions[i].imageSubresource.layerCount = 1;
+        regions[i].imageExtent.width = MAX(1,tex->width >> i);
+        regions[i].imageExtent.height = MAX(1,tex->height >> i);
+        regions[i].imageExtent.depth = 1;
+    }
+    vkCmdCopyBufferToImage(commandBuffer, buffer, tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, tex->mipLevels, regions);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    gf3d_command_end_single_time(commandPool, commandBuffer);
+}
+
+Texture *gf3d_texture_from_compressed(CompressedImage *image,Uint32 flags)
+{
+    Uint32 i;
+    void *data;
+    Texture *tex;
+    VkDeviceSize offsets[GF3D_COMPRESSED_MAX_LEVELS];
+    VkDeviceSize bufferSize = 0;
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    VkFormatProperties formatProperties;
+
+    if (!image)return NULL;
+    vkGetPhysicalDeviceFormatProperties(gf3d_vgraphics_get_default_physical_device(), image->format, &formatProperties);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+    {
+        slog("device cannot sample compressed texture format %i",image->format);
+        return NULL;
+    }
+    tex = gf3d_texture_new();
+    if (!tex)return NULL;
+    tex->width = image->width;
+    tex->height = image->height;
+    tex->format = image->format;
+    tex->mipLevels = (flags & TF_NoMips)?1:image->mipLevels;
+    //offsets into the staging buffer must be a multiple of the block size
+    for (i = 0; i < tex->mipLevels; i++)
+    {
+        offsets[i] = bufferSize;
+        bufferSize += (image->levelSize[i] + 15) & ~(VkDeviceSize)15;
+    }
+    if (!gf3d_buffer_create(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory))
+    {
+        gf3d_texture_delete(tex);
+        return NULL;
+    }
+    vkMapMemory(gf3d_texture.device, stagingBufferMemory, 0, bufferSize, 0, &data);
+        for (i = 0; i < tex->mipLevels; i++)
+        {
+            memcpy((Uint8 *)data + offsets[i], image->levelData[i], image->levelSize[i]);
+        }
+    vkUnmapMemory(gf3d_texture.device, stagingBufferMemory);
+
+    if (!gf3d_texture_create_image(tex,VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT))
+    {
+        gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+        gf3d_texture_delete(tex);
+        return NULL;
+    }
+    gf3d_texture_upload_levels(stagingBuffer, tex, offsets);
+
+    tex->textureImageView = gf3d_vgraphics_create_image_view_mips(tex->textureImage, tex->format, tex->mipLevels);
+    gf3d_texture_create_sampler(tex);
+
+    gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+    return tex;
 }
 
 Texture *gf3d_texture_convert_surface(SDL_Surface * surface)
+{
+    return gf3d_texture_convert_surface_flags(surface,TF_None);
+}
+
+Texture *gf3d_texture_convert_surface_flags(SDL_Surface * surface,Uint32 flags)
 {
     void* data;
     Texture *tex;
     VkDeviceSize imageSize;
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
-    VkImageCreateInfo imageInfo = {0};
-    VkMemoryRequirements memRequirements;
-    VkMemoryAllocateInfo allocInfo = {0};
+    VkImageUsageFlags usage;
 
     if (!surface)
     {
@@ -228,11 +535,27 @@ Texture *gf3d_texture_convert_surface(SDL_Surface * surface)
         return NULL;
     }
     tex->surface = gf3d_vgraphics_screen_convert(&surface);
+    if (!tex->surface)
+    {
+        if (surface)SDL_FreeSurface(surface);
+        gf3d_texture_delete(tex);
+        return NULL;
+    }
     tex->width = tex->surface->w;
     tex->height = tex->surface->h;
+    tex->format = VK_FORMAT_R8G8B8A8_UNORM;
+    tex->mipLevels = 1;
+    if ((!(flags & TF_NoMips))&&(gf3d_texture_blit_supported(VK_FORMAT_R8G8B8A8_UNORM)))
+    {
+        tex->mipLevels = gf3d_texture_get_mip_levels(tex->width,tex->height);
+    }
     imageSize = tex->surface->w * tex->surface->h * 4;
     
-    gf3d_buffer_create(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory);
+    if (!gf3d_buffer_create(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory))
+    {
+        gf3d_texture_delete(tex);
+        return NULL;
+    }
     
     SDL_LockSurface(tex->surface);
         vkMapMemory(gf3d_texture.device, stagingBufferMemory, 0, imageSize, 0, &data);
@@ -240,70 +563,107 @@ Texture *gf3d_texture_convert_surface(SDL_Surface * surface)
         vkUnmapMemory(gf3d_texture.device, stagingBufferMemory);
     SDL_UnlockSurface(tex->surface);    
     
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = tex->surface->w;
-    imageInfo.extent.height = tex->surface->h;
-    imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;    
-    imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.flags = 0; // Optional
-    
-    if (vkCreateImage(gf3d_texture.device, &imageInfo, NULL, &tex->textureImage) != VK_SUCCESS)
+    usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (tex->mipLevels > 1)usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if (!gf3d_texture_create_image(tex,usage))
     {
-        slog("failed to create image!");
+        gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
         gf3d_texture_delete(tex);
-        SDL_FreeSurface(tex->surface);
         return NULL;
     }
-    vkGetImageMemoryRequirements(gf3d_texture.device, tex->textureImage, &memRequirements);
 
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = gf3d_vgraphics_find_memory_type(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    gf3d_texture_upload(stagingBuffer, tex);
 
-    if (vkAllocateMemory(gf3d_texture.device, &allocInfo, NULL, &tex->textureImageMemory) != VK_SUCCESS)
-    {
-        slog("failed to allocate image memory!");
-        gf3d_texture_delete(tex);
-        return NULL;
-    }
-
-    vkBindImageMemory(gf3d_texture.device, tex->textureImage, tex->textureImageMemory, 0);    
-    
-    gf3d_swapchain_transition_image_layout(tex->textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    gf3d_texture_copy_buffer_to_image(stagingBuffer, tex->textureImage, tex->surface->w, tex->surface->h);
-    
-    gf3d_swapchain_transition_image_layout(tex->textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    tex->textureImageView = gf3d_vgraphics_create_image_view(tex->textureImage, VK_FORMAT_R8G8B8A8_UNORM);
+    tex->textureImageView = gf3d_vgraphics_create_image_view_mips(tex->textureImage, tex->format, tex->mipLevels);
     
     gf3d_texture_create_sampler(tex);
     
-    vkDestroyBuffer(gf3d_texture.device, stagingBuffer, NULL);
-    vkFreeMemory(gf3d_texture.device, stagingBufferMemory, NULL);
+    gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+    if (!(flags & TF_KeepSurface))
+    {
+        //rendering only needs the image on the gpu
+        SDL_FreeSurface(tex->surface);
+        tex->surface = NULL;
+    }
     return tex;
 }
 
 
 Texture *gf3d_texture_load(const char *filename)
 {
-    void *mem;
+    return gf3d_texture_load_flags(filename,TF_None);
+}
+
+SDL_Surface *gf3d_texture_surface_from_mem(void *mem,size_t fileSize,const char *filename)
+{
     SDL_RWops *src;
+    SDL_Surface *surface;
+    src = SDL_RWFromMem(mem, fileSize);
+    if (!src)
+    {
+        slog("failed to read image %s",filename);
+        return NULL;
+    }
+    surface = IMG_Load_RW(src,1);
+    if (!surface)
+    {
+        slog("failed to load texture file %s",filename);
+        return NULL;
+    }
+    return gf3d_vgraphics_screen_convert(&surface);
+}
+
+SDL_Surface *gf3d_texture_load_surface(const char *filename)
+{
+    void *mem;
+    size_t fileSize = 0;
+    SDL_Surface *surface;
+    if (!filename)return NULL;
+    mem = gfc_pak_file_extract(filename,&fileSize);
+    if (!mem)
+    {
+        slog("failed to load image %s",filename);
+        return NULL;
+    }
+    surface = gf3d_texture_surface_from_mem(mem,fileSize,filename);
+    free(mem);
+    return surface;
+}
+
+Texture *gf3d_texture_load_flags(const char *filename,Uint32 flags)
+{
+    return gf3d_texture_load_sampled(filename,flags,SP_Texture);
+}
+
+/**
+ * @brief give a new texture its sampler and share it under its filename and that sampler
+ */
+void gf3d_texture_register(Texture *tex,const char *filename,SamplerPreset preset)
+{
+    GFC_TextLine key;
+    if (preset != SP_Texture)gf3d_texture_set_sampler(tex,preset);
+    tex->samplerPreset = preset;
+    gfc_line_cpy(tex->filename,filename);
+    gf3d_texture_make_key(key,filename,preset);
+    gf3d_registry_insert(gf3d_texture.texture_names,key,tex);
+}
+
+Texture *gf3d_texture_load_sampled(const char *filename,Uint32 flags,SamplerPreset preset)
+{
+    void *mem;
     size_t fileSize = 0;
     SDL_Surface * surface;
+    CompressedImage image;
     Texture *tex;
 
-    tex = gf3d_texture_get_by_filename(filename);
+    tex = gf3d_texture_get_sampled(filename,preset);
     if (tex)
     {
+        if ((flags & TF_KeepSurface)&&(!tex->surface)&&(tex->format == VK_FORMAT_R8G8B8A8_UNORM))
+        {
+            //shared with a load that let its image go, decode it again for this caller
+            tex->surface = gf3d_texture_load_surface(filename);
+        }
         tex->_refcount++;
         return tex;
     }
@@ -313,27 +673,291 @@ Texture *gf3d_texture_load(const char *filename)
         slog("failed to load image %s",filename);
         return NULL;
     }
-    src = SDL_RWFromMem(mem, fileSize);
-    if (!src)
+    if (gf3d_texture_compressed_check(mem,fileSize))
     {
-        slog("failed to read image %s",filename);
-        return NULL;
+        //block compressed images go straight to the gpu, no surface is kept
+        tex = NULL;
+        if (gf3d_texture_compressed_parse(mem,fileSize,&image))tex = gf3d_texture_from_compressed(&image,flags);
+        free(mem);
+        if (!tex)
+        {
+            slog("failed to load compressed texture %s",filename);
+            return NULL;
+        }
+        gf3d_texture_register(tex,filename,preset);
+        return tex;
     }
-    surface = IMG_Load_RW(src,1);
+    surface = gf3d_texture_surface_from_mem(mem,fileSize,filename);
     free(mem);
-    if (!surface)
+    if (!surface)return NULL;
+    return gf3d_texture_convert_surface_named(surface,filename,flags,preset);
+}
+
+Texture *gf3d_texture_convert_surface_named(SDL_Surface *surface,const char *filename,Uint32 flags,SamplerPreset preset)
+{
+    Texture *tex;
+    tex = gf3d_texture_convert_surface_flags(surface,flags);
+    if (!tex)return NULL;
+    if (filename)gf3d_texture_register(tex,filename,preset);
+    return tex;
+}
+
+int gf3d_texture_update_region(Texture *tex,SDL_Surface *surface,Uint32 x,Uint32 y)
+{
+    void *data;
+    VkDeviceSize imageSize;
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    VkCommandBuffer commandBuffer;
+    Command * commandPool;
+    VkBufferImageCopy region = {0};
+    VkImageMemoryBarrier barrier = {0};
+    SDL_Rect target;
+
+    if ((!tex)||(!surface))return 0;
+    if ((tex->format != VK_FORMAT_R8G8B8A8_UNORM)||(tex->mipLevels > 1))
     {
-        slog("failed to load texture file %s",filename);
-        return NULL;
+        slog("can only update regions of uncompressed textures without mips");
+        return 0;
     }
-    tex = gf3d_texture_convert_surface(surface);
-    
-    if (!tex)
+    if ((surface->format->BytesPerPixel != 4)||(surface->pitch % 4))
     {
-        return NULL;
+        slog("texture region must be 32 bit image data");
+        return 0;
+    }
+    if ((x + surface->w > tex->width)||(y + surface->h > tex->height))
+    {
+        slog("texture region (%i,%i,%i,%i) is outside of the %ix%i texture",x,y,surface->w,surface->h,tex->width,tex->height);
+        return 0;
+    }
+    imageSize = (VkDeviceSize)surface->pitch * surface->h;
+    if (!gf3d_buffer_create(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &stagingBuffer, &stagingBufferMemory))
+    {
+        return 0;
+    }
+    vkMapMemory(gf3d_texture.device, stagingBufferMemory, 0, imageSize, 0, &data);
+        SDL_LockSurface(surface);
+            memcpy(data, surface->pixels, imageSize);
+        SDL_UnlockSurface(surface);
+    vkUnmapMemory(gf3d_texture.device, stagingBufferMemory);
+
+    commandPool = gf3d_vgraphics_get_graphics_command_pool();
+    commandBuffer = gf3d_command_begin_single_time(commandPool);
+
+    //frames already submitted may still be sampling the rest of the image
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.image = tex->textureImage;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    region.bufferRowLength = surface->pitch / 4;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset.x = x;
+    region.imageOffset.y = y;
+    region.imageExtent.width = surface->w;
+    region.imageExtent.height = surface->h;
+    region.imageExtent.depth = 1;
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    gf3d_command_end_single_time(commandPool, commandBuffer);
+
+    gf3d_buffer_free(stagingBuffer,stagingBufferMemory);
+
+    if (tex->surface)
+    {
+        //keep the cpu copy in step with the gpu
+        target.x = x;
+        target.y = y;
+        target.w = surface->w;
+        target.h = surface->h;
+        SDL_SetSurfaceBlendMode(surface,SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surface,NULL,tex->surface,&target);
+    }
+    return 1;
+}
+
+void gf3d_texture_stream_free(Texture *tex)
+{
+    Uint32 i;
+    if (tex->streamPending)
+    {
+        for (i = 0; i < gf3d_texture.streamCount; i++)
+        {
+            if (gf3d_texture.streams[i] != tex)continue;
+            gf3d_texture.streams[i] = gf3d_texture.streams[--gf3d_texture.streamCount];
+            break;
+        }
+        tex->streamPending = 0;
+    }
+    if (tex->streamBuffer == VK_NULL_HANDLE)return;
+    vkUnmapMemory(gf3d_texture.device,tex->streamMemory);
+    gf3d_buffer_free(tex->streamBuffer,tex->streamMemory);
+    tex->streamBuffer = VK_NULL_HANDLE;
+    tex->streamMemory = VK_NULL_HANDLE;
+    tex->streamMapped = NULL;
+}
+
+int gf3d_texture_stream(Texture *tex)
+{
+    VkDeviceSize sliceSize;
+    if ((!tex)||(!tex->surface))
+    {
+        slog("can only stream textures that kept their surface");
+        return 0;
+    }
+    if ((tex->format != VK_FORMAT_R8G8B8A8_UNORM)||(tex->mipLevels > 1)||(tex->surface->format->BytesPerPixel != 4)||(tex->surface->pitch % 4))
+    {
+        slog("can only stream 32 bit uncompressed textures without mips");
+        return 0;
+    }
+    if (tex->streamPending)return 1;
+    if (gf3d_texture.streamCount >= TEXTURE_MAX_STREAMS)
+    {
+        slog("too many texture uploads queued this frame");
+        return 0;
+    }
+    if (tex->streamBuffer == VK_NULL_HANDLE)
+    {
+        //a slice per swap chain image, a slice is only written again once its image is acquired again
+        sliceSize = (VkDeviceSize)tex->surface->pitch * tex->surface->h;
+        if (!gf3d_buffer_create(
+            sliceSize * gf3d_swapchain_get_swap_image_count(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &tex->streamBuffer,
+            &tex->streamMemory))
+        {
+            return 0;
+        }
+        if (vkMapMemory(gf3d_texture.device,tex->streamMemory,0,VK_WHOLE_SIZE,0,(void **)&tex->streamMapped) != VK_SUCCESS)
+        {
+            slog("failed to map texture stream buffer");
+            gf3d_buffer_free(tex->streamBuffer,tex->streamMemory);
+            tex->streamBuffer = VK_NULL_HANDLE;
+            tex->streamMemory = VK_NULL_HANDLE;
+            return 0;
+        }
+    }
+    tex->streamPending = 1;
+    gf3d_texture.streams[gf3d_texture.streamCount++] = tex;
+    return 1;
+}
+
+void gf3d_texture_record_streams(VkCommandBuffer commandBuffer)
+{
+    Uint32 i;
+    Texture *tex;
+    VkDeviceSize sliceSize;
+    VkBufferImageCopy region = {0};
+    VkImageMemoryBarrier barrier = {0};
+    if ((!gf3d_texture.streamCount)||(!commandBuffer))return;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent.depth = 1;
+    for (i = 0; i < gf3d_texture.streamCount; i++)
+    {
+        tex = gf3d_texture.streams[i];
+        tex->streamPending = 0;
+        sliceSize = (VkDeviceSize)tex->surface->pitch * tex->surface->h;
+        region.bufferOffset = sliceSize * gf3d_vgraphics_get_current_buffer_frame();
+        SDL_LockSurface(tex->surface);
+            memcpy(tex->streamMapped + region.bufferOffset,tex->surface->pixels,sliceSize);
+        SDL_UnlockSurface(tex->surface);
+
+        //frames already submitted may still be sampling the image
+        barrier.image = tex->textureImage;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+        region.bufferRowLength = tex->surface->pitch / 4;
+        region.imageExtent.width = tex->surface->w;
+        region.imageExtent.height = tex->surface->h;
+        vkCmdCopyBufferToImage(commandBuffer, tex->streamBuffer, tex->textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+    }
+    gf3d_texture.streamCount = 0;
+}
+
+Uint32 gf3d_texture_get_count()
+{
+    if (!gf3d_texture.texture_pool)return 0;
+    return gf3d_pool_get_count(gf3d_texture.texture_pool);
+}
+
+void gf3d_texture_get_memory_stats(TextureMemoryStats *stats)
+{
+    Uint32 i,c;
+    Texture *tex;
+    if (!stats)return;
+    memset(stats,0,sizeof(TextureMemoryStats));
+    c = gf3d_pool_get_capacity(gf3d_texture.texture_pool);
+    for (i = 0; i < c; i++)
+    {
+        tex = gf3d_pool_get_nth(gf3d_texture.texture_pool,i);
+        if (!tex)continue;
+        stats->textureCount++;
+        if (!tex->_refcount)stats->unreferencedCount++;
+        stats->gpuBytes += tex->gpuBytes;
+        if (tex->surface)
+        {
+            stats->surfaceCount++;
+            stats->surfaceBytes += (size_t)tex->surface->pitch * tex->surface->h;
+        }
+    }
+}
+
+void gf3d_texture_log_memory()
+{
+    Uint32 i,c;
+    Texture *tex;
+    TextureMemoryStats stats;
+    gf3d_texture_get_memory_stats(&stats);
+    slog("textures: %i live (%i unreferenced), %.2fMB gpu, %i cpu images %.2fMB",
+        stats.textureCount,
+        stats.unreferencedCount,
+        stats.gpuBytes / (1024.0 * 1024.0),
+        stats.surfaceCount,
+        stats.surfaceBytes / (1024.0 * 1024.0));
+    c = gf3d_pool_get_capacity(gf3d_texture.texture_pool);
+    for (i = 0; i < c; i++)
+    {
+        tex = gf3d_pool_get_nth(gf3d_texture.texture_pool,i);
+        if ((!tex)||(!tex->surface))continue;
+        slog("  %s: %ix%i cpu image resident (%i refs)",tex->filename[0]?tex->filename:"<surface>",tex->width,tex->height,tex->_refcount);
     }
-    gfc_line_cpy(tex->filename,filename);
-    return tex;
 }
 
 /*eol@eof*/
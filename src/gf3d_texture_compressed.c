@@ -0,0 +1,260 @@
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_texture_compressed.h"
+
+#define DDS_HEADER_SIZE     128     /**<magic plus the 124 byte header*/
+#define DDS_DX10_SIZE       20
+#define DDS_PF_FOURCC       0x4
+#define DDS_CAPS2_CUBEMAP   0x200
+#define DDS_CAPS2_VOLUME    0x200000
+
+#define KTX2_HEADER_SIZE    80
+#define KTX2_LEVEL_SIZE     24
+
+static const Uint8 gf3d_ktx2_identifier[12] = {0xAB,0x4B,0x54,0x58,0x20,0x32,0x30,0xBB,0x0D,0x0A,0x1A,0x0A};
+
+extern int __DEBUG;
+
+Uint32 gf3d_texture_compressed_read32(const Uint8 *data)
+{
+    return (Uint32)data[0] | ((Uint32)data[1] << 8) | ((Uint32)data[2] << 16) | ((Uint32)data[3] << 24);
+}
+
+Uint64 gf3d_texture_compressed_read64(const Uint8 *data)
+{
+    return (Uint64)gf3d_texture_compressed_read32(data) | ((Uint64)gf3d_texture_compressed_read32(data + 4) << 32);
+}
+
+size_t gf3d_texture_compressed_level_size(Uint32 width,Uint32 height,Uint32 blockBytes)
+{
+    return (size_t)MAX(1,(width + 3) / 4) * (size_t)MAX(1,(height + 3) / 4) * blockBytes;
+}
+
+/**
+ * @brief get how many levels a full mip chain has for an image size, floor(log2(max(w,h))) + 1
+ */
+Uint32 gf3d_texture_compressed_chain_length(Uint32 width,Uint32 height)
+{
+    Uint32 levels = 1,size = MAX(width,height);
+    while (size > 1)
+    {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+/**
+ * @brief clamp a level count from a file to what the image size allows, extra levels are dropped
+ */
+Uint32 gf3d_texture_compressed_clamp_levels(Uint32 levels,Uint32 width,Uint32 height)
+{
+    Uint32 chain;
+    chain = MIN(gf3d_texture_compressed_chain_length(width,height),GF3D_COMPRESSED_MAX_LEVELS);
+    levels = MAX(levels,1);
+    if (levels > chain)
+    {
+        if (__DEBUG)slog("compressed texture declares %i levels, a %ix%i image only has %i",levels,width,height,chain);
+        return chain;
+    }
+    return levels;
+}
+
+/**
+ * @brief get the block size for the formats we accept
+ * @return 0 if the format is not supported
+ */
+Uint32 gf3d_texture_compressed_block_bytes(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+VkFormat gf3d_texture_compressed_dxgi_format(Uint32 dxgi)
+{
+    switch (dxgi)
+    {
+        case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+        case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+int gf3d_texture_compressed_check(const void *data,size_t size)
+{
+    if (!data)return 0;
+    if ((size >= 4)&&(memcmp(data,"DDS ",4) == 0))return 1;
+    if ((size >= sizeof(gf3d_ktx2_identifier))&&(memcmp(data,gf3d_ktx2_identifier,sizeof(gf3d_ktx2_identifier)) == 0))return 1;
+    return 0;
+}
+
+int gf3d_texture_compressed_parse_dds(const Uint8 *data,size_t size,CompressedImage *image)
+{
+    Uint32 i,fourCC,mipCount,w,h;
+    size_t offset = DDS_HEADER_SIZE;
+    if (size < DDS_HEADER_SIZE)return 0;
+    if (gf3d_texture_compressed_read32(&data[4]) != 124)
+    {
+        slog("bad dds header size");
+        return 0;
+    }
+    if (gf3d_texture_compressed_read32(&data[112]) & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME))
+    {
+        slog("dds cube maps and volume textures are not supported");
+        return 0;
+    }
+    image->height = gf3d_texture_compressed_read32(&data[12]);
+    image->width = gf3d_texture_compressed_read32(&data[16]);
+    mipCount = gf3d_texture_compressed_read32(&data[28]);
+    if (!(gf3d_texture_compressed_read32(&data[80]) & DDS_PF_FOURCC))
+    {
+        slog("uncompressed dds files are not supported");
+        return 0;
+    }
+    fourCC = gf3d_texture_compressed_read32(&data[84]);
+    if (fourCC == gf3d_texture_compressed_read32((const Uint8 *)"DXT1"))image->format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    else if (fourCC == gf3d_texture_compressed_read32((const Uint8 *)"DXT5"))image->format = VK_FORMAT_BC3_UNORM_BLOCK;
+    else if ((fourCC == gf3d_texture_compressed_read32((const Uint8 *)"ATI2"))||
+        (fourCC == gf3d_texture_compressed_read32((const Uint8 *)"BC5U")))image->format = VK_FORMAT_BC5_UNORM_BLOCK;
+    else if (fourCC == gf3d_texture_compressed_read32((const Uint8 *)"DX10"))
+    {
+        if (size < DDS_HEADER_SIZE + DDS_DX10_SIZE)return 0;
+        //resource dimension must be 2D and there must be one array element
+        if ((gf3d_texture_compressed_read32(&data[132]) != 3)||(gf3d_texture_compressed_read32(&data[140]) > 1))
+        {
+            slog("only single 2D dds textures are supported");
+            return 0;
+        }
+        image->format = gf3d_texture_compressed_dxgi_format(gf3d_texture_compressed_read32(&data[128]));
+        offset += DDS_DX10_SIZE;
+    }
+    else image->format = VK_FORMAT_UNDEFINED;
+    image->blockBytes = gf3d_texture_compressed_block_bytes(image->format);
+    if (!image->blockBytes)
+    {
+        slog("unsupported dds pixel format");
+        return 0;
+    }
+    image->mipLevels = gf3d_texture_compressed_clamp_levels(mipCount,image->width,image->height);
+    //dds levels are stored back to back, largest first
+    w = image->width;
+    h = image->height;
+    for (i = 0; i < image->mipLevels; i++)
+    {
+        image->levelSize[i] = gf3d_texture_compressed_level_size(w,h,image->blockBytes);
+        if (offset + image->levelSize[i] > size)
+        {
+            if (!i)
+            {
+                slog("dds file is truncated");
+                return 0;
+            }
+            image->mipLevels = i;
+            break;
+        }
+        image->levelData[i] = &data[offset];
+        offset += image->levelSize[i];
+        w = MAX(1,w / 2);
+        h = MAX(1,h / 2);
+    }
+    return 1;
+}
+
+int gf3d_texture_compressed_parse_ktx2(const Uint8 *data,size_t size,CompressedImage *image)
+{
+    Uint32 i,levelCount,w,h;
+    Uint64 offset,length;
+    const Uint8 *level;
+    if (size < KTX2_HEADER_SIZE)return 0;
+    image->format = gf3d_texture_compressed_read32(&data[12]);
+    image->width = gf3d_texture_compressed_read32(&data[20]);
+    image->height = gf3d_texture_compressed_read32(&data[24]);
+    if ((gf3d_texture_compressed_read32(&data[28]))||//depth
+        (gf3d_texture_compressed_read32(&data[32]) > 1)||//layers
+        (gf3d_texture_compressed_read32(&data[36]) != 1))//faces
+    {
+        slog("only single 2D ktx2 textures are supported");
+        return 0;
+    }
+    if (gf3d_texture_compressed_read32(&data[44]))
+    {
+        slog("supercompressed ktx2 files are not supported");
+        return 0;
+    }
+    image->blockBytes = gf3d_texture_compressed_block_bytes(image->format);
+    if (!image->blockBytes)
+    {
+        slog("unsupported ktx2 format %i",image->format);
+        return 0;
+    }
+    levelCount = MAX(gf3d_texture_compressed_read32(&data[40]),1);
+    if (size < KTX2_HEADER_SIZE + (size_t)levelCount * KTX2_LEVEL_SIZE)return 0;
+    image->mipLevels = gf3d_texture_compressed_clamp_levels(levelCount,image->width,image->height);
+    w = image->width;
+    h = image->height;
+    for (i = 0; i < image->mipLevels; i++)
+    {
+        level = &data[KTX2_HEADER_SIZE + i * KTX2_LEVEL_SIZE];
+        offset = gf3d_texture_compressed_read64(level);
+        length = gf3d_texture_compressed_read64(level + 8);
+        if ((offset > size)||(length > size - offset)||(length < gf3d_texture_compressed_level_size(w,h,image->blockBytes)))
+        {
+            if (!i)
+            {
+                slog("ktx2 file is truncated");
+                return 0;
+            }
+            image->mipLevels = i;
+            break;
+        }
+        image->levelData[i] = &data[offset];
+        image->levelSize[i] = gf3d_texture_compressed_level_size(w,h,image->blockBytes);
+        w = MAX(1,w / 2);
+        h = MAX(1,h / 2);
+    }
+    return 1;
+}
+
+int gf3d_texture_compressed_parse(const void *data,size_t size,CompressedImage *image)
+{
+    int result = 0;
+    if ((!data)||(!image))return 0;
+    memset(image,0,sizeof(CompressedImage));
+    if ((size >= 4)&&(memcmp(data,"DDS ",4) == 0))result = gf3d_texture_compressed_parse_dds(data,size,image);
+    else if ((size >= sizeof(gf3d_ktx2_identifier))&&(memcmp(data,gf3d_ktx2_identifier,sizeof(gf3d_ktx2_identifier)) == 0))
+    {
+        result = gf3d_texture_compressed_parse_ktx2(data,size,image);
+    }
+    if ((result)&&((!image->width)||(!image->height)))
+    {
+        slog("compressed texture has no size");
+        result = 0;
+    }
+    if ((result)&&(__DEBUG))slog("compressed texture %ix%i, format %i, %i levels",image->width,image->height,image->format,image->mipLevels);
+    return result;
+}
+
+/*eol@eof*/
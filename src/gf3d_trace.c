@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_trace.h"
+
+typedef struct
+{
+    const char *name;       /**<NULL for an empty slot*/
+    Uint64      start;
+    Uint64      duration;   /**<0 for frame markers*/
+    Uint32      thread;
+    Uint8       marker;     /**<instant frame boundary instead of a zone*/
+}TraceEvent;
+
+typedef struct
+{
+    TraceEvent     *events;
+    Uint32          maxEvents;
+    SDL_atomic_t    next;           /**<total events recorded, the slot is this modulo maxEvents*/
+    Uint64          startCounter;
+    double          usPerTick;
+}TraceManager;
+
+extern int __DEBUG;
+static TraceManager gf3d_trace = {0};
+
+void gf3d_trace_close()
+{
+    if (gf3d_trace.events)free(gf3d_trace.events);
+    memset(&gf3d_trace,0,sizeof(TraceManager));
+    if (__DEBUG)slog("trace closed");
+}
+
+void gf3d_trace_init(Uint32 maxEvents)
+{
+    if (!maxEvents)
+    {
+        slog("cannot trace zero events");
+        return;
+    }
+    gf3d_trace.events = gfc_allocate_array(sizeof(TraceEvent),maxEvents);
+    if (!gf3d_trace.events)
+    {
+        slog("failed to allocate trace buffer");
+        return;
+    }
+    gf3d_trace.maxEvents = maxEvents;
+    gf3d_trace.startCounter = SDL_GetPerformanceCounter();
+    gf3d_trace.usPerTick = 1000000.0 / (double)SDL_GetPerformanceFrequency();
+    atexit(gf3d_trace_close);
+    if (__DEBUG)slog("trace initialized for %i events",maxEvents);
+}
+
+Bool gf3d_trace_enabled()
+{
+    return gf3d_trace.events != NULL;
+}
+
+TraceEvent *gf3d_trace_next_event()
+{
+    int index;
+    //the slot is claimed atomically so any thread may record
+    index = SDL_AtomicAdd(&gf3d_trace.next,1);
+    return &gf3d_trace.events[(Uint32)index % gf3d_trace.maxEvents];
+}
+
+TraceZone gf3d_trace_begin(const char *name)
+{
+    TraceZone zone;
+    zone.name = name;
+    zone.start = gf3d_trace.events?SDL_GetPerformanceCounter():0;
+    return zone;
+}
+
+void gf3d_trace_end(TraceZone zone)
+{
+    Uint64 now;
+    TraceEvent *event;
+    if ((!gf3d_trace.events)||(!zone.name)||(!zone.start))return;
+    now = SDL_GetPerformanceCounter();
+    event = gf3d_trace_next_event();
+    event->name = zone.name;
+    event->start = zone.start;
+    event->duration = now - zone.start;
+    event->thread = (Uint32)SDL_ThreadID();
+    event->marker = 0;
+}
+
+void gf3d_trace_frame()
+{
+    TraceEvent *event;
+    if (!gf3d_trace.events)return;
+    event = gf3d_trace_next_event();
+    event->name = "frame";
+    event->start = SDL_GetPerformanceCounter();
+    event->duration = 0;
+    event->thread = (Uint32)SDL_ThreadID();
+    event->marker = 1;
+}
+
+void gf3d_trace_write_name(FILE *file,const char *name)
+{
+    for (;*name;name++)
+    {
+        if ((*name == '"')||(*name == '\\'))fputc('\\',file);
+        if ((unsigned char)*name < 0x20)continue;
+        fputc(*name,file);
+    }
+}
+
+int gf3d_trace_dump(const char *filename)
+{
+    FILE *file;
+    Uint32 i,count,first,written = 0;
+    Uint32 total;
+    TraceEvent *event;
+    double start;
+    if ((!gf3d_trace.events)||(!filename))return 0;
+    file = fopen(filename,"w");
+    if (!file)
+    {
+        slog("failed to open trace file %s",filename);
+        return 0;
+    }
+    total = (Uint32)SDL_AtomicGet(&gf3d_trace.next);
+    count = MIN(total,gf3d_trace.maxEvents);
+    first = total - count;
+    fprintf(file,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (i = 0; i < count; i++)
+    {
+        //oldest first, events are written as zones end so they are not strictly in start order
+        event = &gf3d_trace.events[(first + i) % gf3d_trace.maxEvents];
+        if (!event->name)continue;
+        start = (double)(event->start - gf3d_trace.startCounter) * gf3d_trace.usPerTick;
+        if (written)fprintf(file,",\n");
+        fprintf(file,"{\"name\":\"");
+        gf3d_trace_write_name(file,event->name);
+        if (event->marker)
+        {
+            fprintf(file,"\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",start,event->thread);
+        }
+        else
+        {
+            fprintf(file,"\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                start,(double)event->duration * gf3d_trace.usPerTick,event->thread);
+        }
+        written++;
+    }
+    fprintf(file,"\n]}\n");
+    fclose(file);
+    slog("wrote %i trace events to %s",written,filename);
+    return 1;
+}
+
+/*eol@eof*/
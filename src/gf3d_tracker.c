@@ -0,0 +1,305 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "simple_logger.h"
+#include "simple_json.h"
+
+#include "gfc_pak.h"
+
+#include "gf3d_tracker.h"
+
+#define TRACKER_MAX_TAGS 64         /**<distinct tags that are summed up in a report*/
+#define TRACKER_MAX_SITE_LINES 64   /**<call sites listed in a report before the rest are summed up*/
+
+typedef struct
+{
+    Uint64          handle;         /**<0 for an empty slot*/
+    TrackerCategory category;
+    VkDeviceSize    size;
+    const char     *tag;
+    const char     *file;
+    int             line;
+}TrackedObject;
+
+typedef struct
+{
+    Uint32          live;
+    Uint32          peak;
+    Uint32          created;        /**<total over the run*/
+    VkDeviceSize    liveBytes;
+    VkDeviceSize    peakBytes;
+}TrackerTotals;
+
+typedef struct
+{
+    TrackedObject  *objects;        /**<open addressing by category and handle*/
+    Uint32          capacity;       /**<always a power of two*/
+    Uint32          count;
+    TrackerTotals   totals[TC_MAX];
+}ObjectTracker;
+
+extern int __DEBUG;
+static ObjectTracker gf3d_tracker = {0};
+
+static const char *gf3d_tracker_category_names[TC_MAX] =
+{
+    "memory",
+    "buffer",
+    "image",
+    "image view",
+    "sampler",
+    "descriptor pool",
+    "descriptor layout",
+    "pipeline",
+    "pipeline layout",
+    "render pass",
+    "shader module",
+    "framebuffer",
+    "command pool",
+    "query pool",
+    "semaphore",
+    "fence"
+};
+
+void gf3d_tracker_close()
+{
+    Uint32 i,leaks = 0;
+    for (i = 0; i < TC_MAX; i++)leaks += gf3d_tracker.totals[i].live;
+    if (leaks)
+    {
+        slog("object tracker: %i vulkan objects were not destroyed",leaks);
+        gf3d_tracker_report(1);
+    }
+    else slog("object tracker: every tracked vulkan object was destroyed");
+    if (gf3d_tracker.objects)free(gf3d_tracker.objects);
+    memset(&gf3d_tracker,0,sizeof(ObjectTracker));
+}
+
+void gf3d_tracker_init(const char *config)
+{
+    SJson *json;
+    short int enable = 0;
+    if (!config)return;
+    json = gfc_pak_load_json(config);
+    if (!json)return;
+    sj_get_bool_value(sj_object_get_value(json,"object_tracker"),&enable);
+    sj_free(json);
+    if (!enable)return;
+    gf3d_tracker.capacity = 1024;
+    gf3d_tracker.objects = gfc_allocate_array(sizeof(TrackedObject),gf3d_tracker.capacity);
+    if (!gf3d_tracker.objects)
+    {
+        slog("failed to allocate object tracker");
+        gf3d_tracker.capacity = 0;
+        return;
+    }
+    atexit(gf3d_tracker_close);
+    slog("object tracker enabled");
+}
+
+Bool gf3d_tracker_enabled()
+{
+    return gf3d_tracker.objects != NULL;
+}
+
+Uint32 gf3d_tracker_hash(TrackerCategory category,Uint64 handle)
+{
+    Uint64 key = handle ^ ((Uint64)category << 56);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (Uint32)key & (gf3d_tracker.capacity - 1);
+}
+
+void gf3d_tracker_insert(TrackedObject *object)
+{
+    Uint32 slot;
+    slot = gf3d_tracker_hash(object->category,object->handle);
+    while (gf3d_tracker.objects[slot].handle)
+    {
+        slot = (slot + 1) & (gf3d_tracker.capacity - 1);
+    }
+    memcpy(&gf3d_tracker.objects[slot],object,sizeof(TrackedObject));
+}
+
+int gf3d_tracker_grow()
+{
+    Uint32 i,oldCapacity;
+    TrackedObject *old;
+    old = gf3d_tracker.objects;
+    oldCapacity = gf3d_tracker.capacity;
+    gf3d_tracker.objects = gfc_allocate_array(sizeof(TrackedObject),oldCapacity * 2);
+    if (!gf3d_tracker.objects)
+    {
+        gf3d_tracker.objects = old;
+        return 0;
+    }
+    gf3d_tracker.capacity = oldCapacity * 2;
+    for (i = 0; i < oldCapacity; i++)
+    {
+        if (!old[i].handle)continue;
+        gf3d_tracker_insert(&old[i]);
+    }
+    free(old);
+    return 1;
+}
+
+void gf3d_tracker_create_at(TrackerCategory category,Uint64 handle,VkDeviceSize size,const char *tag,const char *file,int line)
+{
+    TrackedObject object;
+    TrackerTotals *totals;
+    if ((!gf3d_tracker.objects)||(!handle)||(category >= TC_MAX))return;
+    //kept at most half full so probe runs stay short
+    if (((gf3d_tracker.count + 1) * 2 > gf3d_tracker.capacity)&&(!gf3d_tracker_grow()))
+    {
+        slog("failed to grow object tracker table");
+        return;
+    }
+    object.handle = handle;
+    object.category = category;
+    object.size = size;
+    object.tag = tag?tag:"untagged";
+    object.file = file;
+    object.line = line;
+    gf3d_tracker_insert(&object);
+    gf3d_tracker.count++;
+    totals = &gf3d_tracker.totals[category];
+    totals->live++;
+    totals->created++;
+    totals->liveBytes += size;
+    totals->peak = MAX(totals->peak,totals->live);
+    totals->peakBytes = MAX(totals->peakBytes,totals->liveBytes);
+}
+
+void gf3d_tracker_destroy_at(TrackerCategory category,Uint64 handle,const char *file,int line)
+{
+    Uint32 slot,next,home;
+    TrackedObject *object;
+    TrackerTotals *totals;
+    if ((!gf3d_tracker.objects)||(!handle)||(category >= TC_MAX))return;
+    slot = gf3d_tracker_hash(category,handle);
+    while ((gf3d_tracker.objects[slot].handle != handle)||(gf3d_tracker.objects[slot].category != category))
+    {
+        if (!gf3d_tracker.objects[slot].handle)
+        {
+            if (__DEBUG)slog("object tracker: %s destroyed at %s:%i was never recorded",gf3d_tracker_category_names[category],file,line);
+            return;
+        }
+        slot = (slot + 1) & (gf3d_tracker.capacity - 1);
+    }
+    object = &gf3d_tracker.objects[slot];
+    totals = &gf3d_tracker.totals[category];
+    totals->live--;
+    totals->liveBytes -= MIN(object->size,totals->liveBytes);
+    memset(object,0,sizeof(TrackedObject));
+    gf3d_tracker.count--;
+    //shift back any entries in the same probe run that can now sit closer to home
+    next = (slot + 1) & (gf3d_tracker.capacity - 1);
+    while (gf3d_tracker.objects[next].handle)
+    {
+        home = gf3d_tracker_hash(gf3d_tracker.objects[next].category,gf3d_tracker.objects[next].handle);
+        if (((next - home) & (gf3d_tracker.capacity - 1)) >= ((next - slot) & (gf3d_tracker.capacity - 1)))
+        {
+            memcpy(&gf3d_tracker.objects[slot],&gf3d_tracker.objects[next],sizeof(TrackedObject));
+            memset(&gf3d_tracker.objects[next],0,sizeof(TrackedObject));
+            slot = next;
+        }
+        next = (next + 1) & (gf3d_tracker.capacity - 1);
+    }
+}
+
+Uint32 gf3d_tracker_get_live(TrackerCategory category,VkDeviceSize *bytes)
+{
+    if (category >= TC_MAX)return 0;
+    if (bytes)*bytes = gf3d_tracker.totals[category].liveBytes;
+    return gf3d_tracker.totals[category].live;
+}
+
+int gf3d_tracker_compare_site(const void *a,const void *b)
+{
+    const TrackedObject *oa = *(const TrackedObject **)a,*ob = *(const TrackedObject **)b;
+    int r;
+    r = strcmp(oa->file,ob->file);
+    if (r)return r;
+    if (oa->line != ob->line)return oa->line - ob->line;
+    if (oa->category != ob->category)return (int)oa->category - (int)ob->category;
+    return strcmp(oa->tag,ob->tag);
+}
+
+void gf3d_tracker_report_sites()
+{
+    Uint32 i,live = 0,lines = 0,count;
+    VkDeviceSize bytes;
+    TrackedObject **sorted;
+    sorted = gfc_allocate_array(sizeof(TrackedObject *),MAX(gf3d_tracker.count,1));
+    if (!sorted)return;
+    for (i = 0; i < gf3d_tracker.capacity; i++)
+    {
+        if (gf3d_tracker.objects[i].handle)sorted[live++] = &gf3d_tracker.objects[i];
+    }
+    qsort(sorted,live,sizeof(TrackedObject *),gf3d_tracker_compare_site);
+    slog("live objects by call site:");
+    for (i = 0; i < live; i += count)
+    {
+        bytes = 0;
+        for (count = 0; (i + count < live)&&(gf3d_tracker_compare_site(&sorted[i],&sorted[i + count]) == 0); count++)
+        {
+            bytes += sorted[i + count]->size;
+        }
+        if (lines++ == TRACKER_MAX_SITE_LINES)
+        {
+            slog("  ... and %i more objects",live - i);
+            break;
+        }
+        slog("  %s:%i  %i %s (%s) %llu bytes",sorted[i]->file,sorted[i]->line,count,
+            gf3d_tracker_category_names[sorted[i]->category],sorted[i]->tag,(unsigned long long)bytes);
+    }
+    free(sorted);
+}
+
+void gf3d_tracker_report(Bool sites)
+{
+    Uint32 i,j,tagCount = 0;
+    TrackerTotals *totals;
+    TrackedObject *object;
+    const char *tags[TRACKER_MAX_TAGS];
+    Uint32 tagLive[TRACKER_MAX_TAGS] = {0};
+    VkDeviceSize tagBytes[TRACKER_MAX_TAGS] = {0};
+    if (!gf3d_tracker.objects)
+    {
+        slog("object tracker is not enabled");
+        return;
+    }
+    slog("object tracker: %-18s %8s %8s %8s %14s %14s","category","live","peak","created","live bytes","peak bytes");
+    for (i = 0; i < TC_MAX; i++)
+    {
+        totals = &gf3d_tracker.totals[i];
+        if (!totals->created)continue;
+        slog("object tracker: %-18s %8i %8i %8i %14llu %14llu",gf3d_tracker_category_names[i],
+            totals->live,totals->peak,totals->created,
+            (unsigned long long)totals->liveBytes,(unsigned long long)totals->peakBytes);
+    }
+    for (i = 0; i < gf3d_tracker.capacity; i++)
+    {
+        object = &gf3d_tracker.objects[i];
+        if (!object->handle)continue;
+        for (j = 0; j < tagCount; j++)
+        {
+            if ((tags[j] == object->tag)||(strcmp(tags[j],object->tag) == 0))break;
+        }
+        if (j == tagCount)
+        {
+            if (tagCount == TRACKER_MAX_TAGS)continue;
+            tags[tagCount++] = object->tag;
+        }
+        tagLive[j]++;
+        tagBytes[j] += object->size;
+    }
+    for (i = 0; i < tagCount; i++)
+    {
+        slog("object tracker: tag %-20s %8i live %14llu bytes",tags[i],tagLive[i],(unsigned long long)tagBytes[i]);
+    }
+    if (sites)gf3d_tracker_report_sites();
+}
+
+/*eol@eof*/
@@ -79,14 +79,7 @@ void gf3d_uniform_buffer_list_free(UniformBufferList *list)
     {
         for (i = 0; i < list->buffer_count; i++)
         {
-            if (list->buffers[j][i].uniformBuffer)
-            {
-                vkDestroyBuffer(list->device, list->buffers[j][i].uniformBuffer, NULL);
-            }
-            if (list->buffers[j][i].uniformBufferMemory)
-            {
-                vkFreeMemory(list->device, list->buffers[j][i].uniformBufferMemory, NULL);
-            }
+            gf3d_buffer_free(list->buffers[j][i].uniformBuffer,list->buffers[j][i].uniformBufferMemory);
         }
     }
 }
@@ -0,0 +1,248 @@
+#include <stddef.h>
+#include <float.h>
+
+#include "simple_logger.h"
+
+#include "gf3d_vertex_batch.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GF3D_VERTEX_BATCH_AVX
+#define GF3D_VERTEX_BATCH_SSE
+#elif defined(__SSE2__)||defined(_M_X64)
+#include <emmintrin.h>
+#define GF3D_VERTEX_BATCH_SSE
+#endif
+
+/*
+ * The SIMD kernels load a Vertex as two groups of four floats:
+ * A = (x, y, z, nx) and B = (ny, nz, u, v)
+ */
+#define VERTEX_FLOATS 8
+
+const char *gf3d_vertex_batch_get_kernel_name()
+{
+#if defined(GF3D_VERTEX_BATCH_AVX)
+    return "avx";
+#elif defined(GF3D_VERTEX_BATCH_SSE)
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
+
+void gf3d_vertex_batch_transform_scalar(Vertex *out,const Vertex *in,Uint32 count,GFC_Matrix4 m)
+{
+    Uint32 i;
+    float x,y,z;
+    for (i = 0; i < count; i++)
+    {
+        x = in[i].vertex.x;
+        y = in[i].vertex.y;
+        z = in[i].vertex.z;
+        out[i].vertex.x = m[0][0]*x + m[1][0]*y + m[2][0]*z + m[3][0];
+        out[i].vertex.y = m[0][1]*x + m[1][1]*y + m[2][1]*z + m[3][1];
+        out[i].vertex.z = m[0][2]*x + m[1][2]*y + m[2][2]*z + m[3][2];
+        x = in[i].normal.x;
+        y = in[i].normal.y;
+        z = in[i].normal.z;
+        out[i].normal.x = m[0][0]*x + m[1][0]*y + m[2][0]*z;
+        out[i].normal.y = m[0][1]*x + m[1][1]*y + m[2][1]*z;
+        out[i].normal.z = m[0][2]*x + m[1][2]*y + m[2][2]*z;
+        out[i].texel = in[i].texel;
+    }
+}
+
+#ifdef GF3D_VERTEX_BATCH_SSE
+#define SPLAT(v,i) _mm_shuffle_ps(v,v,_MM_SHUFFLE(i,i,i,i))
+
+Uint32 gf3d_vertex_batch_transform_sse(Vertex *out,const Vertex *in,Uint32 count,GFC_Matrix4 m)
+{
+    Uint32 i;
+    const float *src;
+    float *dst;
+    __m128 r0,r1,r2,r3,a,b,p,n,t;
+    r0 = _mm_loadu_ps(m[0]);
+    r1 = _mm_loadu_ps(m[1]);
+    r2 = _mm_loadu_ps(m[2]);
+    r3 = _mm_loadu_ps(m[3]);
+    for (i = 0; i < count; i++)
+    {
+        src = (const float *)&in[i];
+        dst = (float *)&out[i];
+        a = _mm_loadu_ps(src);
+        b = _mm_loadu_ps(src + 4);
+        p = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(r0,SPLAT(a,0)),_mm_mul_ps(r1,SPLAT(a,1))),
+            _mm_add_ps(_mm_mul_ps(r2,SPLAT(a,2)),r3));
+        n = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(r0,SPLAT(a,3)),_mm_mul_ps(r1,SPLAT(b,0))),
+            _mm_mul_ps(r2,SPLAT(b,1)));
+        //repack into (px,py,pz,nx) and (ny,nz,u,v)
+        t = _mm_shuffle_ps(p,n,_MM_SHUFFLE(0,0,2,2));
+        a = _mm_shuffle_ps(p,t,_MM_SHUFFLE(2,0,1,0));
+        b = _mm_shuffle_ps(n,b,_MM_SHUFFLE(3,2,2,1));
+        _mm_storeu_ps(dst,a);
+        _mm_storeu_ps(dst + 4,b);
+    }
+    return count;
+}
+#endif
+
+#ifdef GF3D_VERTEX_BATCH_AVX
+#define SPLAT256(v,i) _mm256_shuffle_ps(v,v,_MM_SHUFFLE(i,i,i,i))
+
+/**
+ * @brief same as the sse kernel, but with two vertices side by side in the two 128 bit lanes
+ * @return how many vertices were done, always even
+ */
+Uint32 gf3d_vertex_batch_transform_avx(Vertex *out,const Vertex *in,Uint32 count,GFC_Matrix4 m)
+{
+    Uint32 i;
+    const float *src;
+    float *dst;
+    __m256 r0,r1,r2,r3,a,b,p,n,t;
+    r0 = _mm256_broadcast_ps((const __m128 *)m[0]);
+    r1 = _mm256_broadcast_ps((const __m128 *)m[1]);
+    r2 = _mm256_broadcast_ps((const __m128 *)m[2]);
+    r3 = _mm256_broadcast_ps((const __m128 *)m[3]);
+    for (i = 0; i + 1 < count; i += 2)
+    {
+        src = (const float *)&in[i];
+        dst = (float *)&out[i];
+        a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src)),_mm_loadu_ps(src + VERTEX_FLOATS),1);
+        b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 4)),_mm_loadu_ps(src + VERTEX_FLOATS + 4),1);
+        p = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(r0,SPLAT256(a,0)),_mm256_mul_ps(r1,SPLAT256(a,1))),
+            _mm256_add_ps(_mm256_mul_ps(r2,SPLAT256(a,2)),r3));
+        n = _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(r0,SPLAT256(a,3)),_mm256_mul_ps(r1,SPLAT256(b,0))),
+            _mm256_mul_ps(r2,SPLAT256(b,1)));
+        t = _mm256_shuffle_ps(p,n,_MM_SHUFFLE(0,0,2,2));
+        a = _mm256_shuffle_ps(p,t,_MM_SHUFFLE(2,0,1,0));
+        b = _mm256_shuffle_ps(n,b,_MM_SHUFFLE(3,2,2,1));
+        _mm_storeu_ps(dst,_mm256_castps256_ps128(a));
+        _mm_storeu_ps(dst + 4,_mm256_castps256_ps128(b));
+        _mm_storeu_ps(dst + VERTEX_FLOATS,_mm256_extractf128_ps(a,1));
+        _mm_storeu_ps(dst + VERTEX_FLOATS + 4,_mm256_extractf128_ps(b,1));
+    }
+    return i;
+}
+#endif
+
+void gf3d_vertex_batch_transform(Vertex *out,const Vertex *in,Uint32 count,GFC_Matrix4 matrix)
+{
+    Uint32 done = 0;
+    if ((!out)||(!in)||(!count))return;
+#if defined(GF3D_VERTEX_BATCH_SSE)
+    if ((sizeof(Vertex) == sizeof(float)*VERTEX_FLOATS)&&(offsetof(Vertex,texel) == sizeof(float)*6))
+    {
+#if defined(GF3D_VERTEX_BATCH_AVX)
+        done = gf3d_vertex_batch_transform_avx(out,in,count,matrix);
+#endif
+        done += gf3d_vertex_batch_transform_sse(&out[done],&in[done],count - done,matrix);
+    }
+#endif
+    if (done < count)gf3d_vertex_batch_transform_scalar(&out[done],&in[done],count - done,matrix);
+}
+
+void gf3d_vertex_batch_transform_points(GFC_Vector3D *points,Uint32 count,GFC_Matrix4 m,float w)
+{
+    Uint32 i = 0;
+    float x,y,z;
+#ifdef GF3D_VERTEX_BATCH_SSE
+    __m128 r0,r1,r2,r3,a,p;
+    if (count)
+    {
+        r0 = _mm_loadu_ps(m[0]);
+        r1 = _mm_loadu_ps(m[1]);
+        r2 = _mm_loadu_ps(m[2]);
+        r3 = _mm_mul_ps(_mm_loadu_ps(m[3]),_mm_set1_ps(w));
+        //the last point is done in C, a 4 wide load would read past the end of the array
+        for (; i + 1 < count; i++)
+        {
+            a = _mm_loadu_ps(&points[i].x);
+            p = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(r0,SPLAT(a,0)),_mm_mul_ps(r1,SPLAT(a,1))),
+                _mm_add_ps(_mm_mul_ps(r2,SPLAT(a,2)),r3));
+            _mm_storel_pi((__m64 *)&points[i].x,p);
+            _mm_store_ss(&points[i].z,_mm_movehl_ps(p,p));
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        x = points[i].x;
+        y = points[i].y;
+        z = points[i].z;
+        points[i].x = m[0][0]*x + m[1][0]*y + m[2][0]*z + m[3][0]*w;
+        points[i].y = m[0][1]*x + m[1][1]*y + m[2][1]*z + m[3][1]*w;
+        points[i].z = m[0][2]*x + m[1][2]*y + m[2][2]*z + m[3][2]*w;
+    }
+}
+
+/**
+ * @brief shared min/max for any array where the x,y,z floats are at the start of each element
+ */
+void gf3d_vertex_batch_strided_bounds(const char *data,Uint32 count,size_t stride,GFC_Vector3D *min,GFC_Vector3D *max)
+{
+    Uint32 i = 0;
+    const float *p;
+    float lo[3] = {FLT_MAX,FLT_MAX,FLT_MAX},hi[3] = {-FLT_MAX,-FLT_MAX,-FLT_MAX};
+#ifdef GF3D_VERTEX_BATCH_SSE
+    float simdLo[4],simdHi[4];
+    __m128 vlo,vhi,a;
+    int j;
+    //a 4 wide load only stays inside the array if there is a float after z
+    Uint32 simdCount = (stride >= sizeof(float)*4)?count:(count?count - 1:0);
+    if (simdCount)
+    {
+        vlo = _mm_set1_ps(FLT_MAX);
+        vhi = _mm_set1_ps(-FLT_MAX);
+        for (; i < simdCount; i++)
+        {
+            a = _mm_loadu_ps((const float *)(data + i * stride));
+            vlo = _mm_min_ps(vlo,a);
+            vhi = _mm_max_ps(vhi,a);
+        }
+        _mm_storeu_ps(simdLo,vlo);
+        _mm_storeu_ps(simdHi,vhi);
+        for (j = 0; j < 3; j++)
+        {
+            lo[j] = simdLo[j];
+            hi[j] = simdHi[j];
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        p = (const float *)(data + i * stride);
+        if (p[0] < lo[0])lo[0] = p[0];
+        if (p[1] < lo[1])lo[1] = p[1];
+        if (p[2] < lo[2])lo[2] = p[2];
+        if (p[0] > hi[0])hi[0] = p[0];
+        if (p[1] > hi[1])hi[1] = p[1];
+        if (p[2] > hi[2])hi[2] = p[2];
+    }
+    if (!count)
+    {
+        lo[0] = lo[1] = lo[2] = 0;
+        hi[0] = hi[1] = hi[2] = 0;
+    }
+    if (min)*min = gfc_vector3d(lo[0],lo[1],lo[2]);
+    if (max)*max = gfc_vector3d(hi[0],hi[1],hi[2]);
+}
+
+void gf3d_vertex_batch_bounds(const Vertex *vertices,Uint32 count,GFC_Vector3D *min,GFC_Vector3D *max)
+{
+    if (!vertices)count = 0;
+    gf3d_vertex_batch_strided_bounds((const char *)vertices + offsetof(Vertex,vertex),count,sizeof(Vertex),min,max);
+}
+
+void gf3d_vertex_batch_points_bounds(const GFC_Vector3D *points,Uint32 count,GFC_Vector3D *min,GFC_Vector3D *max)
+{
+    if (!points)count = 0;
+    gf3d_vertex_batch_strided_bounds((const char *)points,count,sizeof(GFC_Vector3D),min,max);
+}
+
+/*eol@eof*/
@@ -26,7 +26,17 @@
 #include "gf3d_swapchain.h"
 #include "gf3d_pipeline.h"
 #include "gf3d_commands.h"
+#include "gf3d_sampler.h"
+#include "gf3d_bindless.h"
+#include "gf3d_frame_ubo.h"
+#include "gf3d_profiler.h"
+#include "gf3d_trace.h"
+#include "gf3d_stats.h"
+#include "gf3d_tracker.h"
+#include "gf3d_frame_pacer.h"
+#include "gf3d_latency.h"
 #include "gf3d_texture.h"
+#include "gf3d_skin.h"
 #include "gf2d_sprite.h"
 
 #include "gf3d_vgraphics.h"
@@ -97,6 +107,7 @@ void gf3d_vgraphics_setup(
     int renderWidth,
     int renderHeight,
     Bool fullscreen,
+    Bool hidden,
     Bool enableValidation,
     Bool enableDebug,
     const char *config
@@ -109,6 +120,11 @@ void gf3d_vgraphics_init(const char *config)
     const char *windowName = NULL;
     GFC_Vector2D resolution = {1024,768};
     short int fullscreen = 0;
+    short int hidden = 0;
+    int maxSprites = 1024;
+    float targetFps = 0;
+    VkPresentModeKHR presentMode;
+    SDL_DisplayMode displayMode = {0};
     short int enableValidation = 0;
     short int enableDebug = 0;
     
@@ -133,6 +149,10 @@ void gf3d_vgraphics_init(const char *config)
     sj_value_as_vector2d(sj_object_get_value(setup,"resolution"),&resolution);
     gf3d_vgraphics.bgcolor = sj_value_as_color(sj_object_get_value(setup,"background"));
     sj_get_bool_value(sj_object_get_value(setup,"fullscreen"),&fullscreen);
+    sj_get_bool_value(sj_object_get_value(setup,"hidden"),&hidden);
+    sj_get_integer_value(sj_object_get_value(setup,"max_sprites"),&maxSprites);
+    sj_get_float_value(sj_object_get_value(setup,"target_fps"),&targetFps);
+    presentMode = gf3d_swapchain_present_mode_from_name(sj_object_get_value_as_string(setup,"present_mode"),VK_PRESENT_MODE_MAILBOX_KHR);
     sj_get_bool_value(sj_object_get_value(json,"enable_debug"),&enableDebug);
     sj_get_bool_value(sj_object_get_value(json,"enable_validation"),&enableValidation);
     
@@ -158,11 +178,13 @@ void gf3d_vgraphics_init(const char *config)
     
     gf3d_vgraphics.ubo.proj[1][1] *= -1;
 
+    gf3d_tracker_init(config);
     gf3d_vgraphics_setup(
         windowName,
         resolution.x,
         resolution.y,
         fullscreen,
+        hidden,
         enableValidation,
         enableDebug,
         config
@@ -171,8 +193,11 @@ void gf3d_vgraphics_init(const char *config)
     gf3d_vgraphics.device = gf3d_vgraphics_get_default_logical_device();
 
     gf3d_vqueues_setup_device_queues(gf3d_vgraphics.device);
+    gf3d_stats_init(gf3d_vgraphics.gpu);
     // swap chain!!!
-    gf3d_swapchain_init(gf3d_vgraphics.gpu,gf3d_vgraphics.device,gf3d_vgraphics.surface,resolution.x,resolution.y);
+    gf3d_swapchain_init(gf3d_vgraphics.gpu,gf3d_vgraphics.device,gf3d_vgraphics.surface,resolution.x,resolution.y,presentMode);
+    SDL_GetWindowDisplayMode(gf3d_vgraphics.main_window,&displayMode);
+    gf3d_frame_pacer_init(targetFps,displayMode.refresh_rate);
     gf3d_pipeline_init(16);// how many different rendering pipelines we need
     
     // 2D stuff
@@ -193,13 +218,17 @@ void gf3d_vgraphics_init(const char *config)
         gf3d_vgraphics.bmask,
         gf3d_vgraphics.amask);
 
+    gf3d_sampler_init(config);
+    gf3d_bindless_init(4096);
+    gf3d_frame_ubo_init();
     gf3d_texture_init(1024);
 
     gf3d_command_system_init(16 * gf3d_swapchain_get_swap_image_count(), gf3d_vgraphics.device);
     gf3d_vgraphics.graphicsCommandPool = gf3d_command_graphics_pool_setup(gf3d_swapchain_get_swap_image_count());
+    gf3d_profiler_init(config,64);
 
     gf3d_vgraphics.enable_2d = 1;
-    gf2d_sprite_manager_init(1024);
+    gf2d_sprite_manager_init(maxSprites > 0?maxSprites:1024);
     renderPipe = gf2d_sprite_get_pipeline();
 
     gf3d_swapchain_create_depth_image();
@@ -213,6 +242,7 @@ void gf3d_vgraphics_setup(
     int renderWidth,
     int renderHeight,
     Bool fullscreen,
+    Bool hidden,
     Bool enableValidation,
     Bool enableDebug,
     const char *config
@@ -229,6 +259,8 @@ void gf3d_vgraphics_setup(
     }
     atexit(SDL_Quit);
     SDL_ShowCursor(SDL_DISABLE);
+    //a hidden window still gets a swap chain, for unattended runs like the benchmarks
+    if (hidden)flags |= SDL_WINDOW_HIDDEN;
     if (fullscreen)
     {
         if (renderWidth == 0)
@@ -481,8 +513,17 @@ Uint32 gf3d_vgraphics_render_begin()
 
 void gf3d_vgraphics_render_start()
 {
+    TraceZone zone;
+    gf3d_trace_frame();
+    zone = gf3d_trace_begin("render_start");
     gf3d_vgraphics.bufferFrame = gf3d_vgraphics_render_begin();
+    gf3d_latency_poll();
+    gf3d_bindless_begin_frame(gf3d_vgraphics.bufferFrame);
+    gf3d_frame_ubo_update(gf3d_vgraphics.bufferFrame);
+    gf3d_profiler_begin_frame(gf3d_vgraphics.bufferFrame);
     gf3d_pipeline_reset_all_pipes();
+    gf3d_skin_reset_frame();
+    gf3d_trace_end(zone);
 }
 
 Uint32  gf3d_vgraphics_get_current_buffer_frame()
@@ -498,8 +539,20 @@ void gf3d_vgraphics_render_end()
     VkSemaphore waitSemaphores[] = {gf3d_vgraphics.imageAvailableSemaphore};
     VkSemaphore signalSemaphores[] = {gf3d_vgraphics.renderFinishedSemaphore};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    
+    VkFence fence;
+    TraceZone zone;
+    
+    //pipelines record and submit their draws in gf3d_pipeline_submit_all_pipe_commands, so the latch and the
+    //latency submit stamp go ahead of it to land before any of the frame's draw work reaches the queue
+    zone = gf3d_trace_begin("late_latch");
+    if (gf3d_frame_ubo_late_latch(gf3d_vgraphics.bufferFrame))gf3d_latency_mark_input();
+    gf3d_latency_poll();
+    fence = gf3d_latency_submit(gf3d_vgraphics.bufferFrame);
+    gf3d_trace_end(zone);
+    zone = gf3d_trace_begin("pipeline_submit");
     gf3d_pipeline_submit_all_pipe_commands();
+    gf3d_trace_end(zone);
+    zone = gf3d_trace_begin("present");
     
     swapChains[0] = gf3d_swapchain_get();
 
@@ -517,9 +570,11 @@ void gf3d_vgraphics_render_end()
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
     
-    if (vkQueueSubmit(gf3d_vqueues_get_graphics_queue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+    //the fence also covers the pipeline submits before it, they are earlier in submission order
+    if (vkQueueSubmit(gf3d_vqueues_get_graphics_queue(), 1, &submitInfo, fence) != VK_SUCCESS)
     {
         slog("failed to submit draw command buffer!");
+        if (fence != VK_NULL_HANDLE)gf3d_latency_submit_failed(gf3d_vgraphics.bufferFrame);
     }
     
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -533,10 +588,15 @@ void gf3d_vgraphics_render_end()
     presentInfo.pResults = NULL; // Optional
     
     vkQueuePresentKHR(gf3d_vqueues_get_present_queue(), &presentInfo);
+    gf3d_latency_present(gf3d_vgraphics.bufferFrame);
+    gf3d_trace_end(zone);
+    gf3d_stats_end_frame();
 }
 
 void gf3d_vgraphics_semaphores_close()
 {
+    gf3d_tracker_destroy(TC_Semaphore,gf3d_vgraphics.renderFinishedSemaphore);
+    gf3d_tracker_destroy(TC_Semaphore,gf3d_vgraphics.imageAvailableSemaphore);
     vkDestroySemaphore(gf3d_vgraphics.device, gf3d_vgraphics.renderFinishedSemaphore, NULL);
     vkDestroySemaphore(gf3d_vgraphics.device, gf3d_vgraphics.imageAvailableSemaphore, NULL);
 }
@@ -552,6 +612,8 @@ void gf3d_vgraphics_semaphores_create()
     {
         slog("failed to create semaphores!");
     }
+    gf3d_tracker_create(TC_Semaphore,gf3d_vgraphics.imageAvailableSemaphore,0,"frame sync");
+    gf3d_tracker_create(TC_Semaphore,gf3d_vgraphics.renderFinishedSemaphore,0,"frame sync");
     atexit(gf3d_vgraphics_semaphores_close);
 }
 
@@ -612,6 +674,11 @@ ModelViewProjection gf3d_vgraphics_get_mvp()
 }
 
 VkImageView gf3d_vgraphics_create_image_view(VkImage image, VkFormat format)
+{
+    return gf3d_vgraphics_create_image_view_mips(image,format,1);
+}
+
+VkImageView gf3d_vgraphics_create_image_view_mips(VkImage image, VkFormat format, Uint32 mipLevels)
 {
     VkImageView imageView;
     VkImageViewCreateInfo viewInfo = {0};
@@ -622,7 +689,7 @@ VkImageView gf3d_vgraphics_create_image_view(VkImage image, VkFormat format)
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels?mipLevels:1;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
@@ -631,6 +698,7 @@ VkImageView gf3d_vgraphics_create_image_view(VkImage image, VkFormat format)
         slog("failed to create texture image view!");
         return VK_NULL_HANDLE;
     }
+    gf3d_tracker_create(TC_ImageView,imageView,0,"image view");
 
     return imageView;
 }